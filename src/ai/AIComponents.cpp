@@ -16,12 +16,7 @@ SessionStateAPI::SessionStateAPI() {}
 void SessionStateAPI::setSession(std::shared_ptr<Session> session)
 {
     session_ = session;
-
-    if (stateChangeCallback_)
-    {
-        auto snapshot = generateSnapshot();
-        stateChangeCallback_(snapshot);
-    }
+    notifyStateChanged();
 }
 
 SessionSnapshot SessionStateAPI::generateSnapshot() const
@@ -332,22 +327,21 @@ SessionStateAPI::validateSnapshot(const SessionSnapshot &snapshot) const
 }
 
 bool SessionStateAPI::applyAction(const ActionDSL::Action &action)
+{
+    if (!applyActionQuietly(action))
+        return false;
+
+    notifyStateChanged();
+    return true;
+}
+
+bool SessionStateAPI::applyActionQuietly(const ActionDSL::Action &action)
 {
     if (!session_)
         return false;
 
-    auto findTrackIndexById = [this](const std::string &trackId) -> int
-    {
-        const auto &tracks = session_->getTracks();
-        for (int i = 0; i < static_cast<int>(tracks.size()); ++i)
-        {
-            if (tracks[static_cast<size_t>(i)].id.toStdString() == trackId)
-            {
-                return i;
-            }
-        }
-        return -1;
-    };
+    auto findTrackIndexById = [this](const std::string &trackId)
+    { return session_->findTrackIndexById(juce::String(trackId)); };
 
     auto boolParam = [&action](const std::string &key, bool fallback = false)
     {
@@ -463,31 +457,40 @@ bool SessionStateAPI::applyAction(const ActionDSL::Action &action)
         return false;
     }
 
-    if (stateChangeCallback_)
-    {
-        auto snapshot = generateSnapshot();
-        stateChangeCallback_(snapshot);
-    }
-
     return true;
 }
 
 bool SessionStateAPI::applyActionSequence(const ActionDSL::ActionSequence &actions)
 {
     bool allSucceeded = true;
+    bool anyApplied = false;
 
+    // One snapshot for the whole batch rather than one per action
     for (const auto &action : actions)
     {
-        if (!applyAction(*action))
+        if (!applyActionQuietly(*action))
         {
             allSucceeded = false;
             break;
         }
+        anyApplied = true;
     }
 
+    if (anyApplied)
+        notifyStateChanged();
+
     return allSucceeded;
 }
 
+void SessionStateAPI::notifyStateChanged()
+{
+    if (stateChangeCallback_)
+    {
+        auto snapshot = generateSnapshot();
+        stateChangeCallback_(snapshot);
+    }
+}
+
 void SessionStateAPI::setStateChangeCallback(StateChangeCallback callback)
 {
     stateChangeCallback_ = callback;
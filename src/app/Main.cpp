@@ -36,6 +36,7 @@ namespace ampl
 //==============================================================================
 class MainContentComponent : public juce::Component,
                              public juce::Timer,
+                             public juce::AsyncUpdater,
                              public juce::MenuBarModel,
                              public juce::MidiKeyboardState::Listener
 {
@@ -65,7 +66,7 @@ class MainContentComponent : public juce::Component,
         transportBar_ = std::make_unique<TransportBar>(engine_);
         addAndMakeVisible(transportBar_.get());
 
-        timelineView_ = std::make_unique<TimelineView>(engine_, session_);
+        timelineView_ = std::make_unique<TimelineView>(engine_, session_, commandManager_);
         timelineView_->onSeek = [this](SampleCount pos) { engine_.sendSeek(pos); };
         timelineView_->onSessionChanged = [this]
         {
@@ -82,6 +83,9 @@ class MainContentComponent : public juce::Component,
         };
         timelineView_->onTrackSoloRequested = [this](int trackIdx, bool solo)
         {
+            // Exclusive solo is one undo step
+            CommandManager::ScopedTransaction transaction(commandManager_,
+                                                          solo ? "Solo Track" : "Unsolo Track");
             if (solo)
             {
                 const auto trackCount = static_cast<int>(session_.getTracks().size());
@@ -181,6 +185,11 @@ class MainContentComponent : public juce::Component,
         };
         addAndMakeVisible(redoButton_.get());
 
+        // Removed tracks and clips with many notes park them on disk once
+        // they are a few undo steps back
+        commandManager_.setSpillDirectory(
+            juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("ampl_undo"));
+
         // Update undo/redo button state
         commandManager_.onStateChanged = [this]
         {
@@ -410,6 +419,7 @@ class MainContentComponent : public juce::Component,
         if (pianoKeyboardPanel_)
             pianoKeyboardPanel_->getKeyboardState().removeListener(this);
         stopTimer();
+        cancelPendingUpdate();
         engine_.shutdown();
         setLookAndFeel(nullptr);
     }
@@ -659,6 +669,17 @@ class MainContentComponent : public juce::Component,
             timelineView_->handleAudioMessage(*msg);
         }
 
+        // A plugin changed its latency: republish so the tracks are re-aligned
+        if (engine_.getSessionRenderer().hasPluginLatencyChanged())
+            syncSessionToEngine();
+
+        // Audio of an opened project came in: republish so its clips play
+        if (assetLoader_.haveAssetsLoaded())
+        {
+            syncSessionToEngine();
+            timelineView_->repaint();
+        }
+
         transportBar_->updateDisplay();
         timelineView_->updateDisplay();
         updateTrackInfoPanel();
@@ -849,6 +870,7 @@ class MainContentComponent : public juce::Component,
             menu.addSeparator();
             menu.addItem(3, "Save", true, false);
             menu.addItem(4, "Save As...", true, false);
+            menu.addItem(8, "Export Project as JSON...", true, false);
             menu.addSeparator();
             menu.addItem(7, "Import Logic Project...", true, false);
             menu.addSeparator();
@@ -911,6 +933,9 @@ class MainContentComponent : public juce::Component,
         case 7:
             importLogicProject();
             break;
+        case 8:
+            exportProjectJson();
+            break;
         case 10:
             mixerVisible_ = !mixerVisible_;
             mixerToggleButton_->setToggleState(mixerVisible_, juce::dontSendNotification);
@@ -1059,6 +1084,27 @@ class MainContentComponent : public juce::Component,
                              });
     }
 
+    void exportProjectJson()
+    {
+        auto chooser = std::make_shared<juce::FileChooser>(
+            "Export Project as JSON...",
+            juce::File::getSpecialLocation(juce::File::userDocumentsDirectory), "*.ampl;*.json");
+
+        chooser->launchAsync(juce::FileBrowserComponent::saveMode |
+                                 juce::FileBrowserComponent::canSelectFiles,
+                             [this, chooser](const juce::FileChooser &fc)
+                             {
+                                 auto file = fc.getResult();
+                                 if (file == juce::File{})
+                                     return;
+
+                                 if (!ProjectSerializer::exportJson(session_, file))
+                                     juce::AlertWindow::showMessageBoxAsync(
+                                         juce::MessageBoxIconType::WarningIcon, "Export Failed",
+                                         "Could not write " + file.getFullPathName());
+                             });
+    }
+
     void openProject()
     {
         if (dirty_ && !confirmDiscardChanges())
@@ -1081,8 +1127,8 @@ class MainContentComponent : public juce::Component,
 
     void loadProjectFile(const juce::File &file)
     {
-        Session newSession;
-        if (ProjectSerializer::load(newSession, file, engine_.getFormatManager()))
+        Session newSession = createSession();
+        if (ProjectSerializer::load(newSession, file, engine_.getFormatManager(), &assetLoader_))
         {
             session_ = std::move(newSession);
             currentProjectFile_ = file;
@@ -1195,13 +1241,21 @@ class MainContentComponent : public juce::Component,
                              });
     }
 
+    // Edits call this as they happen; the engine hears about them once per
+    // turn of the message loop, however many there were
     void syncSessionToEngine()
+    {
+        triggerAsyncUpdate();
+    }
+
+    void handleAsyncUpdate() override
     {
         // Sync BPM
         engine_.sendSetBpm(session_.getBpm());
 
-        // Publish full session snapshot for multi-track rendering
-        engine_.publishSession(session_);
+        // Publish full session snapshot for multi-track rendering; the
+        // snapshot is built on the engine's publishing thread
+        engine_.requestPublish(session_);
 
         // Rebuild mixer strips if track count changed
         if (mixerPanel_)
@@ -1214,7 +1268,7 @@ class MainContentComponent : public juce::Component,
             return;
 
         engine_.sendStop();
-        session_ = Session();
+        session_ = createSession();
         session_.addTrack("Track 1");
         currentProjectFile_ = juce::File{};
         commandManager_.clear();
@@ -1247,7 +1301,7 @@ class MainContentComponent : public juce::Component,
             return;
 
         engine_.sendStop();
-        session_ = Session();
+        session_ = createSession();
 
         switch (templateId)
         {
@@ -1412,8 +1466,20 @@ class MainContentComponent : public juce::Component,
                                                "?: Show this help");
     }
 
+    // Sessions opened by the app keep waveform peaks between runs
+    static Session createSession()
+    {
+        Session session;
+        session.setPeakCacheDirectory(
+            juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                .getChildFile("Ampl")
+                .getChildFile("Peaks"));
+        return session;
+    }
+
     AudioEngine engine_;
-    Session session_;
+    Session session_{createSession()};
+    AssetLoader assetLoader_; // After session_: its thread stops before the session goes
     CommandManager commandManager_;
     RecentProjects recentProjects_;
 
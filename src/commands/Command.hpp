@@ -2,7 +2,9 @@
 
 #include <juce_core/juce_core.h>
 #include <memory>
+#include <span>
 #include <string>
+#include <vector>
 #include "../model/Session.hpp"
 
 namespace ampl {
@@ -22,8 +24,108 @@ public:
 
     // Human-readable description for UI display
     virtual juce::String getDescription() const = 0;
+
+    // Approximate bytes this command keeps alive, counted against the undo
+    // history's budget. The default suits commands holding ids and values;
+    // commands that save tracks or clips count all the data they hold, even
+    // while it is shared, since the entry may end up its only owner.
+    virtual size_t getMemoryUsage() const { return kSmallCommandBytes; }
+
+    // Called with a command that has just executed after this one, to fold
+    // continuous gestures (drags) into a single undo step. Return true after
+    // taking next's new state and keeping this command's old state; next is
+    // then discarded.
+    virtual bool mergeWith(const Command& /*next*/) { return false; }
+
+    // Moves the command's undo payload into file and frees it, returning
+    // false if there is nothing worth moving. The caller reads it back with
+    // readBack() before the command next executes or undoes, and deletes
+    // the file.
+    virtual bool spillTo(const juce::File& /*file*/) { return false; }
+
+    // Reads the payload spillTo() moved out back into memory. False if the
+    // file cannot be read: the payload stays on disk and the command must
+    // not execute or undo.
+    virtual bool readBack() { return true; }
+
+    static constexpr size_t kSmallCommandBytes = 128;
 };
 
 using CommandPtr = std::unique_ptr<Command>;
 
+// Moves the notes of MIDI clips held by a command to a file and back (see
+// Command::spillTo()). Only notes the command holds alone are moved; notes
+// still shared with the session stay shared. The clips must be the same, in
+// the same order, when restoring.
+class NoteSpill
+{
+public:
+    bool spill(std::span<MidiClip> clips, const juce::File& file)
+    {
+        if (isSpilled())
+            return false;
+
+        std::vector<bool> owned(clips.size());
+        bool any = false;
+        for (size_t i = 0; i < clips.size(); ++i)
+        {
+            owned[i] = !clips[i].notes.empty() && !clips[i].notes.isStorageShared();
+            any = any || owned[i];
+        }
+        if (!any)
+            return false; // Nothing held alone; the session still shares it
+
+        {
+            juce::FileOutputStream out(file);
+            if (!out.openedOk())
+                return false;
+            for (size_t i = 0; i < clips.size(); ++i)
+                if (owned[i])
+                    clips[i].notes.writeTo(out);
+            out.flush();
+            if (out.getStatus().failed())
+                return false;
+        }
+
+        for (size_t i = 0; i < clips.size(); ++i)
+            if (owned[i])
+                clips[i].notes = {};
+        spilled_ = std::move(owned);
+        file_ = file;
+        return true;
+    }
+
+    // Reads the notes back, all or none: on failure the clips are left as
+    // they are and the notes stay in the file
+    bool restore(std::span<MidiClip> clips)
+    {
+        if (!isSpilled())
+            return true;
+        if (clips.size() != spilled_.size())
+            return false;
+
+        juce::FileInputStream in(file_);
+        if (!in.openedOk())
+            return false;
+
+        std::vector<MidiNoteList> notes(clips.size());
+        for (size_t i = 0; i < clips.size(); ++i)
+            if (spilled_[i] && !notes[i].readFrom(in))
+                return false;
+
+        for (size_t i = 0; i < clips.size(); ++i)
+            if (spilled_[i])
+                clips[i].notes = std::move(notes[i]);
+        spilled_.clear();
+        file_ = juce::File();
+        return true;
+    }
+
+    bool isSpilled() const { return file_ != juce::File(); }
+
+private:
+    juce::File file_;
+    std::vector<bool> spilled_; // Per clip, while spilled
+};
+
 } // namespace ampl
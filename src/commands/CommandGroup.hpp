@@ -0,0 +1,59 @@
+#pragma once
+
+#include "commands/Command.hpp"
+#include <vector>
+
+namespace ampl {
+
+// Commands that undo and redo as one step, in order and in reverse (see
+// CommandManager::beginTransaction()). Holds commands that have already
+// executed.
+class CommandGroup : public Command
+{
+public:
+    explicit CommandGroup(juce::String description) : description_(std::move(description)) {}
+
+    void add(CommandPtr cmd) { commands_.push_back(std::move(cmd)); }
+
+    bool isEmpty() const { return commands_.empty(); }
+    size_t size() const { return commands_.size(); }
+
+    Command* getLast() const { return commands_.empty() ? nullptr : commands_.back().get(); }
+
+    // Hands back the only command, for groups of one
+    CommandPtr releaseOnly()
+    {
+        jassert(commands_.size() == 1);
+        auto cmd = std::move(commands_.back());
+        commands_.clear();
+        return cmd;
+    }
+
+    void execute(Session& session) override
+    {
+        for (auto& cmd : commands_)
+            cmd->execute(session);
+    }
+
+    void undo(Session& session) override
+    {
+        for (auto it = commands_.rbegin(); it != commands_.rend(); ++it)
+            (*it)->undo(session);
+    }
+
+    juce::String getDescription() const override { return description_; }
+
+    size_t getMemoryUsage() const override
+    {
+        size_t bytes = sizeof(*this);
+        for (const auto& cmd : commands_)
+            bytes += cmd->getMemoryUsage();
+        return bytes;
+    }
+
+private:
+    juce::String description_;
+    std::vector<CommandPtr> commands_;
+};
+
+} // namespace ampl
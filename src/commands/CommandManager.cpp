@@ -3,48 +3,70 @@
 
 namespace ampl {
 
+CommandManager::~CommandManager()
+{
+    for (auto& entry : undoStack_)
+        discard(entry);
+}
+
 void CommandManager::execute(CommandPtr cmd, Session& session)
 {
     cmd->execute(session);
-    undoStack_.push_back(std::move(cmd));
+
+    for (auto& entry : redoStack_)
+        discard(entry);
     redoStack_.clear();
 
-    // Trim undo stack if too large
-    while (static_cast<int>(undoStack_.size()) > kMaxUndoLevels)
-        undoStack_.erase(undoStack_.begin());
+    record(std::move(cmd));
+    canMerge_ = gestureDepth_ > 0;
 
-    if (onStateChanged)
-        onStateChanged();
+    // A transaction reports once, at its end
+    if (transaction_ == nullptr)
+    {
+        trimToBudget();
+        notifyStateChanged();
+    }
 }
 
 bool CommandManager::undo(Session& session)
 {
-    if (undoStack_.empty())
+    if (undoStack_.empty() || transaction_ != nullptr)
+    {
+        jassert(transaction_ == nullptr);
+        return false;
+    }
+
+    // Undoing without the spilled payload would restore empty notes: refuse,
+    // keeping the entry, until it can be read back
+    auto& top = undoStack_.back();
+    if (top.spillFile != juce::File() && !top.command->readBack())
         return false;
 
-    auto cmd = std::move(undoStack_.back());
-    undoStack_.pop_back();
-    cmd->undo(session);
-    redoStack_.push_back(std::move(cmd));
+    auto entry = pop(undoStack_);
+    entry.command->undo(session);
+    push(redoStack_, std::move(entry));
+    canMerge_ = false;
 
-    if (onStateChanged)
-        onStateChanged();
+    notifyStateChanged();
 
     return true;
 }
 
 bool CommandManager::redo(Session& session)
 {
-    if (redoStack_.empty())
+    if (redoStack_.empty() || transaction_ != nullptr)
+    {
+        jassert(transaction_ == nullptr);
         return false;
+    }
 
-    auto cmd = std::move(redoStack_.back());
-    redoStack_.pop_back();
-    cmd->execute(session);
-    undoStack_.push_back(std::move(cmd));
+    auto entry = pop(redoStack_);
+    entry.command->execute(session);
+    push(undoStack_, std::move(entry));
+    spillEntryAtDepth();
+    canMerge_ = false;
 
-    if (onStateChanged)
-        onStateChanged();
+    notifyStateChanged();
 
     return true;
 }
@@ -53,23 +75,184 @@ juce::String CommandManager::getUndoDescription() const
 {
     if (undoStack_.empty())
         return {};
-    return undoStack_.back()->getDescription();
+    return undoStack_.back().command->getDescription();
 }
 
 juce::String CommandManager::getRedoDescription() const
 {
     if (redoStack_.empty())
         return {};
-    return redoStack_.back()->getDescription();
+    return redoStack_.back().command->getDescription();
 }
 
 void CommandManager::clear()
 {
+    for (auto& entry : undoStack_)
+        discard(entry);
+    for (auto& entry : redoStack_)
+        discard(entry);
     undoStack_.clear();
     redoStack_.clear();
+    memoryUsage_ = 0;
+    canMerge_ = false;
+
+    // An open transaction carries on, with what it held so far dropped
+    if (transaction_ != nullptr)
+        transaction_ = std::make_unique<CommandGroup>(transaction_->getDescription());
 
+    notifyStateChanged();
+}
+
+void CommandManager::beginGesture()
+{
+    // The first command of a gesture starts a new undo step
+    if (gestureDepth_++ == 0)
+        canMerge_ = false;
+}
+
+void CommandManager::endGesture()
+{
+    jassert(gestureDepth_ > 0);
+    if (gestureDepth_ > 0 && --gestureDepth_ == 0)
+        canMerge_ = false;
+}
+
+void CommandManager::beginTransaction(const juce::String& description)
+{
+    if (transactionDepth_++ == 0)
+    {
+        transaction_ = std::make_unique<CommandGroup>(description);
+        canMerge_ = false;
+    }
+}
+
+void CommandManager::endTransaction()
+{
+    jassert(transactionDepth_ > 0);
+    if (transactionDepth_ == 0 || --transactionDepth_ > 0)
+        return;
+
+    auto group = std::move(transaction_);
+    canMerge_ = false;
+    if (group->isEmpty())
+        return;
+
+    // A group of one is recorded as that command, under its own description
+    if (group->size() == 1)
+        record(group->releaseOnly());
+    else
+        record(std::move(group));
+
+    trimToBudget();
+    notifyStateChanged();
+}
+
+void CommandManager::setMemoryBudget(size_t bytes)
+{
+    memoryBudget_ = bytes;
+    trimToBudget();
+}
+
+void CommandManager::record(CommandPtr cmd)
+{
+    if (transaction_ != nullptr)
+    {
+        auto* last = transaction_->getLast();
+        if (!canMerge_ || last == nullptr || !last->mergeWith(*cmd))
+            transaction_->add(std::move(cmd));
+        return;
+    }
+
+    if (canMerge_ && !undoStack_.empty() && undoStack_.back().command->mergeWith(*cmd))
+    {
+        auto& top = undoStack_.back();
+        memoryUsage_ -= top.bytes;
+        top.bytes = top.command->getMemoryUsage();
+        memoryUsage_ += top.bytes;
+        return;
+    }
+
+    push(undoStack_, {std::move(cmd), 0, {}});
+    spillEntryAtDepth();
+}
+
+void CommandManager::notifyStateChanged()
+{
     if (onStateChanged)
         onStateChanged();
 }
 
+void CommandManager::push(std::deque<Entry>& stack, Entry entry)
+{
+    // A spilled payload was read back (see undo()) before it moved stacks
+    if (entry.spillFile != juce::File())
+    {
+        entry.spillFile.deleteFile();
+        entry.spillFile = juce::File();
+    }
+
+    memoryUsage_ -= entry.bytes;
+    entry.bytes = entry.command->getMemoryUsage();
+    memoryUsage_ += entry.bytes;
+    stack.push_back(std::move(entry));
+}
+
+CommandManager::Entry CommandManager::pop(std::deque<Entry>& stack)
+{
+    auto entry = std::move(stack.back());
+    stack.pop_back();
+    return entry;
+}
+
+void CommandManager::discard(Entry& entry)
+{
+    memoryUsage_ -= entry.bytes;
+    entry.bytes = 0;
+    if (entry.spillFile != juce::File())
+        entry.spillFile.deleteFile();
+}
+
+void CommandManager::trimToBudget()
+{
+    // Redo entries go first: they are cleared by the next execute anyway
+    while (memoryUsage_ > memoryBudget_ && !redoStack_.empty())
+    {
+        discard(redoStack_.front());
+        redoStack_.pop_front();
+    }
+
+    while (memoryUsage_ > memoryBudget_ && undoStack_.size() > 1)
+    {
+        discard(undoStack_.front());
+        undoStack_.pop_front();
+    }
+}
+
+void CommandManager::spillEntryAtDepth()
+{
+    // Entries cross this depth one at a time as commands are pushed, so
+    // looking at the one entry there covers the whole stack
+    if (spillDirectory_ == juce::File() || undoStack_.size() <= kSpillDepth)
+        return;
+
+    auto& entry = undoStack_[undoStack_.size() - 1 - kSpillDepth];
+    if (entry.bytes < kSpillThresholdBytes || entry.spillFile != juce::File())
+        return;
+
+    if (!spillDirectory_.createDirectory())
+        return;
+
+    auto file = spillDirectory_.getNonexistentChildFile("undo", ".bin", false);
+    if (!entry.command->spillTo(file))
+    {
+        file.deleteFile();
+        return;
+    }
+
+    entry.spillFile = file;
+    memoryUsage_ -= entry.bytes;
+    entry.bytes = entry.command->getMemoryUsage();
+    memoryUsage_ += entry.bytes;
+}
+
 } // namespace ampl
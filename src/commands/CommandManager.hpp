@@ -1,17 +1,25 @@
 #pragma once
 
 #include "commands/Command.hpp"
+#include "commands/CommandGroup.hpp"
 #include "../model/Session.hpp"
-#include <vector>
+#include <deque>
 #include <functional>
+#include <memory>
 
 namespace ampl {
 
 // Manages the undo/redo stack. All session mutations go through here.
+//
+// History is bounded by memory rather than by step count: each entry is
+// charged Command::getMemoryUsage() and the oldest entries are dropped once
+// the total passes the budget. The stacks are deques, so dropping from the
+// far end costs O(1).
 class CommandManager
 {
 public:
     CommandManager() = default;
+    ~CommandManager();
 
     // Execute a command and push it onto the undo stack.
     // Clears the redo stack.
@@ -31,17 +39,93 @@ public:
 
     void clear();
 
+    // Bracket a continuous gesture such as a drag, from mouse down to mouse
+    // up. Commands executed in between are merged where they allow it (see
+    // Command::mergeWith()), so the gesture undoes in one step. Nests.
+    void beginGesture();
+    void endGesture();
+
+    // Group the commands executed until the matching endTransaction() into
+    // one undo step, for edits made of many commands (a multi-clip paste, a
+    // sequence of AI actions). Nests; the outermost pair counts.
+    // onStateChanged fires once, when the transaction ends, so listeners
+    // such as the engine publish once per transaction. Undo and redo are
+    // refused while a transaction is open.
+    void beginTransaction(const juce::String& description);
+    void endTransaction();
+    bool isInTransaction() const { return transactionDepth_ > 0; }
+
+    // Opens a transaction for its lifetime
+    class ScopedTransaction
+    {
+    public:
+        ScopedTransaction(CommandManager& manager, const juce::String& description)
+            : manager_(manager)
+        {
+            manager_.beginTransaction(description);
+        }
+        ~ScopedTransaction() { manager_.endTransaction(); }
+
+        ScopedTransaction(const ScopedTransaction&) = delete;
+        ScopedTransaction& operator=(const ScopedTransaction&) = delete;
+
+    private:
+        CommandManager& manager_;
+    };
+
+    // Oldest entries are dropped to keep the history within this many bytes;
+    // the most recent command is always kept
+    void setMemoryBudget(size_t bytes);
+    size_t getMemoryBudget() const { return memoryBudget_; }
+    size_t getMemoryUsage() const { return memoryUsage_; }
+
+    // Undo payloads of kSpillThresholdBytes or more are moved to files in
+    // directory once they are kSpillDepth steps back (see
+    // Command::spillTo()). Off by default; an empty File turns it off.
+    void setSpillDirectory(const juce::File& directory) { spillDirectory_ = directory; }
+
     // Callback when undo/redo state changes (for UI updates)
     std::function<void()> onStateChanged;
 
     int getUndoStackSize() const { return static_cast<int>(undoStack_.size()); }
     int getRedoStackSize() const { return static_cast<int>(redoStack_.size()); }
 
+    static constexpr size_t kDefaultMemoryBudget = 64 * 1024 * 1024;
+    static constexpr size_t kSpillThresholdBytes = 1024 * 1024;
+    static constexpr size_t kSpillDepth = 8;
+
 private:
-    std::vector<CommandPtr> undoStack_;
-    std::vector<CommandPtr> redoStack_;
+    struct Entry
+    {
+        CommandPtr command;
+        size_t bytes{0};
+        juce::File spillFile; // Set while the command's payload is on disk
+    };
+
+    // Pushes a command that has just executed, merging it into the last one
+    // if the open gesture allows
+    void record(CommandPtr cmd);
+    void notifyStateChanged();
+
+    void push(std::deque<Entry>& stack, Entry entry);
+    Entry pop(std::deque<Entry>& stack);
+    void discard(Entry& entry);
+    void trimToBudget();
+    void spillEntryAtDepth();
+
+    std::deque<Entry> undoStack_;
+    std::deque<Entry> redoStack_;
+
+    size_t memoryBudget_{kDefaultMemoryBudget};
+    size_t memoryUsage_{0};
+
+    int gestureDepth_{0};
+    bool canMerge_{false}; // The last command recorded belongs to the open gesture
+
+    int transactionDepth_{0};
+    std::unique_ptr<CommandGroup> transaction_;
 
-    static constexpr int kMaxUndoLevels = 200;
+    juce::File spillDirectory_;
 };
 
 } // namespace ampl
@@ -3,7 +3,11 @@
 namespace ampl
 {
 
-AudioEngine::AudioEngine() = default;
+AudioEngine::AudioEngine()
+{
+    sessionPublisher_.onPublished = [this]
+    { transport_.setOutputLatencySamples(sessionRenderer_.getTotalLatencySamples()); };
+}
 
 AudioEngine::~AudioEngine()
 {
@@ -174,7 +178,16 @@ std::optional<AudioToUIMessage> AudioEngine::pollAudioMessage()
 
 void AudioEngine::publishSession(const Session &session)
 {
-    sessionRenderer_.publishSession(session);
+    // Through the publisher, so a request still queued there cannot land
+    // after this one
+    sessionPublisher_.request(session);
+    sessionPublisher_.flush();
+    useSessionRenderer_ = true;
+}
+
+void AudioEngine::requestPublish(const Session &session)
+{
+    sessionPublisher_.request(session);
     useSessionRenderer_ = true;
 }
 
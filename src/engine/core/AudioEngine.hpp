@@ -2,6 +2,7 @@
 
 #include "engine/core/AudioTrack.hpp"
 #include "engine/core/Metronome.hpp"
+#include "engine/render/SessionPublisher.hpp"
 #include "engine/render/SessionRenderer.hpp"
 #include "engine/core/Transport.hpp"
 #include "engine/io/ExternalIOManager.hpp"
@@ -98,8 +99,12 @@ class AudioEngine : public juce::AudioIODeviceCallback
     // UI thread: poll messages from audio thread
     std::optional<AudioToUIMessage> pollAudioMessage();
 
-    // Session-driven rendering (UI thread publishes snapshots)
+    // Session-driven rendering (UI thread publishes snapshots).
+    // publishSession() returns once the snapshot is built; requestPublish()
+    // queues it to be built in the background, coalescing bursts of edits
+    // (see SessionPublisher).
     void publishSession(const Session &session);
+    void requestPublish(const Session &session);
     SessionRenderer &getSessionRenderer()
     {
         return sessionRenderer_;
@@ -162,6 +167,7 @@ class AudioEngine : public juce::AudioIODeviceCallback
     Transport transport_;
     Metronome metronome_;
     SessionRenderer sessionRenderer_;
+    SessionPublisher sessionPublisher_{sessionRenderer_};
     ExternalIOManager externalIO_;
     AudioTrack track_; // Legacy — kept for backward compat
     bool useSessionRenderer_{false};
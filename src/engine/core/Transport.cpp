@@ -51,6 +51,11 @@ void Transport::setSampleRate(SampleRate sr)
     sampleRate_.store(sr, std::memory_order_release);
 }
 
+void Transport::setOutputLatencySamples(int latency)
+{
+    outputLatencySamples_.store(latency, std::memory_order_release);
+}
+
 void Transport::advance(int numSamples) noexcept
 {
     if (state_.load(std::memory_order_acquire) == State::Playing)
@@ -103,6 +108,16 @@ int Transport::getTimeSigDenominator() const noexcept
     return timeSigDenominator_.load(std::memory_order_acquire);
 }
 
+int Transport::getOutputLatencySamples() const noexcept
+{
+    return outputLatencySamples_.load(std::memory_order_acquire);
+}
+
+double Transport::getOutputLatencySeconds() const noexcept
+{
+    return static_cast<double>(getOutputLatencySamples()) / getSampleRate();
+}
+
 double Transport::samplesToBeats(SampleCount samples) const noexcept
 {
     auto sr = getSampleRate();
@@ -29,6 +29,7 @@ class Transport
     void setTimeSignature(int numerator, int denominator);
     void setPositionInSamples(SampleCount position);
     void setSampleRate(SampleRate sr);
+    void setOutputLatencySamples(int latency);
 
     // Audio thread — called per buffer
     void advance(int numSamples) noexcept;
@@ -43,6 +44,11 @@ class Transport
     int getTimeSigNumerator() const noexcept;
     int getTimeSigDenominator() const noexcept;
 
+    // Processing latency between the transport position and audible output
+    // (plugin delay compensation)
+    int getOutputLatencySamples() const noexcept;
+    double getOutputLatencySeconds() const noexcept;
+
     // Utility
     double samplesToBeats(SampleCount samples) const noexcept;
     SampleCount beatsToSamples(double beats) const noexcept;
@@ -54,6 +60,7 @@ class Transport
     std::atomic<SampleRate> sampleRate_{44100.0};
     std::atomic<int> timeSigNumerator_{4};
     std::atomic<int> timeSigDenominator_{4};
+    std::atomic<int> outputLatencySamples_{0};
 };
 
 } // namespace ampl
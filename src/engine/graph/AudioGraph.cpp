@@ -1,9 +1,12 @@
 ﻿#include "AudioGraph.hpp"
+#include "AudioProcessors.hpp"
 #include "Automation.hpp"
+#include "GraphCompiler.hpp"
+#include "GraphThreadPool.hpp"
 #include <algorithm>
-#include <queue>
 #include <set>
 #include <stdexcept>
+#include <unordered_set>
 
 namespace ampl
 {
@@ -15,29 +18,399 @@ struct AudioGraph::GraphImpl
     std::vector<AudioConnection> connections;
     std::unordered_map<std::string, std::vector<AudioConnection>> nodeConnections;
     std::vector<std::string> processingOrder;
-    bool needsReorder{true};
+    std::string outputNodeId; // Empty: see resolveOutputNode()
+
+    // Delay nodes inserted by latency compensation, keyed by the edge they sit on.
+    // Reused across compiles so their delay lines keep running.
+    std::unordered_map<std::string, std::shared_ptr<LatencyCompensatorNode>> compensators;
+
+    // Effective node latencies the current plan was compensated for
+    std::unordered_map<std::string, int> compensatedLatencies;
+};
+
+// Inputs of one compile, copied so the builder thread never touches GraphImpl
+struct AudioGraph::BuildRequest
+{
+    std::vector<std::shared_ptr<AudioNode>> nodes;
+    std::vector<AudioConnection> connections;
+    std::vector<std::string> processingOrder;
+    std::string outputNodeId;
+    int blockSize{0};
+    GraphThreadPool *threadPool{nullptr};
 };
 
+namespace
+{
+
+// Bypassed nodes pass their input straight through
+int effectiveLatency(const AudioNode &node)
+{
+    return node.isBypassed() ? 0 : std::max(0, node.getLatencySamples());
+}
+
+std::string edgeKey(const AudioConnection &conn)
+{
+    return conn.sourceNodeId + ":" + std::to_string(conn.sourceChannel) + "->" +
+           conn.destNodeId + ":" + std::to_string(conn.destChannel) +
+           (conn.sidechain ? ":sc" : "");
+}
+
+// Kahn's algorithm with a LIFO ready list: each chain is followed to its
+// merge point before the next one starts, which keeps few intermediate
+// buffers live at once for the compiler's slot reuse.
+std::vector<std::string> topologicalSort(const std::vector<std::shared_ptr<AudioNode>> &nodes,
+                                         const std::vector<AudioConnection> &connections)
+{
+    std::unordered_map<std::string, int> inDegree;
+    std::unordered_map<std::string, std::vector<std::string>> outgoing;
+    std::vector<std::string> ready;
+    std::vector<std::string> result;
+
+    // Calculate in-degrees
+    for (const auto &node : nodes)
+    {
+        inDegree[node->getId()] = 0;
+    }
+
+    for (const auto &conn : connections)
+    {
+        inDegree[conn.destNodeId]++;
+        outgoing[conn.sourceNodeId].push_back(conn.destNodeId);
+    }
+
+    // Find nodes with no incoming edges, first-added node on top
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it)
+    {
+        if (inDegree[(*it)->getId()] == 0)
+        {
+            ready.push_back((*it)->getId());
+        }
+    }
+
+    // Process nodes
+    while (!ready.empty())
+    {
+        std::string current = ready.back();
+        ready.pop_back();
+        result.push_back(current);
+
+        // Remove outgoing edges
+        auto edges = outgoing.find(current);
+        if (edges == outgoing.end())
+            continue;
+
+        for (auto it = edges->second.rbegin(); it != edges->second.rend(); ++it)
+        {
+            if (--inDegree[*it] == 0)
+            {
+                ready.push_back(*it);
+            }
+        }
+    }
+
+    return result;
+}
+
+} // namespace
+
 // AudioNode implementation
 AudioNode::AudioNode(Type type, std::string id) : id_(std::move(id)), type_(type) {}
 
-void AudioNode::setAutomationLane(const std::string &paramId, std::shared_ptr<AutomationLane> lane)
+void AudioNode::setAutomationLane(ParameterId paramId, std::shared_ptr<AutomationLane> lane)
 {
     std::lock_guard<std::mutex> lock(automationMutex_);
     automationLanes_[paramId] = lane;
 }
 
-std::shared_ptr<AutomationLane> AudioNode::getAutomationLane(const std::string &paramId) const
+std::shared_ptr<AutomationLane> AudioNode::getAutomationLane(ParameterId paramId) const
 {
     std::lock_guard<std::mutex> lock(automationMutex_);
     auto it = automationLanes_.find(paramId);
     return (it != automationLanes_.end()) ? it->second : nullptr;
 }
 
+std::vector<std::pair<ParameterId, std::shared_ptr<AutomationLane>>>
+AudioNode::getAutomationLanes() const
+{
+    std::lock_guard<std::mutex> lock(automationMutex_);
+    return {automationLanes_.begin(), automationLanes_.end()};
+}
+
+int AudioNode::getParameterIndex(ParameterId paramId) const
+{
+    if (!paramId.isValid())
+        return -1;
+
+    // Graph compile time only: compares names
+    const auto &name = paramId.name();
+    const auto parameters = getParameters();
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        if (parameters[i].id == name)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void AudioNode::bindAutomation(int parameterIndex, const AutomationLane *lane) noexcept
+{
+    if (parameterIndex >= 0 && parameterIndex < kMaxAutomatedParameters)
+        automationBindings_[static_cast<size_t>(parameterIndex)].store(lane,
+                                                                      std::memory_order_release);
+}
+
+const AutomationSnapshot *AudioNode::getAutomationSnapshot(int parameterIndex) const noexcept
+{
+    if (parameterIndex < 0 || parameterIndex >= kMaxAutomatedParameters)
+        return nullptr;
+
+    const auto *lane =
+        automationBindings_[static_cast<size_t>(parameterIndex)].load(std::memory_order_acquire);
+    if (lane == nullptr)
+        return nullptr;
+
+    const auto *snapshot = lane->getSnapshot();
+    return (snapshot != nullptr && !snapshot->points.empty()) ? snapshot : nullptr;
+}
+
+float AudioNode::getAutomatedValue(int parameterIndex, SampleCount position,
+                                   float staticValue) noexcept
+{
+    if (parameterIndex < 0 || parameterIndex >= kMaxAutomatedParameters)
+        return staticValue;
+
+    const auto *lane =
+        automationBindings_[static_cast<size_t>(parameterIndex)].load(std::memory_order_acquire);
+    if (lane == nullptr)
+        return staticValue;
+
+    float value = staticValue;
+    if (auto *recorder = lane->getActiveRecorder(); recorder && recorder->capture(position, value))
+        return value;
+
+    const auto *snapshot = lane->getSnapshot();
+    if (snapshot == nullptr || snapshot->points.empty())
+        return staticValue;
+    return snapshot->getValueAt(automationCursors_[static_cast<size_t>(parameterIndex)], position);
+}
+
 // AudioGraph implementation
 AudioGraph::AudioGraph() : impl_(std::make_unique<GraphImpl>()) {}
 
-AudioGraph::~AudioGraph() = default;
+AudioGraph::~AudioGraph()
+{
+    {
+        std::lock_guard<std::mutex> lock(builderMutex_);
+        stopBuilder_ = true;
+    }
+    builderCondition_.notify_all();
+    if (builderThread_.joinable())
+        builderThread_.join();
+
+    delete activePlan_;
+    delete incomingPlan_;
+    delete pendingPlan_.load(std::memory_order_acquire);
+    freeRetiredPlans();
+}
+
+void AudioGraph::beginUpdate()
+{
+    std::lock_guard<std::mutex> lock(graphMutex_);
+    ++updateDepth_;
+}
+
+void AudioGraph::endUpdate()
+{
+    std::lock_guard<std::mutex> lock(graphMutex_);
+    if (updateDepth_ > 0 && --updateDepth_ == 0)
+        rebuildPlan();
+}
+
+void AudioGraph::rebuildPlan()
+{
+    if (updateDepth_ > 0)
+        return;
+
+    impl_->processingOrder = topologicalSort(impl_->nodes, impl_->connections);
+
+    // Compile against the user graph plus any delay nodes latency compensation adds
+    auto request = std::make_unique<BuildRequest>();
+    request->nodes = impl_->nodes;
+    request->connections = impl_->connections;
+    request->processingOrder = impl_->processingOrder;
+    request->outputNodeId = resolveOutputNode();
+    if (compensateLatency(request->nodes, request->connections, request->outputNodeId))
+        request->processingOrder = topologicalSort(request->nodes, request->connections);
+    request->blockSize = samplesPerBlock_;
+    request->threadPool = threadPool_.get();
+
+    {
+        std::lock_guard<std::mutex> lock(builderMutex_);
+        buildRequest_ = std::move(request);
+        ++requestedBuild_;
+        if (!builderThread_.joinable())
+            builderThread_ = std::thread([this] { runBuilder(); });
+    }
+    builderCondition_.notify_all();
+}
+
+void AudioGraph::runBuilder()
+{
+    std::unique_lock<std::mutex> lock(builderMutex_);
+    for (;;)
+    {
+        builderCondition_.wait(lock, [this] { return stopBuilder_ || buildRequest_; });
+        if (stopBuilder_)
+            return;
+
+        const auto request = std::move(buildRequest_);
+        const auto build = requestedBuild_;
+        lock.unlock();
+
+        // Free the plans the audio thread retired since the previous compile
+        freeRetiredPlans();
+
+        auto plan = GraphCompiler::compile(request->nodes, request->connections,
+                                           request->processingOrder, request->blockSize,
+                                           request->threadPool, request->outputNodeId);
+
+        PlanInfo info;
+        info.numSteps = static_cast<int>(plan->steps.size());
+        info.numBufferSlots = plan->numSlots;
+        info.bufferBytes = plan->slotMemory.size() * sizeof(float);
+        info.maxParallelism =
+            plan->criticalPathLength > 0.0f ? plan->totalWork / plan->criticalPathLength : 1.0f;
+
+        // A pending plan the audio thread never picked up can be freed right away.
+        // Its lanes were already bound to the nodes, so the new plan keeps them alive.
+        auto *published = plan.get();
+        std::unique_ptr<CompiledGraph> stale(
+            pendingPlan_.exchange(plan.release(), std::memory_order_acq_rel));
+        if (stale)
+            published->laneRefs.insert(published->laneRefs.end(), stale->laneRefs.begin(),
+                                       stale->laneRefs.end());
+
+        lock.lock();
+        planInfo_ = info;
+        publishedBuild_ = build;
+        builderCondition_.notify_all();
+    }
+}
+
+void AudioGraph::freeRetiredPlans()
+{
+    while (auto plan = retiredPlans_.tryPop())
+        delete *plan;
+}
+
+void AudioGraph::waitForPlan() const
+{
+    std::unique_lock<std::mutex> lock(builderMutex_);
+    builderCondition_.wait(lock, [this] { return publishedBuild_ == requestedBuild_; });
+}
+
+void AudioGraph::setPlanSwapFade(int numSamples)
+{
+    swapFadeSamples_.store(std::max(0, numSamples), std::memory_order_relaxed);
+}
+
+AudioGraph::PlanInfo AudioGraph::getPlanInfo() const
+{
+    waitForPlan();
+    std::lock_guard<std::mutex> lock(builderMutex_);
+    return planInfo_;
+}
+
+void AudioGraph::setNumProcessingThreads(int numThreads)
+{
+    std::lock_guard<std::mutex> lock(graphMutex_);
+
+    numThreads = std::max(1, numThreads);
+    if (numThreads == getNumProcessingThreadsLocked())
+        return;
+
+    // Audio is stopped, and the audio thread swaps in the pending plan before
+    // touching the active one, so the old pool is never used again once no
+    // compile is still planning for it.
+    waitForPlan();
+    threadPool_.reset();
+    if (numThreads > 1)
+        threadPool_ = std::make_unique<GraphThreadPool>(numThreads - 1);
+
+    rebuildPlan();
+}
+
+int AudioGraph::getNumProcessingThreads() const
+{
+    std::lock_guard<std::mutex> lock(graphMutex_);
+    return getNumProcessingThreadsLocked();
+}
+
+int AudioGraph::getNumProcessingThreadsLocked() const
+{
+    return threadPool_ ? threadPool_->getNumThreads() : 1;
+}
+
+AudioGraph::ParallelStats AudioGraph::getParallelStats() const
+{
+    std::lock_guard<std::mutex> lock(graphMutex_);
+
+    ParallelStats stats;
+    {
+        std::lock_guard<std::mutex> builderLock(builderMutex_);
+        stats.maxParallelism = planInfo_.maxParallelism;
+    }
+    if (threadPool_)
+    {
+        const auto poolStats = threadPool_->getStats();
+        stats.numThreads = poolStats.numThreads;
+        stats.speedup = poolStats.speedup;
+        stats.efficiency = poolStats.efficiency;
+    }
+    return stats;
+}
+
+std::shared_ptr<AudioNode> AudioGraph::findNode(const std::string &nodeId) const
+{
+    auto it = std::find_if(impl_->nodes.begin(), impl_->nodes.end(),
+                           [&nodeId](const std::shared_ptr<AudioNode> &node)
+                           { return node->getId() == nodeId; });
+    return (it != impl_->nodes.end()) ? *it : nullptr;
+}
+
+std::string AudioGraph::resolveOutputNode() const
+{
+    if (findNode(impl_->outputNodeId))
+        return impl_->outputNodeId;
+
+    // Otherwise the newest sink: added order, unlike sort order, is stable
+    std::unordered_set<std::string> sources;
+    for (const auto &conn : impl_->connections)
+        sources.insert(conn.sourceNodeId);
+
+    for (auto it = impl_->nodes.rbegin(); it != impl_->nodes.rend(); ++it)
+    {
+        if (sources.count((*it)->getId()) == 0)
+            return (*it)->getId();
+    }
+    return {};
+}
+
+void AudioGraph::setOutputNode(const std::string &nodeId)
+{
+    std::lock_guard<std::mutex> lock(graphMutex_);
+    if (impl_->outputNodeId == nodeId)
+        return;
+
+    impl_->outputNodeId = nodeId;
+    rebuildPlan();
+}
+
+std::string AudioGraph::getOutputNode() const
+{
+    std::lock_guard<std::mutex> lock(graphMutex_);
+    return impl_->outputNodeId;
+}
 
 void AudioGraph::addNode(std::shared_ptr<AudioNode> node)
 {
@@ -46,7 +419,7 @@ void AudioGraph::addNode(std::shared_ptr<AudioNode> node)
 
     std::lock_guard<std::mutex> lock(graphMutex_);
     impl_->nodes.push_back(node);
-    impl_->needsReorder = true;
+    rebuildPlan();
 }
 
 void AudioGraph::removeNode(const std::string &nodeId)
@@ -66,16 +439,13 @@ void AudioGraph::removeNode(const std::string &nodeId)
                                       { return node->getId() == nodeId; }),
                        impl_->nodes.end());
 
-    impl_->needsReorder = true;
+    rebuildPlan();
 }
 
 std::shared_ptr<AudioNode> AudioGraph::getNode(const std::string &nodeId)
 {
     std::lock_guard<std::mutex> lock(graphMutex_);
-    auto it = std::find_if(impl_->nodes.begin(), impl_->nodes.end(),
-                           [&nodeId](const std::shared_ptr<AudioNode> &node)
-                           { return node->getId() == nodeId; });
-    return (it != impl_->nodes.end()) ? *it : nullptr;
+    return findNode(nodeId);
 }
 
 std::vector<std::shared_ptr<AudioNode>> AudioGraph::getAllNodes() const
@@ -92,8 +462,8 @@ bool AudioGraph::addConnection(const AudioConnection &connection)
     std::lock_guard<std::mutex> lock(graphMutex_);
 
     // Check if nodes exist
-    auto sourceNode = getNode(connection.sourceNodeId);
-    auto destNode = getNode(connection.destNodeId);
+    auto sourceNode = findNode(connection.sourceNodeId);
+    auto destNode = findNode(connection.destNodeId);
     if (!sourceNode || !destNode)
         return false;
 
@@ -103,14 +473,15 @@ bool AudioGraph::addConnection(const AudioConnection &connection)
         if (conn.sourceNodeId == connection.sourceNodeId &&
             conn.destNodeId == connection.destNodeId &&
             conn.sourceChannel == connection.sourceChannel &&
-            conn.destChannel == connection.destChannel)
+            conn.destChannel == connection.destChannel &&
+            conn.sidechain == connection.sidechain)
         {
             return false; // Already exists
         }
     }
 
     impl_->connections.push_back(connection);
-    impl_->needsReorder = true;
+    rebuildPlan();
     return true;
 }
 
@@ -124,152 +495,296 @@ bool AudioGraph::removeConnection(const AudioConnection &connection)
                                return conn.sourceNodeId == connection.sourceNodeId &&
                                       conn.destNodeId == connection.destNodeId &&
                                       conn.sourceChannel == connection.sourceChannel &&
-                                      conn.destChannel == connection.destChannel;
+                                      conn.destChannel == connection.destChannel &&
+                                      conn.sidechain == connection.sidechain;
                            });
 
     if (it != impl_->connections.end())
     {
         impl_->connections.erase(it);
-        impl_->needsReorder = true;
+        rebuildPlan();
         return true;
     }
 
     return false;
 }
 
-std::vector<AudioConnection> AudioGraph::getConnections() const
+void AudioGraph::setAutomationLane(const std::string &nodeId, const std::string &paramId,
+                                   std::shared_ptr<AutomationLane> lane)
 {
     std::lock_guard<std::mutex> lock(graphMutex_);
-    return impl_->connections;
+
+    auto node = findNode(nodeId);
+    if (!node)
+        return;
+
+    // Lanes are bound by the compile; the binding is in place on return
+    node->setAutomationLane(paramId, std::move(lane));
+    rebuildPlan();
+    waitForPlan();
 }
 
-void AudioGraph::process(AudioBuffer &input, AudioBuffer &output, int numSamples,
-                         SampleCount position) noexcept
+void AudioGraph::setNodeBypassed(const std::string &nodeId, bool bypassed)
 {
     std::lock_guard<std::mutex> lock(graphMutex_);
 
-    if (impl_->needsReorder)
-    {
-        topologicalSort();
-        impl_->needsReorder = false;
-    }
+    auto node = findNode(nodeId);
+    if (!node || node->isBypassed() == bypassed)
+        return;
+
+    node->setBypassed(bypassed);
+    rebuildPlan();
+}
 
-    // Clear output buffer
-    output.clear();
+void AudioGraph::setNodeParameter(const std::string &nodeId, const std::string &paramId,
+                                  float value)
+{
+    std::lock_guard<std::mutex> lock(graphMutex_);
 
-    // Create temporary buffers for intermediate processing
-    std::vector<std::vector<float>> tempBuffers(impl_->nodes.size() * 2);
-    std::vector<float *> tempChannelPtrs;
+    auto node = findNode(nodeId);
+    if (!node)
+        return;
 
-    for (auto &buffer : tempBuffers)
+    node->setParameterValue(paramId, value);
+    if (hasLatencyChanged())
+        rebuildPlan();
+}
+
+std::vector<AudioConnection> AudioGraph::getConnections() const
+{
+    std::lock_guard<std::mutex> lock(graphMutex_);
+    return impl_->connections;
+}
+
+void AudioGraph::process(AudioBuffer &input, AudioBuffer &output, int numSamples,
+                         SampleCount position) noexcept
+{
+    // Pick up a newly compiled plan from the builder. It replaces one still
+    // waiting for a fade-out, and is swapped in right away without a fade.
+    if (auto *newPlan = pendingPlan_.exchange(nullptr, std::memory_order_acq_rel))
     {
-        buffer.resize(numSamples, 0.0f);
+        if (incomingPlan_ != nullptr)
+            retirePlan(incomingPlan_);
+        incomingPlan_ = newPlan;
+
+        // A fade already running continues from its current gain
+        if (fadeLength_ == 0 && activePlan_ != nullptr)
+        {
+            fadeLength_ = swapFadeSamples_.load(std::memory_order_relaxed);
+            fadePosition_ = fadeLength_;
+        }
+        if (fadeLength_ == 0)
+            swapInIncomingPlan();
     }
 
-    for (size_t i = 0; i < tempBuffers.size(); ++i)
+    if (activePlan_ == nullptr)
     {
-        tempChannelPtrs.push_back(tempBuffers[i].data());
+        output.clear();
+        return;
     }
 
-    // Process nodes in topological order
-    for (const auto &nodeId : impl_->processingOrder)
-    {
-        auto node = getNode(nodeId);
-        if (!node || node->isBypassed())
-            continue;
+    // Lanes keep the snapshots this block reads until it ends
+    automationReader_.beginBlock();
+    if (fadeLength_ > 0)
+        processWithSwapFade(input, output, numSamples, position);
+    else
+        activePlan_->process(input, output, numSamples, position);
+    automationReader_.endBlock();
+}
 
-        // Find input connections
-        AudioBuffer nodeInput;
-        AudioBuffer nodeOutput;
+void AudioGraph::swapInIncomingPlan() noexcept
+{
+    auto *old = activePlan_;
+    activePlan_ = incomingPlan_;
+    incomingPlan_ = nullptr;
 
-        // Setup input buffer
-        if (nodeId == "input")
-        {
-            nodeInput = input;
-        }
-        else
+    if (old != nullptr)
+        retirePlan(old);
+}
+
+void AudioGraph::retirePlan(CompiledGraph *plan) noexcept
+{
+    // Freeing a plan can run node destructors, so the builder does it. The
+    // queue is sized so this cannot fail (see retiredPlans_).
+    retiredPlans_.tryPush(plan);
+}
+
+// Runs the block in segments: the old plan ramping down to silence, the swap,
+// then the new plan ramping up. Every node still processes each sample once.
+// A crossfade would run both plans over the same samples, and since the new
+// plan reuses the old one's nodes, each shared node would see every sample
+// twice: filter and delay state advanced twice, automation cursors and
+// plugins fed out of order. That corrupts both signals, which is worse than
+// the dip, so the swap trades a short dip (2 x the fade) for clean state.
+void AudioGraph::processWithSwapFade(AudioBuffer &input, AudioBuffer &output, int numSamples,
+                                     SampleCount position) noexcept
+{
+    std::array<float *, CompiledGraph::kMaxChannels> inputChannels{};
+    std::array<float *, CompiledGraph::kMaxChannels> outputChannels{};
+    const int numInputChannels = std::min(input.numChannels, CompiledGraph::kMaxChannels);
+    const int numOutputChannels = std::min(output.numChannels, CompiledGraph::kMaxChannels);
+
+    int offset = 0;
+    while (offset < numSamples)
+    {
+        if (incomingPlan_ != nullptr && fadePosition_ == 0)
+            swapInIncomingPlan();
+
+        const bool fadingOut = incomingPlan_ != nullptr;
+        const bool fading = fadingOut || fadePosition_ < fadeLength_;
+        const int remaining = numSamples - offset;
+        const int length = !fading   ? remaining
+                           : fadingOut ? std::min(remaining, fadePosition_)
+                                       : std::min(remaining, fadeLength_ - fadePosition_);
+
+        for (int ch = 0; ch < numInputChannels; ++ch)
+            inputChannels[static_cast<size_t>(ch)] =
+                input.channels != nullptr && input.channels[ch] != nullptr
+                    ? input.channels[ch] + offset
+                    : nullptr;
+        for (int ch = 0; ch < numOutputChannels; ++ch)
+            outputChannels[static_cast<size_t>(ch)] =
+                output.channels[ch] != nullptr ? output.channels[ch] + offset : nullptr;
+
+        AudioBuffer inputView(input.channels != nullptr ? inputChannels.data() : nullptr,
+                              numInputChannels, length);
+        AudioBuffer outputView(outputChannels.data(), numOutputChannels, length);
+        activePlan_->process(inputView, outputView, length, position + offset);
+
+        if (!fading)
         {
-            // Sum inputs from connected nodes
-            int inputIdx = 0;
-            for (const auto &conn : impl_->connections)
-            {
-                if (conn.destNodeId == nodeId)
-                {
-                    auto sourceNode = getNode(conn.sourceNodeId);
-                    if (sourceNode)
-                    {
-                        // Find source node's buffer index
-                        auto sourceIt = std::find(impl_->processingOrder.begin(),
-                                                  impl_->processingOrder.end(), conn.sourceNodeId);
-                        if (sourceIt != impl_->processingOrder.end())
-                        {
-                            int sourceIdx = std::distance(impl_->processingOrder.begin(), sourceIt);
-                            AudioBuffer sourceBuffer(&tempChannelPtrs[sourceIdx * 2],
-                                                     sourceNode->getOutputChannelCount(),
-                                                     numSamples);
-
-                            if (inputIdx == 0)
-                            {
-                                nodeInput = sourceBuffer;
-                            }
-                            else
-                            {
-                                nodeInput.addFrom(sourceBuffer);
-                            }
-                        }
-                    }
-                    inputIdx++;
-                }
-            }
+            fadeLength_ = 0;
+            return;
         }
 
-        // Setup output buffer
-        auto nodeIt =
-            std::find(impl_->processingOrder.begin(), impl_->processingOrder.end(), nodeId);
-        if (nodeIt != impl_->processingOrder.end())
+        const float step = (fadingOut ? -1.0f : 1.0f) / static_cast<float>(fadeLength_);
+        const float start = static_cast<float>(fadePosition_) / static_cast<float>(fadeLength_);
+        for (int ch = 0; ch < numOutputChannels; ++ch)
         {
-            int nodeIdx = std::distance(impl_->processingOrder.begin(), nodeIt);
-            nodeOutput = AudioBuffer(&tempChannelPtrs[nodeIdx * 2], node->getOutputChannelCount(),
-                                     numSamples);
+            float *out = outputChannels[static_cast<size_t>(ch)];
+            if (out == nullptr)
+                continue;
+            for (int i = 0; i < length; ++i)
+                out[i] *= start + step * static_cast<float>(i);
         }
 
-        // Process the node
-        node->process(nodeInput, nodeOutput, numSamples, position);
+        fadePosition_ += fadingOut ? -length : length;
+        offset += length;
     }
 
-    // Copy final output (from output node or last processed node)
-    if (!impl_->processingOrder.empty())
-    {
-        auto lastNodeId = impl_->processingOrder.back();
-        auto lastNode = getNode(lastNodeId);
-        if (lastNode)
-        {
-            auto nodeIt =
-                std::find(impl_->processingOrder.begin(), impl_->processingOrder.end(), lastNodeId);
-            if (nodeIt != impl_->processingOrder.end())
-            {
-                int nodeIdx = std::distance(impl_->processingOrder.begin(), nodeIt);
-                AudioBuffer finalBuffer(&tempChannelPtrs[nodeIdx * 2],
-                                        lastNode->getOutputChannelCount(), numSamples);
-                output.copyFrom(finalBuffer);
-            }
-        }
-    }
+    if (incomingPlan_ == nullptr && fadePosition_ == fadeLength_)
+        fadeLength_ = 0;
 }
 
 void AudioGraph::updateLatencyCompensation()
 {
     std::lock_guard<std::mutex> lock(graphMutex_);
 
-    // Calculate total latency through the graph
-    totalLatency_ = 0;
+    // The new plan is swapped in atomically between blocks
+    if (hasLatencyChanged())
+        rebuildPlan();
+}
+
+bool AudioGraph::hasLatencyChanged() const
+{
     for (const auto &node : impl_->nodes)
     {
-        totalLatency_ = std::max(totalLatency_, node->getLatencySamples());
+        auto it = impl_->compensatedLatencies.find(node->getId());
+        if (it == impl_->compensatedLatencies.end() || it->second != effectiveLatency(*node))
+            return true;
     }
+    return false;
+}
+
+bool AudioGraph::compensateLatency(std::vector<std::shared_ptr<AudioNode>> &planNodes,
+                                   std::vector<AudioConnection> &planConnections,
+                                   const std::string &outputNodeId)
+{
+    // Latency arriving at each node (slowest input) and leaving it, in processing order
+    std::unordered_map<std::string, int> inputLatency;
+    std::unordered_map<std::string, int> outputLatency;
+    std::unordered_map<std::string, std::vector<std::string>> sources;
+
+    for (const auto &conn : impl_->connections)
+        sources[conn.destNodeId].push_back(conn.sourceNodeId);
+
+    impl_->compensatedLatencies.clear();
+    int totalLatency = 0;
+
+    for (const auto &nodeId : impl_->processingOrder)
+    {
+        auto node = findNode(nodeId);
+        if (!node)
+            continue;
+
+        int arrival = 0;
+        for (const auto &sourceId : sources[nodeId])
+            arrival = std::max(arrival, outputLatency[sourceId]);
+
+        const int latency = effectiveLatency(*node);
+        impl_->compensatedLatencies[nodeId] = latency;
+        inputLatency[nodeId] = arrival;
+        outputLatency[nodeId] = arrival + latency;
+
+        if (nodeId == outputNodeId)
+            totalLatency = arrival + latency;
+    }
+
+    totalLatency_.store(totalLatency, std::memory_order_release);
+
+    // Delay every edge that arrives ahead of the slowest input of its destination
+    std::unordered_map<std::string, std::shared_ptr<LatencyCompensatorNode>> used;
+    std::vector<AudioConnection> rewired;
+    rewired.reserve(planConnections.size());
 
-    // Update delay compensation nodes if needed
-    // This would involve inserting delay nodes to align all paths
+    for (const auto &conn : planConnections)
+    {
+        auto produced = outputLatency.find(conn.sourceNodeId);
+        auto required = inputLatency.find(conn.destNodeId);
+        const int delay = (produced != outputLatency.end() && required != inputLatency.end())
+                              ? required->second - produced->second
+                              : 0;
+        if (delay <= 0)
+        {
+            rewired.push_back(conn);
+            continue;
+        }
+
+        // A compensator of the running plan is reused only if it already has
+        // this delay: retuning it here would change the running plan before
+        // this one is published. Any other delay gets a new delay line, which
+        // joins the audio with the plan that needs it.
+        const auto key = edgeKey(conn);
+        const int channels = findNode(conn.sourceNodeId)->getOutputChannelCount();
+        auto existing = impl_->compensators.find(key);
+        std::shared_ptr<LatencyCompensatorNode> compensator;
+        if (existing != impl_->compensators.end() && existing->second->getDelaySamples() == delay &&
+            existing->second->getOutputChannelCount() == channels)
+        {
+            compensator = existing->second;
+        }
+        else
+        {
+            compensator = std::make_shared<LatencyCompensatorNode>("pdc:" + key);
+            compensator->setInputChannelCount(channels);
+            compensator->setOutputChannelCount(channels);
+            compensator->setMaxDelaySamples(juce::nextPowerOfTwo(delay));
+            compensator->setDelaySamples(delay);
+            compensator->prepareToPlay(sampleRate_, samplesPerBlock_);
+        }
+
+        planNodes.push_back(compensator);
+        rewired.push_back(AudioConnection{conn.sourceNodeId, compensator->getId(),
+                                          conn.sourceChannel, -1});
+        rewired.push_back(AudioConnection{compensator->getId(), conn.destNodeId, -1,
+                                          conn.destChannel, conn.sidechain});
+        used[key] = compensator;
+    }
+
+    // Compensators for edges that no longer need delay are released with the old plan
+    impl_->compensators = std::move(used);
+    planConnections = std::move(rewired);
+    return !impl_->compensators.empty();
 }
 
 bool AudioGraph::isValid() const
@@ -346,7 +861,15 @@ void AudioGraph::prepareToPlay(double sampleRate, int samplesPerBlock)
         node->prepareToPlay(sampleRate, samplesPerBlock);
     }
 
-    updateLatencyCompensation();
+    for (auto &entry : impl_->compensators)
+    {
+        entry.second->prepareToPlay(sampleRate, samplesPerBlock);
+    }
+
+    // Slot buffers are sized to the block size; node latencies may have changed.
+    // Playback starts on the new plan.
+    rebuildPlan();
+    waitForPlan();
 }
 
 void AudioGraph::reset()
@@ -357,6 +880,11 @@ void AudioGraph::reset()
     {
         node->reset();
     }
+
+    for (auto &entry : impl_->compensators)
+    {
+        entry.second->reset();
+    }
 }
 
 AudioGraph::GraphState AudioGraph::getState() const
@@ -383,58 +911,7 @@ void AudioGraph::setState(const GraphState &state)
 
     // Restore connections (nodes would need to be recreated by caller)
     impl_->connections = state.connections;
-    impl_->needsReorder = true;
-}
-
-void AudioGraph::topologicalSort()
-{
-    // Kahn's algorithm for topological sorting
-    std::unordered_map<std::string, int> inDegree;
-    std::queue<std::string> queue;
-    std::vector<std::string> result;
-
-    // Calculate in-degrees
-    for (const auto &node : impl_->nodes)
-    {
-        inDegree[node->getId()] = 0;
-    }
-
-    for (const auto &conn : impl_->connections)
-    {
-        inDegree[conn.destNodeId]++;
-    }
-
-    // Find nodes with no incoming edges
-    for (const auto &pair : inDegree)
-    {
-        if (pair.second == 0)
-        {
-            queue.push(pair.first);
-        }
-    }
-
-    // Process nodes
-    while (!queue.empty())
-    {
-        std::string current = queue.front();
-        queue.pop();
-        result.push_back(current);
-
-        // Remove outgoing edges
-        for (const auto &conn : impl_->connections)
-        {
-            if (conn.sourceNodeId == current)
-            {
-                inDegree[conn.destNodeId]--;
-                if (inDegree[conn.destNodeId] == 0)
-                {
-                    queue.push(conn.destNodeId);
-                }
-            }
-        }
-    }
-
-    impl_->processingOrder = result;
+    rebuildPlan();
 }
 
 std::vector<std::string> AudioGraph::getProcessingOrder() const
@@ -1,21 +1,31 @@
 #pragma once
 
 #include "util/Types.hpp"
+#include "engine/graph/Automation.hpp"
+#include "engine/graph/ParameterId.hpp"
+#include "util/LockFreeQueue.hpp"
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 
 namespace ampl {
 
 // Forward declarations
 class AudioGraph;
 struct AutomationLane;
+struct AutomationSnapshot;
 struct AudioBuffer;
+struct CompiledGraph;
+class GraphThreadPool;
 
 // Parameter definition for automation
 struct ParameterInfo {
@@ -37,6 +47,7 @@ public:
         Gain,
         EQ,
         Compressor,
+        Limiter,
         Plugin,
         Mixer,
         Automation,
@@ -60,6 +71,34 @@ public:
     int getInputChannelCount() const { return inputChannels_; }
     int getOutputChannelCount() const { return outputChannels_; }
 
+    // True if process() tolerates output channels aliasing input channels.
+    // The graph compiler then lets the node overwrite its input buffer.
+    virtual bool canProcessInPlace() const { return false; }
+
+    // Memoryless per-channel gain stages (gain, pan, mute). The graph compiler
+    // fuses chains of them into one gain kernel and calls computeChannelGains()
+    // instead of process().
+    virtual bool isLinearGainStage() const { return false; }
+
+    // Advances parameter smoothing by one block and writes the gain applied to
+    // each of the first numChannels channels.
+    virtual void computeChannelGains(SampleCount position, float* gains, int numChannels) noexcept {
+        (void)position;
+        std::fill(gains, gains + numChannels, 1.0f);
+    }
+
+    // Nodes that take a sidechain input (a second signal keying their
+    // processing, e.g. a compressor ducked by another track). The graph routes
+    // a sidechain connection to processWithSidechain() instead of process();
+    // sidechain connections into other nodes are ignored.
+    virtual bool acceptsSidechain() const { return false; }
+    virtual void processWithSidechain(AudioBuffer& input, const AudioBuffer& sidechain,
+                                      AudioBuffer& output, int numSamples,
+                                      SampleCount position) noexcept {
+        (void)sidechain;
+        process(input, output, numSamples, position);
+    }
+
     // Latency management
     virtual int getLatencySamples() const { return latencySamples_; }
     void setLatencySamples(int latency) { latencySamples_ = latency; }
@@ -69,9 +108,44 @@ public:
     virtual float getParameterValue(const std::string& paramId) const { (void)paramId; return 0.0f; }
     virtual void setParameterValue(const std::string& paramId, float value) { (void)paramId; (void)value; }
 
-    // Automation
-    void setAutomationLane(const std::string& paramId, std::shared_ptr<AutomationLane> lane);
-    std::shared_ptr<AutomationLane> getAutomationLane(const std::string& paramId) const;
+    // Interned parameter access (see ParameterId), for the hot paths. Built-in
+    // nodes implement these and forward the string overloads to them; by
+    // default they forward to the string overloads.
+    virtual float getParameter(ParameterId paramId) const { return getParameterValue(paramId.name()); }
+    virtual void setParameter(ParameterId paramId, float value) { setParameterValue(paramId.name(), value); }
+
+    // Index of a parameter in getParameters(), or -1
+    virtual int getParameterIndex(ParameterId paramId) const;
+    int getParameterIndex(const std::string& paramId) const {
+        return getParameterIndex(ParameterId::find(paramId));
+    }
+
+    // Automation. Lanes are bound to parameter indices when the graph is
+    // compiled; AudioGraph::setAutomationLane() attaches and recompiles.
+    void setAutomationLane(ParameterId paramId, std::shared_ptr<AutomationLane> lane);
+    void setAutomationLane(const std::string& paramId, std::shared_ptr<AutomationLane> lane) {
+        setAutomationLane(ParameterId::intern(paramId), std::move(lane));
+    }
+    std::shared_ptr<AutomationLane> getAutomationLane(ParameterId paramId) const;
+    std::shared_ptr<AutomationLane> getAutomationLane(const std::string& paramId) const {
+        return getAutomationLane(ParameterId::find(paramId));
+    }
+    std::vector<std::pair<ParameterId, std::shared_ptr<AutomationLane>>> getAutomationLanes() const;
+
+    static constexpr int kMaxAutomatedParameters = 32;
+
+    // Graph compiler: binds a lane (or nullptr) to a parameter index. Wrapper
+    // nodes forward the binding to the node they wrap.
+    virtual void bindAutomation(int parameterIndex, const AutomationLane* lane) noexcept;
+
+    // Audio thread: points of the non-empty lane bound to a parameter index, or null
+    const AutomationSnapshot* getAutomationSnapshot(int parameterIndex) const noexcept;
+
+    // Audio thread: a parameter's value for the block at position. The live
+    // control value while its lane is being written (and recorded), else the
+    // lane's value, else staticValue. Reads the lane through the parameter's
+    // own cursor, so block-by-block playback does no search.
+    float getAutomatedValue(int parameterIndex, SampleCount position, float staticValue) noexcept;
 
     // State management
     virtual void prepareToPlay(double sampleRate, int samplesPerBlock) { (void)sampleRate; (void)samplesPerBlock; }
@@ -89,8 +163,15 @@ protected:
     int latencySamples_{0};
     std::atomic<bool> bypassed_{false};
 
-    std::unordered_map<std::string, std::shared_ptr<AutomationLane>> automationLanes_;
+    std::unordered_map<ParameterId, std::shared_ptr<AutomationLane>> automationLanes_;
     mutable std::mutex automationMutex_;
+
+    // Lanes resolved by parameter index; kept alive by the compiled plan
+    std::array<std::atomic<const AutomationLane*>, kMaxAutomatedParameters> automationBindings_{};
+
+    // Audio thread: read positions in the bound lanes. A node is processed by
+    // one worker at a time, so each cursor has a single reader.
+    std::array<AutomationCursor, kMaxAutomatedParameters> automationCursors_{};
 };
 
 // Audio buffer wrapper for graph processing
@@ -118,7 +199,7 @@ struct AudioBuffer {
             return;
 
         for (int ch = 0; ch < numChannels; ++ch) {
-            if (channels[ch] && other.channels[ch]) {
+            if (channels[ch] && other.channels[ch] && channels[ch] != other.channels[ch]) {
                 juce::FloatVectorOperations::copy(channels[ch], other.channels[ch], numSamples);
             }
         }
@@ -142,6 +223,7 @@ struct AudioConnection {
     std::string destNodeId;
     int sourceChannel{-1};  // -1 for all channels
     int destChannel{-1};    // -1 for all channels
+    bool sidechain{false};  // Feeds the destination's sidechain input
 
     bool isValid() const {
         return !sourceNodeId.empty() && !destNodeId.empty();
@@ -165,13 +247,75 @@ public:
     bool removeConnection(const AudioConnection& connection);
     std::vector<AudioConnection> getConnections() const;
 
-    // Processing
+    // The node whose output is the graph output. Without one, the most
+    // recently added node that feeds no other node is used; set it whenever
+    // the graph has other sinks (meters, analyzers) that could be mistaken
+    // for the output.
+    void setOutputNode(const std::string& nodeId);
+    std::string getOutputNode() const;
+
+    // Attach an automation lane to a node's parameter and recompile
+    void setAutomationLane(const std::string& nodeId, const std::string& paramId,
+                           std::shared_ptr<AutomationLane> lane);
+
+    // Bypass a node and recompile, which splices it out of the plan.
+    // AudioNode::setBypassed() alone takes effect without recompiling.
+    void setNodeBypassed(const std::string& nodeId, bool bypassed);
+
+    // Set a node parameter. Recompiles if the change moved the node's reported
+    // latency (a compressor's look-ahead, say), so every path stays aligned.
+    void setNodeParameter(const std::string& nodeId, const std::string& paramId, float value);
+
+    // Batch edits: the execution plan is recompiled once, on the outermost endUpdate()
+    void beginUpdate();
+    void endUpdate();
+
+    // Edits return without waiting for the compiler: the new plan is built on
+    // a builder thread, reusing the node instances (and their DSP state), and
+    // the audio thread swaps it in between blocks. Blocks until every edit so
+    // far is compiled and published.
+    void waitForPlan() const;
+
+    // Optional fade on plan swaps: the old plan's output fades out over this
+    // many samples and the new plan's fades in, so a routing change never
+    // jumps. It dips to silence rather than crossfading: the plans share
+    // their node instances, so running both would process those nodes twice
+    // per sample. 0, the default, swaps on the block boundary.
+    void setPlanSwapFade(int numSamples);
+
+    // Processing (audio thread) - runs the last published plan without locking
     void process(AudioBuffer& input, AudioBuffer& output,
                 int numSamples, SampleCount position) noexcept;
 
-    // Latency compensation
+    // Diagnostics for the most recently compiled plan. Waits for pending edits.
+    struct PlanInfo {
+        int numSteps{0};
+        int numBufferSlots{0};   // After liveness-based slot reuse
+        size_t bufferBytes{0};
+        float maxParallelism{1.0f}; // Total work / critical path (parallel plans)
+    };
+    PlanInfo getPlanInfo() const;
+
+    // Parallel processing. 1 runs the plan serially on the audio thread; N > 1
+    // spreads independent nodes over the audio thread plus N - 1 workers.
+    // Call while audio processing is stopped, like prepareToPlay().
+    void setNumProcessingThreads(int numThreads);
+    int getNumProcessingThreads() const;
+
+    struct ParallelStats {
+        int numThreads{1};
+        float maxParallelism{1.0f}; // Upper bound on speedup for this graph
+        float speedup{1.0f};        // Measured node time / wall time per block
+        float efficiency{1.0f};     // speedup / numThreads
+    };
+    ParallelStats getParallelStats() const;
+
+    // Latency compensation. Every compile measures the latency along each path
+    // and delays the shorter inputs of a node so all of them arrive aligned.
+    // Call after a node's reported latency or bypass state changed; the graph
+    // is re-planned only if something differs from the last compile.
     void updateLatencyCompensation();
-    int getTotalLatency() const { return totalLatency_; }
+    int getTotalLatency() const { return totalLatency_.load(std::memory_order_acquire); }
 
     // Graph validation
     bool isValid() const;
@@ -199,15 +343,67 @@ private:
     std::vector<AudioConnection> connections_;
     std::unordered_map<std::string, std::vector<AudioConnection>> nodeConnections_;
 
-    int totalLatency_{0};
+    std::atomic<int> totalLatency_{0};
     double sampleRate_{44100.0};
     int samplesPerBlock_{512};
 
     mutable std::mutex graphMutex_;
 
-    void topologicalSort();
+    // Compiled execution plan, published builder thread -> audio thread.
+    // The audio thread hands every plan it drops back through retiredPlans_,
+    // which the builder drains before each compile; it never frees one itself.
+    // Between two drains the builder publishes one plan, so at most three
+    // plans (active, incoming and the one pending at the drain) are retired:
+    // the queue cannot fill.
+    std::atomic<CompiledGraph*> pendingPlan_{nullptr};
+    CompiledGraph* activePlan_{nullptr};
+    LockFreeQueue<CompiledGraph*, 8> retiredPlans_;
+    AutomationReader automationReader_;  // Brackets each block's automation reads
+    int updateDepth_{0};
+    std::unique_ptr<GraphThreadPool> threadPool_;
+
+    // Plan building. An edit queues a request (a snapshot of the compiler's
+    // inputs); the builder thread compiles the latest one and publishes it.
+    // A request not yet started is replaced, so a burst of edits compiles once.
+    struct BuildRequest;
+    std::unique_ptr<BuildRequest> buildRequest_;
+    uint64_t requestedBuild_{0};
+    uint64_t publishedBuild_{0};
+    bool stopBuilder_{false};
+    PlanInfo planInfo_;
+    mutable std::mutex builderMutex_; // Guards the request, build counters and planInfo_
+    mutable std::condition_variable builderCondition_;
+    std::thread builderThread_;
+
+    // Audio thread: a plan waiting for the old one to fade out, and the fade.
+    // fadePosition_ / fadeLength_ is the gain on the running plan's output.
+    std::atomic<int> swapFadeSamples_{0};
+    CompiledGraph* incomingPlan_{nullptr};
+    int fadeLength_{0}; // 0 while no fade is running
+    int fadePosition_{0};
+
+    // Call with graphMutex_ held
+    void rebuildPlan();
+    std::shared_ptr<AudioNode> findNode(const std::string& nodeId) const;
+    std::string resolveOutputNode() const;
+    bool hasLatencyChanged() const;
+    int getNumProcessingThreadsLocked() const;
+    bool compensateLatency(std::vector<std::shared_ptr<AudioNode>>& planNodes,
+                           std::vector<AudioConnection>& planConnections,
+                           const std::string& outputNodeId);
+
     std::vector<std::string> getProcessingOrder() const;
     bool hasCycles() const;
+
+    // Builder thread
+    void runBuilder();
+    void freeRetiredPlans();
+
+    // Audio thread
+    void retirePlan(CompiledGraph* plan) noexcept;
+    void swapInIncomingPlan() noexcept;
+    void processWithSwapFade(AudioBuffer& input, AudioBuffer& output, int numSamples,
+                             SampleCount position) noexcept;
 };
 
 } // namespace ampl
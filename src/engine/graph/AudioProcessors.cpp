@@ -1,10 +1,94 @@
 #include "AudioProcessors.hpp"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <string>
 #include <juce_audio_basics/juce_audio_basics.h>
 
 namespace ampl {
 
+namespace {
+
+// Interned once at startup; parameter traffic compares these handles
+const ParameterId kGainId = ParameterId::intern("gain");
+const ParameterId kPanId = ParameterId::intern("pan");
+const ParameterId kMasterGainId = ParameterId::intern("masterGain");
+const ParameterId kMasterPanId = ParameterId::intern("masterPan");
+
+const ParameterId kThresholdId = ParameterId::intern("threshold");
+const ParameterId kRatioId = ParameterId::intern("ratio");
+const ParameterId kAttackId = ParameterId::intern("attack");
+const ParameterId kReleaseId = ParameterId::intern("release");
+const ParameterId kKneeId = ParameterId::intern("knee");
+const ParameterId kMakeupId = ParameterId::intern("makeup");
+const ParameterId kEnabledId = ParameterId::intern("enabled");
+const ParameterId kLookaheadId = ParameterId::intern("lookahead");
+const ParameterId kCeilingId = ParameterId::intern("ceiling");
+const ParameterId kDetectorId = ParameterId::intern("detector");
+
+// EQ band parameters: "band<i>_freq", "_gain", "_q", "_enabled"
+enum EQField { kEQFrequency, kEQGain, kEQQ, kEQEnabled, kNumEQFields };
+
+const std::array<std::array<ParameterId, kNumEQFields>, 4> kEQBandIds = [] {
+    std::array<std::array<ParameterId, kNumEQFields>, 4> ids;
+    for (int i = 0; i < 4; ++i) {
+        const std::string prefix = "band" + std::to_string(i) + "_";
+        ids[i][kEQFrequency] = ParameterId::intern(prefix + "freq");
+        ids[i][kEQGain] = ParameterId::intern(prefix + "gain");
+        ids[i][kEQQ] = ParameterId::intern(prefix + "q");
+        ids[i][kEQEnabled] = ParameterId::intern(prefix + "enabled");
+    }
+    return ids;
+}();
+
+int lookaheadSamples(float milliseconds, double sampleRate) {
+    return static_cast<int>(std::lround(milliseconds * 0.001 * sampleRate));
+}
+
+// Compressor and limiter: the input passes to the output (the engine works in
+// place) and through the dynamics, keyed by the sidechain when there is one
+void processDynamics(DynamicsEngine& dynamics, const AudioBuffer& input,
+                     const AudioBuffer* sidechain, AudioBuffer& output, int numSamples) noexcept {
+    for (int ch = 0; ch < output.numChannels; ++ch) {
+        float* out = output.channels[ch];
+        if (!out) {
+            continue;
+        }
+        const float* in = ch < input.numChannels ? input.channels[ch] : nullptr;
+        if (!in) {
+            juce::FloatVectorOperations::clear(out, numSamples);
+        } else if (in != out) {
+            juce::FloatVectorOperations::copy(out, in, numSamples);
+        }
+    }
+
+    const bool keyed = sidechain && sidechain->channels;
+    dynamics.process(output.channels, output.numChannels,
+                     keyed ? sidechain->channels : nullptr,
+                     keyed ? sidechain->numChannels : 0, numSamples);
+}
+
+// Block copies into and out of a ring buffer, as at most two segments. A null
+// source writes silence.
+void writeRing(float* ring, int size, int position, const float* source, int numSamples) noexcept {
+    const int first = std::min(numSamples, size - position);
+    if (source) {
+        std::memcpy(ring + position, source, static_cast<size_t>(first) * sizeof(float));
+        std::memcpy(ring, source + first, static_cast<size_t>(numSamples - first) * sizeof(float));
+    } else {
+        std::fill(ring + position, ring + position + first, 0.0f);
+        std::fill(ring, ring + numSamples - first, 0.0f);
+    }
+}
+
+void readRing(const float* ring, int size, int position, float* destination, int numSamples) noexcept {
+    const int first = std::min(numSamples, size - position);
+    std::memcpy(destination, ring + position, static_cast<size_t>(first) * sizeof(float));
+    std::memcpy(destination + first, ring, static_cast<size_t>(numSamples - first) * sizeof(float));
+}
+
+} // namespace
+
 // GainNode implementation
 GainNode::GainNode(const std::string& id) : AudioNode(Type::Gain, id) {
     setOutputChannelCount(2);
@@ -19,19 +103,25 @@ void GainNode::process(AudioBuffer& input, AudioBuffer& output,
         return;
     }
 
-    // Get automated values
-    float targetGain = gain_;
-    float targetPan = pan_;
+    std::array<float, kMaxGainChannels> gains;
+    const int numChannels = std::min({input.numChannels, output.numChannels, kMaxGainChannels});
+    computeChannelGains(position, gains.data(), numChannels);
 
-    auto gainLane = getAutomationLane("gain");
-    if (gainLane) {
-        targetGain = gainLane->getValueAt(position);
-    }
+    // Process samples
+    for (int ch = 0; ch < numChannels; ++ch) {
+        if (!input.channels[ch] || !output.channels[ch]) continue;
 
-    auto panLane = getAutomationLane("pan");
-    if (panLane) {
-        targetPan = panLane->getValueAt(position);
+        juce::FloatVectorOperations::multiply(output.channels[ch],
+                                            input.channels[ch],
+                                            gains[ch],
+                                            numSamples);
     }
+}
+
+void GainNode::computeChannelGains(SampleCount position, float* gains, int numChannels) noexcept {
+    // Get automated values
+    const float targetGain = getAutomatedValue(kGainParameter, position, gain_);
+    const float targetPan = getAutomatedValue(kPanParameter, position, pan_);
 
     // Smooth parameter changes
     gainSmoother_ = gainSmoother_ * kSmoothingCoeff + targetGain * (1.0f - kSmoothingCoeff);
@@ -45,18 +135,11 @@ void GainNode::process(AudioBuffer& input, AudioBuffer& output,
     float leftGain = std::cos(panAngle);
     float rightGain = std::sin(panAngle);
 
-    // Process samples
-    for (int ch = 0; ch < std::min(input.numChannels, output.numChannels); ++ch) {
-        if (!input.channels[ch] || !output.channels[ch]) continue;
-
+    for (int ch = 0; ch < numChannels; ++ch) {
         float channelGain = currentGain_;
         if (ch == 0) channelGain *= leftGain;
         if (ch == 1) channelGain *= rightGain;
-
-        juce::FloatVectorOperations::multiply(output.channels[ch],
-                                            input.channels[ch],
-                                            channelGain,
-                                            numSamples);
+        gains[ch] = channelGain;
     }
 }
 
@@ -68,14 +151,22 @@ std::vector<ParameterInfo> GainNode::getParameters() const {
 }
 
 float GainNode::getParameterValue(const std::string& paramId) const {
-    if (paramId == "gain") return gain_;
-    if (paramId == "pan") return pan_;
-    return 0.0f;
+    return getParameter(ParameterId::find(paramId));
 }
 
 void GainNode::setParameterValue(const std::string& paramId, float value) {
-    if (paramId == "gain") gain_ = std::clamp(value, 0.0f, 2.0f);
-    if (paramId == "pan") pan_ = std::clamp(value, -1.0f, 1.0f);
+    setParameter(ParameterId::find(paramId), value);
+}
+
+float GainNode::getParameter(ParameterId paramId) const {
+    if (paramId == kGainId) return gain_;
+    if (paramId == kPanId) return pan_;
+    return 0.0f;
+}
+
+void GainNode::setParameter(ParameterId paramId, float value) {
+    if (paramId == kGainId) gain_ = std::clamp(value, 0.0f, 2.0f);
+    if (paramId == kPanId) pan_ = std::clamp(value, -1.0f, 1.0f);
 }
 
 void GainNode::prepareToPlay(double sampleRate, int samplesPerBlock) {
@@ -93,10 +184,10 @@ EQNode::EQNode(const std::string& id) : AudioNode(Type::EQ, id) {
     setOutputChannelCount(2);
 
     // Initialize default EQ bands
-    bands_[0] = {80.0f, 0.0f, 1.0f, true};   // Low shelf
-    bands_[1] = {250.0f, 0.0f, 1.0f, true};  // Low-mid
-    bands_[2] = {1000.0f, 0.0f, 1.0f, true}; // Mid
-    bands_[3] = {8000.0f, 0.0f, 1.0f, true}; // High shelf
+    setBand(0, {80.0f, 0.0f, 1.0f, true});   // Low shelf
+    setBand(1, {250.0f, 0.0f, 1.0f, true});  // Low-mid
+    setBand(2, {1000.0f, 0.0f, 1.0f, true}); // Mid
+    setBand(3, {8000.0f, 0.0f, 1.0f, true}); // High shelf
 }
 
 void EQNode::process(AudioBuffer& input, AudioBuffer& output,
@@ -108,131 +199,157 @@ void EQNode::process(AudioBuffer& input, AudioBuffer& output,
         return;
     }
 
-    // Process each channel
-    for (int ch = 0; ch < std::min(input.numChannels, output.numChannels); ++ch) {
+    const int numChannels = std::min(input.numChannels, output.numChannels);
+    for (int ch = 0; ch < numChannels; ++ch) {
         if (!input.channels[ch] || !output.channels[ch]) continue;
 
-        // Copy input to output
-        juce::FloatVectorOperations::copy(output.channels[ch],
-                                        input.channels[ch],
-                                        numSamples);
-
-        // Apply each EQ band
-        for (auto& band : bands_) {
-            if (!band.enabled) continue;
-
-            for (int i = 0; i < numSamples; ++i) {
-                output.channels[ch][i] = processBiquad(band, output.channels[ch][i]);
-            }
+        // Copy input to output (skipped when processing in place)
+        if (output.channels[ch] != input.channels[ch]) {
+            juce::FloatVectorOperations::copy(output.channels[ch],
+                                            input.channels[ch],
+                                            numSamples);
         }
     }
+
+    const auto bands = getBlockBands(position);
+    if (bands != appliedBands_) {
+        updateFilters(bands, false);
+    }
+
+    filters_.process(output.channels, numChannels, numSamples);
+}
+
+EQNode::EQBand EQNode::getBand(int bandIndex) const {
+    const auto& band = bands_[static_cast<size_t>(bandIndex)];
+    return {band.frequency.load(std::memory_order_relaxed), band.gain.load(std::memory_order_relaxed),
+            band.q.load(std::memory_order_relaxed), band.enabled.load(std::memory_order_relaxed)};
+}
+
+void EQNode::setBand(int bandIndex, const EQBand& band) {
+    auto& target = bands_[static_cast<size_t>(bandIndex)];
+    target.frequency.store(std::clamp(band.frequency, 20.0f, 20000.0f), std::memory_order_relaxed);
+    target.gain.store(std::clamp(band.gain, -24.0f, 24.0f), std::memory_order_relaxed);
+    target.q.store(std::clamp(band.q, 0.1f, 10.0f), std::memory_order_relaxed);
+    target.enabled.store(band.enabled, std::memory_order_relaxed);
 }
 
 std::vector<ParameterInfo> EQNode::getParameters() const {
     std::vector<ParameterInfo> params;
     for (int i = 0; i < 4; ++i) {
+        const auto band = getBand(i);
         params.push_back({"band" + std::to_string(i) + "_freq", "Band " + std::to_string(i) + " Freq",
-                         20.0f, 20000.0f, bands_[i].frequency, true, "Hz"});
+                         20.0f, 20000.0f, band.frequency, true, "Hz"});
         params.push_back({"band" + std::to_string(i) + "_gain", "Band " + std::to_string(i) + " Gain",
-                         -24.0f, 24.0f, bands_[i].gain, true, "dB"});
+                         -24.0f, 24.0f, band.gain, true, "dB"});
         params.push_back({"band" + std::to_string(i) + "_q", "Band " + std::to_string(i) + " Q",
-                         0.1f, 10.0f, bands_[i].q, true, ""});
+                         0.1f, 10.0f, band.q, true, ""});
         params.push_back({"band" + std::to_string(i) + "_enabled", "Band " + std::to_string(i) + " Enable",
-                         0.0f, 1.0f, bands_[i].enabled ? 1.0f : 0.0f, true, ""});
+                         0.0f, 1.0f, band.enabled ? 1.0f : 0.0f, true, ""});
     }
     return params;
 }
 
 float EQNode::getParameterValue(const std::string& paramId) const {
+    return getParameter(ParameterId::find(paramId));
+}
+
+void EQNode::setParameterValue(const std::string& paramId, float value) {
+    setParameter(ParameterId::find(paramId), value);
+}
+
+float EQNode::getParameter(ParameterId paramId) const {
     for (int i = 0; i < 4; ++i) {
-        std::string prefix = "band" + std::to_string(i) + "_";
-        if (paramId == prefix + "freq") return bands_[i].frequency;
-        if (paramId == prefix + "gain") return bands_[i].gain;
-        if (paramId == prefix + "q") return bands_[i].q;
-        if (paramId == prefix + "enabled") return bands_[i].enabled ? 1.0f : 0.0f;
+        const auto& ids = kEQBandIds[i];
+        if (paramId == ids[kEQFrequency]) return bands_[i].frequency;
+        if (paramId == ids[kEQGain]) return bands_[i].gain;
+        if (paramId == ids[kEQQ]) return bands_[i].q;
+        if (paramId == ids[kEQEnabled]) return bands_[i].enabled ? 1.0f : 0.0f;
     }
     return 0.0f;
 }
 
-void EQNode::setParameterValue(const std::string& paramId, float value) {
+void EQNode::setParameter(ParameterId paramId, float value) {
     for (int i = 0; i < 4; ++i) {
-        std::string prefix = "band" + std::to_string(i) + "_";
-        if (paramId == prefix + "freq") {
+        const auto& ids = kEQBandIds[i];
+        if (paramId == ids[kEQFrequency]) {
             bands_[i].frequency = std::clamp(value, 20.0f, 20000.0f);
-            calculateBiquadCoeffs(bands_[i]);
-        }
-        if (paramId == prefix + "gain") {
+        } else if (paramId == ids[kEQGain]) {
             bands_[i].gain = std::clamp(value, -24.0f, 24.0f);
-            calculateBiquadCoeffs(bands_[i]);
-        }
-        if (paramId == prefix + "q") {
+        } else if (paramId == ids[kEQQ]) {
             bands_[i].q = std::clamp(value, 0.1f, 10.0f);
-            calculateBiquadCoeffs(bands_[i]);
-        }
-        if (paramId == prefix + "enabled") {
+        } else if (paramId == ids[kEQEnabled]) {
             bands_[i].enabled = value > 0.5f;
+        } else {
+            continue;
         }
+        return;
     }
 }
 
 void EQNode::prepareToPlay(double sampleRate, int samplesPerBlock) {
     sampleRate_ = sampleRate;
-    for (auto& band : bands_) {
-        calculateBiquadCoeffs(band);
-    }
+    filters_.setRampLength(static_cast<int>(sampleRate * kRampSeconds));
+    updateFilters({getBand(0), getBand(1), getBand(2), getBand(3)}, true);
+    filters_.reset();
 }
 
 void EQNode::reset() {
-    for (auto& band : bands_) {
-        band.z1 = 0.0f;
-        band.z2 = 0.0f;
-    }
+    filters_.reset();
 }
 
-void EQNode::calculateBiquadCoeffs(EQBand& band) {
-    double sampleRate = sampleRate_;
-    double omega = 2.0 * juce::MathConstants<double>::pi * band.frequency / sampleRate;
-    double sinOmega = std::sin(omega);
-    double cosOmega = std::cos(omega);
-
-    // Convert gain from dB to linear
-    double A = std::pow(10.0, band.gain / 40.0);
-    double alpha = sinOmega / (2.0 * band.q);
-
-    // Peaking EQ filter coefficients
-    band.b0 = 1.0 + alpha * A;
-    band.b1 = -2.0 * cosOmega;
-    band.b2 = 1.0 - alpha * A;
-    band.a0 = 1.0 + alpha / A;
-    band.a1 = -2.0 * cosOmega;
-    band.a2 = 1.0 - alpha / A;
-
-    // Normalize
-    band.b0 /= band.a0;
-    band.b1 /= band.a0;
-    band.b2 /= band.a0;
-    band.a1 /= band.a0;
-    band.a2 /= band.a0;
+std::array<EQNode::EQBand, 4> EQNode::getBlockBands(SampleCount position) noexcept {
+    // Parameter indices follow getParameters(): kNumEQFields per band
+    std::array<EQBand, 4> bands;
+    for (int i = 0; i < 4; ++i) {
+        const auto band = getBand(i);
+        const int first = i * kNumEQFields;
+        bands[i].frequency = std::clamp(getAutomatedValue(first + kEQFrequency, position, band.frequency),
+                                        20.0f, 20000.0f);
+        bands[i].gain = std::clamp(getAutomatedValue(first + kEQGain, position, band.gain), -24.0f, 24.0f);
+        bands[i].q = std::clamp(getAutomatedValue(first + kEQQ, position, band.q), 0.1f, 10.0f);
+        bands[i].enabled = getAutomatedValue(first + kEQEnabled, position, band.enabled ? 1.0f : 0.0f) > 0.5f;
+    }
+    return bands;
 }
 
-float EQNode::processBiquad(EQBand& band, float input) {
-    float output = band.b0 * input + band.b1 * band.z1 + band.b2 * band.z2
-                   - band.a1 * band.z1 - band.a2 * band.z2;
-
-    band.z2 = band.z1;
-    band.z1 = output;
+void EQNode::updateFilters(const std::array<EQBand, 4>& bands, bool immediate) noexcept {
+    appliedBands_ = bands;
 
-    return output;
+    for (int i = 0; i < 4; ++i) {
+        const auto& band = bands[i];
+        // Disabled bands ramp to identity rather than switching off
+        const auto coefficients = band.enabled
+            ? BiquadCoefficients::peaking(sampleRate_, band.frequency, band.gain, band.q)
+            : BiquadCoefficients{};
+
+        if (immediate) {
+            filters_.setCoefficientsImmediately(i, coefficients);
+        } else {
+            filters_.setCoefficients(i, coefficients);
+        }
+    }
 }
 
 // CompressorNode implementation
 CompressorNode::CompressorNode(const std::string& id) : AudioNode(Type::Compressor, id) {
     setOutputChannelCount(2);
-    rmsBuffer_.fill(0.0f);
 }
 
 void CompressorNode::process(AudioBuffer& input, AudioBuffer& output,
                            int numSamples, SampleCount position) noexcept {
+    (void)position;
+    run(input, nullptr, output, numSamples);
+}
+
+void CompressorNode::processWithSidechain(AudioBuffer& input, const AudioBuffer& sidechain,
+                                          AudioBuffer& output, int numSamples,
+                                          SampleCount position) noexcept {
+    (void)position;
+    run(input, &sidechain, output, numSamples);
+}
+
+void CompressorNode::run(AudioBuffer& input, const AudioBuffer* sidechain, AudioBuffer& output,
+                         int numSamples) noexcept {
     if (isBypassed() || !enabled_ || !input.channels || !output.channels) {
         if (input.channels && output.channels) {
             output.copyFrom(input);
@@ -240,57 +357,23 @@ void CompressorNode::process(AudioBuffer& input, AudioBuffer& output,
         return;
     }
 
-    // Copy input to output
-    for (int ch = 0; ch < std::min(input.numChannels, output.numChannels); ++ch) {
-        if (input.channels[ch] && output.channels[ch]) {
-            juce::FloatVectorOperations::copy(output.channels[ch],
-                                            input.channels[ch],
-                                            numSamples);
-        }
-    }
-
-    // Process left channel (or mono)
-    if (input.channels[0]) {
-        for (int i = 0; i < numSamples; ++i) {
-            float inputSample = input.channels[0][i];
-
-            // RMS detection
-            float rmsLevel = processRMS(inputSample);
-            float inputDb = juce::Decibels::gainToDecibels(rmsLevel + 0.0001f);
-
-            // Calculate gain reduction
-            float gainReductionDb = calculateGainReduction(inputDb);
-            float gainReductionLinear = juce::Decibels::decibelsToGain(gainReductionDb);
-
-            // Update envelope
-            float targetEnvelope = gainReductionLinear;
-            if (targetEnvelope < envelope_) {
-                envelope_ = envelope_ * attackCoeff_ + targetEnvelope * (1.0f - attackCoeff_);
-            } else {
-                envelope_ = envelope_ * releaseCoeff_ + targetEnvelope * (1.0f - releaseCoeff_);
-            }
-
-            // Apply gain reduction to all channels
-            for (int ch = 0; ch < output.numChannels; ++ch) {
-                if (output.channels[ch]) {
-                    output.channels[ch][i] *= envelope_;
-                }
-            }
-        }
-    }
-
-    // Apply makeup gain
-    float makeupGainValue = makeupGain_.load();
-    float makeupGainLinear = juce::Decibels::decibelsToGain(makeupGainValue);
-    for (int ch = 0; ch < output.numChannels; ++ch) {
-        if (output.channels[ch]) {
-            juce::FloatVectorOperations::multiply(output.channels[ch],
-                                                makeupGainLinear,
-                                                numSamples);
-        }
-    }
+    DynamicsEngine::Settings settings;
+    settings.thresholdDb = threshold_;
+    settings.ratio = ratio_;
+    settings.kneeDb = knee_;
+    settings.attackMs = attack_;
+    settings.releaseMs = release_;
+    settings.makeupDb = makeupGain_;
+    settings.detector = peakDetection_ ? DynamicsEngine::Detector::Peak
+                                       : DynamicsEngine::Detector::RMS;
+    dynamics_.setSettings(settings);
+    dynamics_.setLookahead(lookaheadSamples(lookahead_, sampleRate_));
+
+    processDynamics(dynamics_, input, sidechain, output, numSamples);
+}
 
-    gainReduction_ = juce::Decibels::gainToDecibels(envelope_);
+int CompressorNode::getLatencySamples() const {
+    return enabled_ ? lookaheadSamples(lookahead_, sampleRate_) : 0;
 }
 
 std::vector<ParameterInfo> CompressorNode::getParameters() const {
@@ -301,87 +384,284 @@ std::vector<ParameterInfo> CompressorNode::getParameters() const {
         {"release", "Release", 1.0f, 1000.0f, 50.0f, true, "ms"},
         {"knee", "Knee", 0.0f, 10.0f, 2.0f, true, "dB"},
         {"makeup", "Makeup", 0.0f, 24.0f, 0.0f, true, "dB"},
-        {"enabled", "Enabled", 0.0f, 1.0f, 1.0f, true, ""}
+        {"enabled", "Enabled", 0.0f, 1.0f, 1.0f, true, ""},
+        {"lookahead", "Lookahead", 0.0f, kMaxLookaheadMs, 0.0f, false, "ms"},
+        {"detector", "Detector", 0.0f, 1.0f, 0.0f, false, ""}   // 0 = RMS, 1 = peak
     };
 }
 
 float CompressorNode::getParameterValue(const std::string& paramId) const {
-    if (paramId == "threshold") return threshold_;
-    if (paramId == "ratio") return ratio_;
-    if (paramId == "attack") return attack_;
-    if (paramId == "release") return release_;
-    if (paramId == "knee") return knee_;
-    if (paramId == "makeup") return makeupGain_;
-    if (paramId == "enabled") return enabled_ ? 1.0f : 0.0f;
-    return 0.0f;
+    return getParameter(ParameterId::find(paramId));
 }
 
 void CompressorNode::setParameterValue(const std::string& paramId, float value) {
-    if (paramId == "threshold") {
+    setParameter(ParameterId::find(paramId), value);
+}
+
+float CompressorNode::getParameter(ParameterId paramId) const {
+    if (paramId == kThresholdId) return threshold_;
+    if (paramId == kRatioId) return ratio_;
+    if (paramId == kAttackId) return attack_;
+    if (paramId == kReleaseId) return release_;
+    if (paramId == kKneeId) return knee_;
+    if (paramId == kMakeupId) return makeupGain_;
+    if (paramId == kEnabledId) return enabled_ ? 1.0f : 0.0f;
+    if (paramId == kLookaheadId) return lookahead_;
+    if (paramId == kDetectorId) return peakDetection_ ? 1.0f : 0.0f;
+    return 0.0f;
+}
+
+void CompressorNode::setParameter(ParameterId paramId, float value) {
+    if (paramId == kThresholdId) {
         threshold_ = std::clamp(value, -60.0f, 0.0f);
-    } else if (paramId == "ratio") {
+    } else if (paramId == kRatioId) {
         ratio_ = std::clamp(value, 1.0f, 20.0f);
-    } else if (paramId == "attack") {
+    } else if (paramId == kAttackId) {
         attack_ = std::clamp(value, 0.1f, 100.0f);
-        updateCoefficients();
-    } else if (paramId == "release") {
+    } else if (paramId == kReleaseId) {
         release_ = std::clamp(value, 1.0f, 1000.0f);
-        updateCoefficients();
-    } else if (paramId == "knee") {
+    } else if (paramId == kKneeId) {
         knee_ = std::clamp(value, 0.0f, 10.0f);
-    } else if (paramId == "makeup") {
+    } else if (paramId == kMakeupId) {
         makeupGain_ = std::clamp(value, 0.0f, 24.0f);
-    } else if (paramId == "enabled") {
+    } else if (paramId == kEnabledId) {
         enabled_ = value > 0.5f;
+    } else if (paramId == kLookaheadId) {
+        // Changes the reported latency; see AudioGraph::setNodeParameter()
+        lookahead_ = std::clamp(value, 0.0f, kMaxLookaheadMs);
+    } else if (paramId == kDetectorId) {
+        peakDetection_ = value > 0.5f;
     }
 }
 
 void CompressorNode::prepareToPlay(double sampleRate, int samplesPerBlock) {
+    (void)samplesPerBlock;
     sampleRate_ = sampleRate;
-    updateCoefficients();
-    reset();
+    dynamics_.prepare(sampleRate, lookaheadSamples(kMaxLookaheadMs, sampleRate));
 }
 
 void CompressorNode::reset() {
-    envelope_ = 1.0f;
-    gainReduction_ = 0.0f;
-    rmsBuffer_.fill(0.0f);
-    rmsBufferPos_ = 0;
-    rmsSum_ = 0.0f;
+    dynamics_.reset();
 }
 
-void CompressorNode::updateCoefficients() {
-    double sampleRate = sampleRate_;
-    attackCoeff_ = std::exp(-1.0 / (sampleRate * attack_ * 0.001));
-    releaseCoeff_ = std::exp(-1.0 / (sampleRate * release_ * 0.001));
+// LimiterNode implementation
+LimiterNode::LimiterNode(const std::string& id) : AudioNode(Type::Limiter, id) {
+    setOutputChannelCount(2);
 }
 
-float CompressorNode::calculateGainReduction(float inputLevel) const {
-    float kneeHalf = knee_ * 0.5f;
+void LimiterNode::process(AudioBuffer& input, AudioBuffer& output,
+                          int numSamples, SampleCount position) noexcept {
+    (void)position;
+    if (isBypassed() || !enabled_ || !input.channels || !output.channels) {
+        if (input.channels && output.channels) {
+            output.copyFrom(input);
+        }
+        return;
+    }
 
-    // Soft knee calculation
-    if (inputLevel < threshold_ - kneeHalf) {
-        return 0.0f; // No compression
-    } else if (inputLevel > threshold_ + kneeHalf) {
-        // Above knee range
-        float slope = 1.0f - (1.0f / ratio_);
-        return slope * (inputLevel - threshold_);
-    } else {
-        // Within knee range
-        float kneeRatio = (inputLevel - (threshold_ - kneeHalf)) / knee_;
-        float slope = kneeRatio * (1.0f - (1.0f / ratio_));
-        return slope * (inputLevel - threshold_);
+    DynamicsEngine::Settings settings;
+    settings.thresholdDb = ceiling_;
+    settings.kneeDb = 0.0f;
+    settings.releaseMs = release_;
+    settings.detector = DynamicsEngine::Detector::Peak;
+    settings.brickwall = true;
+    dynamics_.setSettings(settings);
+    dynamics_.setLookahead(lookaheadSamples(lookahead_, sampleRate_));
+
+    processDynamics(dynamics_, input, nullptr, output, numSamples);
+}
+
+int LimiterNode::getLatencySamples() const {
+    return enabled_ ? lookaheadSamples(lookahead_, sampleRate_) : 0;
+}
+
+std::vector<ParameterInfo> LimiterNode::getParameters() const {
+    return {
+        {"ceiling", "Ceiling", -24.0f, 0.0f, -0.3f, true, "dB"},
+        {"release", "Release", 1.0f, 1000.0f, 100.0f, true, "ms"},
+        {"lookahead", "Lookahead", 0.0f, kMaxLookaheadMs, 2.0f, false, "ms"},
+        {"enabled", "Enabled", 0.0f, 1.0f, 1.0f, true, ""}
+    };
+}
+
+float LimiterNode::getParameterValue(const std::string& paramId) const {
+    return getParameter(ParameterId::find(paramId));
+}
+
+void LimiterNode::setParameterValue(const std::string& paramId, float value) {
+    setParameter(ParameterId::find(paramId), value);
+}
+
+float LimiterNode::getParameter(ParameterId paramId) const {
+    if (paramId == kCeilingId) return ceiling_;
+    if (paramId == kReleaseId) return release_;
+    if (paramId == kLookaheadId) return lookahead_;
+    if (paramId == kEnabledId) return enabled_ ? 1.0f : 0.0f;
+    return 0.0f;
+}
+
+void LimiterNode::setParameter(ParameterId paramId, float value) {
+    if (paramId == kCeilingId) {
+        ceiling_ = std::clamp(value, -24.0f, 0.0f);
+    } else if (paramId == kReleaseId) {
+        release_ = std::clamp(value, 1.0f, 1000.0f);
+    } else if (paramId == kLookaheadId) {
+        lookahead_ = std::clamp(value, 0.0f, kMaxLookaheadMs);
+    } else if (paramId == kEnabledId) {
+        enabled_ = value > 0.5f;
+    }
+}
+
+void LimiterNode::prepareToPlay(double sampleRate, int samplesPerBlock) {
+    (void)samplesPerBlock;
+    sampleRate_ = sampleRate;
+    dynamics_.prepare(sampleRate, lookaheadSamples(kMaxLookaheadMs, sampleRate));
+}
+
+void LimiterNode::reset() {
+    dynamics_.reset();
+}
+
+// OversampledNode implementation
+OversampledNode::OversampledNode(std::shared_ptr<AudioNode> inner, int factor,
+                                 Oversampler::Filter filter)
+    : AudioNode(inner->getType(), inner->getId()),
+      inner_(std::move(inner)),
+      factor_(factor),
+      filter_(filter),
+      numChannels_(std::clamp(inner_->getOutputChannelCount(), 1, Oversampler::kMaxChannels)) {
+    setInputChannelCount(inner_->getInputChannelCount());
+    setOutputChannelCount(inner_->getOutputChannelCount());
+}
+
+void OversampledNode::process(AudioBuffer& input, AudioBuffer& output,
+                              int numSamples, SampleCount position) noexcept {
+    run(input, nullptr, output, numSamples, position);
+}
+
+void OversampledNode::processWithSidechain(AudioBuffer& input, const AudioBuffer& sidechain,
+                                           AudioBuffer& output, int numSamples,
+                                           SampleCount position) noexcept {
+    run(input, &sidechain, output, numSamples, position);
+}
+
+void OversampledNode::run(AudioBuffer& input, const AudioBuffer* sidechain, AudioBuffer& output,
+                          int numSamples, SampleCount position) noexcept {
+    if (isBypassed() || oversampler_.getMaxBlockSize() == 0 || !input.channels ||
+        !output.channels) {
+        if (input.channels && output.channels) {
+            output.copyFrom(input);
+        }
+        return;
+    }
+
+    // Channels past the inner node's pass through
+    for (int ch = numChannels_; ch < output.numChannels; ++ch) {
+        float* out = output.channels[ch];
+        const float* in = ch < input.numChannels ? input.channels[ch] : nullptr;
+        if (out && !in) {
+            juce::FloatVectorOperations::clear(out, numSamples);
+        } else if (out && in != out) {
+            juce::FloatVectorOperations::copy(out, in, numSamples);
+        }
+    }
+
+    const int factor = oversampler_.getFactor();
+    const int blockSize = oversampler_.getMaxBlockSize();
+    const bool keyed = sidechain && sidechain->channels;
+    std::array<const float*, Oversampler::kMaxChannels> in{};
+    std::array<const float*, Oversampler::kMaxChannels> key{};
+    std::array<float*, Oversampler::kMaxChannels> out{};
+
+    for (int offset = 0; offset < numSamples; offset += blockSize) {
+        const int n = std::min(blockSize, numSamples - offset);
+        for (int ch = 0; ch < numChannels_; ++ch) {
+            const float* inChannel = ch < input.numChannels ? input.channels[ch] : nullptr;
+            float* outChannel = ch < output.numChannels ? output.channels[ch] : nullptr;
+            in[ch] = inChannel ? inChannel + offset : nullptr;
+            out[ch] = outChannel ? outChannel + offset : nullptr;
+        }
+
+        // Upsampled buffers are processed in place unless the inner node can't
+        AudioBuffer upsampled(oversampler_.upsample(in.data(), n), numChannels_, n * factor);
+        AudioBuffer processed = innerOutput_.empty()
+                                    ? upsampled
+                                    : AudioBuffer(innerOutput_.data(), numChannels_, n * factor);
+
+        if (keyed) {
+            for (int ch = 0; ch < numChannels_; ++ch) {
+                const float* keyChannel =
+                    ch < sidechain->numChannels ? sidechain->channels[ch] : nullptr;
+                key[ch] = keyChannel ? keyChannel + offset : nullptr;
+            }
+            AudioBuffer upsampledKey(sidechainOversampler_.upsample(key.data(), n), numChannels_,
+                                     n * factor);
+            inner_->processWithSidechain(upsampled, upsampledKey, processed, n * factor,
+                                         position + offset);
+        } else {
+            inner_->process(upsampled, processed, n * factor, position + offset);
+        }
+
+        if (processed.channels != upsampled.channels) {
+            upsampled.copyFrom(processed);
+        }
+        oversampler_.downsample(out.data(), n);
     }
 }
 
-float CompressorNode::processRMS(float input) {
-    // Add to RMS buffer
-    rmsSum_ -= rmsBuffer_[rmsBufferPos_];
-    rmsBuffer_[rmsBufferPos_] = input * input;
-    rmsSum_ += rmsBuffer_[rmsBufferPos_];
-    rmsBufferPos_ = (rmsBufferPos_ + 1) % kRMSBufferSize;
+int OversampledNode::getLatencySamples() const {
+    // The inner node reports in oversampled samples
+    const int factor = oversampler_.getFactor();
+    return oversampler_.getLatencySamples() + (inner_->getLatencySamples() + factor / 2) / factor;
+}
+
+float OversampledNode::getParameterValue(const std::string& paramId) const {
+    return inner_->getParameterValue(paramId);
+}
 
-    return std::sqrt(rmsSum_ / kRMSBufferSize);
+void OversampledNode::setParameterValue(const std::string& paramId, float value) {
+    inner_->setParameterValue(paramId, value);
+}
+
+float OversampledNode::getParameter(ParameterId paramId) const {
+    return inner_->getParameter(paramId);
+}
+
+void OversampledNode::setParameter(ParameterId paramId, float value) {
+    inner_->setParameter(paramId, value);
+}
+
+int OversampledNode::getParameterIndex(ParameterId paramId) const {
+    return inner_->getParameterIndex(paramId);
+}
+
+void OversampledNode::bindAutomation(int parameterIndex, const AutomationLane* lane) noexcept {
+    inner_->bindAutomation(parameterIndex, lane);
+}
+
+void OversampledNode::prepareToPlay(double sampleRate, int samplesPerBlock) {
+    const int blockSize = std::max(1, samplesPerBlock);
+    oversampler_.prepare(factor_, filter_, numChannels_, blockSize);
+    sidechainOversampler_.prepare(factor_, filter_, numChannels_, blockSize);
+
+    const int factor = oversampler_.getFactor();
+    inner_->prepareToPlay(sampleRate * factor, blockSize * factor);
+
+    innerOutputMemory_.clear();
+    innerOutput_.clear();
+    if (!inner_->canProcessInPlace()) {
+        const auto length = static_cast<size_t>(blockSize) * static_cast<size_t>(factor);
+        innerOutputMemory_.assign(static_cast<size_t>(numChannels_) * length, 0.0f);
+        for (int ch = 0; ch < numChannels_; ++ch) {
+            innerOutput_.push_back(innerOutputMemory_.data() + static_cast<size_t>(ch) * length);
+        }
+    }
+}
+
+void OversampledNode::reset() {
+    oversampler_.reset();
+    sidechainOversampler_.reset();
+    inner_->reset();
 }
 
 // TrackInputNode implementation
@@ -455,26 +735,33 @@ TrackOutputNode::TrackOutputNode(const std::string& id) : AudioNode(Type::TrackO
 
 void TrackOutputNode::process(AudioBuffer& input, AudioBuffer& output,
                             int numSamples, SampleCount position) noexcept {
-    if (isBypassed() || muted_ || !input.channels || !output.channels) {
-        if (input.channels && output.channels && !muted_) {
+    if (isBypassed() || !input.channels || !output.channels) {
+        if (input.channels && output.channels) {
             output.copyFrom(input);
         }
         return;
     }
 
-    // Get automated values
-    float targetGain = gain_;
-    float targetPan = pan_;
+    std::array<float, kMaxGainChannels> gains;
+    const int numChannels = std::min({input.numChannels, output.numChannels, kMaxGainChannels});
+    computeChannelGains(position, gains.data(), numChannels);
 
-    auto gainLane = getAutomationLane("gain");
-    if (gainLane) {
-        targetGain = gainLane->getValueAt(position);
-    }
+    // Process samples
+    for (int ch = 0; ch < numChannels; ++ch) {
+        if (!input.channels[ch] || !output.channels[ch]) continue;
 
-    auto panLane = getAutomationLane("pan");
-    if (panLane) {
-        targetPan = panLane->getValueAt(position);
+        juce::FloatVectorOperations::multiply(output.channels[ch],
+                                            input.channels[ch],
+                                            gains[ch],
+                                            numSamples);
     }
+}
+
+void TrackOutputNode::computeChannelGains(SampleCount position, float* gains,
+                                          int numChannels) noexcept {
+    // Get automated values
+    const float targetGain = getAutomatedValue(kGainParameter, position, gain_);
+    const float targetPan = getAutomatedValue(kPanParameter, position, pan_);
 
     // Smooth parameter changes
     gainSmoother_ = gainSmoother_ * kSmoothingCoeff + targetGain * (1.0f - kSmoothingCoeff);
@@ -488,18 +775,14 @@ void TrackOutputNode::process(AudioBuffer& input, AudioBuffer& output,
     float leftGain = std::cos(panAngle);
     float rightGain = std::sin(panAngle);
 
-    // Process samples
-    for (int ch = 0; ch < std::min(input.numChannels, output.numChannels); ++ch) {
-        if (!input.channels[ch] || !output.channels[ch]) continue;
+    // Muted tracks keep smoothing so they come back at the right level
+    const float trackGain = muted_ ? 0.0f : currentGain_;
 
-        float channelGain = currentGain_;
+    for (int ch = 0; ch < numChannels; ++ch) {
+        float channelGain = trackGain;
         if (ch == 0) channelGain *= leftGain;
         if (ch == 1) channelGain *= rightGain;
-
-        juce::FloatVectorOperations::multiply(output.channels[ch],
-                                            input.channels[ch],
-                                            channelGain,
-                                            numSamples);
+        gains[ch] = channelGain;
     }
 }
 
@@ -511,14 +794,22 @@ std::vector<ParameterInfo> TrackOutputNode::getParameters() const {
 }
 
 float TrackOutputNode::getParameterValue(const std::string& paramId) const {
-    if (paramId == "gain") return gain_;
-    if (paramId == "pan") return pan_;
-    return 0.0f;
+    return getParameter(ParameterId::find(paramId));
 }
 
 void TrackOutputNode::setParameterValue(const std::string& paramId, float value) {
-    if (paramId == "gain") gain_ = std::clamp(value, 0.0f, 2.0f);
-    if (paramId == "pan") pan_ = std::clamp(value, -1.0f, 1.0f);
+    setParameter(ParameterId::find(paramId), value);
+}
+
+float TrackOutputNode::getParameter(ParameterId paramId) const {
+    if (paramId == kGainId) return gain_;
+    if (paramId == kPanId) return pan_;
+    return 0.0f;
+}
+
+void TrackOutputNode::setParameter(ParameterId paramId, float value) {
+    if (paramId == kGainId) gain_ = std::clamp(value, 0.0f, 2.0f);
+    if (paramId == kPanId) pan_ = std::clamp(value, -1.0f, 1.0f);
 }
 
 // MixerNode implementation
@@ -538,19 +829,24 @@ void MixerNode::process(AudioBuffer& input, AudioBuffer& output,
     // Copy input to output (summing happens in AudioGraph)
     output.copyFrom(input);
 
-    // Apply master gain and pan
-    float targetGain = masterGain_;
-    float targetPan = masterPan_;
+    std::array<float, kMaxGainChannels> gains;
+    const int numChannels = std::min(output.numChannels, kMaxGainChannels);
+    computeChannelGains(position, gains.data(), numChannels);
 
-    auto gainLane = getAutomationLane("masterGain");
-    if (gainLane) {
-        targetGain = gainLane->getValueAt(position);
-    }
+    // Apply master processing
+    for (int ch = 0; ch < numChannels; ++ch) {
+        if (!output.channels[ch]) continue;
 
-    auto panLane = getAutomationLane("masterPan");
-    if (panLane) {
-        targetPan = panLane->getValueAt(position);
+        juce::FloatVectorOperations::multiply(output.channels[ch],
+                                            gains[ch],
+                                            numSamples);
     }
+}
+
+void MixerNode::computeChannelGains(SampleCount position, float* gains, int numChannels) noexcept {
+    // Apply master gain and pan
+    const float targetGain = getAutomatedValue(kGainParameter, position, masterGain_);
+    const float targetPan = getAutomatedValue(kPanParameter, position, masterPan_);
 
     // Smooth parameter changes
     gainSmoother_ = gainSmoother_ * kSmoothingCoeff + targetGain * (1.0f - kSmoothingCoeff);
@@ -564,17 +860,11 @@ void MixerNode::process(AudioBuffer& input, AudioBuffer& output,
     float leftGain = std::cos(panAngle);
     float rightGain = std::sin(panAngle);
 
-    // Apply master processing
-    for (int ch = 0; ch < output.numChannels; ++ch) {
-        if (!output.channels[ch]) continue;
-
+    for (int ch = 0; ch < numChannels; ++ch) {
         float channelGain = currentMasterGain_;
         if (ch == 0) channelGain *= leftGain;
         if (ch == 1) channelGain *= rightGain;
-
-        juce::FloatVectorOperations::multiply(output.channels[ch],
-                                            channelGain,
-                                            numSamples);
+        gains[ch] = channelGain;
     }
 }
 
@@ -586,14 +876,22 @@ std::vector<ParameterInfo> MixerNode::getParameters() const {
 }
 
 float MixerNode::getParameterValue(const std::string& paramId) const {
-    if (paramId == "masterGain") return masterGain_;
-    if (paramId == "masterPan") return masterPan_;
-    return 0.0f;
+    return getParameter(ParameterId::find(paramId));
 }
 
 void MixerNode::setParameterValue(const std::string& paramId, float value) {
-    if (paramId == "masterGain") masterGain_ = std::clamp(value, 0.0f, 2.0f);
-    if (paramId == "masterPan") masterPan_ = std::clamp(value, -1.0f, 1.0f);
+    setParameter(ParameterId::find(paramId), value);
+}
+
+float MixerNode::getParameter(ParameterId paramId) const {
+    if (paramId == kMasterGainId) return masterGain_;
+    if (paramId == kMasterPanId) return masterPan_;
+    return 0.0f;
+}
+
+void MixerNode::setParameter(ParameterId paramId, float value) {
+    if (paramId == kMasterGainId) masterGain_ = std::clamp(value, 0.0f, 2.0f);
+    if (paramId == kMasterPanId) masterPan_ = std::clamp(value, -1.0f, 1.0f);
 }
 
 // LatencyCompensatorNode implementation
@@ -602,51 +900,165 @@ LatencyCompensatorNode::LatencyCompensatorNode(const std::string& id)
     setOutputChannelCount(2);
 }
 
+LatencyCompensatorNode::~LatencyCompensatorNode() {
+    delete pendingRing_.load(std::memory_order_acquire);
+    freeRetiredRings();
+}
+
 void LatencyCompensatorNode::process(AudioBuffer& input, AudioBuffer& output,
                                    int numSamples, SampleCount position) noexcept {
-    if (isBypassed() || !input.channels || !output.channels || delaySamples_ == 0) {
+    (void)position;
+
+    // Read before the swap: a delay set after growing the ring finds it swapped in
+    const int requestedDelay = delaySamples_.load(std::memory_order_acquire);
+    swapInPendingRing();
+
+    if (isBypassed() || !input.channels || !output.channels || !ring_) {
         if (input.channels && output.channels) {
             output.copyFrom(input);
         }
         return;
     }
 
-    int delay = delaySamples_;
+    Ring& ring = *ring_;
+    const int targetDelay = std::min(requestedDelay, ring.maxDelay);
+    if (!primed_) {
+        currentDelay_ = targetDelay;
+        primed_ = true;
+    }
 
-    // Process each channel
-    for (int ch = 0; ch < std::min(input.numChannels, output.numChannels); ++ch) {
-        if (!input.channels[ch] || !output.channels[ch]) continue;
+    const int numChannels = std::min(numChannels_, output.numChannels);
+    const float fadeStep = 1.0f / kCrossfadeSamples;
 
-        float* delayBuffer = delayBuffers_[ch].data();
+    for (int offset = 0; offset < numSamples; offset += blockSize_) {
+        const int n = std::min(blockSize_, numSamples - offset);
 
-        // Write input to delay buffer
-        for (int i = 0; i < numSamples; ++i) {
-            delayBuffer[writePos_] = input.channels[ch][i];
+        // A change during a crossfade waits for it to finish
+        if (fadeRemaining_ == 0 && targetDelay != currentDelay_) {
+            fadeFromDelay_ = currentDelay_;
+            currentDelay_ = targetDelay;
+            fadeRemaining_ = kCrossfadeSamples;
+        }
+
+        const int readPos = (writePos_ - currentDelay_ + ring.size) % ring.size;
+        const int fadeReadPos = (writePos_ - fadeFromDelay_ + ring.size) % ring.size;
+        const int fadeLength = std::min(n, fadeRemaining_);
+        const float fadeStart = static_cast<float>(kCrossfadeSamples - fadeRemaining_) * fadeStep;
 
-            // Read delayed sample
-            int readPos = (writePos_ - delay + bufferSize_) % bufferSize_;
-            output.channels[ch][i] = delayBuffer[readPos];
+        for (int ch = 0; ch < numChannels; ++ch) {
+            float* data = ring.channel(ch);
+            const float* in = ch < input.numChannels ? input.channels[ch] : nullptr;
+            float* out = output.channels[ch];
 
-            writePos_ = (writePos_ + 1) % bufferSize_;
+            // The block goes in before anything is read, so in-place buffers are safe
+            writeRing(data, ring.size, writePos_, in ? in + offset : nullptr, n);
+            if (!out) {
+                continue;
+            }
+
+            readRing(data, ring.size, readPos, out + offset, n);
+            if (fadeLength > 0) {
+                float* from = fadeScratch_.data();
+                readRing(data, ring.size, fadeReadPos, from, fadeLength);
+                for (int i = 0; i < fadeLength; ++i) {
+                    const float t = fadeStart + static_cast<float>(i) * fadeStep;
+                    out[offset + i] = from[i] + t * (out[offset + i] - from[i]);
+                }
+            }
         }
+
+        fadeRemaining_ -= fadeLength;
+        writePos_ = (writePos_ + n) % ring.size;
     }
 }
 
 void LatencyCompensatorNode::setDelaySamples(int delaySamples) {
-    delaySamples_ = std::max(0, delaySamples);
+    delaySamples = std::max(0, delaySamples);
+    if (delaySamples > maxDelaySamples_) {
+        setMaxDelaySamples(delaySamples);
+    }
+    delaySamples_.store(delaySamples, std::memory_order_release);
+}
+
+void LatencyCompensatorNode::setMaxDelaySamples(int maxDelaySamples) {
+    if (maxDelaySamples <= maxDelaySamples_) {
+        return;
+    }
+    maxDelaySamples_ = maxDelaySamples;
+
+    // Unprepared rings are sized by prepareToPlay()
+    if (blockSize_ == 0) {
+        return;
+    }
+
+    // Free the rings the audio thread retired since the previous growth. A
+    // pending ring it never picked up is smaller than this one: replace it.
+    freeRetiredRings();
+    delete pendingRing_.exchange(makeRing(maxDelaySamples).release(), std::memory_order_acq_rel);
+}
+
+std::unique_ptr<LatencyCompensatorNode::Ring> LatencyCompensatorNode::makeRing(int maxDelay) const {
+    auto ring = std::make_unique<Ring>();
+    ring->maxDelay = maxDelay;
+    ring->size = maxDelay + blockSize_;
+    ring->memory.assign(static_cast<size_t>(numChannels_) * static_cast<size_t>(ring->size), 0.0f);
+    return ring;
+}
+
+void LatencyCompensatorNode::swapInPendingRing() noexcept {
+    auto* grown = pendingRing_.exchange(nullptr, std::memory_order_acq_rel);
+    if (!grown) {
+        return;
+    }
+
+    // Unroll the history into the larger ring, oldest sample first
+    if (ring_) {
+        for (int ch = 0; ch < numChannels_; ++ch) {
+            readRing(ring_->channel(ch), ring_->size, writePos_, grown->channel(ch), ring_->size);
+        }
+        writePos_ = ring_->size;
+    }
+
+    // Freeing is the UI thread's job. The queue is sized so this cannot
+    // fail (see retiredRings_).
+    if (ring_) {
+        retiredRings_.tryPush(ring_.release());
+    }
+    ring_.reset(grown);
+}
+
+void LatencyCompensatorNode::freeRetiredRings() {
+    while (auto ring = retiredRings_.tryPop()) {
+        delete *ring;
+    }
 }
 
 void LatencyCompensatorNode::prepareToPlay(double sampleRate, int samplesPerBlock) {
-    bufferSize_ = samplesPerBlock * 4; // 4x buffer size for safety
-    delayBuffers_.resize(2, std::vector<float>(bufferSize_, 0.0f));
+    (void)sampleRate;
+    blockSize_ = std::max(1, samplesPerBlock);
+    numChannels_ = std::max(2, outputChannels_);
+
+    // Headroom for short delays set without a maximum
+    maxDelaySamples_ = std::max<int>(maxDelaySamples_, blockSize_ * 3);
+
+    delete pendingRing_.exchange(nullptr, std::memory_order_acq_rel);
+    freeRetiredRings();
+    ring_ = makeRing(maxDelaySamples_);
+    fadeScratch_.assign(static_cast<size_t>(blockSize_), 0.0f);
+
     writePos_ = 0;
+    fadeRemaining_ = 0;
+    primed_ = false;
 }
 
 void LatencyCompensatorNode::reset() {
-    for (auto& buffer : delayBuffers_) {
-        std::fill(buffer.begin(), buffer.end(), 0.0f);
+    swapInPendingRing();
+    if (ring_) {
+        std::fill(ring_->memory.begin(), ring_->memory.end(), 0.0f);
     }
     writePos_ = 0;
+    fadeRemaining_ = 0;
+    primed_ = false;
 }
 
 } // namespace ampl
@@ -2,24 +2,42 @@
 
 #include "AudioGraph.hpp"
 #include "Automation.hpp"
+#include "BiquadCascade.hpp"
+#include "DynamicsEngine.hpp"
+#include "Oversampler.hpp"
+#include "util/LockFreeQueue.hpp"
 #include <juce_audio_basics/juce_audio_basics.h>
+#include <algorithm>
 #include <memory>
 #include <array>
 
 namespace ampl {
 
+// Channels a built-in gain stage computes gains for
+constexpr int kMaxGainChannels = 8;
+
 // Gain processor with automation support
 class GainNode : public AudioNode {
 public:
+    // Parameter indices, in getParameters() order
+    static constexpr int kGainParameter = 0;
+    static constexpr int kPanParameter = 1;
+
     GainNode(const std::string& id);
     ~GainNode() override = default;
 
     void process(AudioBuffer& input, AudioBuffer& output,
                 int numSamples, SampleCount position) noexcept override;
 
+    bool canProcessInPlace() const override { return true; }
+    bool isLinearGainStage() const override { return true; }
+    void computeChannelGains(SampleCount position, float* gains, int numChannels) noexcept override;
+
     std::vector<ParameterInfo> getParameters() const override;
     float getParameterValue(const std::string& paramId) const override;
     void setParameterValue(const std::string& paramId, float value) override;
+    float getParameter(ParameterId paramId) const override;
+    void setParameter(ParameterId paramId, float value) override;
 
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void reset() override;
@@ -36,7 +54,9 @@ private:
     static constexpr float kSmoothingCoeff = 0.999f;
 };
 
-// 4-band parametric EQ
+// 4-band parametric EQ. Bands run as a BiquadCascade: per-channel double
+// precision state, channel pairs processed together, and coefficient ramps
+// when a band is moved or automated.
 class EQNode : public AudioNode {
 public:
     struct EQBand {
@@ -45,10 +65,7 @@ public:
         float q{1.0f};           // Quality factor
         bool enabled{true};
 
-        // Biquad filter state
-        float z1{0.0f}, z2{0.0f};
-        float a0{1.0f}, a1{0.0f}, a2{0.0f};
-        float b0{1.0f}, b1{0.0f}, b2{0.0f};
+        bool operator==(const EQBand&) const = default;
     };
 
     EQNode(const std::string& id);
@@ -57,26 +74,51 @@ public:
     void process(AudioBuffer& input, AudioBuffer& output,
                 int numSamples, SampleCount position) noexcept override;
 
+    bool canProcessInPlace() const override { return true; }
+
     std::vector<ParameterInfo> getParameters() const override;
     float getParameterValue(const std::string& paramId) const override;
     void setParameterValue(const std::string& paramId, float value) override;
+    float getParameter(ParameterId paramId) const override;
+    void setParameter(ParameterId paramId, float value) override;
 
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void reset() override;
 
-    // Band access
-    EQBand& getBand(int bandIndex) { return bands_[bandIndex]; }
-    const EQBand& getBand(int bandIndex) const { return bands_[bandIndex]; }
+    // Band access, from any thread. The audio thread picks up a change at
+    // its next block; automation of a band parameter overrides it.
+    EQBand getBand(int bandIndex) const;
+    void setBand(int bandIndex, const EQBand& band);
 
 private:
-    std::array<EQBand, 4> bands_;
+    // A band's static settings, written by the UI thread
+    struct BandParameters {
+        std::atomic<float> frequency{1000.0f};
+        std::atomic<float> gain{0.0f};
+        std::atomic<float> q{1.0f};
+        std::atomic<bool> enabled{true};
+    };
+
+    std::array<BandParameters, 4> bands_;
     double sampleRate_{44100.0};
 
-    void calculateBiquadCoeffs(EQBand& band);
-    float processBiquad(EQBand& band, float input);
+    BiquadCascade filters_;
+    std::array<EQBand, 4> appliedBands_; // Audio thread: what the filters were last given
+
+    // Audio thread: the bands' settings for the block at position
+    std::array<EQBand, 4> getBlockBands(SampleCount position) noexcept;
+
+    // Audio thread: hands band settings to the filters
+    void updateFilters(const std::array<EQBand, 4>& bands, bool immediate) noexcept;
+
+    // Length of the coefficient ramp after a band change
+    static constexpr double kRampSeconds = 0.005;
 };
 
-// Compressor with RMS detection, soft knee, and full parameter control
+// Compressor with RMS or peak detection, soft knee and full parameter control. Runs on
+// a DynamicsEngine: block-wise detection and gain computation, an optional
+// look-ahead (reported as latency) and a sidechain input, which keys the
+// detector when a sidechain connection feeds the node.
 class CompressorNode : public AudioNode {
 public:
     CompressorNode(const std::string& id);
@@ -85,13 +127,28 @@ public:
     void process(AudioBuffer& input, AudioBuffer& output,
                 int numSamples, SampleCount position) noexcept override;
 
+    bool canProcessInPlace() const override { return true; }
+    bool acceptsSidechain() const override { return true; }
+    void processWithSidechain(AudioBuffer& input, const AudioBuffer& sidechain,
+                              AudioBuffer& output, int numSamples,
+                              SampleCount position) noexcept override;
+
+    // The look-ahead, while enabled
+    int getLatencySamples() const override;
+
     std::vector<ParameterInfo> getParameters() const override;
     float getParameterValue(const std::string& paramId) const override;
     void setParameterValue(const std::string& paramId, float value) override;
+    float getParameter(ParameterId paramId) const override;
+    void setParameter(ParameterId paramId, float value) override;
 
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void reset() override;
 
+    float getGainReductionDb() const { return dynamics_.getGainReductionDb(); }
+
+    static constexpr float kMaxLookaheadMs = 10.0f;
+
 private:
     // Parameters
     std::atomic<float> threshold_{-20.0f};    // dB
@@ -100,26 +157,109 @@ private:
     std::atomic<float> release_{50.0f};        // ms
     std::atomic<float> knee_{2.0f};            // dB
     std::atomic<float> makeupGain_{0.0f};     // dB
+    std::atomic<float> lookahead_{0.0f};       // ms
+    std::atomic<bool> peakDetection_{false};   // RMS otherwise
+    std::atomic<bool> enabled_{true};
+
+    double sampleRate_{44100.0};
+    DynamicsEngine dynamics_;
+
+    void run(AudioBuffer& input, const AudioBuffer* sidechain, AudioBuffer& output,
+             int numSamples) noexcept;
+};
+
+// Brickwall limiter for the master bus: the compressor's engine with peak
+// detection and an infinite ratio. The gain settles over the look-ahead
+// window, so no sample leaves above the ceiling.
+class LimiterNode : public AudioNode {
+public:
+    LimiterNode(const std::string& id);
+    ~LimiterNode() override = default;
+
+    void process(AudioBuffer& input, AudioBuffer& output,
+                int numSamples, SampleCount position) noexcept override;
+
+    bool canProcessInPlace() const override { return true; }
+
+    // The look-ahead, while enabled
+    int getLatencySamples() const override;
+
+    std::vector<ParameterInfo> getParameters() const override;
+    float getParameterValue(const std::string& paramId) const override;
+    void setParameterValue(const std::string& paramId, float value) override;
+    float getParameter(ParameterId paramId) const override;
+    void setParameter(ParameterId paramId, float value) override;
+
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void reset() override;
+
+    float getGainReductionDb() const { return dynamics_.getGainReductionDb(); }
+
+    static constexpr float kMaxLookaheadMs = 10.0f;
+
+private:
+    std::atomic<float> ceiling_{-0.3f};     // dB
+    std::atomic<float> release_{100.0f};    // ms
+    std::atomic<float> lookahead_{2.0f};    // ms
     std::atomic<bool> enabled_{true};
 
-    // Runtime state
     double sampleRate_{44100.0};
-    float envelope_{0.0f};
-    float gainReduction_{0.0f};
-
-    // Coefficients
-    float attackCoeff_{0.0f};
-    float releaseCoeff_{0.0f};
-
-    // RMS detection buffer
-    static constexpr int kRMSBufferSize = 256;
-    std::array<float, kRMSBufferSize> rmsBuffer_;
-    int rmsBufferPos_{0};
-    float rmsSum_{0.0f};
-
-    void updateCoefficients();
-    float calculateGainReduction(float inputLevel) const;
-    float processRMS(float input);
+    DynamicsEngine dynamics_;
+};
+
+// Runs a nonlinear node (saturation, compression, limiting) at 2x, 4x or 8x the
+// session rate, so the harmonics it generates above Nyquist are filtered out
+// instead of folding back into the audio band. Only wrapped nodes pay for the
+// resampling. Takes the inner node's id and type and forwards its parameters,
+// automation and sidechain; the latency adds the filters' round trip to the
+// inner node's own, scaled to the session rate.
+class OversampledNode : public AudioNode {
+public:
+    OversampledNode(std::shared_ptr<AudioNode> inner, int factor,
+                    Oversampler::Filter filter = Oversampler::Filter::FIR);
+    ~OversampledNode() override = default;
+
+    void process(AudioBuffer& input, AudioBuffer& output,
+                int numSamples, SampleCount position) noexcept override;
+
+    bool canProcessInPlace() const override { return true; }
+    bool acceptsSidechain() const override { return inner_->acceptsSidechain(); }
+    void processWithSidechain(AudioBuffer& input, const AudioBuffer& sidechain,
+                              AudioBuffer& output, int numSamples,
+                              SampleCount position) noexcept override;
+
+    // Known once prepared
+    int getLatencySamples() const override;
+
+    std::vector<ParameterInfo> getParameters() const override { return inner_->getParameters(); }
+    float getParameterValue(const std::string& paramId) const override;
+    void setParameterValue(const std::string& paramId, float value) override;
+    float getParameter(ParameterId paramId) const override;
+    void setParameter(ParameterId paramId, float value) override;
+    int getParameterIndex(ParameterId paramId) const override;
+    void bindAutomation(int parameterIndex, const AutomationLane* lane) noexcept override;
+
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void reset() override;
+
+    AudioNode& getInner() const { return *inner_; }
+    int getFactor() const { return oversampler_.getFactor(); }
+
+private:
+    std::shared_ptr<AudioNode> inner_;
+    int factor_;
+    Oversampler::Filter filter_;
+    int numChannels_;
+
+    Oversampler oversampler_;
+    Oversampler sidechainOversampler_;
+
+    // Oversampled output of an inner node that cannot process in place
+    std::vector<float> innerOutputMemory_;
+    std::vector<float*> innerOutput_;
+
+    void run(AudioBuffer& input, const AudioBuffer* sidechain, AudioBuffer& output,
+             int numSamples, SampleCount position) noexcept;
 };
 
 // Track input node - receives audio from clips
@@ -153,15 +293,25 @@ private:
 // Track output node - applies gain/pan/mute/solo
 class TrackOutputNode : public AudioNode {
 public:
+    // Parameter indices, in getParameters() order
+    static constexpr int kGainParameter = 0;
+    static constexpr int kPanParameter = 1;
+
     TrackOutputNode(const std::string& id);
     ~TrackOutputNode() override = default;
 
     void process(AudioBuffer& input, AudioBuffer& output,
                 int numSamples, SampleCount position) noexcept override;
 
+    bool canProcessInPlace() const override { return true; }
+    bool isLinearGainStage() const override { return true; }
+    void computeChannelGains(SampleCount position, float* gains, int numChannels) noexcept override;
+
     std::vector<ParameterInfo> getParameters() const override;
     float getParameterValue(const std::string& paramId) const override;
     void setParameterValue(const std::string& paramId, float value) override;
+    float getParameter(ParameterId paramId) const override;
+    void setParameter(ParameterId paramId, float value) override;
 
     void setMuted(bool muted) { muted_ = muted; }
     void setSoloed(bool soloed) { soloed_ = soloed; }
@@ -185,15 +335,25 @@ private:
 // Mixer node - sums multiple track outputs
 class MixerNode : public AudioNode {
 public:
+    // Parameter indices, in getParameters() order
+    static constexpr int kGainParameter = 0;
+    static constexpr int kPanParameter = 1;
+
     MixerNode(const std::string& id);
     ~MixerNode() override = default;
 
     void process(AudioBuffer& input, AudioBuffer& output,
                 int numSamples, SampleCount position) noexcept override;
 
+    bool canProcessInPlace() const override { return true; }
+    bool isLinearGainStage() const override { return true; }
+    void computeChannelGains(SampleCount position, float* gains, int numChannels) noexcept override;
+
     std::vector<ParameterInfo> getParameters() const override;
     float getParameterValue(const std::string& paramId) const override;
     void setParameterValue(const std::string& paramId, float value) override;
+    float getParameter(ParameterId paramId) const override;
+    void setParameter(ParameterId paramId, float value) override;
 
 private:
     std::atomic<float> masterGain_{1.0f};
@@ -207,28 +367,74 @@ private:
     static constexpr float kSmoothingCoeff = 0.999f;
 };
 
-// Latency compensator node - adds delay to align tracks
+// Latency compensation delay. Blocks are written to and read from the ring as
+// at most two contiguous segments. A delay change crossfades from the old read
+// position to the new one, and the ring grows without the audio thread
+// allocating: setMaxDelaySamples() builds a larger ring on the calling thread
+// and the audio thread swaps it in (copying the history) before its next block.
+// PDC can therefore retune during playback without clicks.
 class LatencyCompensatorNode : public AudioNode {
 public:
     LatencyCompensatorNode(const std::string& id);
-    ~LatencyCompensatorNode() override = default;
+    ~LatencyCompensatorNode() override;
 
     void process(AudioBuffer& input, AudioBuffer& output,
                 int numSamples, SampleCount position) noexcept override;
 
+    bool canProcessInPlace() const override { return true; }
+
+    // UI thread. Grows the ring when the delay exceeds its capacity.
     void setDelaySamples(int delaySamples);
     int getDelaySamples() const { return delaySamples_; }
 
+    // UI thread. Delay the ring must hold; allocates a larger ring once
+    // prepared, which is safe during playback. Delays beyond it are clamped.
+    void setMaxDelaySamples(int maxDelaySamples);
+    int getMaxDelaySamples() const { return maxDelaySamples_; }
+
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void reset() override;
 
     int getLatencySamples() const override { return delaySamples_; }
 
+    // Length of the crossfade after a delay change
+    static constexpr int kCrossfadeSamples = 256;
+
 private:
+    // Per channel, a ring of size samples: a block plus maxDelay samples of history
+    struct Ring {
+        int size{0};
+        int maxDelay{0};
+        std::vector<float> memory;
+
+        float* channel(int ch) { return memory.data() + static_cast<size_t>(ch) * size; }
+    };
+
+    std::unique_ptr<Ring> makeRing(int maxDelay) const;
+    void swapInPendingRing() noexcept;
+    void freeRetiredRings();
+
     std::atomic<int> delaySamples_{0};
-    std::vector<std::vector<float>> delayBuffers_;
+    std::atomic<int> maxDelaySamples_{0};
+    int numChannels_{2};
+    int blockSize_{0};
+
+    // Audio thread state
+    std::unique_ptr<Ring> ring_;
     int writePos_{0};
-    int bufferSize_{0};
+    int currentDelay_{0};
+    int fadeFromDelay_{0};
+    int fadeRemaining_{0};
+    bool primed_{false}; // False until the first block after prepare/reset
+    std::vector<float> fadeScratch_;
+
+    // Grown rings, published UI thread -> audio thread. The audio thread hands
+    // every ring it replaces back through retiredRings_ and never frees one;
+    // the UI thread drains the queue before each growth. Between two drains
+    // the audio thread swaps in at most the ring pending at the drain and the
+    // one published after it, so the queue cannot fill.
+    std::atomic<Ring*> pendingRing_{nullptr};
+    LockFreeQueue<Ring*, 4> retiredRings_;
 };
 
 } // namespace ampl
@@ -5,8 +5,313 @@
 
 namespace ampl {
 
+namespace {
+
+// Advanced by every publish(); readers note it at the start of each block
+std::atomic<uint64_t> snapshotEpoch{0};
+
+struct ReaderRegistry {
+    std::mutex mutex;
+    std::vector<const AutomationReader*> readers;
+};
+
+ReaderRegistry& getReaderRegistry() {
+    static ReaderRegistry registry;
+    return registry;
+}
+
+// Source of AutomationSnapshot::version; a freed snapshot's address can be reused
+std::atomic<uint64_t> snapshotVersions{0};
+
+float linearInterpolate(const AutomationPoint& p1, const AutomationPoint& p2,
+                        SampleCount position) {
+    if (p2.position == p1.position) return p1.value;
+
+    float t = static_cast<float>(position - p1.position) /
+              static_cast<float>(p2.position - p1.position);
+
+    return p1.value + t * (p2.value - p1.value);
+}
+
+float curveInterpolate(const AutomationPoint& p1, const AutomationPoint& p2,
+                       SampleCount position) {
+    if (p2.position == p1.position) return p1.value;
+
+    float t = static_cast<float>(position - p1.position) /
+              static_cast<float>(p2.position - p1.position);
+
+    // Apply curve function
+    if (p1.curve > 0.0f) {
+        // Exponential curve
+        t = std::pow(t, 1.0f + p1.curve);
+    } else if (p1.curve < 0.0f) {
+        // Logarithmic curve
+        t = 1.0f - std::pow(1.0f - t, 1.0f - p1.curve);
+    }
+
+    return p1.value + t * (p2.value - p1.value);
+}
+
+// Value at position of a sorted point list, where next is the index of the
+// first point after position; holds the first/last value outside the list
+float evaluateBefore(const std::vector<AutomationPoint>& points, size_t next,
+                     SampleCount position) {
+    if (next == 0) {
+        // Position is before first point
+        return points.front().value;
+    }
+
+    const auto& before = points[next - 1];
+    if (next == points.size() || before.position == position) {
+        // Exactly on a point, or after the last one
+        return before.value;
+    }
+
+    // Interpolate
+    if (before.curve == 0.0f) {
+        return linearInterpolate(before, points[next], position);
+    } else {
+        return curveInterpolate(before, points[next], position);
+    }
+}
+
+// Value of a sorted point list at a position
+float evaluate(const std::vector<AutomationPoint>& points, SampleCount position) {
+    if (points.empty()) return 0.0f;
+
+    const auto next = std::upper_bound(points.begin(), points.end(),
+                                       AutomationPoint{position, 0.0f}) - points.begin();
+    return evaluateBefore(points, static_cast<size_t>(next), position);
+}
+
+// Straight line from 'from' with a per-sample step; a plain loop so it vectorizes
+void writeRamp(float* out, int count, float from, float step) noexcept {
+    for (int i = 0; i < count; ++i) {
+        out[i] = from + step * static_cast<float>(i);
+    }
+}
+
+// Ramer-Douglas-Peucker on a time series. Deviation is measured vertically
+// (in value units) since time and value have unrelated scales.
+std::vector<AutomationPoint> thinPoints(const std::vector<AutomationPoint>& points,
+                                        float tolerance) {
+    const size_t count = points.size();
+    if (count <= 2) return points;
+
+    std::vector<char> keep(count, 0);
+    keep.front() = keep.back() = 1;
+
+    std::vector<std::pair<size_t, size_t>> spans{{0, count - 1}};
+    while (!spans.empty()) {
+        const auto [first, last] = spans.back();
+        spans.pop_back();
+        if (last <= first + 1) continue;
+
+        const auto& a = points[first];
+        const auto& b = points[last];
+        const double slope = static_cast<double>(b.value - a.value) /
+                             static_cast<double>(b.position - a.position);
+
+        size_t worst = first;
+        double worstDeviation = 0.0;
+        for (size_t i = first + 1; i < last; ++i) {
+            const double line = a.value + slope * static_cast<double>(points[i].position - a.position);
+            const double deviation = std::abs(points[i].value - line);
+            if (deviation > worstDeviation) {
+                worstDeviation = deviation;
+                worst = i;
+            }
+        }
+
+        if (worstDeviation > tolerance) {
+            keep[worst] = 1;
+            spans.emplace_back(first, worst);
+            spans.emplace_back(worst, last);
+        }
+    }
+
+    std::vector<AutomationPoint> thinned;
+    for (size_t i = 0; i < count; ++i) {
+        if (keep[i]) thinned.push_back(points[i]);
+    }
+    return thinned;
+}
+
+} // namespace
+
+float AutomationSnapshot::getValueAt(SampleCount position) const noexcept {
+    return evaluate(points, position);
+}
+
+float AutomationSnapshot::getValueAt(AutomationCursor& cursor,
+                                     SampleCount position) const noexcept {
+    if (points.empty()) return 0.0f;
+
+    // Walk forward from the cursor; seek only after an edit or a jump back
+    size_t next = cursor.next;
+    if (version == 0 || cursor.version != version || position < cursor.position ||
+        next > points.size()) {
+        next = static_cast<size_t>(std::upper_bound(points.begin(), points.end(),
+                                                    AutomationPoint{position, 0.0f}) -
+                                   points.begin());
+    }
+    while (next < points.size() && points[next].position <= position) ++next;
+
+    cursor.version = version;
+    cursor.position = position;
+    cursor.next = next;
+    return evaluateBefore(points, next, position);
+}
+
+bool AutomationSnapshot::renderBlock(AutomationCursor& cursor, SampleCount start,
+                                     int numSamples, float* out) const noexcept {
+    if (numSamples <= 0) return true;
+
+    if (points.empty()) {
+        std::fill_n(out, numSamples, 0.0f);
+        return true;
+    }
+
+    // Re-seek only after an edit (new snapshot) or a jump in position
+    size_t next = cursor.next;
+    if (version == 0 || cursor.version != version || cursor.position != start ||
+        next > points.size()) {
+        next = static_cast<size_t>(std::upper_bound(points.begin(), points.end(),
+                                                    AutomationPoint{start, 0.0f}) -
+                                   points.begin());
+    }
+
+    bool constant = true;
+    SampleCount position = start;
+    int done = 0;
+
+    while (done < numSamples) {
+        while (next < points.size() && points[next].position <= position) ++next;
+
+        const int remaining = numSamples - done;
+        float* dest = out + done;
+        int count = remaining;
+        bool flat = true;
+
+        if (next == 0) {
+            // Before the first point
+            count = static_cast<int>(std::min<SampleCount>(remaining,
+                                                           points.front().position - position));
+            std::fill_n(dest, count, points.front().value);
+        } else if (next == points.size()) {
+            // Past the last point
+            std::fill_n(dest, count, points.back().value);
+        } else {
+            const auto& p1 = points[next - 1];
+            const auto& p2 = points[next];
+            count = static_cast<int>(std::min<SampleCount>(remaining, p2.position - position));
+
+            if (p1.value == p2.value) {
+                std::fill_n(dest, count, p1.value);
+            } else if (p1.curve == 0.0f) {
+                const double slope = static_cast<double>(p2.value - p1.value) /
+                                     static_cast<double>(p2.position - p1.position);
+                const double from = p1.value + slope * static_cast<double>(position - p1.position);
+                writeRamp(dest, count, static_cast<float>(from), static_cast<float>(slope));
+                flat = count == 1;
+            } else {
+                // Exact at anchors, linear in between. Anchors are at most
+                // 1/256 of the segment apart, which keeps the error of the
+                // (smooth, convex) curve far below audibility; short
+                // segments are evaluated per sample.
+                const int step = static_cast<int>(std::clamp<SampleCount>(
+                    (p2.position - p1.position) / 256, 1, kCurveStep));
+                float from = curveInterpolate(p1, p2, position);
+                for (int i = 0; i < count; i += step) {
+                    const int run = std::min(step, count - i);
+                    const float to = curveInterpolate(p1, p2, position + i + run);
+                    writeRamp(dest + i, run, from, (to - from) / static_cast<float>(run));
+                    from = to;
+                }
+                flat = count == 1;
+            }
+        }
+
+        if (constant && (!flat || dest[0] != out[0])) constant = false;
+
+        done += count;
+        position += count;
+    }
+
+    cursor.version = version;
+    cursor.position = position;
+    cursor.next = next;
+    return constant;
+}
+
+// AutomationReader implementation
+AutomationReader::AutomationReader() {
+    auto& registry = getReaderRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.readers.push_back(this);
+}
+
+AutomationReader::~AutomationReader() {
+    auto& registry = getReaderRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.readers.erase(std::find(registry.readers.begin(), registry.readers.end(), this));
+}
+
+void AutomationReader::beginBlock() noexcept {
+    // Sequentially consistent with publish(): a reader that notes a later
+    // epoch than a snapshot was retired in loads the snapshot that replaced it
+    epoch_.store(snapshotEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+}
+
+void AutomationReader::endBlock() noexcept {
+    epoch_.store(kIdle, std::memory_order_seq_cst);
+}
+
+uint64_t AutomationReader::getOldestEpochInUse() {
+    auto& registry = getReaderRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    uint64_t oldest = kIdle;
+    for (const auto* reader : registry.readers)
+        oldest = std::min(oldest, reader->epoch_.load(std::memory_order_seq_cst));
+    return oldest;
+}
+
 // AutomationLane implementation
 AutomationLane::AutomationLane() {
+    publish();
+}
+
+AutomationLane::~AutomationLane() {
+    delete snapshot_.load(std::memory_order_acquire);
+}
+
+AutomationRecorder& AutomationLane::getRecorder() {
+    if (!recorderStorage_) {
+        recorderStorage_ = std::make_unique<AutomationRecorder>(*this);
+        recorder_.store(recorderStorage_.get(), std::memory_order_release);
+    }
+    return *recorderStorage_;
+}
+
+void AutomationLane::publish() {
+    auto* snapshot = new AutomationSnapshot{
+        points_, snapshotVersions.fetch_add(1, std::memory_order_relaxed) + 1};
+
+    if (auto* old = snapshot_.exchange(snapshot, std::memory_order_seq_cst)) {
+        retired_.emplace_back(snapshotEpoch.fetch_add(1, std::memory_order_seq_cst),
+                              std::unique_ptr<const AutomationSnapshot>(old));
+    }
+    reclaimRetired();
+}
+
+void AutomationLane::reclaimRetired() {
+    if (retired_.empty()) return;
+
+    // Readers that began their block after a snapshot was retired never saw it
+    const uint64_t oldest = AutomationReader::getOldestEpochInUse();
+    retired_.erase(retired_.begin(),
+                   std::find_if(retired_.begin(), retired_.end(),
+                                [oldest](const auto& entry) { return entry.first >= oldest; }));
 }
 
 void AutomationLane::addPoint(const AutomationPoint& point) {
@@ -21,12 +326,15 @@ void AutomationLane::addPoint(const AutomationPoint& point) {
         // Insert new point
         points_.insert(it, point);
     }
+
+    publish();
 }
 
 void AutomationLane::removePoint(SampleCount position) {
     auto it = findPointAt(position);
     if (it != points_.end()) {
         points_.erase(it);
+        publish();
     }
 }
 
@@ -37,53 +345,20 @@ void AutomationLane::removePointsInRange(SampleCount start, SampleCount end) {
                                  AutomationPoint{end, 0.0f});
 
     points_.erase(startIt, endIt);
+    publish();
 }
 
 void AutomationLane::clear() {
     points_.clear();
+    publish();
 }
 
 float AutomationLane::getValueAt(SampleCount position) const {
-    if (points_.empty()) return 0.0f;
-
-    // Find exact point
-    auto it = findPointAt(position);
-    if (it != points_.end()) {
-        return it->value;
-    }
-
-    // Interpolate between surrounding points
-    return getInterpolatedValue(position);
+    return evaluate(points_, position);
 }
 
 float AutomationLane::getInterpolatedValue(SampleCount position) const {
-    if (points_.empty()) return 0.0f;
-
-    if (points_.size() == 1) {
-        return points_[0].value;
-    }
-
-    // Find surrounding points
-    auto beforeIt = findPointBefore(position);
-    auto afterIt = findPointAfter(position);
-
-    // Handle edge cases
-    if (beforeIt == points_.end()) {
-        // Position is before first point
-        return points_.front().value;
-    }
-
-    if (afterIt == points_.end()) {
-        // Position is after last point
-        return points_.back().value;
-    }
-
-    // Interpolate
-    if (beforeIt->curve == 0.0f) {
-        return linearInterpolate(*beforeIt, *afterIt, position);
-    } else {
-        return curveInterpolate(*beforeIt, *afterIt, position);
-    }
+    return evaluate(points_, position);
 }
 
 void AutomationLane::moveRange(SampleCount start, SampleCount end, SampleCount offset) {
@@ -95,6 +370,7 @@ void AutomationLane::moveRange(SampleCount start, SampleCount end, SampleCount o
 
     // Re-sort points
     std::sort(points_.begin(), points_.end());
+    publish();
 }
 
 void AutomationLane::scaleRange(SampleCount start, SampleCount end, float scaleFactor) {
@@ -103,6 +379,7 @@ void AutomationLane::scaleRange(SampleCount start, SampleCount end, float scaleF
             point.value *= scaleFactor;
         }
     }
+    publish();
 }
 
 void AutomationLane::offsetRange(SampleCount start, SampleCount end, float offset) {
@@ -111,6 +388,7 @@ void AutomationLane::offsetRange(SampleCount start, SampleCount end, float offse
             point.value += offset;
         }
     }
+    publish();
 }
 
 SampleCount AutomationLane::getStart() const {
@@ -143,35 +421,6 @@ float AutomationLane::getMaxValue() const {
     return maxIt->value;
 }
 
-float AutomationLane::linearInterpolate(const AutomationPoint& p1, const AutomationPoint& p2,
-                                       SampleCount position) const {
-    if (p2.position == p1.position) return p1.value;
-
-    float t = static_cast<float>(position - p1.position) /
-              static_cast<float>(p2.position - p1.position);
-
-    return p1.value + t * (p2.value - p1.value);
-}
-
-float AutomationLane::curveInterpolate(const AutomationPoint& p1, const AutomationPoint& p2,
-                                      SampleCount position) const {
-    if (p2.position == p1.position) return p1.value;
-
-    float t = static_cast<float>(position - p1.position) /
-              static_cast<float>(p2.position - p1.position);
-
-    // Apply curve function
-    if (p1.curve > 0.0f) {
-        // Exponential curve
-        t = std::pow(t, 1.0f + p1.curve);
-    } else if (p1.curve < 0.0f) {
-        // Logarithmic curve
-        t = 1.0f - std::pow(1.0f - t, 1.0f - p1.curve);
-    }
-
-    return p1.value + t * (p2.value - p1.value);
-}
-
 std::vector<AutomationPoint>::const_iterator AutomationLane::findPointAt(SampleCount position) const {
     auto it = std::lower_bound(points_.begin(), points_.end(),
                               AutomationPoint{position, 0.0f});
@@ -199,32 +448,130 @@ std::vector<AutomationPoint>::const_iterator AutomationLane::findPointAfter(Samp
                            AutomationPoint{position, 0.0f});
 }
 
+// AutomationRecorder implementation
+AutomationRecorder::AutomationRecorder(AutomationLane& lane) : lane_(lane) {
+}
+
+void AutomationRecorder::setMode(AutomationWriteMode mode) {
+    mode_.store(mode, std::memory_order_relaxed);
+    if (mode == AutomationWriteMode::Read) {
+        writing_.store(false, std::memory_order_release);
+    }
+}
+
+void AutomationRecorder::beginTouch(float value) {
+    value_.store(value, std::memory_order_relaxed);
+    if (getMode() == AutomationWriteMode::Read) return;
+
+    if (!writing_.load(std::memory_order_relaxed)) {
+        pass_.fetch_add(1, std::memory_order_relaxed);
+    }
+    writing_.store(true, std::memory_order_release);
+}
+
+void AutomationRecorder::setValue(float value) {
+    value_.store(value, std::memory_order_relaxed);
+}
+
+void AutomationRecorder::endTouch() {
+    if (getMode() == AutomationWriteMode::Touch) {
+        writing_.store(false, std::memory_order_release);
+    }
+}
+
+void AutomationRecorder::stop() {
+    writing_.store(false, std::memory_order_release);
+}
+
+bool AutomationRecorder::capture(SampleCount position, float& value) noexcept {
+    if (!writing_.load(std::memory_order_acquire)) return false;
+
+    value = value_.load(std::memory_order_relaxed);
+
+    // One point per block; a stopped transport repeats the same position.
+    // A full queue drops the point, which thinning would mostly remove anyway.
+    if (position != lastCapture_) {
+        queue_.tryPush(CapturedValue{position, value, pass_.load(std::memory_order_relaxed)});
+        lastCapture_ = position;
+    }
+    return true;
+}
+
+bool AutomationRecorder::merge() {
+    bool changed = false;
+
+    while (auto captured = queue_.tryPop()) {
+        // A new touch or a jump back in time (loop, seek) starts a new pass
+        if (!pending_.empty() &&
+            (captured->pass != pendingPass_ || captured->position <= pending_.back().position)) {
+            changed |= flushPass();
+        }
+        pendingPass_ = captured->pass;
+        pending_.push_back(AutomationPoint{captured->position, captured->value, 0.0f});
+    }
+
+    if (!isWriting()) {
+        changed |= flushPass();
+    }
+    return changed;
+}
+
+bool AutomationRecorder::flushPass() {
+    if (pending_.empty()) return false;
+
+    const auto thinned = thinPoints(pending_, tolerance_);
+    pending_.clear();
+
+    const SampleCount first = thinned.front().position;
+    const SampleCount last = thinned.back().position;
+    auto& points = lane_.getPoints();
+
+    auto begin = std::lower_bound(points.begin(), points.end(), AutomationPoint{first, 0.0f});
+    auto end = std::upper_bound(points.begin(), points.end(), AutomationPoint{last, 0.0f});
+
+    // Pin the existing curve on both sides of the written range
+    const bool pinned = !points.empty();
+    std::vector<AutomationPoint> merged(points.begin(), begin);
+    if (pinned && (begin == points.begin() || std::prev(begin)->position < first - 1)) {
+        merged.push_back(AutomationPoint{first - 1, lane_.getValueAt(first - 1), 0.0f});
+    }
+    merged.insert(merged.end(), thinned.begin(), thinned.end());
+    if (pinned && (end == points.end() || end->position > last + 1)) {
+        merged.push_back(AutomationPoint{last + 1, lane_.getValueAt(last + 1), 0.0f});
+    }
+    merged.insert(merged.end(), end, points.end());
+
+    points = std::move(merged);
+    lane_.publish();
+    return true;
+}
+
 // AutomationManager implementation
 AutomationManager::AutomationManager() {
 }
 
-void AutomationManager::addLane(const std::string& parameterId, std::shared_ptr<AutomationLane> lane) {
+void AutomationManager::addLane(ParameterId parameterId, std::shared_ptr<AutomationLane> lane) {
     std::lock_guard<std::mutex> lock(lanesMutex_);
     lanes_[parameterId] = lane;
 }
 
-void AutomationManager::removeLane(const std::string& parameterId) {
+void AutomationManager::removeLane(ParameterId parameterId) {
     std::lock_guard<std::mutex> lock(lanesMutex_);
     lanes_.erase(parameterId);
 }
 
-std::shared_ptr<AutomationLane> AutomationManager::getLane(const std::string& parameterId) {
+std::shared_ptr<AutomationLane> AutomationManager::getLane(ParameterId parameterId) {
     std::lock_guard<std::mutex> lock(lanesMutex_);
     auto it = lanes_.find(parameterId);
     return (it != lanes_.end()) ? it->second : nullptr;
 }
 
-bool AutomationManager::hasLane(const std::string& parameterId) const {
+bool AutomationManager::hasLane(ParameterId parameterId) const {
     std::lock_guard<std::mutex> lock(lanesMutex_);
     return lanes_.find(parameterId) != lanes_.end();
 }
 
-float AutomationManager::getParameterValue(const std::string& parameterId, SampleCount position) const {
+float AutomationManager::getParameterValue(ParameterId parameterId, SampleCount position) const {
     std::lock_guard<std::mutex> lock(lanesMutex_);
 
     auto it = lanes_.find(parameterId);
@@ -250,13 +597,23 @@ void AutomationManager::clearRange(SampleCount start, SampleCount end) {
     }
 }
 
+void AutomationManager::mergeRecordings() {
+    std::lock_guard<std::mutex> lock(lanesMutex_);
+
+    for (auto& pair : lanes_) {
+        if (pair.second && pair.second->getActiveRecorder()) {
+            pair.second->getActiveRecorder()->merge();
+        }
+    }
+}
+
 AutomationManager::AutomationData AutomationManager::getData() const {
     std::lock_guard<std::mutex> lock(lanesMutex_);
 
     AutomationData automationData;
     for (const auto& pair : lanes_) {
         if (pair.second) {
-            automationData.lanes[pair.first] = pair.second->getData();
+            automationData.lanes[pair.first.name()] = pair.second->getData();
         }
     }
 
@@ -271,7 +628,7 @@ void AutomationManager::setData(const AutomationData& automationData) {
     for (const auto& pair : automationData.lanes) {
         auto lane = std::make_shared<AutomationLane>();
         lane->setData(pair.second);
-        lanes_[pair.first] = lane;
+        lanes_[ParameterId::intern(pair.first)] = lane;
     }
 }
 
@@ -1,9 +1,16 @@
 #pragma once
 
 #include "util/Types.hpp"
+#include "util/LockFreeQueue.hpp"
+#include "engine/graph/ParameterId.hpp"
 #include <vector>
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include <mutex>
+#include <string>
+#include <atomic>
+#include <utility>
 #include <algorithm>
 
 namespace ampl {
@@ -19,11 +26,81 @@ struct AutomationPoint {
     }
 };
 
-// Automation lane containing points and interpolation logic
+// Read position carried between consecutive reads of a lane, so a
+// contiguous playback run seeks with a binary search only once. Each reader
+// (e.g. each node parameter) keeps its own; a cursor is not thread-safe.
+struct AutomationCursor {
+    uint64_t version{0};       // Snapshot the cursor was positioned in
+    SampleCount position{-1};  // Where the next block is expected to start
+    size_t next{0};            // Index of the first point after position
+};
+
+// Immutable copy of a lane's points, read by the audio thread
+struct AutomationSnapshot {
+    std::vector<AutomationPoint> points;
+    uint64_t version{0};  // Unique per published snapshot; 0 = unpublished
+
+    float getValueAt(SampleCount position) const noexcept;
+
+    // Same, walking forward from cursor instead of searching: positions that
+    // only move forward (block by block) cost O(1) amortized
+    float getValueAt(AutomationCursor& cursor, SampleCount position) const noexcept;
+
+    // Writes the values for [start, start + numSamples) to out. Linear
+    // segments are written as ramps; long curved segments are evaluated
+    // exactly every few samples (at most kCurveStep) and interpolated in
+    // between. Returns true when
+    // the whole block holds a single value (out[0]), so callers can skip
+    // per-sample processing.
+    bool renderBlock(AutomationCursor& cursor, SampleCount start, int numSamples,
+                     float* out) const noexcept;
+
+    static constexpr int kCurveStep = 16;
+};
+
+class AutomationRecorder;
+
+// Marks the blocks in which one audio thread (e.g. one AudioGraph) reads
+// lane snapshots. Lanes free a replaced snapshot only once every reader has
+// been outside a block, or started a new one, since it was replaced, so any
+// number of graphs may process at once. Created and destroyed on the UI
+// thread, while the reader is not processing.
+class AutomationReader {
+public:
+    AutomationReader();
+    ~AutomationReader();
+
+    AutomationReader(const AutomationReader&) = delete;
+    AutomationReader& operator=(const AutomationReader&) = delete;
+
+    // Audio thread: call before reading any snapshot in a block
+    void beginBlock() noexcept;
+    // Audio thread: call once the block has finished with its snapshots
+    void endBlock() noexcept;
+
+private:
+    friend struct AutomationLane;
+
+    static constexpr uint64_t kIdle = ~uint64_t{0};
+
+    // Oldest epoch a reader may still be reading in; kIdle if none is
+    static uint64_t getOldestEpochInUse();
+
+    std::atomic<uint64_t> epoch_{kIdle};  // Epoch the current block began in
+};
+
+// Automation lane containing points and interpolation logic.
+// Every edit publishes a new AutomationSnapshot through an atomic pointer
+// (copy-on-write), so the audio thread reads points without locks or
+// refcounting. Replaced snapshots are freed once no AutomationReader can
+// still be reading them.
 struct AutomationLane {
 public:
     AutomationLane();
-    ~AutomationLane() = default;
+    ~AutomationLane();
+
+    AutomationLane(const AutomationLane&) = delete;
+    AutomationLane& operator=(const AutomationLane&) = delete;
 
     // Point management
     void addPoint(const AutomationPoint& point);
@@ -35,10 +112,40 @@ public:
     float getValueAt(SampleCount position) const;
     float getInterpolatedValue(SampleCount position) const;
 
-    // Point access
+    // Audio thread: block rendering of the published points (see
+    // AutomationSnapshot::renderBlock), with the reader's own cursor
+    bool renderBlock(AutomationCursor& cursor, SampleCount start, int numSamples,
+                     float* out) const noexcept {
+        return getSnapshot()->renderBlock(cursor, start, numSamples, out);
+    }
+
+    // Point access. Call publish() after editing the points directly.
     const std::vector<AutomationPoint>& getPoints() const { return points_; }
     std::vector<AutomationPoint>& getPoints() { return points_; }
 
+    // UI thread: makes the current points visible to the audio thread.
+    // Frees the replaced snapshot at once unless a reader is mid-block.
+    void publish();
+
+    // UI thread: frees replaced snapshots no reader can still see. publish()
+    // does this too; call it (e.g. from a UI timer) to free the last one
+    // without waiting for another edit.
+    void reclaimRetired();
+
+    // Audio thread: the latest published points, valid until the end of the block
+    const AutomationSnapshot* getSnapshot() const noexcept {
+        return snapshot_.load(std::memory_order_acquire);
+    }
+
+    // Touch/latch writing. Created on first use (UI thread) and kept for the
+    // lifetime of the lane.
+    AutomationRecorder& getRecorder();
+
+    // Audio thread: the lane's recorder, or null if it was never written
+    AutomationRecorder* getActiveRecorder() const noexcept {
+        return recorder_.load(std::memory_order_acquire);
+    }
+
     // Range operations
     void moveRange(SampleCount start, SampleCount end, SampleCount offset);
     void scaleRange(SampleCount start, SampleCount end, float scaleFactor);
@@ -57,16 +164,17 @@ public:
     };
 
     LaneData getData() const { return {points_}; }
-    void setData(const LaneData& data) { points_ = data.points; }
+    void setData(const LaneData& data) { points_ = data.points; publish(); }
 
 private:
     std::vector<AutomationPoint> points_;
 
-    // Interpolation methods
-    float linearInterpolate(const AutomationPoint& p1, const AutomationPoint& p2,
-                           SampleCount position) const;
-    float curveInterpolate(const AutomationPoint& p1, const AutomationPoint& p2,
-                          SampleCount position) const;
+    std::atomic<const AutomationSnapshot*> snapshot_{nullptr};
+    // Replaced snapshots with the epoch they were replaced in, oldest first
+    std::vector<std::pair<uint64_t, std::unique_ptr<const AutomationSnapshot>>> retired_;
+
+    std::unique_ptr<AutomationRecorder> recorderStorage_;
+    std::atomic<AutomationRecorder*> recorder_{nullptr};
 
     // Helper methods
     std::vector<AutomationPoint>::const_iterator findPointAt(SampleCount position) const;
@@ -74,25 +182,114 @@ private:
     std::vector<AutomationPoint>::const_iterator findPointAfter(SampleCount position) const;
 };
 
+// Automation write modes
+enum class AutomationWriteMode {
+    Read,   // Play back the lane
+    Touch,  // Write while the control is held, then return to the lane
+    Latch   // Write from the first touch until the transport stops
+};
+
+// Records control moves into a lane. The UI thread reports touches and
+// values; the audio thread stamps the live value with its sample position
+// once per block and pushes it through a lock-free queue; the message thread
+// merges each finished pass into the lane, thinned with Ramer-Douglas-Peucker,
+// and publishes it as a new snapshot. Playback never waits for the writer.
+// Only one node may drive a lane that is being written (single producer).
+//
+// This is engine-side support only. The host of an AudioGraph drives it: its
+// controls call beginTouch()/setValue()/endTouch() and its message-thread
+// timer calls merge() (or AutomationManager::mergeRecordings()). The app's
+// mixer and inspector play back through SessionRenderer, which has no
+// automation lanes, so their faders are not recorded yet.
+class AutomationRecorder {
+public:
+    explicit AutomationRecorder(AutomationLane& lane);
+
+    // UI thread
+    void setMode(AutomationWriteMode mode);
+    AutomationWriteMode getMode() const { return mode_.load(std::memory_order_relaxed); }
+
+    // Largest deviation of the thinned curve from the captured values
+    void setTolerance(float tolerance) { tolerance_ = std::max(0.0f, tolerance); }
+    float getTolerance() const { return tolerance_; }
+
+    void beginTouch(float value);
+    void setValue(float value);
+    void endTouch();
+    void stop();  // Transport stopped: ends a latch pass
+
+    bool isWriting() const noexcept { return writing_.load(std::memory_order_acquire); }
+
+    // Audio thread: while writing, records the live value at position and
+    // returns true with it in value
+    bool capture(SampleCount position, float& value) noexcept;
+
+    // Message thread: merges finished passes into the lane. Returns true if
+    // the lane changed.
+    bool merge();
+
+private:
+    struct CapturedValue {
+        SampleCount position{0};
+        float value{0.0f};
+        uint32_t pass{0};
+    };
+
+    bool flushPass();
+
+    AutomationLane& lane_;
+    LockFreeQueue<CapturedValue, 4096> queue_;
+
+    std::atomic<AutomationWriteMode> mode_{AutomationWriteMode::Read};
+    std::atomic<float> value_{0.0f};
+    std::atomic<bool> writing_{false};
+    std::atomic<uint32_t> pass_{0};
+    float tolerance_{0.001f};
+
+    // Audio thread
+    SampleCount lastCapture_{-1};
+
+    // Message thread: the pass being collected
+    std::vector<AutomationPoint> pending_;
+    uint32_t pendingPass_{0};
+};
+
 // Automation manager for handling multiple lanes and parameter mapping
 class AutomationManager {
 public:
     AutomationManager();
     ~AutomationManager() = default;
 
-    // Lane management
-    void addLane(const std::string& parameterId, std::shared_ptr<AutomationLane> lane);
-    void removeLane(const std::string& parameterId);
-    std::shared_ptr<AutomationLane> getLane(const std::string& parameterId);
-    bool hasLane(const std::string& parameterId) const;
+    // Lane management. Lanes are keyed by interned ParameterId; the string
+    // overloads resolve the handle first.
+    void addLane(ParameterId parameterId, std::shared_ptr<AutomationLane> lane);
+    void removeLane(ParameterId parameterId);
+    std::shared_ptr<AutomationLane> getLane(ParameterId parameterId);
+    bool hasLane(ParameterId parameterId) const;
+
+    void addLane(const std::string& parameterId, std::shared_ptr<AutomationLane> lane) {
+        addLane(ParameterId::intern(parameterId), std::move(lane));
+    }
+    void removeLane(const std::string& parameterId) { removeLane(ParameterId::find(parameterId)); }
+    std::shared_ptr<AutomationLane> getLane(const std::string& parameterId) {
+        return getLane(ParameterId::find(parameterId));
+    }
+    bool hasLane(const std::string& parameterId) const { return hasLane(ParameterId::find(parameterId)); }
 
     // Value retrieval
-    float getParameterValue(const std::string& parameterId, SampleCount position) const;
+    float getParameterValue(ParameterId parameterId, SampleCount position) const;
+    float getParameterValue(const std::string& parameterId, SampleCount position) const {
+        return getParameterValue(ParameterId::find(parameterId), position);
+    }
 
     // Global operations
     void clear();
     void clearRange(SampleCount start, SampleCount end);
 
+    // Message thread: merges recorded passes of every lane being written.
+    // Call periodically (e.g. from a UI timer) while recording.
+    void mergeRecordings();
+
     // Serialization
     struct AutomationData {
         std::map<std::string, AutomationLane::LaneData> lanes;
@@ -102,7 +299,7 @@ public:
     void setData(const AutomationData& data);
 
 private:
-    std::map<std::string, std::shared_ptr<AutomationLane>> lanes_;
+    std::unordered_map<ParameterId, std::shared_ptr<AutomationLane>> lanes_;
     mutable std::mutex lanesMutex_;
 };
 
@@ -0,0 +1,269 @@
+#include "engine/graph/BiquadCascade.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define AMPL_BIQUAD_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define AMPL_BIQUAD_NEON 1
+#endif
+
+namespace ampl
+{
+
+namespace
+{
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Two doubles, one per channel of a pair
+#if AMPL_BIQUAD_SSE2
+using Lanes = __m128d;
+inline Lanes splat(double v) noexcept { return _mm_set1_pd(v); }
+inline Lanes load(const double *p) noexcept { return _mm_load_pd(p); }
+inline void store(double *p, Lanes v) noexcept { _mm_store_pd(p, v); }
+inline Lanes make(double a, double b) noexcept { return _mm_set_pd(b, a); }
+inline Lanes add(Lanes a, Lanes b) noexcept { return _mm_add_pd(a, b); }
+inline Lanes sub(Lanes a, Lanes b) noexcept { return _mm_sub_pd(a, b); }
+inline Lanes mul(Lanes a, Lanes b) noexcept { return _mm_mul_pd(a, b); }
+inline double lane0(Lanes v) noexcept { return _mm_cvtsd_f64(v); }
+inline double lane1(Lanes v) noexcept { return _mm_cvtsd_f64(_mm_unpackhi_pd(v, v)); }
+#elif AMPL_BIQUAD_NEON
+using Lanes = float64x2_t;
+inline Lanes splat(double v) noexcept { return vdupq_n_f64(v); }
+inline Lanes load(const double *p) noexcept { return vld1q_f64(p); }
+inline void store(double *p, Lanes v) noexcept { vst1q_f64(p, v); }
+inline Lanes make(double a, double b) noexcept { return vsetq_lane_f64(b, vdupq_n_f64(a), 1); }
+inline Lanes add(Lanes a, Lanes b) noexcept { return vaddq_f64(a, b); }
+inline Lanes sub(Lanes a, Lanes b) noexcept { return vsubq_f64(a, b); }
+inline Lanes mul(Lanes a, Lanes b) noexcept { return vmulq_f64(a, b); }
+inline double lane0(Lanes v) noexcept { return vgetq_lane_f64(v, 0); }
+inline double lane1(Lanes v) noexcept { return vgetq_lane_f64(v, 1); }
+#else
+struct Lanes
+{
+    double v[2];
+};
+inline Lanes splat(double v) noexcept { return {{v, v}}; }
+inline Lanes load(const double *p) noexcept { return {{p[0], p[1]}}; }
+inline void store(double *p, Lanes v) noexcept { p[0] = v.v[0]; p[1] = v.v[1]; }
+inline Lanes make(double a, double b) noexcept { return {{a, b}}; }
+inline Lanes add(Lanes a, Lanes b) noexcept { return {{a.v[0] + b.v[0], a.v[1] + b.v[1]}}; }
+inline Lanes sub(Lanes a, Lanes b) noexcept { return {{a.v[0] - b.v[0], a.v[1] - b.v[1]}}; }
+inline Lanes mul(Lanes a, Lanes b) noexcept { return {{a.v[0] * b.v[0], a.v[1] * b.v[1]}}; }
+inline double lane0(Lanes v) noexcept { return v.v[0]; }
+inline double lane1(Lanes v) noexcept { return v.v[1]; }
+#endif
+
+BiquadCoefficients difference(const BiquadCoefficients &a, const BiquadCoefficients &b,
+                              double scale) noexcept
+{
+    return {(a.b0 - b.b0) * scale, (a.b1 - b.b1) * scale, (a.b2 - b.b2) * scale,
+            (a.a1 - b.a1) * scale, (a.a2 - b.a2) * scale};
+}
+
+void accumulate(BiquadCoefficients &c, const BiquadCoefficients &step) noexcept
+{
+    c.b0 += step.b0;
+    c.b1 += step.b1;
+    c.b2 += step.b2;
+    c.a1 += step.a1;
+    c.a2 += step.a2;
+}
+
+} // namespace
+
+BiquadCoefficients BiquadCoefficients::peaking(double sampleRate, double frequency, double gainDb,
+                                               double q) noexcept
+{
+    if (gainDb == 0.0 || sampleRate <= 0.0)
+        return {};
+
+    const double omega = 2.0 * kPi * std::clamp(frequency, 1.0, sampleRate * 0.49) / sampleRate;
+    const double sinOmega = std::sin(omega);
+    const double cosOmega = std::cos(omega);
+    const double A = std::pow(10.0, gainDb / 40.0);
+    const double alpha = sinOmega / (2.0 * std::max(q, 1.0e-3));
+
+    const double a0 = 1.0 + alpha / A;
+    return {(1.0 + alpha * A) / a0, (-2.0 * cosOmega) / a0, (1.0 - alpha * A) / a0,
+            (-2.0 * cosOmega) / a0, (1.0 - alpha / A) / a0};
+}
+
+void BiquadCascade::setRampLength(int samples) noexcept
+{
+    rampLength_ = std::max(1, samples);
+}
+
+void BiquadCascade::setCoefficients(int stage, const BiquadCoefficients &coefficients) noexcept
+{
+    if (stage < 0 || stage >= kMaxStages)
+        return;
+
+    auto &s = stages_[static_cast<size_t>(stage)];
+    s.target = coefficients;
+    s.step = difference(coefficients, s.current, 1.0 / rampLength_);
+    s.rampRemaining = rampLength_;
+    numStages_ = std::max(numStages_, stage + 1);
+}
+
+void BiquadCascade::setCoefficientsImmediately(int stage,
+                                               const BiquadCoefficients &coefficients) noexcept
+{
+    if (stage < 0 || stage >= kMaxStages)
+        return;
+
+    auto &s = stages_[static_cast<size_t>(stage)];
+    s.current = s.target = coefficients;
+    s.rampRemaining = 0;
+    numStages_ = std::max(numStages_, stage + 1);
+}
+
+void BiquadCascade::reset() noexcept
+{
+    for (auto &s : stages_)
+    {
+        s.current = s.target;
+        s.rampRemaining = 0;
+    }
+    for (auto &pair : state_)
+        pair.fill(PairState{});
+}
+
+void BiquadCascade::process(float *const *channels, int numChannels, int numSamples) noexcept
+{
+    numChannels = std::min(numChannels, kMaxChannels);
+    if (numChannels <= 0 || numSamples <= 0)
+        return;
+
+    // Stages that change the signal this block; flat, settled stages are skipped
+    std::array<int, kMaxStages> active{};
+    int numActive = 0;
+    for (int s = 0; s < numStages_; ++s)
+    {
+        const auto &stage = stages_[static_cast<size_t>(s)];
+        if (stage.rampRemaining > 0 || !stage.current.isIdentity())
+            active[static_cast<size_t>(numActive++)] = s;
+    }
+    if (numActive == 0)
+        return;
+
+    // Samples at the start of the block in which some stage is still ramping
+    int rampSamples = 0;
+    for (int a = 0; a < numActive; ++a)
+    {
+        const auto &stage = stages_[static_cast<size_t>(active[static_cast<size_t>(a)])];
+        rampSamples = std::max(rampSamples, stage.rampRemaining);
+    }
+    rampSamples = std::min(rampSamples, numSamples);
+
+    // Every pair walks the same ramp, from a copy of the block-start coefficients
+    std::array<Stage, kMaxStages> ramped = stages_;
+
+    for (int first = 0; first < numChannels; first += 2)
+    {
+        float *left = channels[first];
+        float *right = first + 1 < numChannels ? channels[first + 1] : nullptr;
+        if (left == nullptr)
+            std::swap(left, right);
+        if (left == nullptr)
+            continue;
+
+        // State lives in registers (or at least not behind the sample pointers)
+        auto &pairState = state_[static_cast<size_t>(first / 2)];
+        Lanes z1[kMaxStages];
+        Lanes z2[kMaxStages];
+        for (int a = 0; a < numActive; ++a)
+        {
+            const auto &z = pairState[static_cast<size_t>(active[static_cast<size_t>(a)])];
+            z1[a] = load(z.z1);
+            z2[a] = load(z.z2);
+        }
+
+        ramped = stages_;
+        int i = 0;
+
+        // Ramping: coefficients advance every sample
+        for (; i < rampSamples; ++i)
+        {
+            Lanes x = make(left[i], right != nullptr ? right[i] : 0.0f);
+            for (int a = 0; a < numActive; ++a)
+            {
+                auto &stage = ramped[static_cast<size_t>(active[static_cast<size_t>(a)])];
+                if (stage.rampRemaining > 0)
+                {
+                    if (--stage.rampRemaining == 0)
+                        stage.current = stage.target;
+                    else
+                        accumulate(stage.current, stage.step);
+                }
+
+                const auto &c = stage.current;
+                auto &s1 = z1[a];
+                auto &s2 = z2[a];
+                const Lanes y = add(mul(splat(c.b0), x), s1);
+                s1 = add(sub(mul(splat(c.b1), x), mul(splat(c.a1), y)), s2);
+                s2 = sub(mul(splat(c.b2), x), mul(splat(c.a2), y));
+                x = y;
+            }
+            left[i] = static_cast<float>(lane0(x));
+            if (right != nullptr)
+                right[i] = static_cast<float>(lane1(x));
+        }
+
+        // Settled: coefficients broadcast once for the rest of the block
+        if (i < numSamples)
+        {
+            Lanes b0[kMaxStages], b1[kMaxStages], b2[kMaxStages], a1[kMaxStages], a2[kMaxStages];
+            for (int a = 0; a < numActive; ++a)
+            {
+                const auto &c = ramped[static_cast<size_t>(active[static_cast<size_t>(a)])].current;
+                b0[a] = splat(c.b0);
+                b1[a] = splat(c.b1);
+                b2[a] = splat(c.b2);
+                a1[a] = splat(c.a1);
+                a2[a] = splat(c.a2);
+            }
+
+            for (; i < numSamples; ++i)
+            {
+                Lanes x = make(left[i], right != nullptr ? right[i] : 0.0f);
+                for (int a = 0; a < numActive; ++a)
+                {
+                    const Lanes y = add(mul(b0[a], x), z1[a]);
+                    z1[a] = add(sub(mul(b1[a], x), mul(a1[a], y)), z2[a]);
+                    z2[a] = sub(mul(b2[a], x), mul(a2[a], y));
+                    x = y;
+                }
+                left[i] = static_cast<float>(lane0(x));
+                if (right != nullptr)
+                    right[i] = static_cast<float>(lane1(x));
+            }
+        }
+
+        for (int a = 0; a < numActive; ++a)
+        {
+            auto &z = pairState[static_cast<size_t>(active[static_cast<size_t>(a)])];
+            store(z.z1, z1[a]);
+            store(z.z2, z2[a]);
+        }
+    }
+
+    stages_ = ramped;
+
+    // Settled identity stages hold no signal: clear them so re-enabling starts clean
+    for (int a = 0; a < numActive; ++a)
+    {
+        const int s = active[static_cast<size_t>(a)];
+        const auto &stage = stages_[static_cast<size_t>(s)];
+        if (stage.rampRemaining == 0 && stage.current.isIdentity())
+        {
+            for (auto &pair : state_)
+                pair[static_cast<size_t>(s)] = PairState{};
+        }
+    }
+}
+
+} // namespace ampl
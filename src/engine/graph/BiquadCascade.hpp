@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+
+namespace ampl
+{
+
+// Normalized biquad coefficients (a0 = 1)
+struct BiquadCoefficients
+{
+    double b0{1.0};
+    double b1{0.0};
+    double b2{0.0};
+    double a1{0.0};
+    double a2{0.0};
+
+    bool isIdentity() const noexcept
+    {
+        return b0 == 1.0 && b1 == 0.0 && b2 == 0.0 && a1 == 0.0 && a2 == 0.0;
+    }
+
+    // RBJ cookbook peaking filter; identity at 0 dB
+    static BiquadCoefficients peaking(double sampleRate, double frequency, double gainDb,
+                                      double q) noexcept;
+};
+
+// Cascade of biquad stages applied to several channels. Transposed direct
+// form II in double precision, with separate state per channel and stage.
+// Channels are processed in pairs, as the two lanes of one SIMD register
+// (SSE2 or NEON; scalar elsewhere). Coefficient changes are interpolated per
+// sample over a short ramp, so moving or automating a filter does not click.
+// Stages at identity that are not ramping are skipped.
+class BiquadCascade
+{
+  public:
+    static constexpr int kMaxStages = 8;
+    static constexpr int kMaxChannels = 8;
+
+    // Samples over which a coefficient change is interpolated
+    void setRampLength(int samples) noexcept;
+
+    // Audio thread: ramps the stage to new coefficients
+    void setCoefficients(int stage, const BiquadCoefficients &coefficients) noexcept;
+
+    // Jumps to the coefficients without a ramp (after prepare or reset)
+    void setCoefficientsImmediately(int stage, const BiquadCoefficients &coefficients) noexcept;
+
+    // Clears filter state and finishes any ramp
+    void reset() noexcept;
+
+    // Filters the first numChannels channels in place
+    void process(float *const *channels, int numChannels, int numSamples) noexcept;
+
+  private:
+    struct Stage
+    {
+        BiquadCoefficients current;
+        BiquadCoefficients target;
+        BiquadCoefficients step;
+        int rampRemaining{0};
+    };
+
+    // TDF-II state of one stage for a channel pair
+    struct alignas(16) PairState
+    {
+        double z1[2]{0.0, 0.0};
+        double z2[2]{0.0, 0.0};
+    };
+
+    std::array<Stage, kMaxStages> stages_{};
+    std::array<std::array<PairState, kMaxStages>, kMaxChannels / 2> state_{};
+    int numStages_{0};
+    int rampLength_{64};
+};
+
+} // namespace ampl
@@ -0,0 +1,463 @@
+#include "engine/graph/DynamicsEngine.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define AMPL_DYNAMICS_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define AMPL_DYNAMICS_NEON 1
+#endif
+
+namespace ampl
+{
+
+namespace
+{
+
+// Levels below this (-200 dB) are treated as silence by the detector
+constexpr float kLevelFloor = 1.0e-10f;
+
+// Averaging time of the RMS detector
+constexpr double kRmsWindowMs = 10.0;
+
+// Brickwall mode aims this far below the threshold, covering the error of the
+// log2/exp2 approximations
+constexpr float kBrickwallMarginDb = 0.005f;
+
+constexpr float kDecibelsPerLog2Amplitude = 6.0205999f; // 20 * log10(2)
+constexpr float kDecibelsPerLog2Power = 3.0103f;        // 10 * log10(2)
+constexpr float kLog2PerDecibel = 0.16609640f;          // log2(10) / 20
+
+// Least-squares polynomials: log2(m) for m in [1, 2) and 2^f for f in [0, 1).
+// Errors stay within 0.0013 dB and 0.00005 dB.
+constexpr float kLog2C0 = -2.4968459f;
+constexpr float kLog2C1 = 4.0285475f;
+constexpr float kLog2C2 = -2.0812137f;
+constexpr float kLog2C3 = 0.62887341f;
+constexpr float kLog2C4 = -0.079158128f;
+
+constexpr float kExp2C0 = 1.0000052f;
+constexpr float kExp2C1 = 0.69297457f;
+constexpr float kExp2C2 = 0.24150804f;
+constexpr float kExp2C3 = 0.05199022f;
+constexpr float kExp2C4 = 0.013511465f;
+
+// x > 0 and normal
+inline float fastLog2(float x) noexcept
+{
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    const auto exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+    bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    return exponent + (kLog2C0 + m * (kLog2C1 + m * (kLog2C2 + m * (kLog2C3 + m * kLog2C4))));
+}
+
+inline float fastExp2(float x) noexcept
+{
+    x = std::clamp(x, -126.0f, 126.0f);
+    const float whole = std::floor(x);
+    const float f = x - whole;
+    const auto bits = static_cast<uint32_t>(static_cast<int32_t>(whole) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return scale * (kExp2C0 + f * (kExp2C1 + f * (kExp2C2 + f * (kExp2C3 + f * kExp2C4))));
+}
+
+#if AMPL_DYNAMICS_SSE2
+inline __m128 madd(__m128 a, __m128 b, __m128 c) noexcept
+{
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+inline __m128 log2x4(__m128 x) noexcept
+{
+    const __m128i bits = _mm_castps_si128(x);
+    const __m128 exponent =
+        _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    const __m128 m = _mm_castsi128_ps(_mm_or_si128(
+        _mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+
+    __m128 p = _mm_set1_ps(kLog2C4);
+    p = madd(p, m, _mm_set1_ps(kLog2C3));
+    p = madd(p, m, _mm_set1_ps(kLog2C2));
+    p = madd(p, m, _mm_set1_ps(kLog2C1));
+    p = madd(p, m, _mm_set1_ps(kLog2C0));
+    return _mm_add_ps(exponent, p);
+}
+
+inline __m128 exp2x4(__m128 x) noexcept
+{
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(126.0f));
+
+    // Floor: truncate, then step down where truncation rounded up
+    __m128i whole = _mm_cvttps_epi32(x);
+    const __m128 roundedUp = _mm_cmpgt_ps(_mm_cvtepi32_ps(whole), x);
+    whole = _mm_add_epi32(whole, _mm_castps_si128(roundedUp));
+    const __m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(whole));
+
+    __m128 p = _mm_set1_ps(kExp2C4);
+    p = madd(p, f, _mm_set1_ps(kExp2C3));
+    p = madd(p, f, _mm_set1_ps(kExp2C2));
+    p = madd(p, f, _mm_set1_ps(kExp2C1));
+    p = madd(p, f, _mm_set1_ps(kExp2C0));
+
+    const __m128 scale =
+        _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23));
+    return _mm_mul_ps(p, scale);
+}
+#elif AMPL_DYNAMICS_NEON
+inline float32x4_t madd(float32x4_t a, float32x4_t b, float32x4_t c) noexcept
+{
+    return vaddq_f32(vmulq_f32(a, b), c);
+}
+
+inline float32x4_t log2x4(float32x4_t x) noexcept
+{
+    const uint32x4_t bits = vreinterpretq_u32_f32(x);
+    const float32x4_t exponent = vcvtq_f32_s32(
+        vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+    const float32x4_t m = vreinterpretq_f32_u32(
+        vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007FFFFF)), vdupq_n_u32(0x3F800000)));
+
+    float32x4_t p = vdupq_n_f32(kLog2C4);
+    p = madd(p, m, vdupq_n_f32(kLog2C3));
+    p = madd(p, m, vdupq_n_f32(kLog2C2));
+    p = madd(p, m, vdupq_n_f32(kLog2C1));
+    p = madd(p, m, vdupq_n_f32(kLog2C0));
+    return vaddq_f32(exponent, p);
+}
+
+inline float32x4_t exp2x4(float32x4_t x) noexcept
+{
+    x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-126.0f)), vdupq_n_f32(126.0f));
+
+    // Floor: truncate, then step down where truncation rounded up
+    int32x4_t whole = vcvtq_s32_f32(x);
+    const uint32x4_t roundedUp = vcgtq_f32(vcvtq_f32_s32(whole), x);
+    whole = vaddq_s32(whole, vreinterpretq_s32_u32(roundedUp));
+    const float32x4_t f = vsubq_f32(x, vcvtq_f32_s32(whole));
+
+    float32x4_t p = vdupq_n_f32(kExp2C4);
+    p = madd(p, f, vdupq_n_f32(kExp2C3));
+    p = madd(p, f, vdupq_n_f32(kExp2C2));
+    p = madd(p, f, vdupq_n_f32(kExp2C1));
+    p = madd(p, f, vdupq_n_f32(kExp2C0));
+
+    const float32x4_t scale =
+        vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(whole, vdupq_n_s32(127)), 23));
+    return vmulq_f32(p, scale);
+}
+#endif
+
+// values[i] = scale * log2(values[i]), with values floored at kLevelFloor
+void toDecibels(float *values, int numSamples, float scale) noexcept
+{
+    int i = 0;
+#if AMPL_DYNAMICS_SSE2
+    const __m128 floor = _mm_set1_ps(kLevelFloor);
+    const __m128 s = _mm_set1_ps(scale);
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const __m128 x = _mm_max_ps(_mm_loadu_ps(values + i), floor);
+        _mm_storeu_ps(values + i, _mm_mul_ps(log2x4(x), s));
+    }
+#elif AMPL_DYNAMICS_NEON
+    const float32x4_t floor = vdupq_n_f32(kLevelFloor);
+    const float32x4_t s = vdupq_n_f32(scale);
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        const float32x4_t x = vmaxq_f32(vld1q_f32(values + i), floor);
+        vst1q_f32(values + i, vmulq_f32(log2x4(x), s));
+    }
+#endif
+    for (; i < numSamples; ++i)
+        values[i] = scale * fastLog2(std::max(values[i], kLevelFloor));
+}
+
+// values[i] = 10^(values[i] / 20): decibels to linear gain
+void toGain(float *values, int numSamples) noexcept
+{
+    int i = 0;
+#if AMPL_DYNAMICS_SSE2
+    const __m128 s = _mm_set1_ps(kLog2PerDecibel);
+    for (; i + 4 <= numSamples; i += 4)
+        _mm_storeu_ps(values + i, exp2x4(_mm_mul_ps(_mm_loadu_ps(values + i), s)));
+#elif AMPL_DYNAMICS_NEON
+    const float32x4_t s = vdupq_n_f32(kLog2PerDecibel);
+    for (; i + 4 <= numSamples; i += 4)
+        vst1q_f32(values + i, exp2x4(vmulq_f32(vld1q_f32(values + i), s)));
+#endif
+    for (; i < numSamples; ++i)
+        values[i] = fastExp2(values[i] * kLog2PerDecibel);
+}
+
+float smoothingCoefficient(double sampleRate, double milliseconds) noexcept
+{
+    const double samples = sampleRate * milliseconds * 0.001;
+    return samples > 1.0 ? static_cast<float>(std::exp(-1.0 / samples)) : 0.0f;
+}
+
+} // namespace
+
+void DynamicsEngine::prepare(double sampleRate, int maxLookaheadSamples)
+{
+    sampleRate_ = sampleRate > 0.0 ? sampleRate : 44100.0;
+    maxLookahead_ = std::max(0, maxLookaheadSamples);
+    lookahead_ = std::min(lookahead_, maxLookahead_);
+
+    // A chunk is written before the oldest delayed sample is read
+    delaySize_ = maxLookahead_ + kChunkSize;
+    delayMemory_.assign(static_cast<size_t>(kMaxChannels) * static_cast<size_t>(delaySize_),
+                        0.0f);
+
+    const auto window = static_cast<size_t>(maxLookahead_ + 1);
+    minValues_.assign(window, 0.0f);
+    minTimes_.assign(window, 0);
+    averageHistory_.assign(window, 0.0f);
+
+    configured_ = false;
+    setSettings(settings_);
+    reset();
+}
+
+void DynamicsEngine::setSettings(const Settings &settings) noexcept
+{
+    if (configured_ && settings == settings_)
+        return;
+
+    settings_ = settings;
+    configured_ = true;
+
+    slope_ = settings.brickwall ? -1.0f : 1.0f / std::max(settings.ratio, 1.0f) - 1.0f;
+    const float knee = settings.brickwall ? 0.0f : std::max(settings.kneeDb, 0.0f);
+    kneeScale_ = knee > 0.0f ? 0.5f / knee : 0.0f;
+    attackCoeff_ = smoothingCoefficient(sampleRate_, settings.attackMs);
+    releaseCoeff_ = smoothingCoefficient(sampleRate_, settings.releaseMs);
+    rmsCoeff_ = 1.0f - smoothingCoefficient(sampleRate_, kRmsWindowMs);
+}
+
+void DynamicsEngine::setLookahead(int samples) noexcept
+{
+    samples = std::clamp(samples, 0, maxLookahead_);
+    if (samples == lookahead_)
+        return;
+
+    lookahead_ = samples;
+    reset();
+}
+
+void DynamicsEngine::reset() noexcept
+{
+    envelopeDb_ = 0.0f;
+    meanSquare_ = 0.0f;
+    gainReductionDb_.store(0.0f, std::memory_order_relaxed);
+
+    std::fill(delayMemory_.begin(), delayMemory_.end(), 0.0f);
+    delayWrite_ = 0;
+
+    minHead_ = 0;
+    minCount_ = 0;
+    std::fill(averageHistory_.begin(), averageHistory_.end(), 0.0f);
+    averagePos_ = 0;
+    averageSum_ = 0.0;
+    sampleCounter_ = 0;
+}
+
+void DynamicsEngine::process(float *const *channels, int numChannels, const float *const *key,
+                             int numKeyChannels, int numSamples) noexcept
+{
+    numChannels = std::min(numChannels, kMaxChannels);
+    if (channels == nullptr || numChannels <= 0 || numSamples <= 0)
+        return;
+
+    if (key == nullptr)
+    {
+        key = channels;
+        numKeyChannels = numChannels;
+    }
+
+    for (int offset = 0; offset < numSamples; offset += kChunkSize)
+    {
+        processChunk(channels, numChannels, key, numKeyChannels, offset,
+                     std::min(kChunkSize, numSamples - offset));
+    }
+
+    gainReductionDb_.store(envelopeDb_, std::memory_order_relaxed);
+}
+
+void DynamicsEngine::processChunk(float *const *channels, int numChannels,
+                                  const float *const *key, int numKeyChannels, int offset,
+                                  int numSamples) noexcept
+{
+    float *level = level_.data();
+    float *gain = gain_.data();
+
+    // Detector, before the channels are touched: the key may be the channels
+    detect(key, numKeyChannels, offset, numSamples);
+    toDecibels(level, numSamples,
+               settings_.detector == Detector::RMS ? kDecibelsPerLog2Power
+                                                   : kDecibelsPerLog2Amplitude);
+
+    // Static curve with a quadratic soft knee; hard when kneeScale_ is zero
+    const float knee = kneeScale_ > 0.0f ? 0.5f / kneeScale_ : 0.0f;
+    const float threshold = settings_.thresholdDb - (settings_.brickwall ? kBrickwallMarginDb : 0.0f);
+    const float start = threshold - 0.5f * knee;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float over = level[i] - start;
+        const float inKnee = std::clamp(over, 0.0f, knee);
+        gain[i] = slope_ * (inKnee * inKnee * kneeScale_ + std::max(over - knee, 0.0f));
+    }
+
+    if (settings_.brickwall)
+        smoothBrickwall(numSamples);
+    else
+        smoothCompressor(numSamples);
+
+    const float makeup = settings_.makeupDb;
+    for (int i = 0; i < numSamples; ++i)
+        gain[i] += makeup;
+    toGain(gain, numSamples);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float *channel = channels[ch];
+        if (channel == nullptr)
+            continue;
+
+        channel += offset;
+        if (lookahead_ > 0)
+            delay(channel, ch, numSamples);
+        for (int i = 0; i < numSamples; ++i)
+            channel[i] *= gain[i];
+    }
+
+    if (lookahead_ > 0)
+        delayWrite_ = (delayWrite_ + numSamples) % delaySize_;
+}
+
+void DynamicsEngine::detect(const float *const *key, int numKeyChannels, int offset,
+                            int numSamples) noexcept
+{
+    float *level = level_.data();
+    std::fill(level, level + numSamples, 0.0f);
+
+    // Linked detection: the loudest channel drives every channel's gain
+    const bool rms = settings_.detector == Detector::RMS;
+    for (int ch = 0; ch < numKeyChannels; ++ch)
+    {
+        const float *in = key[ch];
+        if (in == nullptr)
+            continue;
+
+        in += offset;
+        if (rms)
+        {
+            for (int i = 0; i < numSamples; ++i)
+                level[i] = std::max(level[i], in[i] * in[i]);
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                level[i] = std::max(level[i], std::abs(in[i]));
+        }
+    }
+
+    if (rms)
+    {
+        float meanSquare = meanSquare_;
+        for (int i = 0; i < numSamples; ++i)
+        {
+            meanSquare += rmsCoeff_ * (level[i] - meanSquare);
+            level[i] = meanSquare;
+        }
+        meanSquare_ = meanSquare;
+    }
+}
+
+void DynamicsEngine::smoothCompressor(int numSamples) noexcept
+{
+    float *gain = gain_.data();
+    float envelope = envelopeDb_;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const float target = gain[i];
+        const float coeff = target < envelope ? attackCoeff_ : releaseCoeff_;
+        envelope = target + coeff * (envelope - target);
+        gain[i] = envelope;
+    }
+    envelopeDb_ = envelope;
+}
+
+void DynamicsEngine::smoothBrickwall(int numSamples) noexcept
+{
+    // Over a window of lookahead + 1 samples, the minimum covers every target
+    // still in the delay, and averaging the minima ramps into each reduction
+    // while never rising above it
+    float *gain = gain_.data();
+    const int window = lookahead_ + 1;
+    const int capacity = maxLookahead_ + 1;
+    const double windowScale = 1.0 / window;
+    float envelope = envelopeDb_;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const int64_t now = sampleCounter_++;
+
+        if (minCount_ > 0 && minTimes_[static_cast<size_t>(minHead_)] <= now - window)
+        {
+            minHead_ = (minHead_ + 1) % capacity;
+            --minCount_;
+        }
+        while (minCount_ > 0)
+        {
+            const auto back = static_cast<size_t>((minHead_ + minCount_ - 1) % capacity);
+            if (minValues_[back] < gain[i])
+                break;
+            --minCount_;
+        }
+        const auto tail = static_cast<size_t>((minHead_ + minCount_) % capacity);
+        minValues_[tail] = gain[i];
+        minTimes_[tail] = now;
+        ++minCount_;
+
+        const float minimum = minValues_[static_cast<size_t>(minHead_)];
+        auto &oldest = averageHistory_[static_cast<size_t>(averagePos_)];
+        averageSum_ += minimum - oldest;
+        oldest = minimum;
+        averagePos_ = averagePos_ + 1 < window ? averagePos_ + 1 : 0;
+        const auto average = static_cast<float>(averageSum_ * windowScale);
+
+        // Release only ever holds the gain lower than the average
+        envelope = average < envelope ? average : average + releaseCoeff_ * (envelope - average);
+        gain[i] = envelope;
+    }
+    envelopeDb_ = envelope;
+}
+
+void DynamicsEngine::delay(float *channel, int ch, int numSamples) noexcept
+{
+    float *ring = delayMemory_.data() + static_cast<size_t>(ch) * static_cast<size_t>(delaySize_);
+
+    // Write the chunk, then read it back lookahead_ samples late; both wrap
+    // at most once
+    const int firstWrite = std::min(numSamples, delaySize_ - delayWrite_);
+    std::memcpy(ring + delayWrite_, channel, sizeof(float) * static_cast<size_t>(firstWrite));
+    std::memcpy(ring, channel + firstWrite,
+                sizeof(float) * static_cast<size_t>(numSamples - firstWrite));
+
+    int read = delayWrite_ - lookahead_;
+    if (read < 0)
+        read += delaySize_;
+    const int firstRead = std::min(numSamples, delaySize_ - read);
+    std::memcpy(channel, ring + read, sizeof(float) * static_cast<size_t>(firstRead));
+    std::memcpy(channel + firstRead, ring,
+                sizeof(float) * static_cast<size_t>(numSamples - firstRead));
+}
+
+} // namespace ampl
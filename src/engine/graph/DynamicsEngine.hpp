@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace ampl
+{
+
+// Feed-forward gain computer and gain stage shared by the compressor and the
+// limiter. Audio is processed in chunks: the detector, the dB conversion, the
+// static curve and the gain conversion each run as one pass over a chunk, with
+// log2/exp2 approximations evaluated four samples at a time (SSE2 or NEON;
+// scalar elsewhere), so only the envelope recursion is left per sample.
+//
+// An optional look-ahead delays the audio against the detector, so gain
+// reduction is in place before a transient arrives. Owners report the
+// look-ahead as latency so the graph compensates parallel paths.
+class DynamicsEngine
+{
+  public:
+    static constexpr int kMaxChannels = 8;
+    static constexpr int kChunkSize = 256;
+
+    enum class Detector
+    {
+        Peak,
+        RMS
+    };
+
+    struct Settings
+    {
+        float thresholdDb{-20.0f};
+        float ratio{4.0f}; // Ignored when brickwall
+        float kneeDb{2.0f};
+        float attackMs{5.0f}; // Ignored when brickwall; the look-ahead is the attack
+        float releaseMs{50.0f};
+        float makeupDb{0.0f};
+        Detector detector{Detector::RMS};
+
+        // Limiting: infinite ratio, and the gain reaches each peak's reduction
+        // by the time the delayed peak is played, so nothing passes the threshold
+        bool brickwall{false};
+
+        bool operator==(const Settings &) const = default;
+    };
+
+    // Allocates the look-ahead delay. Not real-time safe.
+    void prepare(double sampleRate, int maxLookaheadSamples);
+
+    // Audio thread. Coefficients are only recomputed when settings change.
+    void setSettings(const Settings &settings) noexcept;
+
+    // Audio thread. Clamped to the prepared maximum; a change clears the delay.
+    void setLookahead(int samples) noexcept;
+    int getLookahead() const noexcept { return lookahead_; }
+
+    void reset() noexcept;
+
+    // Processes the first numChannels channels in place. The detector listens
+    // to key (a sidechain) when given, else to the channels themselves. Null
+    // channel pointers are skipped.
+    void process(float *const *channels, int numChannels, const float *const *key,
+                 int numKeyChannels, int numSamples) noexcept;
+
+    // Gain reduction at the end of the last block in dB (<= 0), for metering
+    float getGainReductionDb() const noexcept
+    {
+        return gainReductionDb_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    void processChunk(float *const *channels, int numChannels, const float *const *key,
+                      int numKeyChannels, int offset, int numSamples) noexcept;
+    void detect(const float *const *key, int numKeyChannels, int offset,
+                int numSamples) noexcept;
+    void smoothCompressor(int numSamples) noexcept;
+    void smoothBrickwall(int numSamples) noexcept;
+    void delay(float *channel, int ch, int numSamples) noexcept;
+
+    Settings settings_;
+    double sampleRate_{44100.0};
+    bool configured_{false};
+
+    // Derived from settings_
+    float slope_{0.0f}; // dB of reduction per dB over the threshold (<= 0)
+    float kneeScale_{0.0f};
+    float attackCoeff_{0.0f};
+    float releaseCoeff_{0.0f};
+    float rmsCoeff_{0.0f};
+
+    float envelopeDb_{0.0f};
+    float meanSquare_{0.0f};
+    std::atomic<float> gainReductionDb_{0.0f};
+
+    // Per chunk: detector level, then its gain in dB, then the linear gain
+    alignas(16) std::array<float, kChunkSize> level_{};
+    alignas(16) std::array<float, kChunkSize> gain_{};
+
+    // Look-ahead delay: one ring of delaySize_ samples per channel
+    std::vector<float> delayMemory_;
+    int delaySize_{0};
+    int delayWrite_{0};
+    int maxLookahead_{0};
+    int lookahead_{0};
+
+    // Brickwall: sliding minimum of the target gain over the look-ahead window
+    // (a monotonic queue), then a moving average over the same window
+    std::vector<float> minValues_;
+    std::vector<int64_t> minTimes_;
+    int minHead_{0};
+    int minCount_{0};
+    std::vector<float> averageHistory_;
+    int averagePos_{0};
+    double averageSum_{0.0};
+    int64_t sampleCounter_{0};
+};
+
+} // namespace ampl
@@ -0,0 +1,752 @@
+#include "engine/graph/GraphCompiler.hpp"
+#include "engine/graph/GraphThreadPool.hpp"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ampl
+{
+
+namespace
+{
+
+// Copies the overlapping channels of src into dst; AudioBuffer::copyFrom
+// refuses buffers whose channel counts differ.
+void copyChannels(AudioBuffer &dst, const AudioBuffer &src, int numSamples) noexcept
+{
+    const int channels = std::min(dst.numChannels, src.numChannels);
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        if (dst.channels[ch] && src.channels[ch] && dst.channels[ch] != src.channels[ch])
+            juce::FloatVectorOperations::copy(dst.channels[ch], src.channels[ch], numSamples);
+    }
+    for (int ch = channels; ch < dst.numChannels; ++ch)
+    {
+        if (dst.channels[ch])
+            juce::FloatVectorOperations::clear(dst.channels[ch], numSamples);
+    }
+}
+
+void addChannels(AudioBuffer &dst, const AudioBuffer &src, int numSamples) noexcept
+{
+    const int channels = std::min(dst.numChannels, src.numChannels);
+    for (int ch = 0; ch < channels; ++ch)
+    {
+        if (dst.channels[ch] && src.channels[ch])
+            juce::FloatVectorOperations::add(dst.channels[ch], src.channels[ch], numSamples);
+    }
+}
+
+// out = in * gain, with the gain moving linearly from `from` to `to` across the
+// block. One pass per channel; the loop has no carried dependency, so it
+// vectorizes. Safe in place.
+void applyGainRamp(const float *in, float *out, float from, float to, int numSamples) noexcept
+{
+    if (from == to)
+    {
+        juce::FloatVectorOperations::multiply(out, in, to, numSamples);
+        return;
+    }
+
+    const float delta = (to - from) / static_cast<float>(numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        out[i] = in[i] * (from + delta * static_cast<float>(i + 1));
+}
+
+// Removes a bypassed node from the edge list by connecting each of its sources
+// to each of its destinations; their sum is what the node would pass through.
+// Its sidechain is dropped with it. Nodes without inputs (silence) or without
+// outputs stay in the plan.
+bool spliceOut(const std::string &nodeId, std::vector<AudioConnection> &edges)
+{
+    std::vector<AudioConnection> in, out, kept;
+    for (const auto &edge : edges)
+    {
+        if (edge.destNodeId == nodeId && edge.sidechain)
+            continue;
+
+        if (edge.destNodeId == nodeId)
+            in.push_back(edge);
+        else if (edge.sourceNodeId == nodeId)
+            out.push_back(edge);
+        else
+            kept.push_back(edge);
+    }
+
+    if (in.empty() || out.empty())
+        return false;
+
+    for (const auto &source : in)
+    {
+        for (const auto &dest : out)
+        {
+            kept.push_back(AudioConnection{source.sourceNodeId, dest.destNodeId,
+                                           source.sourceChannel, dest.destChannel,
+                                           dest.sidechain});
+        }
+    }
+
+    edges = std::move(kept);
+    return true;
+}
+
+bool isFusible(const AudioNode &node)
+{
+    return node.isLinearGainStage() && !node.isBypassed() && node.getLatencySamples() == 0;
+}
+
+// Builds a view of `buffer` starting at `offset`, using caller-provided pointer storage.
+AudioBuffer offsetView(const AudioBuffer &buffer, int offset, int numSamples,
+                       float **pointerStorage) noexcept
+{
+    if (!buffer.channels)
+        return {};
+
+    const int channels = std::min(buffer.numChannels, CompiledGraph::kMaxChannels);
+    for (int ch = 0; ch < channels; ++ch)
+        pointerStorage[ch] = buffer.channels[ch] ? buffer.channels[ch] + offset : nullptr;
+
+    return AudioBuffer(pointerStorage, channels, numSamples);
+}
+
+// Liveness pass: a step's output buffer is released once its last reader has
+// run, and later steps draw from the released slots. Producers feeding a
+// multi-input node add into that node's mix slot as soon as they finish, so a
+// wide mixer holds one accumulator instead of one buffer per channel. Nodes
+// that support it write their output over an input buffer that dies at that step.
+void assignBufferSlots(CompiledGraph &plan)
+{
+    const int numSteps = static_cast<int>(plan.steps.size());
+
+    // Direct readers (single-input consumers) and accumulate targets per step
+    std::vector<int> lastRead(static_cast<size_t>(numSteps), -1);
+    std::vector<std::vector<int>> accumulateInto(static_cast<size_t>(numSteps));
+    for (int i = 0; i < numSteps; ++i)
+    {
+        const auto &step = plan.steps[static_cast<size_t>(i)];
+        for (int e = 0; e < step.inputCount; ++e)
+        {
+            const auto &in = plan.inputs[static_cast<size_t>(step.inputBegin + e)];
+            if (step.inputCount == 1)
+                lastRead[static_cast<size_t>(in.step)] = i;
+            else
+                accumulateInto[static_cast<size_t>(in.step)].push_back(i);
+        }
+
+        if (step.sidechainInput >= 0)
+        {
+            const auto &sc = plan.inputs[static_cast<size_t>(step.sidechainInput)];
+            lastRead[static_cast<size_t>(sc.step)] = i;
+        }
+    }
+
+    // The final step's output is copied to the graph output after all steps
+    if (plan.finalStep >= 0)
+        lastRead[static_cast<size_t>(plan.finalStep)] = numSteps;
+
+    std::vector<int> freeSlots;
+    auto acquire = [&]() -> int
+    {
+        if (freeSlots.empty())
+            return plan.numSlots++;
+        const int slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    };
+
+    for (int i = 0; i < numSteps; ++i)
+    {
+        auto &step = plan.steps[static_cast<size_t>(i)];
+
+        // Buffer the node reads that dies at this step, if any
+        int dyingInput = -1;
+        if (step.inputCount == 1)
+        {
+            auto &in = plan.inputs[static_cast<size_t>(step.inputBegin)];
+            in.slot = plan.steps[static_cast<size_t>(in.step)].outputSlot;
+            if (lastRead[static_cast<size_t>(in.step)] == i)
+                dyingInput = in.slot;
+        }
+        else if (step.inputCount > 1)
+        {
+            dyingInput = step.mixSlot;
+        }
+
+        // The sidechain is read alongside the input, so the node must not
+        // overwrite it in place
+        int dyingSidechain = -1;
+        if (step.sidechainInput >= 0)
+        {
+            auto &sc = plan.inputs[static_cast<size_t>(step.sidechainInput)];
+            sc.slot = plan.steps[static_cast<size_t>(sc.step)].outputSlot;
+            if (lastRead[static_cast<size_t>(sc.step)] == i)
+                dyingSidechain = sc.slot;
+        }
+
+        if (dyingInput >= 0 && dyingInput != dyingSidechain && step.node->canProcessInPlace())
+        {
+            step.outputSlot = dyingInput;
+        }
+        else
+        {
+            step.outputSlot = acquire();
+            if (dyingInput >= 0)
+                freeSlots.push_back(dyingInput);
+        }
+        if (dyingSidechain >= 0 && dyingSidechain != dyingInput)
+            freeSlots.push_back(dyingSidechain);
+
+        // Fold this output into downstream mix slots right after the node runs
+        step.accumulateBegin = static_cast<int>(plan.accumulates.size());
+        for (int consumer : accumulateInto[static_cast<size_t>(i)])
+        {
+            auto &target = plan.steps[static_cast<size_t>(consumer)];
+            CompiledGraph::Accumulate acc;
+            acc.first = (target.mixSlot < 0);
+            if (acc.first)
+                target.mixSlot = acquire();
+            acc.slot = target.mixSlot;
+            acc.numChannels = target.mixChannels;
+            plan.accumulates.push_back(acc);
+        }
+        step.accumulateCount = static_cast<int>(plan.accumulates.size()) - step.accumulateBegin;
+
+        // Outputs with no remaining direct reader are scratch for this step only
+        if (lastRead[static_cast<size_t>(i)] < i)
+            freeSlots.push_back(step.outputSlot);
+    }
+}
+
+// Slot assignment for parallel plans. Without a global order, a buffer can only
+// be reused by the sole reader of its producer: that reader cannot start before
+// the producer finishes and nothing else ever reads the buffer.
+void assignParallelBufferSlots(CompiledGraph &plan)
+{
+    const int numSteps = static_cast<int>(plan.steps.size());
+
+    std::vector<int> readers(static_cast<size_t>(numSteps), 0);
+    for (const auto &in : plan.inputs)
+        ++readers[static_cast<size_t>(in.step)];
+
+    auto ownedBy = [&](const CompiledGraph::Input &in)
+    { return readers[static_cast<size_t>(in.step)] == 1 && in.step != plan.finalStep; };
+
+    for (int i = 0; i < numSteps; ++i)
+    {
+        auto &step = plan.steps[static_cast<size_t>(i)];
+        auto first = plan.inputs.begin() + step.inputBegin;
+        auto last = first + step.inputCount;
+
+        for (auto it = first; it != last; ++it)
+            it->slot = plan.steps[static_cast<size_t>(it->step)].outputSlot;
+
+        // Sidechain producers count as readers above, so their slot is never owned
+        if (step.sidechainInput >= 0)
+        {
+            auto &sc = plan.inputs[static_cast<size_t>(step.sidechainInput)];
+            sc.slot = plan.steps[static_cast<size_t>(sc.step)].outputSlot;
+        }
+
+        // Owned inputs first: the first one becomes the mix slot, summed in place
+        std::stable_partition(first, last, ownedBy);
+        std::vector<int> owned;
+        for (auto it = first; it != last && ownedBy(*it); ++it)
+            owned.push_back(it->slot);
+
+        int dyingInput = -1;
+        if (step.inputCount == 1)
+        {
+            if (!owned.empty())
+                dyingInput = owned.front();
+        }
+        else if (step.inputCount > 1)
+        {
+            if (!owned.empty())
+            {
+                step.mixSlot = owned.front();
+                owned.erase(owned.begin());
+            }
+            else
+            {
+                step.mixSlot = plan.numSlots++;
+            }
+            dyingInput = step.mixSlot;
+        }
+
+        if (dyingInput >= 0 && step.node->canProcessInPlace())
+            step.outputSlot = dyingInput;
+        else if (step.inputCount > 1 && !owned.empty())
+            step.outputSlot = owned.front();
+        else
+            step.outputSlot = plan.numSlots++;
+    }
+}
+
+float estimateStepCost(const AudioNode &node)
+{
+    switch (node.getType())
+    {
+        case AudioNode::Type::Plugin:
+            return 8.0f;
+        case AudioNode::Type::EQ:
+        case AudioNode::Type::Compressor:
+        case AudioNode::Type::Limiter:
+            return 2.0f;
+        default:
+            return 1.0f;
+    }
+}
+
+// Successor lists, dependency roots and critical-path priorities for the
+// parallel scheduler.
+void buildSchedule(CompiledGraph &plan)
+{
+    const int numSteps = static_cast<int>(plan.steps.size());
+
+    std::vector<std::vector<int>> successors(static_cast<size_t>(numSteps));
+    for (int i = 0; i < numSteps; ++i)
+    {
+        const auto &step = plan.steps[static_cast<size_t>(i)];
+        for (int e = 0; e < step.inputCount; ++e)
+        {
+            const auto &in = plan.inputs[static_cast<size_t>(step.inputBegin + e)];
+            successors[static_cast<size_t>(in.step)].push_back(i);
+        }
+
+        if (step.sidechainInput >= 0)
+        {
+            const auto &sc = plan.inputs[static_cast<size_t>(step.sidechainInput)];
+            successors[static_cast<size_t>(sc.step)].push_back(i);
+        }
+    }
+
+    // Steps are topologically ordered, so walk backwards from the sinks
+    plan.totalWork = 0.0f;
+    plan.criticalPathLength = 0.0f;
+    for (int i = numSteps - 1; i >= 0; --i)
+    {
+        auto &step = plan.steps[static_cast<size_t>(i)];
+        float longest = 0.0f;
+        for (int s : successors[static_cast<size_t>(i)])
+            longest = std::max(longest, plan.steps[static_cast<size_t>(s)].criticalPath);
+
+        const float cost = estimateStepCost(*step.node);
+        step.criticalPath = cost + longest;
+        plan.totalWork += cost;
+        plan.criticalPathLength = std::max(plan.criticalPathLength, step.criticalPath);
+    }
+
+    auto byPriority = [&plan](int a, int b)
+    {
+        return plan.steps[static_cast<size_t>(a)].criticalPath >
+               plan.steps[static_cast<size_t>(b)].criticalPath;
+    };
+
+    for (int i = 0; i < numSteps; ++i)
+    {
+        auto &list = successors[static_cast<size_t>(i)];
+        std::stable_sort(list.begin(), list.end(), byPriority);
+
+        auto &step = plan.steps[static_cast<size_t>(i)];
+        step.successorBegin = static_cast<int>(plan.successors.size());
+        step.successorCount = static_cast<int>(list.size());
+        plan.successors.insert(plan.successors.end(), list.begin(), list.end());
+
+        if (step.dependencyCount == 0)
+            plan.rootSteps.push_back(i);
+    }
+    std::stable_sort(plan.rootSteps.begin(), plan.rootSteps.end(), byPriority);
+
+    plan.byRank.resize(static_cast<size_t>(numSteps));
+    std::iota(plan.byRank.begin(), plan.byRank.end(), 0);
+    std::stable_sort(plan.byRank.begin(), plan.byRank.end(), byPriority);
+    for (int r = 0; r < numSteps; ++r)
+        plan.steps[static_cast<size_t>(plan.byRank[static_cast<size_t>(r)])].rank = r;
+
+    plan.pendingInputs = std::make_unique<std::atomic<int>[]>(static_cast<size_t>(numSteps));
+    plan.readyWords = (numSteps + 63) / 64;
+    plan.readySteps = std::make_unique<std::atomic<uint64_t>[]>(static_cast<size_t>(plan.readyWords));
+}
+
+} // namespace
+
+void CompiledGraph::process(AudioBuffer &input, AudioBuffer &output, int numSamples,
+                            SampleCount position) noexcept
+{
+    if (blockSize <= 0)
+        return;
+
+    int done = 0;
+    while (done < numSamples)
+    {
+        const int chunk = std::min(blockSize, numSamples - done);
+
+        float *inPointers[kMaxChannels] = {};
+        float *outPointers[kMaxChannels] = {};
+        AudioBuffer chunkIn = offsetView(input, done, chunk, inPointers);
+        AudioBuffer chunkOut = offsetView(output, done, chunk, outPointers);
+
+        processBlock(chunkIn, chunkOut, chunk, position + done);
+        done += chunk;
+    }
+}
+
+void CompiledGraph::processBlock(AudioBuffer &input, AudioBuffer &output, int numSamples,
+                                 SampleCount position) noexcept
+{
+    output.clear();
+
+    if (threadPool != nullptr)
+    {
+        threadPool->runBlock(*this, input, numSamples, position);
+    }
+    else
+    {
+        const int numSteps = static_cast<int>(steps.size());
+        for (int i = 0; i < numSteps; ++i)
+            runStep(i, input, numSamples, position);
+    }
+
+    if (finalSlot >= 0)
+    {
+        AudioBuffer finalBuffer(getSlot(finalSlot), finalChannels, numSamples);
+        copyChannels(output, finalBuffer, numSamples);
+    }
+}
+
+void CompiledGraph::runStep(int index, AudioBuffer &input, int numSamples,
+                            SampleCount position) noexcept
+{
+    const auto &step = steps[static_cast<size_t>(index)];
+
+    AudioBuffer nodeInput;
+    AudioBuffer nodeOutput(getSlot(step.outputSlot), step.numOutputChannels, numSamples);
+
+    if (step.usesGraphInput)
+    {
+        nodeInput = input;
+    }
+    else if (step.inputCount == 1)
+    {
+        const auto &in = inputs[static_cast<size_t>(step.inputBegin)];
+        nodeInput = AudioBuffer(getSlot(in.slot), in.numChannels, numSamples);
+    }
+    else if (step.inputCount > 1)
+    {
+        nodeInput = AudioBuffer(getSlot(step.mixSlot), step.mixChannels, numSamples);
+
+        // Serial plans are summed by the producers' accumulate actions. Parallel
+        // plans sum here; an input that already lives in the mix slot comes first.
+        if (threadPool != nullptr)
+        {
+            for (int i = 0; i < step.inputCount; ++i)
+            {
+                const auto &in = inputs[static_cast<size_t>(step.inputBegin + i)];
+                AudioBuffer source(getSlot(in.slot), in.numChannels, numSamples);
+                if (i == 0)
+                    copyChannels(nodeInput, source, numSamples);
+                else
+                    addChannels(nodeInput, source, numSamples);
+            }
+        }
+    }
+
+    if (step.chainCount > 0)
+    {
+        runGainChain(index, nodeInput, nodeOutput, numSamples, position);
+    }
+    else if (step.node->isBypassed())
+    {
+        // Bypassed nodes pass their input through (silence for source nodes)
+        if (nodeInput.channels)
+            copyChannels(nodeOutput, nodeInput, numSamples);
+        else
+            nodeOutput.clear();
+    }
+    else if (step.sidechainInput >= 0)
+    {
+        const auto &sc = inputs[static_cast<size_t>(step.sidechainInput)];
+        const AudioBuffer sidechain(getSlot(sc.slot), sc.numChannels, numSamples);
+        step.node->processWithSidechain(nodeInput, sidechain, nodeOutput, numSamples, position);
+    }
+    else
+    {
+        step.node->process(nodeInput, nodeOutput, numSamples, position);
+    }
+
+    for (int a = 0; a < step.accumulateCount; ++a)
+    {
+        const auto &acc = accumulates[static_cast<size_t>(step.accumulateBegin + a)];
+        AudioBuffer mix(getSlot(acc.slot), acc.numChannels, numSamples);
+        if (acc.first)
+            copyChannels(mix, nodeOutput, numSamples);
+        else
+            addChannels(mix, nodeOutput, numSamples);
+    }
+}
+
+void CompiledGraph::runGainChain(int index, const AudioBuffer &input, AudioBuffer &output,
+                                 int numSamples, SampleCount position) noexcept
+{
+    const auto &step = steps[static_cast<size_t>(index)];
+    const int numChannels = std::min(output.numChannels, kMaxChannels);
+
+    // Product of every stage's gains for this block
+    float target[kMaxChannels];
+    float stage[kMaxChannels];
+    std::fill(target, target + kMaxChannels, 1.0f);
+    for (int c = 0; c < step.chainCount; ++c)
+    {
+        auto *node = chainNodes[static_cast<size_t>(step.chainBegin + c)];
+        if (node->isBypassed())
+            continue;
+
+        node->computeChannelGains(position, stage, numChannels);
+        for (int ch = 0; ch < numChannels; ++ch)
+            target[ch] *= stage[ch];
+    }
+
+    float *previous = chainGains.data() + static_cast<size_t>(index) * kMaxChannels;
+    const int shared = input.channels ? std::min(input.numChannels, numChannels) : 0;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if (!output.channels[ch])
+            continue;
+
+        if (ch < shared && input.channels[ch])
+        {
+            const float from = previous[ch] < 0.0f ? target[ch] : previous[ch];
+            applyGainRamp(input.channels[ch], output.channels[ch], from, target[ch], numSamples);
+        }
+        else
+        {
+            juce::FloatVectorOperations::clear(output.channels[ch], numSamples);
+        }
+        previous[ch] = target[ch];
+    }
+}
+
+std::unique_ptr<CompiledGraph>
+GraphCompiler::compile(const std::vector<std::shared_ptr<AudioNode>> &nodes,
+                       const std::vector<AudioConnection> &connections,
+                       const std::vector<std::string> &processingOrder, int blockSize,
+                       GraphThreadPool *threadPool, const std::string &outputNodeId)
+{
+    auto plan = std::make_unique<CompiledGraph>();
+    plan->blockSize = std::max(1, blockSize);
+    plan->threadPool = threadPool;
+
+    std::unordered_map<std::string, std::shared_ptr<AudioNode>> nodesById;
+    for (const auto &node : nodes)
+        nodesById[node->getId()] = node;
+
+    // Sidechain connections only reach nodes that take one
+    std::vector<AudioConnection> edges;
+    for (const auto &conn : connections)
+    {
+        auto dest = nodesById.find(conn.destNodeId);
+        if (conn.sidechain && (dest == nodesById.end() || !dest->second->acceptsSidechain()))
+            continue;
+        edges.push_back(conn);
+    }
+
+    // Splice bypassed nodes out of the plan
+    std::vector<std::string> order;
+    for (const auto &nodeId : processingOrder)
+    {
+        auto it = nodesById.find(nodeId);
+        if (it == nodesById.end())
+            continue;
+
+        // The output node stays, passing its input through, so it still
+        // names the graph output
+        if (it->second->isBypassed() && nodeId != "input" && nodeId != outputNodeId &&
+            spliceOut(nodeId, edges))
+            continue;
+
+        order.push_back(nodeId);
+    }
+
+    std::unordered_map<std::string, std::vector<std::string>> consumers;
+    std::unordered_map<std::string, int> numSources;
+    for (const auto &edge : edges)
+    {
+        consumers[edge.sourceNodeId].push_back(edge.destNodeId);
+        if (!edge.sidechain)
+            ++numSources[edge.destNodeId];
+    }
+
+    // Step index per node id, in processing order. A linear gain stage absorbs
+    // the following stages while each link is its producer's only output and
+    // its consumer's only input; every member maps to the fused step.
+    std::unordered_map<std::string, int> stepIndex;
+    std::unordered_set<std::string> fused;
+    for (const auto &nodeId : order)
+    {
+        if (fused.count(nodeId) > 0)
+            continue;
+
+        const auto &node = nodesById[nodeId];
+        const int index = static_cast<int>(plan->steps.size());
+
+        CompiledGraph::Step step;
+        step.node = node.get();
+        step.numOutputChannels =
+            std::clamp(step.node->getOutputChannelCount(), 1, CompiledGraph::kMaxChannels);
+        step.usesGraphInput = (nodeId == "input");
+        stepIndex[nodeId] = index;
+        plan->nodeRefs.push_back(node);
+
+        if (isFusible(*node))
+        {
+            step.chainBegin = static_cast<int>(plan->chainNodes.size());
+            plan->chainNodes.push_back(node.get());
+
+            std::string tail = nodeId;
+            while (true)
+            {
+                // Fusing past the output node would lose its output
+                const auto &next = consumers[tail];
+                if (tail == outputNodeId || next.size() != 1 || next.front() == "input" || numSources[next.front()] != 1)
+                    break;
+
+                auto member = nodesById.find(next.front());
+                if (member == nodesById.end() || !isFusible(*member->second))
+                    break;
+
+                tail = next.front();
+                fused.insert(tail);
+                stepIndex[tail] = index;
+                plan->chainNodes.push_back(member->second.get());
+                plan->nodeRefs.push_back(member->second);
+                step.numOutputChannels = std::clamp(member->second->getOutputChannelCount(), 1,
+                                                    step.numOutputChannels);
+            }
+
+            step.chainCount = static_cast<int>(plan->chainNodes.size()) - step.chainBegin;
+        }
+
+        plan->steps.push_back(step);
+    }
+
+    // Sinks other than the output node (meters, unconnected nodes) may sort after it
+    if (!plan->steps.empty())
+    {
+        auto output = stepIndex.find(outputNodeId);
+        plan->finalStep = output != stepIndex.end() ? output->second
+                                                    : static_cast<int>(plan->steps.size()) - 1;
+    }
+
+    // Resolve automation lanes to parameter indices
+    for (const auto &node : plan->nodeRefs)
+    {
+        std::array<const AutomationLane *, AudioNode::kMaxAutomatedParameters> bound{};
+        for (const auto &[paramId, lane] : node->getAutomationLanes())
+        {
+            const int index = node->getParameterIndex(paramId);
+            if (!lane || index < 0 || index >= AudioNode::kMaxAutomatedParameters)
+                continue;
+
+            bound[static_cast<size_t>(index)] = lane.get();
+            plan->laneRefs.push_back(lane);
+        }
+
+        for (int i = 0; i < AudioNode::kMaxAutomatedParameters; ++i)
+            node->bindAutomation(i, bound[static_cast<size_t>(i)]);
+    }
+
+    std::unordered_map<std::string, std::vector<const AudioConnection *>> incoming;
+    for (const auto &conn : edges)
+        incoming[conn.destNodeId].push_back(&conn);
+
+    // Resolve incoming edges to producer steps. Edges whose source has not been
+    // scheduled before the destination (cycles, missing nodes) are dropped. A
+    // node reads one sidechain, stored after its inputs; further sidechain
+    // connections are ignored (sum them upstream).
+    for (size_t i = 0; i < plan->steps.size(); ++i)
+    {
+        auto &step = plan->steps[i];
+        step.inputBegin = static_cast<int>(plan->inputs.size());
+
+        if (step.usesGraphInput)
+            continue;
+
+        auto edges = incoming.find(step.node->getId());
+        if (edges == incoming.end())
+            continue;
+
+        CompiledGraph::Input sidechain;
+        for (const auto *conn : edges->second)
+        {
+            auto src = stepIndex.find(conn->sourceNodeId);
+            if (src == stepIndex.end() || src->second >= static_cast<int>(i))
+                continue;
+
+            const auto &producer = plan->steps[static_cast<size_t>(src->second)];
+            if (conn->sidechain)
+            {
+                if (sidechain.step < 0)
+                {
+                    sidechain.step = src->second;
+                    sidechain.numChannels = producer.numOutputChannels;
+                }
+                continue;
+            }
+
+            CompiledGraph::Input in;
+            in.step = src->second;
+            in.numChannels = producer.numOutputChannels;
+            plan->inputs.push_back(in);
+            step.mixChannels = std::max(step.mixChannels, producer.numOutputChannels);
+        }
+
+        step.inputCount = static_cast<int>(plan->inputs.size()) - step.inputBegin;
+        step.dependencyCount = step.inputCount;
+
+        if (sidechain.step >= 0)
+        {
+            step.sidechainInput = static_cast<int>(plan->inputs.size());
+            plan->inputs.push_back(sidechain);
+            ++step.dependencyCount;
+        }
+    }
+
+    if (threadPool != nullptr)
+        assignParallelBufferSlots(*plan);
+    else
+        assignBufferSlots(*plan);
+
+    // Also built for serial plans so getPlanInfo() can report available parallelism
+    buildSchedule(*plan);
+
+    if (!plan->steps.empty())
+    {
+        const auto &finalStep = plan->steps[static_cast<size_t>(plan->finalStep)];
+        plan->finalSlot = finalStep.outputSlot;
+        plan->finalChannels = finalStep.numOutputChannels;
+    }
+
+    for (const auto &step : plan->steps)
+        plan->slotChannels = std::max(plan->slotChannels, step.numOutputChannels);
+
+    plan->chainGains.assign(plan->steps.size() * CompiledGraph::kMaxChannels, -1.0f);
+
+    // Preassign all buffer memory up front
+    const auto blockLength = static_cast<size_t>(plan->blockSize);
+    const auto slotLength = static_cast<size_t>(plan->slotChannels) * blockLength;
+    plan->slotMemory.assign(static_cast<size_t>(plan->numSlots) * slotLength, 0.0f);
+    plan->slotPointers.assign(static_cast<size_t>(plan->numSlots) * CompiledGraph::kMaxChannels,
+                              nullptr);
+    for (int slot = 0; slot < plan->numSlots; ++slot)
+    {
+        float **pointers = plan->getSlot(slot);
+        for (int ch = 0; ch < plan->slotChannels; ++ch)
+            pointers[ch] = plan->slotMemory.data() + static_cast<size_t>(slot) * slotLength +
+                           static_cast<size_t>(ch) * blockLength;
+    }
+
+    return plan;
+}
+
+} // namespace ampl
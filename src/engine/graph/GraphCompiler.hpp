@@ -0,0 +1,149 @@
+#pragma once
+
+#include "engine/graph/AudioGraph.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ampl
+{
+
+class GraphThreadPool;
+
+// Flat, index-based execution plan for an AudioGraph.
+// Built on the UI thread from the node/connection lists and published to the
+// audio thread by atomic pointer swap. The audio thread only walks the step
+// array: no strings, no locks, no allocation.
+struct CompiledGraph
+{
+    static constexpr int kMaxChannels = 8;
+
+    // One incoming edge of a step, resolved to the producer's buffer slot.
+    struct Input
+    {
+        int step{-1}; // Producing step
+        int slot{-1};
+        int numChannels{2};
+    };
+
+    // Adds a step's output into a downstream node's mix slot.
+    struct Accumulate
+    {
+        int slot{-1};
+        int numChannels{2};
+        bool first{false}; // First contribution overwrites instead of adding
+    };
+
+    struct Step
+    {
+        AudioNode *node{nullptr};
+        int inputBegin{0}; // Range into inputs
+        int inputCount{0};
+        int sidechainInput{-1}; // Index into inputs, after the range; -1 without a sidechain
+        int dependencyCount{0}; // Steps that must finish first: inputs plus the sidechain
+        int accumulateBegin{0}; // Range into accumulates, run after the node
+        int accumulateCount{0};
+        int mixSlot{-1}; // Slot the inputs of a multi-input node are summed into
+        int mixChannels{0};
+        int outputSlot{-1};
+        int numOutputChannels{2};
+        bool usesGraphInput{false};
+
+        // Fused chain of linear gain stages (range into chainNodes), applied by
+        // one gain kernel instead of calling node->process() on each
+        int chainBegin{0};
+        int chainCount{0};
+
+        // Parallel scheduling
+        int successorBegin{0}; // Range into successors
+        int successorCount{0};
+        float criticalPath{0.0f}; // Estimated cost of the longest path from here to a sink
+        int rank{0};              // Position in byRank
+    };
+
+    std::vector<Step> steps;
+    std::vector<Input> inputs; // Flattened adjacency, indexed by Step::inputBegin
+    std::vector<Accumulate> accumulates;
+    std::vector<int> successors; // Per step, longest critical path first
+    std::vector<int> rootSteps;  // Steps without inputs, longest critical path first
+    std::vector<int> byRank;     // Every step, longest critical path first
+    std::vector<AudioNode *> chainNodes;
+
+    // kMaxChannels per step: the fused gain reached at the end of the previous
+    // block, which the next block ramps from. Negative until the first block.
+    std::vector<float> chainGains;
+
+    // Keeps every node referenced by the plan alive while the audio thread may use it.
+    std::vector<std::shared_ptr<AudioNode>> nodeRefs;
+
+    // Automation lanes bound to the nodes' parameter indices by this compile
+    std::vector<std::shared_ptr<AutomationLane>> laneRefs;
+
+    // Buffer slots are shared between steps whose outputs are never live at the
+    // same time (see the liveness pass in GraphCompiler.cpp).
+    int numSlots{0};
+    int slotChannels{1}; // Channels backed by memory in every slot
+    int blockSize{0};
+    int finalStep{-1}; // Step whose output is copied to the graph output
+    int finalSlot{-1};
+    int finalChannels{0};
+
+    // Preassigned buffer memory: numSlots * slotChannels channels of blockSize samples.
+    // slotPointers holds kMaxChannels entries per slot; unused entries are null.
+    std::vector<float> slotMemory;
+    std::vector<float *> slotPointers;
+
+    float **getSlot(int slot) noexcept
+    {
+        return slotPointers.data() + static_cast<size_t>(slot) * kMaxChannels;
+    }
+
+    // Set when compiled for parallel execution. Multi-input nodes then sum their
+    // inputs themselves and slots are only handed from a producer to its sole
+    // reader, so independent steps never touch the same buffer.
+    GraphThreadPool *threadPool{nullptr};
+    float totalWork{0.0f};          // Sum of estimated step costs
+    float criticalPathLength{0.0f}; // Longest root-to-sink cost
+
+    // Per-block scheduling state, reset by the pool before each block.
+    // readySteps has one bit per step in rank order, so the lowest set bit is
+    // the ready step with the longest critical path.
+    std::unique_ptr<std::atomic<int>[]> pendingInputs;
+    std::unique_ptr<std::atomic<uint64_t>[]> readySteps;
+    int readyWords{0};
+    std::atomic<int> remaining{0};
+
+    // Audio thread. Blocks larger than blockSize are processed in sub-blocks.
+    void process(AudioBuffer &input, AudioBuffer &output, int numSamples,
+                 SampleCount position) noexcept;
+
+    // Gathers a step's input, runs (or bypasses) its node and performs its
+    // accumulate actions. Called from pool workers on parallel plans.
+    void runStep(int index, AudioBuffer &input, int numSamples, SampleCount position) noexcept;
+
+  private:
+    void processBlock(AudioBuffer &input, AudioBuffer &output, int numSamples,
+                      SampleCount position) noexcept;
+    void runGainChain(int index, const AudioBuffer &input, AudioBuffer &output, int numSamples,
+                      SampleCount position) noexcept;
+};
+
+// Turns nodes + connections + a topological order into a CompiledGraph.
+// Bypassed nodes are spliced out and chains of linear gain stages are fused
+// into single steps. Pass a thread pool to compile a plan for parallel execution.
+// outputNodeId names the node whose output becomes the graph output; without
+// one (or if it is missing), the last node in processing order is used.
+// UI thread only — allocates freely.
+class GraphCompiler
+{
+  public:
+    static std::unique_ptr<CompiledGraph>
+    compile(const std::vector<std::shared_ptr<AudioNode>> &nodes,
+            const std::vector<AudioConnection> &connections,
+            const std::vector<std::string> &processingOrder, int blockSize,
+            GraphThreadPool *threadPool = nullptr, const std::string &outputNodeId = {});
+};
+
+} // namespace ampl
@@ -0,0 +1,215 @@
+#include "engine/graph/GraphThreadPool.hpp"
+#include "engine/graph/GraphCompiler.hpp"
+#include <bit>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #include <immintrin.h>
+#endif
+
+namespace ampl
+{
+
+namespace
+{
+
+// Spin-wait hint; keeps the core responsive without a syscall
+inline void cpuRelax() noexcept
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm64__)
+    asm volatile("yield");
+#endif
+}
+
+// How long an idle worker spins before sleeping: long enough to bridge
+// consecutive sub-blocks of one callback. A pause costs anywhere from a few
+// to over a hundred cycles depending on the CPU, so the spin is bounded by
+// the clock rather than by a count. The clock is read every kSpinCheck pauses.
+constexpr int64_t kSpinNanos = 50000;
+constexpr int kSpinCheck = 64;
+
+constexpr float kStatsSmoothing = 0.9f;
+
+int64_t nowNanos() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+GraphThreadPool::GraphThreadPool(int numWorkers)
+{
+    // Workers start from the generation at construction, so a wake-up (or
+    // shutdown) issued before a thread first runs is not missed
+    const uint32_t start = generation_.load(std::memory_order_acquire);
+    for (int i = 0; i < numWorkers; ++i)
+        workers_.emplace_back([this, start] { workerLoop(start); });
+}
+
+GraphThreadPool::~GraphThreadPool()
+{
+    quit_.store(true, std::memory_order_release);
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    generation_.notify_all();
+
+    for (auto &worker : workers_)
+        worker.join();
+}
+
+void GraphThreadPool::runBlock(CompiledGraph &plan, AudioBuffer &input, int numSamples,
+                               SampleCount position) noexcept
+{
+    const int numSteps = static_cast<int>(plan.steps.size());
+    if (numSteps == 0)
+        return;
+
+    const int64_t start = nowNanos();
+
+    // Reset dependency counters and the ready set, then seed it with the roots
+    for (int i = 0; i < numSteps; ++i)
+        plan.pendingInputs[static_cast<size_t>(i)].store(
+            plan.steps[static_cast<size_t>(i)].dependencyCount, std::memory_order_relaxed);
+    for (int w = 0; w < plan.readyWords; ++w)
+        plan.readySteps[static_cast<size_t>(w)].store(0, std::memory_order_relaxed);
+    plan.remaining.store(numSteps, std::memory_order_relaxed);
+    busyNanos_.store(0, std::memory_order_relaxed);
+
+    for (int root : plan.rootSteps)
+        markReady(plan, root);
+
+    Job job{&plan, &input, numSamples, position};
+    currentJob_.store(&job, std::memory_order_seq_cst);
+    generation_.fetch_add(1, std::memory_order_seq_cst);
+
+    // Waking a sleeper is a syscall; workers still spinning see the new
+    // generation on their own. Pairs with the increment in workerLoop().
+    if (sleepingWorkers_.load(std::memory_order_seq_cst) > 0)
+        generation_.notify_all();
+
+    drain(job);
+
+    // Wait for workers to leave the job before its stack frame goes away
+    currentJob_.store(nullptr, std::memory_order_seq_cst);
+    while (activeWorkers_.load(std::memory_order_seq_cst) != 0)
+        cpuRelax();
+
+    const int64_t wall = std::max<int64_t>(1, nowNanos() - start);
+    const float speedup =
+        static_cast<float>(busyNanos_.load(std::memory_order_relaxed)) / static_cast<float>(wall);
+    const float efficiency = speedup / static_cast<float>(getNumThreads());
+
+    speedup_.store(speedup_.load(std::memory_order_relaxed) * kStatsSmoothing +
+                       speedup * (1.0f - kStatsSmoothing),
+                   std::memory_order_relaxed);
+    efficiency_.store(efficiency_.load(std::memory_order_relaxed) * kStatsSmoothing +
+                          efficiency * (1.0f - kStatsSmoothing),
+                      std::memory_order_relaxed);
+}
+
+GraphThreadPool::Stats GraphThreadPool::getStats() const noexcept
+{
+    Stats stats;
+    stats.numThreads = getNumThreads();
+    stats.speedup = speedup_.load(std::memory_order_relaxed);
+    stats.efficiency = efficiency_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void GraphThreadPool::workerLoop(uint32_t seen) noexcept
+{
+    while (true)
+    {
+        const int64_t spinStart = nowNanos();
+        int spins = 0;
+        while (generation_.load(std::memory_order_acquire) == seen)
+        {
+            if (++spins % kSpinCheck != 0 || nowNanos() - spinStart < kSpinNanos)
+            {
+                cpuRelax();
+                continue;
+            }
+
+            // Announce the sleep before checking the generation one last time
+            // inside wait(), so runBlock() either sees us or we see its block
+            sleepingWorkers_.fetch_add(1, std::memory_order_seq_cst);
+            generation_.wait(seen, std::memory_order_seq_cst);
+            sleepingWorkers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        seen = generation_.load(std::memory_order_acquire);
+
+        if (quit_.load(std::memory_order_acquire))
+            return;
+
+        // Register before reading the job so runBlock() either sees us or we see null
+        activeWorkers_.fetch_add(1, std::memory_order_seq_cst);
+        if (auto *job = currentJob_.load(std::memory_order_seq_cst))
+            drain(*job);
+        activeWorkers_.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+void GraphThreadPool::drain(const Job &job) noexcept
+{
+    auto &plan = *job.plan;
+    int64_t busy = 0;
+
+    while (plan.remaining.load(std::memory_order_acquire) > 0)
+    {
+        const int index = takeReady(plan);
+        if (index < 0)
+        {
+            cpuRelax();
+            continue;
+        }
+
+        const int64_t stepStart = nowNanos();
+        plan.runStep(index, *job.input, job.numSamples, job.position);
+        busy += nowNanos() - stepStart;
+
+        const auto &step = plan.steps[static_cast<size_t>(index)];
+        for (int s = 0; s < step.successorCount; ++s)
+        {
+            const int next = plan.successors[static_cast<size_t>(step.successorBegin + s)];
+            if (plan.pendingInputs[static_cast<size_t>(next)].fetch_sub(
+                    1, std::memory_order_acq_rel) == 1)
+                markReady(plan, next);
+        }
+
+        plan.remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    busyNanos_.fetch_add(busy, std::memory_order_relaxed);
+}
+
+void GraphThreadPool::markReady(CompiledGraph &plan, int index) noexcept
+{
+    const int rank = plan.steps[static_cast<size_t>(index)].rank;
+    plan.readySteps[static_cast<size_t>(rank / 64)].fetch_or(uint64_t{1} << (rank % 64),
+                                                             std::memory_order_release);
+}
+
+int GraphThreadPool::takeReady(CompiledGraph &plan) noexcept
+{
+    // Lower bits are higher ranks, so the first bit claimed is the ready step
+    // with the longest critical path
+    for (int w = 0; w < plan.readyWords; ++w)
+    {
+        auto &word = plan.readySteps[static_cast<size_t>(w)];
+        uint64_t bits = word.load(std::memory_order_relaxed);
+        while (bits != 0)
+        {
+            const uint64_t bit = bits & (~bits + 1);
+            bits = word.fetch_and(~bit, std::memory_order_acq_rel);
+            if ((bits & bit) != 0)
+                return plan.byRank[static_cast<size_t>(w * 64 + std::countr_zero(bit))];
+            // Another thread claimed it first; retry with what is left
+        }
+    }
+    return -1;
+}
+
+} // namespace ampl
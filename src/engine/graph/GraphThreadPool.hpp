@@ -0,0 +1,75 @@
+#pragma once
+
+#include "engine/graph/AudioGraph.hpp"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace ampl
+{
+
+struct CompiledGraph;
+
+// Worker pool that executes a parallel CompiledGraph one block at a time.
+// Steps become ready when all their inputs are done (dependency counting) and
+// are claimed from a lock-free ready set, longest critical path first.
+// The audio thread takes part in every block, so N worker threads give N + 1
+// threads of processing. No locks or allocation on the processing path; idle
+// workers spin briefly, then sleep on an atomic wait.
+class GraphThreadPool
+{
+  public:
+    explicit GraphThreadPool(int numWorkers);
+    ~GraphThreadPool();
+
+    GraphThreadPool(const GraphThreadPool &) = delete;
+    GraphThreadPool &operator=(const GraphThreadPool &) = delete;
+
+    int getNumThreads() const noexcept
+    {
+        return static_cast<int>(workers_.size()) + 1;
+    }
+
+    // Audio thread: runs every step of the plan and returns once all are done.
+    void runBlock(CompiledGraph &plan, AudioBuffer &input, int numSamples,
+                  SampleCount position) noexcept;
+
+    // Smoothed over recent blocks.
+    // speedup = node processing time / wall time of the block;
+    // efficiency = speedup / number of threads.
+    struct Stats
+    {
+        int numThreads{1};
+        float speedup{1.0f};
+        float efficiency{1.0f};
+    };
+    Stats getStats() const noexcept;
+
+  private:
+    struct Job
+    {
+        CompiledGraph *plan{nullptr};
+        AudioBuffer *input{nullptr};
+        int numSamples{0};
+        SampleCount position{0};
+    };
+
+    void workerLoop(uint32_t seen) noexcept;
+    void drain(const Job &job) noexcept;
+    static void markReady(CompiledGraph &plan, int index) noexcept;
+    static int takeReady(CompiledGraph &plan) noexcept; // -1 if nothing is ready
+
+    std::vector<std::thread> workers_;
+    std::atomic<uint32_t> generation_{0};
+    std::atomic<Job *> currentJob_{nullptr};
+    std::atomic<int> activeWorkers_{0};
+    std::atomic<int> sleepingWorkers_{0};
+    std::atomic<bool> quit_{false};
+
+    std::atomic<int64_t> busyNanos_{0};
+    std::atomic<float> speedup_{1.0f};
+    std::atomic<float> efficiency_{1.0f};
+};
+
+} // namespace ampl
@@ -0,0 +1,462 @@
+#include "engine/graph/Oversampler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define AMPL_OVERSAMPLER_SSE 1
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define AMPL_OVERSAMPLER_NEON 1
+#endif
+
+namespace ampl
+{
+
+namespace
+{
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Per stage, first (most demanding) stage first: the signal band is fixed, so
+// each later stage has a wider transition band to work with.
+// FIR lengths (4m + 3 taps, so the centre tap sits at an odd index)
+constexpr int kFirLengths[] = {111, 23, 15};
+constexpr double kKaiserBeta = 7.86; // ~80 dB stopband
+
+// IIR allpass counts and transition widths (fraction of the stage's output rate)
+constexpr int kIirCoefficients[] = {10, 4, 3};
+constexpr double kIirTransition[] = {0.045, 0.25, 0.35};
+
+// Four channels of one sample, as one SIMD register
+#if AMPL_OVERSAMPLER_SSE
+using Lanes = __m128;
+inline Lanes load(const float *p) noexcept { return _mm_load_ps(p); }
+inline void store(float *p, Lanes v) noexcept { _mm_store_ps(p, v); }
+inline Lanes splat(float v) noexcept { return _mm_set1_ps(v); }
+inline Lanes add(Lanes a, Lanes b) noexcept { return _mm_add_ps(a, b); }
+inline Lanes sub(Lanes a, Lanes b) noexcept { return _mm_sub_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) noexcept { return _mm_mul_ps(a, b); }
+#elif AMPL_OVERSAMPLER_NEON
+using Lanes = float32x4_t;
+inline Lanes load(const float *p) noexcept { return vld1q_f32(p); }
+inline void store(float *p, Lanes v) noexcept { vst1q_f32(p, v); }
+inline Lanes splat(float v) noexcept { return vdupq_n_f32(v); }
+inline Lanes add(Lanes a, Lanes b) noexcept { return vaddq_f32(a, b); }
+inline Lanes sub(Lanes a, Lanes b) noexcept { return vsubq_f32(a, b); }
+inline Lanes mul(Lanes a, Lanes b) noexcept { return vmulq_f32(a, b); }
+#else
+struct Lanes
+{
+    float v[4];
+};
+inline Lanes load(const float *p) noexcept { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store(float *p, Lanes v) noexcept { std::memcpy(p, v.v, sizeof(v.v)); }
+inline Lanes splat(float v) noexcept { return {{v, v, v, v}}; }
+inline Lanes add(Lanes a, Lanes b) noexcept
+{
+    return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+}
+inline Lanes sub(Lanes a, Lanes b) noexcept
+{
+    return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+}
+inline Lanes mul(Lanes a, Lanes b) noexcept
+{
+    return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+}
+#endif
+
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k)
+    {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1.0e-12)
+            break;
+    }
+    return sum;
+}
+
+// Kaiser-windowed half-band lowpass, normalized to unity gain at DC
+std::vector<double> designHalfBandFir(int length)
+{
+    std::vector<double> h(static_cast<size_t>(length), 0.0);
+    const int centre = (length - 1) / 2;
+    const double norm = besselI0(kKaiserBeta);
+    double sum = 0.0;
+    for (int k = 0; k < length; ++k)
+    {
+        const int offset = k - centre;
+        double sinc = 0.5;
+        if (offset != 0)
+            sinc = offset % 2 == 0 ? 0.0 : std::sin(kPi * offset / 2.0) / (kPi * offset);
+
+        const double r = 2.0 * k / (length - 1) - 1.0;
+        h[static_cast<size_t>(k)] = sinc * besselI0(kKaiserBeta * std::sqrt(1.0 - r * r)) / norm;
+        sum += h[static_cast<size_t>(k)];
+    }
+    for (auto &tap : h)
+        tap /= sum;
+    return h;
+}
+
+double ipow(double x, int n)
+{
+    double result = 1.0;
+    for (int i = 0; i < n; ++i)
+        result *= x;
+    return result;
+}
+
+// Polyphase allpass half-band coefficients for a given transition width, from
+// the elliptic filter design (L. de Soras, "hiir")
+std::vector<double> designHalfBandIir(int numCoefficients, double transition)
+{
+    double k = std::tan((1.0 - transition * 2.0) * kPi / 4.0);
+    k *= k;
+    const double kkSqrt = std::pow(1.0 - k * k, 0.25);
+    const double e = 0.5 * (1.0 - kkSqrt) / (1.0 + kkSqrt);
+    const double e4 = e * e * e * e;
+    const double q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+    const int order = numCoefficients * 2 + 1;
+
+    std::vector<double> coefficients;
+    for (int index = 0; index < numCoefficients; ++index)
+    {
+        const int c = index + 1;
+
+        double num = 0.0;
+        double term = 0.0;
+        int sign = 1;
+        for (int i = 0; i == 0 || std::abs(term) > 1.0e-100; ++i, sign = -sign)
+        {
+            term = ipow(q, i * (i + 1)) * std::sin((i * 2 + 1) * c * kPi / order) * sign;
+            num += term;
+        }
+
+        double den = 0.0;
+        sign = -1;
+        for (int i = 1; i == 1 || std::abs(term) > 1.0e-100; ++i, sign = -sign)
+        {
+            term = ipow(q, i * i) * std::cos(i * 2 * c * kPi / order) * sign;
+            den += term;
+        }
+
+        const double ww = num * std::pow(q, 0.25) / (den + 0.5);
+        const double wwSq = ww * ww;
+        const double x = std::sqrt((1.0 - wwSq * k) * (1.0 - wwSq / k)) / (1.0 + wwSq);
+        coefficients.push_back((1.0 - x) / (1.0 + x));
+    }
+    return coefficients;
+}
+
+} // namespace
+
+void Oversampler::prepare(int factor, Filter filter, int numChannels, int maxBlockSize)
+{
+    factor_ = factor >= 8 ? 8 : factor >= 4 ? 4 : factor >= 2 ? 2 : 1;
+    numStages_ = factor_ == 8 ? 3 : factor_ == 4 ? 2 : factor_ == 2 ? 1 : 0;
+    filter_ = filter;
+    numChannels_ = std::clamp(numChannels, 1, kMaxChannels);
+    numGroups_ = (numChannels_ + 3) / 4;
+    maxBlockSize_ = std::max(1, maxBlockSize);
+
+    // Design the stages and add up their round-trip delay (in session samples)
+    stages_.assign(static_cast<size_t>(numStages_), Stage{});
+    double latency = 0.0;
+    for (int s = 0; s < numStages_; ++s)
+    {
+        auto &stage = stages_[static_cast<size_t>(s)];
+        const double stageScale = 1.0 / static_cast<double>(1 << s);
+
+        if (filter_ == Filter::FIR)
+        {
+            const auto h = designHalfBandFir(kFirLengths[s]);
+            const int centre = (kFirLengths[s] - 1) / 2;
+            for (size_t k = 0; k < h.size(); k += 2)
+                stage.taps.push_back(static_cast<float>(h[k]));
+            stage.centreDelay = (centre - 1) / 2;
+
+            // Up and down each delay by the centre tap at the stage's output rate
+            latency += centre * stageScale;
+        }
+        else
+        {
+            const auto coefficients =
+                designHalfBandIir(kIirCoefficients[s], kIirTransition[s]);
+            double branchDelay = 0.0;
+            for (double a : coefficients)
+            {
+                stage.coefficients.push_back(static_cast<float>(a));
+                branchDelay += (1.0 - a) / (1.0 + a);
+            }
+
+            // Both directions: each branch's first-order allpasses at DC
+            latency += branchDelay * stageScale;
+        }
+    }
+
+    // FIR: pad at the top rate to whole session samples
+    alignDelay_ = 0;
+    if (filter_ == Filter::FIR && numStages_ > 0)
+    {
+        const auto topSamples = static_cast<int>(std::lround(latency * factor_));
+        alignDelay_ = (factor_ - topSamples % factor_) % factor_;
+        latency = static_cast<double>(topSamples + alignDelay_) / factor_;
+    }
+    latency_ = static_cast<int>(std::lround(latency));
+
+    const auto groups = static_cast<size_t>(numGroups_);
+    const auto stages = static_cast<size_t>(numStages_);
+    upState_.assign(groups * stages, StageState{});
+    downState_.assign(groups * stages, StageState{});
+    for (size_t g = 0; g < groups; ++g)
+    {
+        for (size_t s = 0; s < stages; ++s)
+        {
+            const auto &stage = stages_[s];
+            auto &up = upState_[g * stages + s];
+            auto &down = downState_[g * stages + s];
+            if (filter_ == Filter::FIR)
+            {
+                up.history.assign(stage.taps.size() - 1, Frame{});
+                down.history.assign(2 * (stage.taps.size() - 1), Frame{});
+            }
+            else
+            {
+                up.x1.assign(stage.coefficients.size(), Frame{});
+                up.y1.assign(stage.coefficients.size(), Frame{});
+                down.x1.assign(stage.coefficients.size(), Frame{});
+                down.y1.assign(stage.coefficients.size(), Frame{});
+            }
+        }
+    }
+    alignHistory_.assign(groups, std::vector<Frame>(static_cast<size_t>(alignDelay_)));
+
+    const auto topLength = static_cast<size_t>(maxBlockSize_) * static_cast<size_t>(factor_);
+    frameA_.assign(topLength, Frame{});
+    frameB_.assign(topLength, Frame{});
+
+    size_t longestHistory = static_cast<size_t>(alignDelay_);
+    for (const auto &stage : stages_)
+        longestHistory = std::max(longestHistory, 2 * stage.taps.size());
+    scratch_.assign(longestHistory + topLength, Frame{});
+
+    channelMemory_.assign(static_cast<size_t>(numChannels_) * topLength, 0.0f);
+    channelPointers_.resize(static_cast<size_t>(numChannels_));
+    for (int ch = 0; ch < numChannels_; ++ch)
+        channelPointers_[static_cast<size_t>(ch)] =
+            channelMemory_.data() + static_cast<size_t>(ch) * topLength;
+}
+
+void Oversampler::reset() noexcept
+{
+    for (auto *states : {&upState_, &downState_})
+    {
+        for (auto &state : *states)
+        {
+            std::fill(state.history.begin(), state.history.end(), Frame{});
+            std::fill(state.x1.begin(), state.x1.end(), Frame{});
+            std::fill(state.y1.begin(), state.y1.end(), Frame{});
+        }
+    }
+    for (auto &history : alignHistory_)
+        std::fill(history.begin(), history.end(), Frame{});
+}
+
+float **Oversampler::upsample(const float *const *input, int numSamples) noexcept
+{
+    numSamples = std::min(numSamples, maxBlockSize_);
+    const int topLength = numSamples * factor_;
+
+    for (int g = 0; g < numGroups_; ++g)
+    {
+        const int firstChannel = g * 4;
+        const int groupChannels = std::min(4, numChannels_ - firstChannel);
+
+        // Interleave the group's channels into frames
+        Frame *frames = frameA_.data();
+        for (int i = 0; i < numSamples; ++i)
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                const float *in = lane < groupChannels ? input[firstChannel + lane] : nullptr;
+                frames[i].lanes[lane] = in != nullptr ? in[i] : 0.0f;
+            }
+        }
+
+        int length = numSamples;
+        for (int s = 0; s < numStages_; ++s)
+        {
+            Frame *out = frames == frameA_.data() ? frameB_.data() : frameA_.data();
+            upStage(s, upState_[static_cast<size_t>(g * numStages_ + s)], frames, length, out);
+            frames = out;
+            length *= 2;
+        }
+
+        for (int lane = 0; lane < groupChannels; ++lane)
+        {
+            float *out = channelPointers_[static_cast<size_t>(firstChannel + lane)];
+            for (int i = 0; i < topLength; ++i)
+                out[i] = frames[i].lanes[lane];
+        }
+    }
+
+    return channelPointers_.data();
+}
+
+void Oversampler::downsample(float *const *output, int numSamples) noexcept
+{
+    numSamples = std::min(numSamples, maxBlockSize_);
+    const int topLength = numSamples * factor_;
+
+    for (int g = 0; g < numGroups_; ++g)
+    {
+        const int firstChannel = g * 4;
+        const int groupChannels = std::min(4, numChannels_ - firstChannel);
+
+        // Interleave behind the alignment delay, if any
+        auto &align = alignHistory_[static_cast<size_t>(g)];
+        Frame *frames = scratch_.data();
+        std::copy(align.begin(), align.end(), frames);
+        Frame *block = frames + alignDelay_;
+        for (int i = 0; i < topLength; ++i)
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                block[i].lanes[lane] =
+                    lane < groupChannels
+                        ? channelPointers_[static_cast<size_t>(firstChannel + lane)][i]
+                        : 0.0f;
+            }
+        }
+        std::copy(frames + topLength, frames + topLength + alignDelay_, align.begin());
+        std::copy(frames, frames + topLength, frameA_.data());
+        frames = frameA_.data();
+
+        int length = topLength;
+        for (int s = numStages_ - 1; s >= 0; --s)
+        {
+            length /= 2;
+            Frame *out = frames == frameA_.data() ? frameB_.data() : frameA_.data();
+            downStage(s, downState_[static_cast<size_t>(g * numStages_ + s)], frames, length,
+                      out);
+            frames = out;
+        }
+
+        for (int lane = 0; lane < groupChannels; ++lane)
+        {
+            float *out = output[firstChannel + lane];
+            if (out == nullptr)
+                continue;
+            for (int i = 0; i < numSamples; ++i)
+                out[i] = frames[i].lanes[lane];
+        }
+    }
+}
+
+void Oversampler::upStage(int stageIndex, StageState &state, const Frame *in, int numIn,
+                          Frame *out) noexcept
+{
+    const auto &stage = stages_[static_cast<size_t>(stageIndex)];
+
+    if (filter_ == Filter::FIR)
+    {
+        // Even outputs: the polyphase taps over the input and its history.
+        // Odd outputs: the input, delayed to the centre tap.
+        const int numTaps = static_cast<int>(stage.taps.size());
+        const int historyLength = numTaps - 1;
+        Frame *x = scratch_.data();
+        std::copy(state.history.begin(), state.history.end(), x);
+        std::copy(in, in + numIn, x + historyLength);
+
+        const float *taps = stage.taps.data();
+        for (int i = 0; i < numIn; ++i)
+        {
+            const Frame *newest = x + historyLength + i;
+            Lanes acc = mul(splat(2.0f * taps[0]), load(newest->lanes));
+            for (int t = 1; t < numTaps; ++t)
+                acc = add(acc, mul(splat(2.0f * taps[t]), load((newest - t)->lanes)));
+            store(out[2 * i].lanes, acc);
+            out[2 * i + 1] = *(newest - stage.centreDelay);
+        }
+
+        std::copy(x + numIn, x + numIn + historyLength, state.history.begin());
+        return;
+    }
+
+    // Two allpass branches over the same input, one per output phase
+    const int numCoefficients = static_cast<int>(stage.coefficients.size());
+    for (int i = 0; i < numIn; ++i)
+    {
+        Lanes branch[2] = {load(in[i].lanes), load(in[i].lanes)};
+        for (int c = 0; c < numCoefficients; ++c)
+        {
+            Lanes &x = branch[c & 1];
+            const Lanes y = add(mul(splat(stage.coefficients[static_cast<size_t>(c)]),
+                                    sub(x, load(state.y1[static_cast<size_t>(c)].lanes))),
+                                load(state.x1[static_cast<size_t>(c)].lanes));
+            store(state.x1[static_cast<size_t>(c)].lanes, x);
+            store(state.y1[static_cast<size_t>(c)].lanes, y);
+            x = y;
+        }
+        store(out[2 * i].lanes, branch[0]);
+        store(out[2 * i + 1].lanes, branch[1]);
+    }
+}
+
+void Oversampler::downStage(int stageIndex, StageState &state, const Frame *in, int numOut,
+                            Frame *out) noexcept
+{
+    const auto &stage = stages_[static_cast<size_t>(stageIndex)];
+
+    if (filter_ == Filter::FIR)
+    {
+        // The polyphase taps over the even inputs plus the centre tap on the odd ones
+        const int numTaps = static_cast<int>(stage.taps.size());
+        const int historyLength = 2 * (numTaps - 1);
+        Frame *x = scratch_.data();
+        std::copy(state.history.begin(), state.history.end(), x);
+        std::copy(in, in + 2 * numOut, x + historyLength);
+
+        const float *taps = stage.taps.data();
+        const int centre = 2 * stage.centreDelay + 1;
+        for (int i = 0; i < numOut; ++i)
+        {
+            const Frame *newest = x + historyLength + 2 * i;
+            Lanes acc = mul(splat(0.5f), load((newest - centre)->lanes));
+            for (int t = 0; t < numTaps; ++t)
+                acc = add(acc, mul(splat(taps[t]), load((newest - 2 * t)->lanes)));
+            store(out[i].lanes, acc);
+        }
+
+        std::copy(x + 2 * numOut, x + 2 * numOut + historyLength, state.history.begin());
+        return;
+    }
+
+    // The odd input through one branch, the even input through the other
+    const int numCoefficients = static_cast<int>(stage.coefficients.size());
+    const Lanes half = splat(0.5f);
+    for (int i = 0; i < numOut; ++i)
+    {
+        Lanes branch[2] = {load(in[2 * i + 1].lanes), load(in[2 * i].lanes)};
+        for (int c = 0; c < numCoefficients; ++c)
+        {
+            Lanes &x = branch[c & 1];
+            const Lanes y = add(mul(splat(stage.coefficients[static_cast<size_t>(c)]),
+                                    sub(x, load(state.y1[static_cast<size_t>(c)].lanes))),
+                                load(state.x1[static_cast<size_t>(c)].lanes));
+            store(state.x1[static_cast<size_t>(c)].lanes, x);
+            store(state.y1[static_cast<size_t>(c)].lanes, y);
+            x = y;
+        }
+        store(out[i].lanes, mul(half, add(branch[0], branch[1])));
+    }
+}
+
+} // namespace ampl
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+
+namespace ampl
+{
+
+// 2x, 4x or 8x sample-rate conversion around a nonlinear process, as a
+// cascade of half-band stages. Each stage is polyphase: upsampling filters
+// at the input rate and downsampling at the output rate, so no work is spent
+// on the zeros of the stuffed signal.
+//
+// Two filter families:
+// - FIR: linear-phase half-band filters (Kaiser window, ~80 dB stopband).
+//   The latency is padded to a whole number of samples at the session rate.
+// - IIR: polyphase allpass half-band filters. A fraction of the FIR latency
+//   and cost, with phase distortion near the top of the band; the latency
+//   reported is the group delay at low frequencies, rounded.
+//
+// Channels are processed four at a time, as the lanes of one SIMD register
+// (SSE or NEON; scalar elsewhere).
+class Oversampler
+{
+  public:
+    enum class Filter
+    {
+        FIR,
+        IIR
+    };
+
+    static constexpr int kMaxFactor = 8;
+    static constexpr int kMaxChannels = 8;
+
+    // Allocates for blocks of up to maxBlockSize samples at the session rate.
+    // factor is rounded to 1, 2, 4 or 8. Not real-time safe.
+    void prepare(int factor, Filter filter, int numChannels, int maxBlockSize);
+
+    int getFactor() const noexcept { return factor_; }
+    Filter getFilter() const noexcept { return filter_; }
+    int getMaxBlockSize() const noexcept { return maxBlockSize_; }
+
+    // Round-trip latency (upsample then downsample) at the session rate
+    int getLatencySamples() const noexcept { return latency_; }
+
+    void reset() noexcept;
+
+    // Audio thread: upsamples numSamples (<= getMaxBlockSize()) samples of
+    // each channel and returns the oversampled channels, factor * numSamples
+    // samples each. Null input channels upsample silence.
+    float **upsample(const float *const *input, int numSamples) noexcept;
+
+    // Audio thread: filters the oversampled channels (as returned by
+    // upsample(), processed in place since) back down into output.
+    void downsample(float *const *output, int numSamples) noexcept;
+
+  private:
+    // One sample of four channels
+    struct alignas(16) Frame
+    {
+        float lanes[4];
+    };
+
+    struct Stage
+    {
+        // FIR: the nonzero polyphase taps. Upsampling computes one output
+        // phase from them, the other is the input delayed by centreDelay.
+        std::vector<float> taps;
+        int centreDelay{0};
+
+        // IIR: allpass coefficients, alternating between the two branches
+        std::vector<float> coefficients;
+    };
+
+    // Per channel group and stage: filter memory of one direction
+    struct StageState
+    {
+        std::vector<Frame> history; // FIR: inputs preceding the block
+        std::vector<Frame> x1;      // IIR: previous input of each allpass
+        std::vector<Frame> y1;      // IIR: previous output of each allpass
+    };
+
+    void upStage(int stage, StageState &state, const Frame *in, int numIn, Frame *out) noexcept;
+    void downStage(int stage, StageState &state, const Frame *in, int numOut,
+                   Frame *out) noexcept;
+
+    int factor_{1};
+    int numStages_{0};
+    Filter filter_{Filter::FIR};
+    int numChannels_{0};
+    int numGroups_{0};
+    int maxBlockSize_{0};
+    int latency_{0};
+
+    std::vector<Stage> stages_;
+    std::vector<StageState> upState_;   // [group * numStages_ + stage]
+    std::vector<StageState> downState_; // [group * numStages_ + stage]
+
+    // FIR: frames at the top rate that pad the latency to whole samples
+    int alignDelay_{0};
+    std::vector<std::vector<Frame>> alignHistory_; // Per group
+
+    // Ping-pong frame buffers and the FIR history + block scratch
+    std::vector<Frame> frameA_;
+    std::vector<Frame> frameB_;
+    std::vector<Frame> scratch_;
+
+    // Oversampled channels handed to the caller
+    std::vector<float> channelMemory_;
+    std::vector<float *> channelPointers_;
+};
+
+} // namespace ampl
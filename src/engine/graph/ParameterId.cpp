@@ -0,0 +1,78 @@
+#include "engine/graph/ParameterId.hpp"
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace ampl
+{
+
+namespace
+{
+
+class ParameterTable
+{
+  public:
+    static ParameterTable &instance()
+    {
+        static ParameterTable table;
+        return table;
+    }
+
+    ParameterId intern(std::string_view name)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            if (auto it = ids_.find(name); it != ids_.end())
+                return ParameterId{it->second};
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (auto it = ids_.find(name); it != ids_.end())
+            return ParameterId{it->second};
+
+        // The deque keeps every name at a fixed address for the map's keys
+        const auto value = static_cast<uint32_t>(names_.size());
+        const std::string &stored = names_.emplace_back(name);
+        ids_.emplace(std::string_view(stored), value);
+        return ParameterId{value};
+    }
+
+    ParameterId find(std::string_view name) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(name);
+        return it != ids_.end() ? ParameterId{it->second} : ParameterId{};
+    }
+
+    const std::string &name(ParameterId id) const
+    {
+        static const std::string empty;
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return id.value < names_.size() ? names_[id.value] : empty;
+    }
+
+  private:
+    mutable std::shared_mutex mutex_;
+    std::deque<std::string> names_;
+    std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+} // namespace
+
+ParameterId ParameterId::intern(std::string_view name)
+{
+    return ParameterTable::instance().intern(name);
+}
+
+ParameterId ParameterId::find(std::string_view name)
+{
+    return ParameterTable::instance().find(name);
+}
+
+const std::string &ParameterId::name() const
+{
+    return ParameterTable::instance().name(*this);
+}
+
+} // namespace ampl
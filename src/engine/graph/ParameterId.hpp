@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace ampl
+{
+
+// Compact handle for a parameter ID string. IDs are interned once in a global
+// table (at setup, off the audio thread); from then on parameters are set,
+// read and automated by comparing integers, with no string building or hashing.
+// Handles are process-wide and stable, so equal strings always get equal handles.
+struct ParameterId
+{
+    static constexpr uint32_t kInvalid = 0xffffffffu;
+
+    uint32_t value{kInvalid};
+
+    // Handle for name, added to the table on first use. Takes a lock and may
+    // allocate: call at setup, not on the audio thread.
+    static ParameterId intern(std::string_view name);
+
+    // Handle for a name that was already interned, or an invalid handle
+    static ParameterId find(std::string_view name);
+
+    // The interned string; empty for an invalid handle
+    const std::string &name() const;
+
+    bool isValid() const noexcept
+    {
+        return value != kInvalid;
+    }
+
+    friend bool operator==(ParameterId a, ParameterId b) noexcept
+    {
+        return a.value == b.value;
+    }
+    friend bool operator!=(ParameterId a, ParameterId b) noexcept
+    {
+        return a.value != b.value;
+    }
+};
+
+} // namespace ampl
+
+template <> struct std::hash<ampl::ParameterId>
+{
+    size_t operator()(ampl::ParameterId id) const noexcept
+    {
+        return std::hash<uint32_t>{}(id.value);
+    }
+};
@@ -9,6 +9,13 @@ bool OfflineRenderer::render(const Session& session,
                               std::function<void(const Progress&)> progressCallback,
                               std::atomic<bool>* cancelFlag)
 {
+    // An export can start while a project's audio is still loading in the
+    // background; render the clips, not silence
+    for (const auto& track : session.getTracks())
+        for (const auto& clip : track.clips)
+            if (clip.asset)
+                clip.asset->waitUntilLoaded();
+
     // Determine render length
     SampleCount endSample = settings.endSample;
     if (endSample <= 0)
@@ -174,7 +181,7 @@ void OfflineRenderer::processBlock(const Session& session,
 
         for (const auto& clip : track.clips)
         {
-            if (!clip.asset || clip.asset->numChannels == 0)
+            if (!clip.asset || !clip.asset->hasSamples())
                 continue;
 
             // Check if this clip overlaps the current block
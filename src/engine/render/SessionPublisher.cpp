@@ -0,0 +1,74 @@
+#include "engine/render/SessionPublisher.hpp"
+
+namespace ampl
+{
+
+SessionPublisher::SessionPublisher(SessionRenderer &renderer)
+    : renderer_(renderer), thread_([this] { run(); })
+{
+}
+
+SessionPublisher::~SessionPublisher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+}
+
+void SessionPublisher::request(const Session &session)
+{
+    auto request = renderer_.prepare(session);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = std::move(request);
+        ++requested_;
+    }
+    condition_.notify_all();
+}
+
+void SessionPublisher::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto target = requested_;
+    condition_.wait(lock, [this, target] { return stop_ || published_ >= target; });
+}
+
+void SessionPublisher::run()
+{
+    auto nextAllowed = std::chrono::steady_clock::now();
+
+    for (;;)
+    {
+        SessionRenderer::PublishRequest request;
+        uint64_t covers = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return stop_ || pending_.has_value(); });
+
+            // Rate limit; requests arriving meanwhile replace this one
+            condition_.wait_until(lock, nextAllowed, [this] { return stop_; });
+            if (stop_)
+                return;
+
+            request = std::move(*pending_);
+            pending_.reset();
+            covers = requested_;
+        }
+
+        renderer_.publish(request);
+        if (onPublished)
+            onPublished();
+        nextAllowed = std::chrono::steady_clock::now() + kMinInterval;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            published_ = covers;
+        }
+        condition_.notify_all();
+    }
+}
+
+} // namespace ampl
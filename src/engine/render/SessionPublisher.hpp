@@ -0,0 +1,52 @@
+#pragma once
+
+#include "engine/render/SessionRenderer.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace ampl
+{
+
+// Publishes the session to a SessionRenderer from a background thread, so
+// render snapshots (flattened notes, clip tables, delay compensation) are
+// built off the UI thread. Requests coalesce: one made while another waits
+// replaces it, so a burst of edits costs one build. Builds start at least
+// kMinInterval apart.
+class SessionPublisher
+{
+  public:
+    explicit SessionPublisher(SessionRenderer &renderer);
+    ~SessionPublisher();
+
+    // UI thread: capture the session and queue it for publishing
+    void request(const Session &session);
+
+    // UI thread: wait until every request made so far has been published
+    void flush();
+
+    // Publishing thread: called after each publish
+    std::function<void()> onPublished;
+
+    static constexpr std::chrono::milliseconds kMinInterval{15};
+
+  private:
+    void run();
+
+    SessionRenderer &renderer_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::optional<SessionRenderer::PublishRequest> pending_;
+    uint64_t requested_{0}; // Requests made
+    uint64_t published_{0}; // Requests published or superseded
+    bool stop_{false};
+
+    std::thread thread_;
+};
+
+} // namespace ampl
@@ -1,4 +1,5 @@
 #include "engine/render/SessionRenderer.hpp"
+#include <algorithm>
 #include <cmath>
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_processors/juce_audio_processors.h>
@@ -28,10 +29,56 @@ SessionRenderer::~SessionRenderer()
 
 void SessionRenderer::publishSession(const Session &session)
 {
+    publish(prepare(session));
+}
+
+SessionRenderer::PublishRequest SessionRenderer::prepare(const Session &session)
+{
+    PublishRequest request;
+    request.session = session.takeSnapshot();
+    request.pluginSlots.reserve(request.session.tracks.size());
+
+    for (const auto &track : request.session.tracks)
+    {
+        auto &slots = request.pluginSlots.emplace_back();
+
+        auto addSlot = [&](const PluginSlot &ps, bool isInstrument)
+        {
+            if (!ps.isResolved)
+                return;
+            auto *loaded = pluginManager_->getPluginForAudio(ps.pluginId);
+            if (loaded && loaded->instance)
+            {
+                RenderTrack::PluginSlotInstance slot;
+                slot.instance = loaded->instance.get();
+                slot.bypassed = ps.bypassed;
+                slot.isInstrument = isInstrument;
+                slot.latencySamples = std::max(0, slot.instance->getLatencySamples());
+                slots.push_back(slot);
+                if (!ps.bypassed)
+                    request.pluginLatencies.emplace_back(ps.pluginId, slot.latencySamples);
+            }
+        };
+
+        // Instrument plugin (for MIDI tracks), then the insert effect chain
+        if (track.instrumentPlugin.has_value())
+            addSlot(*track.instrumentPlugin, true);
+        for (const auto &ps : track.pluginChain)
+            addSlot(ps, false);
+    }
+
+    return request;
+}
+
+void SessionRenderer::publish(const PublishRequest &request)
+{
+    std::lock_guard<std::mutex> lock(publishMutex_);
+
+    const auto &session = request.session;
     auto *snapshot = new RenderSnapshot();
 
     bool hasSolo = false;
-    for (const auto &track : session.getTracks())
+    for (const auto &track : session.tracks)
     {
         if (track.solo)
         {
@@ -42,15 +89,16 @@ void SessionRenderer::publishSession(const Session &session)
     snapshot->hasSoloedTrack = hasSolo;
 
     // Master bus
-    snapshot->masterGainLinear = juce::Decibels::decibelsToGain(session.getMasterGainDb());
-    float masterPanAngle = (session.getMasterPan() + 1.0f) * 0.5f;
+    snapshot->masterGainLinear = juce::Decibels::decibelsToGain(session.masterGainDb);
+    float masterPanAngle = (session.masterPan + 1.0f) * 0.5f;
     snapshot->masterPanL = std::cos(masterPanAngle * 1.5707963f);
     snapshot->masterPanR = std::sin(masterPanAngle * 1.5707963f);
 
-    DBG("SessionRenderer: Publishing session with " << session.getTracks().size() << " tracks");
+    DBG("SessionRenderer: Publishing session with " << session.tracks.size() << " tracks");
 
-    for (const auto &track : session.getTracks())
+    for (size_t trackIndex = 0; trackIndex < session.tracks.size(); ++trackIndex)
     {
+        const auto &track = session.tracks[trackIndex];
         RenderTrack rt;
         rt.gainLinear = juce::Decibels::decibelsToGain(track.gainDb);
         rt.muted = track.muted;
@@ -64,45 +112,17 @@ void SessionRenderer::publishSession(const Session &session)
         rt.isMidi = (track.type == TrackType::Midi);
         rt.isRecordArmed = false; // Can be extended later
 
-        // ─── Load plugin chain instances ───────────────────────────
-        // Instrument plugin (for MIDI tracks)
-        if (track.instrumentPlugin.has_value() && track.instrumentPlugin->isResolved)
-        {
-            auto *loaded = pluginManager_->getPluginForAudio(track.instrumentPlugin->pluginId);
-            if (loaded && loaded->instance)
-            {
-                RenderTrack::PluginSlotInstance slot;
-                slot.instance = loaded->instance.get();
-                slot.bypassed = track.instrumentPlugin->bypassed;
-                slot.isInstrument = true;
-                rt.pluginSlots.push_back(slot);
-            }
-        }
-
-        // Insert effect chain
-        for (const auto &ps : track.pluginChain)
-        {
-            if (!ps.isResolved)
-                continue;
-            auto *loaded = pluginManager_->getPluginForAudio(ps.pluginId);
-            if (loaded && loaded->instance)
-            {
-                RenderTrack::PluginSlotInstance slot;
-                slot.instance = loaded->instance.get();
-                slot.bypassed = ps.bypassed;
-                slot.isInstrument = false;
-                rt.pluginSlots.push_back(slot);
-            }
-        }
+        // Plugin chain, resolved by prepare()
+        rt.pluginSlots = request.pluginSlots[trackIndex];
 
         if (track.isAudio())
         {
             DBG("  Track '" << track.name << "' has " << track.clips.size() << " clips");
             for (const auto &clip : track.clips)
             {
-                if (!clip.asset || clip.asset->numChannels == 0)
+                if (!clip.asset || !clip.asset->hasSamples())
                 {
-                    DBG("    Clip has no asset or 0 channels");
+                    DBG("    Clip has no asset or its samples are not loaded");
                     continue;
                 }
 
@@ -136,14 +156,15 @@ void SessionRenderer::publishSession(const Session &session)
             for (const auto &mclip : track.midiClips)
             {
                 RenderMidiClip rmc;
-                for (const auto &note : mclip.notes)
+                const auto &notes = mclip.notes;
+                rmc.notes.resize(notes.size());
+                for (size_t i = 0; i < notes.size(); ++i)
                 {
-                    RenderMidiNote rmn;
-                    rmn.noteNumber = note.noteNumber;
-                    rmn.velocity = note.velocity;
-                    rmn.absoluteStart = mclip.timelineStartSample + note.startSample;
-                    rmn.absoluteEnd = rmn.absoluteStart + note.lengthSamples;
-                    rmc.notes.push_back(rmn);
+                    auto &rmn = rmc.notes[i];
+                    rmn.noteNumber = notes.getNoteNumber(i);
+                    rmn.velocity = notes.getVelocity(i);
+                    rmn.absoluteStart = mclip.timelineStartSample + notes.getStart(i);
+                    rmn.absoluteEnd = rmn.absoluteStart + notes.getLength(i);
                 }
                 rt.midiClips.push_back(std::move(rmc));
             }
@@ -152,11 +173,47 @@ void SessionRenderer::publishSession(const Session &session)
         snapshot->tracks.push_back(std::move(rt));
     }
 
+    // ─── Plugin delay compensation ─────────────────────────────
+    // Delay every track to the slowest plugin chain
+    for (auto &rt : snapshot->tracks)
+    {
+        for (const auto &slot : rt.pluginSlots)
+        {
+            if (slot.bypassed)
+                continue;
+            rt.latencySamples += slot.latencySamples;
+        }
+        snapshot->totalLatencySamples = std::max(snapshot->totalLatencySamples, rt.latencySamples);
+    }
+    for (auto &rt : snapshot->tracks)
+        rt.compensationSamples = snapshot->totalLatencySamples - rt.latencySamples;
+
+    totalLatencySamples_.store(snapshot->totalLatencySamples, std::memory_order_release);
+    auto latencies = request.pluginLatencies;
+    {
+        std::lock_guard<std::mutex> latencyLock(latencyMutex_);
+        publishedLatencies_.swap(latencies);
+    }
+
     // Atomically publish — audio thread will pick it up
     auto *old = pending_.exchange(snapshot, std::memory_order_acq_rel);
     delete old;
 }
 
+bool SessionRenderer::hasPluginLatencyChanged() const
+{
+    std::lock_guard<std::mutex> lock(latencyMutex_);
+    for (const auto &[pluginId, latency] : publishedLatencies_)
+    {
+        // An unloaded plugin counts as changed: the next publish drops it
+        auto *loaded = pluginManager_->getPluginForAudio(pluginId);
+        if (loaded == nullptr || loaded->instance == nullptr ||
+            std::max(0, loaded->instance->getLatencySamples()) != latency)
+            return true;
+    }
+    return false;
+}
+
 void SessionRenderer::process(float *leftOut, float *rightOut, int numSamples,
                               SampleCount position) noexcept
 {
@@ -312,6 +369,9 @@ void SessionRenderer::processWithExternalIO(float *leftOut, float *rightOut, int
         if (snapshot.hasSoloedTrack && !track.solo)
             continue;
 
+        // Sequenced material is read late to line up with the slowest track
+        const SampleCount trackPosition = position - track.compensationSamples;
+
         // ── MIDI track with real plugin instrument ──────────────────
         if (track.isMidi && !track.pluginSlots.empty())
         {
@@ -326,18 +386,18 @@ void SessionRenderer::processWithExternalIO(float *leftOut, float *rightOut, int
             {
                 for (const auto &note : mclip.notes)
                 {
-                    if (note.absoluteStart >= position &&
-                        note.absoluteStart < position + numSamples)
+                    if (note.absoluteStart >= trackPosition &&
+                        note.absoluteStart < trackPosition + numSamples)
                     {
-                        int sampleOffset = static_cast<int>(note.absoluteStart - position);
+                        int sampleOffset = static_cast<int>(note.absoluteStart - trackPosition);
                         trackMidi.addEvent(
                             juce::MidiMessage::noteOn(1, note.noteNumber, note.velocity),
                             sampleOffset);
                     }
-                    if (note.absoluteEnd >= position &&
-                        note.absoluteEnd < position + numSamples)
+                    if (note.absoluteEnd >= trackPosition &&
+                        note.absoluteEnd < trackPosition + numSamples)
                     {
-                        int sampleOffset = static_cast<int>(note.absoluteEnd - position);
+                        int sampleOffset = static_cast<int>(note.absoluteEnd - trackPosition);
                         trackMidi.addEvent(
                             juce::MidiMessage::noteOff(1, note.noteNumber),
                             sampleOffset);
@@ -383,13 +443,13 @@ void SessionRenderer::processWithExternalIO(float *leftOut, float *rightOut, int
                 {
                     for (const auto &note : mclip.notes)
                     {
-                        if (note.absoluteStart >= position &&
-                            note.absoluteStart < position + numSamples)
+                        if (note.absoluteStart >= trackPosition &&
+                            note.absoluteStart < trackPosition + numSamples)
                         {
                             pianoSynth_->noteOn(note.noteNumber, note.velocity);
                         }
-                        if (note.absoluteEnd >= position &&
-                            note.absoluteEnd < position + numSamples)
+                        if (note.absoluteEnd >= trackPosition &&
+                            note.absoluteEnd < trackPosition + numSamples)
                         {
                             pianoSynth_->noteOff(note.noteNumber);
                         }
@@ -430,16 +490,16 @@ void SessionRenderer::processWithExternalIO(float *leftOut, float *rightOut, int
         for (const auto &clip : track.clips)
         {
             SampleCount clipEnd = clip.timelineStart + clip.sourceLength;
-            if (position >= clipEnd || position + numSamples <= clip.timelineStart)
+            if (trackPosition >= clipEnd || trackPosition + numSamples <= clip.timelineStart)
                 continue;
 
             int blockStart = 0;
             int blockEnd = numSamples;
 
-            if (position < clip.timelineStart)
-                blockStart = static_cast<int>(clip.timelineStart - position);
-            if (position + numSamples > clipEnd)
-                blockEnd = static_cast<int>(clipEnd - position);
+            if (trackPosition < clip.timelineStart)
+                blockStart = static_cast<int>(clip.timelineStart - trackPosition);
+            if (trackPosition + numSamples > clipEnd)
+                blockEnd = static_cast<int>(clipEnd - trackPosition);
 
             float trackGain = hasPlugins ? 1.0f : track.gainLinear;
             float panL = hasPlugins ? 1.0f : track.panL;
@@ -447,7 +507,7 @@ void SessionRenderer::processWithExternalIO(float *leftOut, float *rightOut, int
 
             for (int i = blockStart; i < blockEnd; ++i)
             {
-                SampleCount posInClip = (position + i) - clip.timelineStart;
+                SampleCount posInClip = (trackPosition + i) - clip.timelineStart;
                 SampleCount sourcePos = clip.sourceStart + posInClip;
 
                 if (sourcePos < 0 || sourcePos >= clip.assetLength)
@@ -10,13 +10,15 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 namespace ampl
 {
 
 // RT-safe snapshot of the session for audio rendering.
-// All data is resolved at publish time on the UI thread.
+// All data is resolved at publish time, off the audio thread.
 // The audio thread only reads plain values and raw pointers
 // to immutable AudioAsset sample data — zero allocations, zero locks.
 struct RenderClip
@@ -71,8 +73,16 @@ struct RenderTrack
         juce::AudioPluginInstance *instance{nullptr}; // raw ptr, owned by pluginInstances_
         bool bypassed{false};
         bool isInstrument{false};
+        int latencySamples{0}; // As reported at publish time
     };
     std::vector<PluginSlotInstance> pluginSlots;
+
+    // Plugin delay compensation, resolved at publish time.
+    // latencySamples is the sum reported by the track's active plugins. The track
+    // reads its clips and notes compensationSamples behind the transport so its
+    // output lines up with the slowest track. Live input is not delayed.
+    int latencySamples{0};
+    int compensationSamples{0};
 };
 
 struct RenderSnapshot
@@ -85,23 +95,47 @@ struct RenderSnapshot
     float masterPanL{1.0f};
     float masterPanR{1.0f};
 
+    // Latency of the slowest track: how far output lags the transport position
+    int totalLatencySamples{0};
+
     // Keep AudioAssets alive while this snapshot is in use.
-    // Only touched by the UI thread during publish/delete — never by audio thread.
+    // Only touched while publishing or deleting — never by the audio thread.
     std::vector<AudioAssetPtr> assetRefs;
 };
 
 // Manages publishing session state to the audio thread via atomic pointer swap.
 // UI thread calls publishSession() whenever the session changes.
 // Audio thread calls process() to render audio from the current snapshot.
+//
+// Publishing comes in two halves so the snapshot can be built off the UI
+// thread (see SessionPublisher): prepare() captures the session on the UI
+// thread, publish() builds and installs the snapshot on any thread.
 class SessionRenderer
 {
   public:
     SessionRenderer();
     ~SessionRenderer();
 
+    // What publish() needs from the session. Copying the tracks costs
+    // O(tracks + clips) (see TrackState); plugins are resolved here because
+    // the plugin manager belongs to the UI thread.
+    struct PublishRequest
+    {
+        Session::Snapshot session;
+        std::vector<std::vector<RenderTrack::PluginSlotInstance>> pluginSlots; // [track]
+        std::vector<std::pair<juce::String, int>> pluginLatencies; // Active plugins by id
+    };
+
     // UI thread: publish a new snapshot from the current session state.
     void publishSession(const Session &session);
 
+    // UI thread
+    PublishRequest prepare(const Session &session);
+
+    // Any thread: builds the snapshot for request and hands it to the audio
+    // thread. Calls are serialised.
+    void publish(const PublishRequest &request);
+
     // Audio thread: render all tracks/clips into the output buffer.
     // Completely RT-safe — no allocations, no locks, no shared_ptr ops.
     void process(float *leftOut, float *rightOut, int numSamples, SampleCount position) noexcept;
@@ -112,6 +146,16 @@ class SessionRenderer
                                const float *audioInLeft, const float *audioInRight,
                                juce::MidiBuffer &externalMidi) noexcept;
 
+    // Total plugin latency of the last published snapshot
+    int getTotalLatencySamples() const noexcept
+    {
+        return totalLatencySamples_.load(std::memory_order_acquire);
+    }
+
+    // UI thread: true if a plugin in the last published snapshot now reports a
+    // different latency. Publish the session again to re-align the tracks.
+    bool hasPluginLatencyChanged() const;
+
     void setSampleRate(double sr) noexcept
     {
         sampleRate_ = sr;
@@ -158,6 +202,16 @@ class SessionRenderer
     std::vector<std::unique_ptr<juce::AudioPluginInstance>> pluginInstances_;
     std::mutex pluginInstancesMutex_; // protects pluginInstances_ on UI thread
 
+    std::mutex publishMutex_; // Serializes publish()
+
+    // Plugin latencies the last snapshot was aligned for, by plugin id: an
+    // instance may be unloaded after the publish. publish() copies them aside
+    // and only swaps them in under latencyMutex_, so the UI never waits on a
+    // snapshot build.
+    std::vector<std::pair<juce::String, int>> publishedLatencies_;
+    mutable std::mutex latencyMutex_;
+    std::atomic<int> totalLatencySamples_{0};
+
     std::atomic<RenderSnapshot *> pending_{nullptr};
     RenderSnapshot *active_{nullptr};
     RenderSnapshot *retired_{nullptr};
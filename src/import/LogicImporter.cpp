@@ -914,15 +914,15 @@ LogicImportResult LogicImporter::convertToSession(const LogicProjectData &projec
             mc.timelineStartSample = secondsToSamples(midiRegion.startTime, sampleRate);
             mc.lengthSamples = secondsToSamples(midiRegion.duration, sampleRate);
 
+            mc.notes.reserve(midiRegion.notes.size());
             for (const auto &note : midiRegion.notes)
             {
                 MidiNote mn;
-                mn.id = juce::Uuid().toString();
                 mn.noteNumber = note.noteNumber;
                 mn.velocity = note.velocity;
                 mn.startSample = secondsToSamples(note.startTime, sampleRate);
                 mn.lengthSamples = secondsToSamples(note.duration, sampleRate);
-                mc.notes.push_back(mn);
+                mc.addNote(mn);
             }
 
             track->midiClips.push_back(std::move(mc));
@@ -0,0 +1,76 @@
+#include "model/AssetLoader.hpp"
+#include "model/Session.hpp"
+
+namespace ampl
+{
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+
+    // Nobody waiting on these may hang
+    for (auto &job : jobs_)
+        publish(*job.asset);
+}
+
+void AssetLoader::enqueue(std::shared_ptr<AudioAsset> asset, OpenReader openReader,
+                          uint64_t peakKey, const juce::File &peakCacheDirectory)
+{
+    jassert(asset != nullptr && !asset->isLoaded());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back({std::move(asset), std::move(openReader), peakKey, peakCacheDirectory});
+        if (!thread_.joinable())
+            thread_ = std::thread([this] { run(); });
+    }
+    condition_.notify_one();
+}
+
+bool AssetLoader::load(AudioAsset &asset, juce::AudioFormatReader *reader, uint64_t peakKey,
+                       const juce::File &peakCacheDirectory)
+{
+    // The length and channel count were handed out before the samples were
+    // read, so a reader that disagrees with them is not used
+    const bool matches = reader != nullptr &&
+                         static_cast<int>(reader->numChannels) == asset.numChannels &&
+                         static_cast<SampleCount>(reader->lengthInSamples) == asset.lengthInSamples;
+    if (matches)
+        Session::readAsset(*reader, asset, peakKey, peakCacheDirectory);
+
+    publish(asset);
+    return matches;
+}
+
+void AssetLoader::run()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (stop_)
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        auto reader = job.openReader();
+        load(*job.asset, reader.get(), job.peakKey, job.peakCacheDirectory);
+        assetsLoaded_ = true;
+    }
+}
+
+void AssetLoader::publish(AudioAsset &asset)
+{
+    asset.loaded.store(true, std::memory_order_release);
+    asset.loaded.notify_all();
+}
+
+} // namespace ampl
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "model/Clip.hpp"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace ampl
+{
+
+// Reads the samples of audio assets on a background thread, so a project
+// can be shown as soon as its index is read. ProjectSerializer hands the
+// assets out unloaded (see AudioAsset::isLoaded()) and queues them here;
+// each is published when its samples and peaks are in. Assets are read one
+// at a time, in the order queued.
+class AssetLoader
+{
+  public:
+    AssetLoader() = default;
+    ~AssetLoader(); // Assets still queued are published without samples
+
+    // Creates the reader for an asset, on the loader thread
+    using OpenReader = std::function<std::unique_ptr<juce::AudioFormatReader>()>;
+
+    // asset must not be loaded yet
+    void enqueue(std::shared_ptr<AudioAsset> asset, OpenReader openReader, uint64_t peakKey,
+                 const juce::File &peakCacheDirectory);
+
+    // Fills asset from reader on the calling thread and publishes it.
+    // Fails, publishing the asset without samples, if there is no reader or
+    // it does not match the asset's channel count and length.
+    static bool load(AudioAsset &asset, juce::AudioFormatReader *reader, uint64_t peakKey,
+                     const juce::File &peakCacheDirectory);
+
+    // Message thread: true if an asset was published since the last call
+    bool haveAssetsLoaded()
+    {
+        return assetsLoaded_.exchange(false);
+    }
+
+  private:
+    struct Job
+    {
+        std::shared_ptr<AudioAsset> asset;
+        OpenReader openReader;
+        uint64_t peakKey;
+        juce::File peakCacheDirectory;
+    };
+
+    void run();
+    static void publish(AudioAsset &asset);
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Job> jobs_;
+    bool stop_{false};
+    std::atomic<bool> assetsLoaded_{false};
+
+    std::thread thread_;
+};
+
+} // namespace ampl
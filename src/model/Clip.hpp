@@ -1,7 +1,10 @@
 #pragma once
 
 #include <juce_core/juce_core.h>
+#include "model/PeakPyramid.hpp"
 #include "util/Types.hpp"
+#include <atomic>
+#include <functional>
 #include <vector>
 #include <memory>
 
@@ -9,6 +12,11 @@ namespace ampl {
 
 // Immutable audio data loaded from a file. Shared across clips that reference
 // the same source file. Never modified after creation — RT-safe to read.
+//
+// Assets of a binary project are handed out before their samples are read
+// (see AssetLoader): until isLoaded(), only the names, length, rate and
+// channel count may be read. channels and peaks are filled in once, before
+// the asset is marked loaded, and stay empty if reading failed.
 struct AudioAsset
 {
     juce::String filePath;
@@ -17,6 +25,33 @@ struct AudioAsset
     SampleCount lengthInSamples{0};
     double sampleRate{0.0};
     int numChannels{0};
+
+    // Waveform overview, filled in on the peak thread after loading
+    std::shared_ptr<const PeakPyramid> peaks;
+    uint64_t peakKey{0}; // PeakPyramid::contentKey() of the source, 0 if unknown
+
+    // Opens the encoded audio the samples came from, for assets with no
+    // source file of their own (e.g. read from a project archive)
+    std::function<std::unique_ptr<juce::InputStream>()> openSource;
+
+    std::atomic<bool> loaded{true};
+
+    bool isLoaded() const noexcept
+    {
+        return loaded.load(std::memory_order_acquire);
+    }
+
+    // Blocks until the background read has finished
+    void waitUntilLoaded() const noexcept
+    {
+        loaded.wait(false, std::memory_order_acquire);
+    }
+
+    // True once the samples can be played or drawn
+    bool hasSamples() const noexcept
+    {
+        return isLoaded() && !channels.empty();
+    }
 };
 
 using AudioAssetPtr = std::shared_ptr<const AudioAsset>;
@@ -2,35 +2,14 @@
 
 #include <juce_core/juce_core.h>
 #include "util/Types.hpp"
+#include "model/MidiNoteList.hpp"
+#include <optional>
+#include <utility>
 #include <vector>
-#include <algorithm>
 
 namespace ampl {
 
-// A single MIDI note event within a MidiClip.
-struct MidiNote
-{
-    juce::String id{juce::Uuid().toString()};
-    int noteNumber{60};           // 0-127 (C4 = 60)
-    float velocity{0.8f};         // 0.0 - 1.0
-    SampleCount startSample{0};   // Position within the clip (relative to clip start)
-    SampleCount lengthSamples{0}; // Duration
-
-    SampleCount getEndSample() const { return startSample + lengthSamples; }
-
-    MidiNote clone() const
-    {
-        MidiNote n;
-        n.id = juce::Uuid().toString();
-        n.noteNumber = noteNumber;
-        n.velocity = velocity;
-        n.startSample = startSample;
-        n.lengthSamples = lengthSamples;
-        return n;
-    }
-};
-
-// A MIDI clip on the timeline, containing a sequence of MidiNotes.
+// A MIDI clip on the timeline, containing a MidiNoteList.
 struct MidiClip
 {
     juce::String id{juce::Uuid().toString()};
@@ -39,13 +18,15 @@ struct MidiClip
     SampleCount timelineStartSample{0};
     SampleCount lengthSamples{0};   // Total clip length on timeline
 
-    std::vector<MidiNote> notes;
+    MidiNoteList notes;
 
     SampleCount getTimelineEndSample() const
     {
         return timelineStartSample + lengthSamples;
     }
 
+    // Note ids are per clip, so the copy keeps them, and shares the note
+    // storage until either clip is edited
     MidiClip clone() const
     {
         MidiClip c;
@@ -53,12 +34,14 @@ struct MidiClip
         c.name = name;
         c.timelineStartSample = timelineStartSample;
         c.lengthSamples = lengthSamples;
-        c.notes.reserve(notes.size());
-        for (const auto& n : notes)
-            c.notes.push_back(n.clone());
+        c.notes = notes;
         return c;
     }
 
+    // Bytes held by this clip, shared notes included (see
+    // MidiNoteList::getMemoryUsage())
+    size_t getMemoryUsage() const { return sizeof(MidiClip) + notes.getMemoryUsage(); }
+
     // Factory: create an empty MIDI clip of given length
     static MidiClip createEmpty(SampleCount startSample, SampleCount length,
                                  const juce::String& clipName = "MIDI")
@@ -70,38 +53,55 @@ struct MidiClip
         return c;
     }
 
+    // --- Note edits (see MidiNoteList) ---
+
+    MidiNoteId addNote(const MidiNote& note) { return notes.add(note); }
+
+    bool removeNote(MidiNoteId noteId, MidiNote* removed = nullptr)
+    {
+        return notes.remove(noteId, removed);
+    }
+
+    template <typename Fn>
+    bool updateNote(MidiNoteId noteId, Fn&& change)
+    {
+        return notes.update(noteId, std::forward<Fn>(change));
+    }
+
     // Find note by ID
-    MidiNote* findNote(const juce::String& noteId)
+    std::optional<MidiNote> findNote(MidiNoteId noteId) const { return notes.find(noteId); }
+
+    // --- Spatial queries (clip-relative samples) ---
+
+    // Replaces result with the positions in `notes` of the notes of pitch
+    // [lowNote, highNote] overlapping [startSample, endSample)
+    void findNotesInRange(SampleCount startSample, SampleCount endSample, int lowNote,
+                          int highNote, std::vector<uint32_t>& result) const
     {
-        for (auto& n : notes)
-            if (n.id == noteId) return &n;
-        return nullptr;
+        notes.getIndex().findInRange(notes, startSample, endSample, lowNote, highNote, result);
     }
 
-    const MidiNote* findNote(const juce::String& noteId) const
+    // The note of noteNumber sounding at sample (the latest-starting one if
+    // several overlap)
+    std::optional<MidiNote> findNoteAt(int noteNumber, SampleCount sample) const
     {
-        for (const auto& n : notes)
-            if (n.id == noteId) return &n;
-        return nullptr;
+        auto position = notes.getIndex().findNoteAt(notes, noteNumber, sample);
+        if (position < 0)
+            return std::nullopt;
+        return notes[static_cast<size_t>(position)];
     }
 
     // Get the highest note number and lowest for display range
     int getLowestNote() const
     {
         if (notes.empty()) return 60;
-        int lo = 127;
-        for (const auto& n : notes)
-            lo = std::min(lo, n.noteNumber);
-        return lo;
+        return notes.getIndex().getLowestPitch();
     }
 
     int getHighestNote() const
     {
         if (notes.empty()) return 72;
-        int hi = 0;
-        for (const auto& n : notes)
-            hi = std::max(hi, n.noteNumber);
-        return hi;
+        return notes.getIndex().getHighestPitch();
     }
 };
 
@@ -0,0 +1,224 @@
+#include "model/MidiNoteIndex.hpp"
+#include "model/MidiNoteList.hpp"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+
+namespace ampl {
+
+void MidiNoteIndex::rebuild(const MidiNoteList& notes)
+{
+    clear();
+
+    for (uint32_t position = 0; position < notes.size(); ++position)
+        getBucket(notes.getNoteNumber(position))->byStart.push_back(position);
+
+    for (auto& bucket : buckets_)
+    {
+        std::stable_sort(bucket.byStart.begin(), bucket.byStart.end(),
+                         [&notes](uint32_t a, uint32_t b)
+                         { return notes.getStart(a) < notes.getStart(b); });
+        updateEnds(notes, bucket, 0);
+    }
+
+    size_ = notes.size();
+}
+
+void MidiNoteIndex::clear()
+{
+    for (auto& bucket : buckets_)
+    {
+        bucket.byStart.clear();
+        bucket.maxEnd.clear();
+        bucket.leaves = 0;
+    }
+    size_ = 0;
+}
+
+void MidiNoteIndex::noteAdded(const MidiNoteList& notes, uint32_t position)
+{
+    insert(notes, position);
+    ++size_;
+}
+
+void MidiNoteIndex::noteRemoving(const MidiNoteList& notes, uint32_t position)
+{
+    erase(notes, position);
+    --size_;
+
+    // The last note moves into the hole
+    auto last = static_cast<uint32_t>(notes.size() - 1);
+    if (position != last)
+    {
+        auto& bucket = *getBucket(notes.getNoteNumber(last));
+        bucket.byStart[find(notes, bucket, last)] = position;
+    }
+}
+
+void MidiNoteIndex::noteChanging(const MidiNoteList& notes, uint32_t position)
+{
+    erase(notes, position);
+}
+
+void MidiNoteIndex::noteChanged(const MidiNoteList& notes, uint32_t position)
+{
+    insert(notes, position);
+}
+
+void MidiNoteIndex::findInRange(const MidiNoteList& notes, SampleCount start,
+                                SampleCount end, int lowPitch, int highPitch,
+                                std::vector<uint32_t>& result) const
+{
+    result.clear();
+
+    for (int pitch = std::max(0, lowPitch); pitch <= std::min(kNumPitches - 1, highPitch); ++pitch)
+    {
+        const auto& bucket = buckets_[static_cast<size_t>(pitch)];
+        if (bucket.byStart.empty())
+            continue;
+
+        // Of the notes starting before end, those still sounding at start
+        collectEndingAfter(bucket, 1, 0, bucket.leaves, firstStartingAtOrAfter(notes, bucket, end),
+                           start, result);
+    }
+}
+
+int64_t MidiNoteIndex::findNoteAt(const MidiNoteList& notes, int noteNumber,
+                                  SampleCount sample) const
+{
+    if (noteNumber < 0 || noteNumber >= kNumPitches)
+        return -1;
+    const auto& bucket = buckets_[static_cast<size_t>(noteNumber)];
+    if (bucket.byStart.empty())
+        return -1;
+
+    // The last of the notes starting at or before sample that ends after it
+    auto i = lastEndingAfter(bucket, 1, 0, bucket.leaves,
+                             firstStartingAtOrAfter(notes, bucket, sample + 1), sample);
+    return i < 0 ? -1 : static_cast<int64_t>(bucket.byStart[static_cast<size_t>(i)]);
+}
+
+size_t MidiNoteIndex::getMemoryUsage() const
+{
+    size_t bytes = sizeof(*this);
+    for (const auto& bucket : buckets_)
+        bytes += bucket.byStart.capacity() * sizeof(uint32_t) +
+                 bucket.maxEnd.capacity() * sizeof(SampleCount);
+    return bytes;
+}
+
+int MidiNoteIndex::getLowestPitch() const
+{
+    for (int pitch = 0; pitch < kNumPitches; ++pitch)
+        if (!buckets_[static_cast<size_t>(pitch)].byStart.empty())
+            return pitch;
+    return -1;
+}
+
+int MidiNoteIndex::getHighestPitch() const
+{
+    for (int pitch = kNumPitches - 1; pitch >= 0; --pitch)
+        if (!buckets_[static_cast<size_t>(pitch)].byStart.empty())
+            return pitch;
+    return -1;
+}
+
+MidiNoteIndex::Bucket* MidiNoteIndex::getBucket(int noteNumber)
+{
+    return &buckets_[static_cast<size_t>(std::clamp(noteNumber, 0, kNumPitches - 1))];
+}
+
+size_t MidiNoteIndex::firstStartingAtOrAfter(const MidiNoteList& notes,
+                                             const Bucket& bucket, SampleCount sample) const
+{
+    auto it = std::lower_bound(bucket.byStart.begin(), bucket.byStart.end(), sample,
+                               [&notes](uint32_t position, SampleCount s)
+                               { return notes.getStart(position) < s; });
+    return static_cast<size_t>(it - bucket.byStart.begin());
+}
+
+size_t MidiNoteIndex::find(const MidiNoteList& notes, const Bucket& bucket,
+                           uint32_t position) const
+{
+    // Notes sharing a start are in no particular order
+    auto i = firstStartingAtOrAfter(notes, bucket, notes.getStart(position));
+    while (i < bucket.byStart.size() && bucket.byStart[i] != position)
+        ++i;
+    jassert(i < bucket.byStart.size());
+    return i;
+}
+
+void MidiNoteIndex::erase(const MidiNoteList& notes, uint32_t position)
+{
+    auto& bucket = *getBucket(notes.getNoteNumber(position));
+    auto i = find(notes, bucket, position);
+    if (i == bucket.byStart.size())
+        return;
+
+    bucket.byStart.erase(bucket.byStart.begin() + static_cast<std::ptrdiff_t>(i));
+    updateEnds(notes, bucket, i);
+}
+
+void MidiNoteIndex::insert(const MidiNoteList& notes, uint32_t position)
+{
+    auto& bucket = *getBucket(notes.getNoteNumber(position));
+    auto i = firstStartingAtOrAfter(notes, bucket, notes.getStart(position) + 1);
+    bucket.byStart.insert(bucket.byStart.begin() + static_cast<std::ptrdiff_t>(i), position);
+    updateEnds(notes, bucket, i);
+}
+
+void MidiNoteIndex::updateEnds(const MidiNoteList& notes, Bucket& bucket, size_t first)
+{
+    const auto size = bucket.byStart.size();
+    if (size > bucket.leaves)
+    {
+        bucket.leaves = std::max<size_t>(16, bucket.leaves * 2);
+        while (bucket.leaves < size)
+            bucket.leaves *= 2;
+        bucket.maxEnd.assign(2 * bucket.leaves, kNoEnd);
+        first = 0;
+    }
+    if (bucket.leaves == 0)
+        return;
+
+    // Leaves from first on moved; one past the end may have been vacated
+    const auto last = std::min(size + 1, bucket.leaves);
+    if (first >= last)
+        return;
+    for (auto i = first; i < last; ++i)
+        bucket.maxEnd[bucket.leaves + i] = i < size ? notes.getEnd(bucket.byStart[i]) : kNoEnd;
+
+    for (auto lo = (bucket.leaves + first) / 2, hi = (bucket.leaves + last - 1) / 2; lo > 0;
+         lo /= 2, hi /= 2)
+    {
+        for (auto node = lo; node <= hi; ++node)
+            bucket.maxEnd[node] = std::max(bucket.maxEnd[2 * node], bucket.maxEnd[2 * node + 1]);
+    }
+}
+
+void MidiNoteIndex::collectEndingAfter(const Bucket& bucket, size_t node, size_t lo,
+                                       size_t width, size_t limit, SampleCount sample,
+                                       std::vector<uint32_t>& result) const
+{
+    if (lo >= limit || bucket.maxEnd[node] <= sample)
+        return;
+    if (width == 1)
+    {
+        result.push_back(bucket.byStart[lo]);
+        return;
+    }
+    collectEndingAfter(bucket, 2 * node, lo, width / 2, limit, sample, result);
+    collectEndingAfter(bucket, 2 * node + 1, lo + width / 2, width / 2, limit, sample, result);
+}
+
+int64_t MidiNoteIndex::lastEndingAfter(const Bucket& bucket, size_t node, size_t lo,
+                                       size_t width, size_t limit, SampleCount sample) const
+{
+    if (lo >= limit || bucket.maxEnd[node] <= sample)
+        return -1;
+    if (width == 1)
+        return static_cast<int64_t>(lo);
+    auto later = lastEndingAfter(bucket, 2 * node + 1, lo + width / 2, width / 2, limit, sample);
+    return later >= 0 ? later : lastEndingAfter(bucket, 2 * node, lo, width / 2, limit, sample);
+}
+
+} // namespace ampl
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "util/Types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace ampl {
+
+class MidiNoteList;
+
+// Spatial index over the notes of one MidiClip, for the piano roll.
+// One bucket per pitch holds positions into the clip's MidiNoteList sorted by
+// start sample, over a tree of the latest end below each node. A binary
+// search bounds the notes starting before the end of a range, and the tree
+// leads straight to those of them still sounding at its start, skipping every
+// subtree that ends earlier. Painting visits only the notes in view and a
+// hit test costs O(log n), however long the notes are.
+//
+// Owned by MidiNoteList, which reports every edit to it.
+class MidiNoteIndex
+{
+public:
+    static constexpr int kNumPitches = 128;
+
+    void rebuild(const MidiNoteList& notes);
+    void clear();
+
+    // The note at position was appended
+    void noteAdded(const MidiNoteList& notes, uint32_t position);
+
+    // The note at position is about to be erased by moving the last note
+    // into its place
+    void noteRemoving(const MidiNoteList& notes, uint32_t position);
+
+    // The note at position is about to change pitch, start or length; call
+    // noteChanged() once it has
+    void noteChanging(const MidiNoteList& notes, uint32_t position);
+    void noteChanged(const MidiNoteList& notes, uint32_t position);
+
+    size_t size() const { return size_; }
+
+    // Bytes allocated by the buckets
+    size_t getMemoryUsage() const;
+
+    // Replaces result with the positions of the notes of pitch [lowPitch,
+    // highPitch] that overlap the clip-relative sample range [start, end),
+    // in pitch order and by start within a pitch
+    void findInRange(const MidiNoteList& notes, SampleCount start, SampleCount end,
+                     int lowPitch, int highPitch, std::vector<uint32_t>& result) const;
+
+    // Position of the latest-starting note of noteNumber that covers the
+    // clip-relative sample, or -1
+    int64_t findNoteAt(const MidiNoteList& notes, int noteNumber,
+                       SampleCount sample) const;
+
+    // Lowest and highest pitch in use, or -1 if the clip has no notes
+    int getLowestPitch() const;
+    int getHighestPitch() const;
+
+private:
+    struct Bucket
+    {
+        std::vector<uint32_t> byStart; // positions, ordered by start sample
+
+        // Implicit binary tree over byStart: leaf i, at maxEnd[leaves + i],
+        // holds the end of byStart[i], every other node the latest end below
+        // it. Unused leaves hold kNoEnd.
+        std::vector<SampleCount> maxEnd;
+        size_t leaves{0};
+    };
+
+    static constexpr SampleCount kNoEnd = std::numeric_limits<SampleCount>::min();
+
+    Bucket* getBucket(int noteNumber);
+    size_t firstStartingAtOrAfter(const MidiNoteList& notes, const Bucket& bucket,
+                                  SampleCount sample) const;
+
+    // Brings the tree up to date after byStart changed from index first on
+    void updateEnds(const MidiNoteList& notes, Bucket& bucket, size_t first);
+
+    // Tree walks over the leaves below node, which covers [lo, lo + width),
+    // limited to those before limit and ending after sample
+    void collectEndingAfter(const Bucket& bucket, size_t node, size_t lo, size_t width,
+                            size_t limit, SampleCount sample, std::vector<uint32_t>& result) const;
+    int64_t lastEndingAfter(const Bucket& bucket, size_t node, size_t lo, size_t width,
+                            size_t limit, SampleCount sample) const;
+    size_t find(const MidiNoteList& notes, const Bucket& bucket, uint32_t position) const;
+    void erase(const MidiNoteList& notes, uint32_t position);
+    void insert(const MidiNoteList& notes, uint32_t position);
+
+    std::array<Bucket, kNumPitches> buckets_;
+    size_t size_{0};
+};
+
+} // namespace ampl
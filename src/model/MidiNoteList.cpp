@@ -0,0 +1,222 @@
+#include "model/MidiNoteList.hpp"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+namespace ampl {
+
+namespace {
+
+uint64_t takeRevision()
+{
+    // Shared by all lists, so a copy edited apart from its original never
+    // repeats a revision the original had
+    static std::atomic<uint64_t> lastRevision{0};
+    return ++lastRevision;
+}
+
+} // namespace
+
+MidiNoteList::MidiNoteList() : data_(getEmptyData()) {}
+
+const std::shared_ptr<MidiNoteList::Data>& MidiNoteList::getEmptyData()
+{
+    static const auto empty = std::make_shared<Data>();
+    return empty;
+}
+
+MidiNoteList::Data& MidiNoteList::edit()
+{
+    if (data_.use_count() > 1)
+        data_ = std::make_shared<Data>(*data_);
+    data_->revision = takeRevision();
+    return *data_;
+}
+
+void MidiNoteList::reserve(size_t numNotes)
+{
+    auto& d = edit();
+    d.ids.reserve(numNotes);
+    d.pitches.reserve(numNotes);
+    d.velocities.reserve(numNotes);
+    d.starts.reserve(numNotes);
+    d.lengths.reserve(numNotes);
+}
+
+void MidiNoteList::clear()
+{
+    // Ids stay unique across the clear
+    auto nextId = data_->nextId;
+    data_ = std::make_shared<Data>();
+    data_->nextId = nextId;
+    data_->revision = takeRevision();
+}
+
+MidiNoteId MidiNoteList::add(const MidiNote& note)
+{
+    auto& d = edit();
+
+    auto id = note.id;
+    bool usable = id != 0 && id < d.nextId + kMaxIdGap && indexOf(id) < 0;
+    if (!usable)
+        id = d.nextId;
+    d.nextId = std::max(d.nextId, id + 1);
+
+    if (id >= d.positionOfId.size())
+        d.positionOfId.resize(static_cast<size_t>(id) + 1, kNoPosition);
+
+    auto position = static_cast<uint32_t>(d.ids.size());
+    d.positionOfId[id] = position;
+    d.ids.push_back(id);
+    d.pitches.push_back(static_cast<uint8_t>(std::clamp(note.noteNumber, 0, 127)));
+    d.velocities.push_back(note.velocity);
+    d.starts.push_back(note.startSample);
+    d.lengths.push_back(note.lengthSamples);
+
+    d.index.noteAdded(*this, position);
+    return id;
+}
+
+bool MidiNoteList::remove(MidiNoteId id, MidiNote* removed)
+{
+    auto found = indexOf(id);
+    if (found < 0)
+        return false;
+
+    auto position = static_cast<uint32_t>(found);
+    if (removed != nullptr)
+        *removed = (*this)[position];
+
+    auto& d = edit();
+    d.index.noteRemoving(*this, position);
+
+    auto last = d.ids.size() - 1;
+    if (position != last)
+    {
+        d.ids[position] = d.ids[last];
+        d.pitches[position] = d.pitches[last];
+        d.velocities[position] = d.velocities[last];
+        d.starts[position] = d.starts[last];
+        d.lengths[position] = d.lengths[last];
+        d.positionOfId[d.ids[position]] = position;
+    }
+
+    d.ids.pop_back();
+    d.pitches.pop_back();
+    d.velocities.pop_back();
+    d.starts.pop_back();
+    d.lengths.pop_back();
+    d.positionOfId[id] = kNoPosition;
+    return true;
+}
+
+void MidiNoteList::store(uint32_t position, const MidiNote& note)
+{
+    auto pitch = static_cast<uint8_t>(std::clamp(note.noteNumber, 0, 127));
+    bool moved = pitch != data_->pitches[position] || note.startSample != data_->starts[position]
+                 || note.lengthSamples != data_->lengths[position];
+
+    // Leave shared storage shared if nothing changes
+    if (!moved && note.velocity == data_->velocities[position])
+        return;
+
+    auto& d = edit();
+
+    if (moved)
+        d.index.noteChanging(*this, position);
+
+    d.pitches[position] = pitch;
+    d.velocities[position] = note.velocity;
+    d.starts[position] = note.startSample;
+    d.lengths[position] = note.lengthSamples;
+
+    if (moved)
+        d.index.noteChanged(*this, position);
+}
+
+size_t MidiNoteList::getMemoryUsage() const
+{
+    const auto& d = *data_;
+    return sizeof(Data) + d.ids.capacity() * sizeof(MidiNoteId)
+           + d.pitches.capacity() * sizeof(uint8_t) + d.velocities.capacity() * sizeof(float)
+           + d.starts.capacity() * sizeof(SampleCount)
+           + d.lengths.capacity() * sizeof(SampleCount)
+           + d.positionOfId.capacity() * sizeof(uint32_t) + d.index.getMemoryUsage();
+}
+
+// The columns go out as raw arrays, which are little-endian on every
+// platform we build for
+static_assert(std::endian::native == std::endian::little);
+
+namespace {
+
+template <typename T>
+void writeColumn(juce::OutputStream& out, const std::vector<T>& column)
+{
+    out.write(column.data(), column.size() * sizeof(T));
+}
+
+template <typename T>
+bool readColumn(juce::InputStream& in, std::vector<T>& column, size_t size)
+{
+    column.resize(size);
+    auto bytes = size * sizeof(T);
+    return static_cast<size_t>(in.read(column.data(), bytes)) == bytes;
+}
+
+} // namespace
+
+void MidiNoteList::writeTo(juce::OutputStream& out) const
+{
+    const auto& d = *data_;
+    out.writeInt(static_cast<int>(d.ids.size()));
+    out.writeInt(static_cast<int>(d.nextId));
+    writeColumn(out, d.ids);
+    writeColumn(out, d.pitches);
+    writeColumn(out, d.velocities);
+    writeColumn(out, d.starts);
+    writeColumn(out, d.lengths);
+}
+
+bool MidiNoteList::readFrom(juce::InputStream& in)
+{
+    auto numNotes = static_cast<uint32_t>(in.readInt());
+    auto nextId = static_cast<MidiNoteId>(in.readInt());
+
+    auto d = std::make_shared<Data>();
+    data_ = getEmptyData();
+
+    // Ids come from add(), so none can be further than kMaxIdGap per note
+    // past the last; anything beyond that is corrupt
+    if (nextId == 0 || nextId > (static_cast<uint64_t>(numNotes) + 1) * kMaxIdGap)
+        return false;
+
+    // Columns are filled before anything is allocated for them
+    auto remaining = in.getNumBytesRemaining();
+    auto bytesPerNote = sizeof(MidiNoteId) + sizeof(uint8_t) + sizeof(float) + 2 * sizeof(SampleCount);
+    if (remaining >= 0 && static_cast<uint64_t>(remaining) < numNotes * static_cast<uint64_t>(bytesPerNote))
+        return false;
+
+    if (!readColumn(in, d->ids, numNotes) || !readColumn(in, d->pitches, numNotes)
+        || !readColumn(in, d->velocities, numNotes) || !readColumn(in, d->starts, numNotes)
+        || !readColumn(in, d->lengths, numNotes))
+        return false;
+
+    d->nextId = nextId;
+    d->revision = takeRevision();
+    d->positionOfId.assign(nextId, kNoPosition);
+    for (uint32_t position = 0; position < numNotes; ++position)
+    {
+        auto id = d->ids[position];
+        if (id == 0 || id >= nextId || d->positionOfId[id] != kNoPosition || d->pitches[position] > 127)
+            return false;
+        d->positionOfId[id] = position;
+    }
+
+    data_ = std::move(d);
+    data_->index.rebuild(*this);
+    return true;
+}
+
+} // namespace ampl
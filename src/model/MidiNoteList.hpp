@@ -0,0 +1,195 @@
+#pragma once
+
+#include "util/Types.hpp"
+#include "model/MidiNoteIndex.hpp"
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace juce {
+class InputStream;
+class OutputStream;
+} // namespace juce
+
+namespace ampl {
+
+// Identifies a note within its MidiClip. Allocated by the clip's note list,
+// never reused by it, and copied along with the notes when a clip is cloned.
+// Zero means "not yet assigned".
+using MidiNoteId = uint32_t;
+
+// A single MIDI note event within a MidiClip. A value type: the clip stores
+// its notes column-wise in a MidiNoteList and hands out copies.
+struct MidiNote
+{
+    MidiNoteId id{0};
+    int noteNumber{60};           // 0-127 (C4 = 60)
+    float velocity{0.8f};         // 0.0 - 1.0
+    SampleCount startSample{0};   // Position within the clip (relative to clip start)
+    SampleCount lengthSamples{0}; // Duration
+
+    SampleCount getEndSample() const { return startSample + lengthSamples; }
+};
+
+// The notes of a MidiClip, stored as structure-of-arrays: one column each
+// for id, pitch, velocity, start and length, plus a table from id to
+// position. Looking a note up by id is O(1). The order of the notes carries
+// no meaning; removal moves the last note into the hole.
+//
+// Copies share their storage until one of them is edited, so copying a
+// clip for an undo snapshot costs a reference count rather than the notes.
+// Lists are edited and copied on the message thread only.
+//
+// The list keeps a MidiNoteIndex over its notes up to date with every edit.
+class MidiNoteList
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = MidiNote;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = MidiNote;
+
+        const_iterator() = default;
+        const_iterator(const MidiNoteList* list, size_t position) : list_(list), position_(position) {}
+
+        MidiNote operator*() const { return (*list_)[position_]; }
+        const_iterator& operator++() { ++position_; return *this; }
+        const_iterator operator++(int) { auto old = *this; ++position_; return old; }
+        bool operator==(const const_iterator& other) const { return position_ == other.position_; }
+        bool operator!=(const const_iterator& other) const { return position_ != other.position_; }
+
+    private:
+        const MidiNoteList* list_{nullptr};
+        size_t position_{0};
+    };
+
+    MidiNoteList();
+
+    size_t size() const { return data_->ids.size(); }
+    bool empty() const { return data_->ids.empty(); }
+    void reserve(size_t numNotes);
+    void clear();
+
+    MidiNote operator[](size_t position) const
+    {
+        const auto& d = *data_;
+        return {d.ids[position], d.pitches[position], d.velocities[position],
+                d.starts[position], d.lengths[position]};
+    }
+
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, size()}; }
+
+    // Column access by position
+    MidiNoteId getId(size_t position) const { return data_->ids[position]; }
+    int getNoteNumber(size_t position) const { return data_->pitches[position]; }
+    float getVelocity(size_t position) const { return data_->velocities[position]; }
+    SampleCount getStart(size_t position) const { return data_->starts[position]; }
+    SampleCount getLength(size_t position) const { return data_->lengths[position]; }
+    SampleCount getEnd(size_t position) const { return getStart(position) + getLength(position); }
+
+    // Appends note, keeping its id if that is set and free, and returns the
+    // id it was stored under. The pitch is clamped to 0-127.
+    MidiNoteId add(const MidiNote& note);
+
+    // False if there is no such note
+    bool remove(MidiNoteId id, MidiNote* removed = nullptr);
+
+    // Calls change(note) on a copy of the note and stores the result back
+    // (the id cannot change). False if there is no such note.
+    template <typename Fn>
+    bool update(MidiNoteId id, Fn&& change)
+    {
+        auto position = indexOf(id);
+        if (position < 0)
+            return false;
+
+        auto note = (*this)[static_cast<size_t>(position)];
+        change(note);
+        note.id = id;
+        store(static_cast<uint32_t>(position), note);
+        return true;
+    }
+
+    // Position of the note, or -1
+    int64_t indexOf(MidiNoteId id) const
+    {
+        const auto& positionOfId = data_->positionOfId;
+        if (id >= positionOfId.size() || positionOfId[id] == kNoPosition)
+            return -1;
+        return positionOfId[id];
+    }
+
+    std::optional<MidiNote> find(MidiNoteId id) const
+    {
+        auto position = indexOf(id);
+        if (position < 0)
+            return std::nullopt;
+        return (*this)[static_cast<size_t>(position)];
+    }
+
+    const MidiNoteIndex& getIndex() const { return data_->index; }
+
+    // Changes with every edit and is never reused, so equal revisions mean
+    // equal notes. Lets a view tell whether the notes it drew have changed
+    // without comparing them.
+    uint64_t getRevision() const { return data_->revision; }
+
+    // True if this list and other share their storage
+    bool sharesStorageWith(const MidiNoteList& other) const { return data_ == other.data_; }
+
+    // Bytes of the storage this list holds, counted in full even while it is
+    // shared: the other holders may let go later and leave this list (say,
+    // in an undo entry) its only owner
+    size_t getMemoryUsage() const;
+
+    // True if another list currently shares the storage. A hint only: other
+    // threads may be dropping their copies.
+    bool isStorageShared() const { return data_.use_count() > 1; }
+
+    // Binary dump of the columns (readFrom() rebuilds the id table and
+    // index). readFrom() replaces the notes and returns false, leaving the
+    // list empty, if the stream is truncated or inconsistent.
+    void writeTo(juce::OutputStream& out) const;
+    bool readFrom(juce::InputStream& in);
+
+private:
+    static constexpr uint32_t kNoPosition = 0xffffffffu;
+    // Requested ids further than this past the highest id in use are
+    // replaced, so a corrupt file cannot blow up the id table
+    static constexpr MidiNoteId kMaxIdGap = 1u << 16;
+
+    struct Data
+    {
+        std::vector<MidiNoteId> ids;
+        std::vector<uint8_t> pitches;
+        std::vector<float> velocities;
+        std::vector<SampleCount> starts;
+        std::vector<SampleCount> lengths;
+
+        std::vector<uint32_t> positionOfId; // [id], kNoPosition if unused
+        MidiNoteId nextId{1};
+        uint64_t revision{0}; // 0 until first edited
+
+        MidiNoteIndex index;
+    };
+
+    // Shared by every empty list
+    static const std::shared_ptr<Data>& getEmptyData();
+
+    // The storage, unshared first if another list refers to it, under a new
+    // revision
+    Data& edit();
+
+    void store(uint32_t position, const MidiNote& note);
+
+    std::shared_ptr<Data> data_;
+};
+
+} // namespace ampl
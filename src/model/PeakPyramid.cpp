@@ -0,0 +1,483 @@
+#include "model/PeakPyramid.hpp"
+#include "model/Clip.hpp"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define AMPL_PEAKS_SSE 1
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define AMPL_PEAKS_NEON 1
+#endif
+
+namespace ampl
+{
+
+namespace
+{
+
+// min, max and RMS of count (> 0) samples, four at a time
+PeakPyramid::Peak scanBucket(const float *samples, int count) noexcept
+{
+    int i = 0;
+    float minValue = samples[0];
+    float maxValue = samples[0];
+    float squares = 0.0f;
+
+#if AMPL_PEAKS_SSE
+    if (count >= 4)
+    {
+        __m128 vMin = _mm_loadu_ps(samples);
+        __m128 vMax = vMin;
+        __m128 vSquares = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(samples + i);
+            vMin = _mm_min_ps(vMin, x);
+            vMax = _mm_max_ps(vMax, x);
+            vSquares = _mm_add_ps(vSquares, _mm_mul_ps(x, x));
+        }
+        alignas(16) float lanes[3][4];
+        _mm_store_ps(lanes[0], vMin);
+        _mm_store_ps(lanes[1], vMax);
+        _mm_store_ps(lanes[2], vSquares);
+        minValue = std::min({lanes[0][0], lanes[0][1], lanes[0][2], lanes[0][3]});
+        maxValue = std::max({lanes[1][0], lanes[1][1], lanes[1][2], lanes[1][3]});
+        squares = (lanes[2][0] + lanes[2][1]) + (lanes[2][2] + lanes[2][3]);
+    }
+#elif AMPL_PEAKS_NEON
+    if (count >= 4)
+    {
+        float32x4_t vMin = vld1q_f32(samples);
+        float32x4_t vMax = vMin;
+        float32x4_t vSquares = vdupq_n_f32(0.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            const float32x4_t x = vld1q_f32(samples + i);
+            vMin = vminq_f32(vMin, x);
+            vMax = vmaxq_f32(vMax, x);
+            vSquares = vmlaq_f32(vSquares, x, x);
+        }
+        minValue = vminvq_f32(vMin);
+        maxValue = vmaxvq_f32(vMax);
+        squares = vaddvq_f32(vSquares);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const float x = samples[i];
+        minValue = std::min(minValue, x);
+        maxValue = std::max(maxValue, x);
+        squares += x * x;
+    }
+
+    return {minValue, maxValue, std::sqrt(squares / static_cast<float>(count))};
+}
+
+// 64-bit FNV-1a
+constexpr uint64_t kHashSeed = 14695981039346656037ull;
+
+uint64_t hashBytes(uint64_t hash, const void *data, size_t size) noexcept
+{
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+
+// Folds b into a, both summarising the same number of samples (or b fewer,
+// at the end of a level, which the RMS ignores)
+void merge(PeakPyramid::Peak &a, const PeakPyramid::Peak &b) noexcept
+{
+    a.min = std::min(a.min, b.min);
+    a.max = std::max(a.max, b.max);
+    a.rms = std::sqrt(0.5f * (a.rms * a.rms + b.rms * b.rms));
+}
+
+// One background thread shared by all assets for builds and peak file
+// writes, started on first use
+class PeakBuilder
+{
+  public:
+    static PeakBuilder &instance()
+    {
+        static PeakBuilder builder;
+        return builder;
+    }
+
+    ~PeakBuilder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        condition_.notify_all();
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    void enqueue(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(std::move(job));
+            if (!thread_.joinable())
+                thread_ = std::thread([this] { run(); });
+        }
+        condition_.notify_one();
+    }
+
+  private:
+    void run()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+                if (stop_)
+                    return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::function<void()>> jobs_;
+    bool stop_{false};
+    std::thread thread_;
+};
+
+} // namespace
+
+void PeakPyramid::build(const AudioAsset &asset)
+{
+    begin(asset.numChannels, asset.lengthInSamples);
+
+    constexpr int kChunkSize = kBaseBucketSize << 14;
+    std::vector<const float *> channels(asset.channels.size());
+    for (SampleCount position = 0; position < length_; position += kChunkSize)
+    {
+        for (size_t ch = 0; ch < channels.size(); ++ch)
+            channels[ch] = asset.channels[ch].data() + position;
+        addSamples(channels.data(), static_cast<int>(std::min<SampleCount>(kChunkSize, length_ - position)));
+    }
+
+    finish();
+}
+
+void PeakPyramid::begin(int numChannels, SampleCount length)
+{
+    numChannels_ = std::max(numChannels, 0);
+    length_ = std::max(length, SampleCount(0));
+    bucketsAdded_ = 0;
+    levels_.clear();
+
+    if (numChannels_ > 0 && length_ > 0)
+    {
+        Level base;
+        base.bucketSize = kBaseBucketSize;
+        base.numBuckets = (length_ + kBaseBucketSize - 1) / kBaseBucketSize;
+        base.peaks.resize(static_cast<size_t>(base.numBuckets * numChannels_));
+        levels_.push_back(std::move(base));
+    }
+}
+
+void PeakPyramid::addSamples(const float *const *channels, int numSamples) noexcept
+{
+    if (levels_.empty() || numSamples <= 0)
+        return;
+
+    Level &base = levels_.front();
+    const int64_t first = bucketsAdded_;
+    const int64_t count = std::min<int64_t>((numSamples + kBaseBucketSize - 1) / kBaseBucketSize,
+                                            base.numBuckets - first);
+    for (int ch = 0; ch < numChannels_; ++ch)
+    {
+        Peak *peaks = base.peaks.data() + ch * base.numBuckets + first;
+        for (int64_t b = 0; b < count; ++b)
+        {
+            const auto offset = static_cast<int>(b * kBaseBucketSize);
+            peaks[b] = scanBucket(channels[ch] + offset, std::min(kBaseBucketSize, numSamples - offset));
+        }
+    }
+    bucketsAdded_ += count;
+}
+
+void PeakPyramid::finish()
+{
+    addUpperLevels();
+    ready_.store(true, std::memory_order_release);
+    ready_.notify_all();
+}
+
+void PeakPyramid::addUpperLevels()
+{
+    // Each level above halves the one below, down to a single bucket
+    while (!levels_.empty() && levels_.back().numBuckets > 1)
+    {
+        const Level &below = levels_.back();
+        Level level;
+        level.bucketSize = below.bucketSize * 2;
+        level.numBuckets = (below.numBuckets + 1) / 2;
+        level.peaks.resize(static_cast<size_t>(level.numBuckets * numChannels_));
+        for (int ch = 0; ch < numChannels_; ++ch)
+        {
+            const Peak *source = below.peaks.data() + ch * below.numBuckets;
+            Peak *peaks = level.peaks.data() + ch * level.numBuckets;
+            for (int64_t b = 0; b < level.numBuckets; ++b)
+            {
+                peaks[b] = source[2 * b];
+                if (2 * b + 1 < below.numBuckets)
+                    merge(peaks[b], source[2 * b + 1]);
+            }
+        }
+        levels_.push_back(std::move(level));
+    }
+}
+
+std::shared_ptr<PeakPyramid> PeakPyramid::buildInBackground(std::shared_ptr<const AudioAsset> asset)
+{
+    auto pyramid = std::make_shared<PeakPyramid>();
+    PeakBuilder::instance().enqueue([asset = std::move(asset), pyramid] { pyramid->build(*asset); });
+    return pyramid;
+}
+
+void PeakPyramid::waitUntilReady() const noexcept
+{
+    ready_.wait(false, std::memory_order_acquire);
+}
+
+uint64_t PeakPyramid::contentKey(const juce::File &source)
+{
+    juce::FileInputStream in(source);
+    if (!in.openedOk())
+        return 0;
+
+    constexpr int kNumBlocks = 32;
+    constexpr int kBlockBytes = 4096;
+    const juce::int64 size = in.getTotalLength();
+    const juce::int64 modified = source.getLastModificationTime().toMilliseconds();
+    uint64_t hash = hashBytes(kHashSeed, &size, sizeof(size));
+    hash = hashBytes(hash, &modified, sizeof(modified));
+
+    char block[kBlockBytes];
+    for (int i = 0; i < kNumBlocks; ++i)
+    {
+        const juce::int64 position =
+            size <= kBlockBytes ? 0 : (size - kBlockBytes) * i / (kNumBlocks - 1);
+        if (!in.setPosition(position))
+            return 0;
+        const int bytesRead = in.read(block, kBlockBytes);
+        hash = hashBytes(hash, block, static_cast<size_t>(std::max(bytesRead, 0)));
+        if (size <= kBlockBytes)
+            break;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+uint64_t PeakPyramid::contentKey(const void *data, size_t size)
+{
+    const uint64_t hash = hashBytes(hashBytes(kHashSeed, &size, sizeof(size)), data, size);
+    return hash != 0 ? hash : 1;
+}
+
+juce::File PeakPyramid::getPeakFile(const juce::File &directory, uint64_t key)
+{
+    return directory.getChildFile(juce::String::toHexString(static_cast<juce::int64>(key)) + ".peaks");
+}
+
+bool PeakPyramid::saveToFile(const juce::File &file, uint64_t key) const
+{
+    if (!isReady() || !file.getParentDirectory().createDirectory())
+        return false;
+
+    // Header, then each level's peaks as stored. Peak files are a local
+    // cache, so the floats are written in the machine's own layout.
+    juce::TemporaryFile temp(file);
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return false;
+
+        out.writeInt(static_cast<int>(kFileMagic));
+        out.writeInt(static_cast<int>(kFileVersion));
+        out.writeInt64(static_cast<juce::int64>(key));
+        out.writeInt(numChannels_);
+        out.writeInt(kBaseBucketSize);
+        out.writeInt64(length_);
+        out.writeInt(getNumLevels());
+        for (const auto &level : levels_)
+        {
+            out.writeInt64(level.numBuckets);
+            out.write(level.peaks.data(), level.peaks.size() * sizeof(Peak));
+        }
+
+        out.flush();
+        if (out.getStatus().failed())
+            return false;
+    }
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+bool PeakPyramid::loadFromFile(const juce::File &file, uint64_t key)
+{
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data))
+        return false;
+
+    juce::MemoryInputStream in(data, false);
+    if (static_cast<uint32_t>(in.readInt()) != kFileMagic ||
+        static_cast<uint32_t>(in.readInt()) != kFileVersion ||
+        static_cast<uint64_t>(in.readInt64()) != key)
+        return false;
+
+    const int numChannels = in.readInt();
+    const int baseBucketSize = in.readInt();
+    const SampleCount length = in.readInt64();
+    const int numLevels = in.readInt();
+    if (numChannels < 0 || baseBucketSize != kBaseBucketSize || length < 0)
+        return false;
+    const auto baseBytes = static_cast<uint64_t>((length + kBaseBucketSize - 1) / kBaseBucketSize) *
+                           static_cast<uint64_t>(numChannels) * sizeof(Peak);
+    if (baseBytes > data.getSize())
+        return false;
+
+    // The level sizes follow from the length; check them against the file
+    // before trusting any of it
+    begin(numChannels, length);
+    addUpperLevels();
+    if (numLevels != getNumLevels())
+        return false;
+
+    for (auto &level : levels_)
+    {
+        const auto bytes = level.peaks.size() * sizeof(Peak);
+        if (in.readInt64() != level.numBuckets ||
+            in.read(level.peaks.data(), bytes) != static_cast<int>(bytes))
+            return false;
+    }
+    if (!in.isExhausted())
+        return false;
+
+    bucketsAdded_ = levels_.empty() ? 0 : levels_.front().numBuckets;
+    ready_.store(true, std::memory_order_release);
+    ready_.notify_all();
+    return true;
+}
+
+void PeakPyramid::saveInBackground(std::shared_ptr<const PeakPyramid> pyramid, const juce::File &file,
+                                   uint64_t key)
+{
+    PeakBuilder::instance().enqueue([pyramid = std::move(pyramid), file, key] {
+        pyramid->saveToFile(file, key);
+    });
+}
+
+bool PeakPyramid::getPeaks(const AudioAsset &asset, int channel, double firstSample,
+                           double samplesPerPixel, Peak *out, int numPixels)
+{
+    if (numPixels <= 0)
+        return true;
+    if (!asset.isLoaded())
+        return false;
+
+    if (channel < 0 || channel >= static_cast<int>(asset.channels.size()) || samplesPerPixel <= 0.0)
+    {
+        std::fill(out, out + numPixels, Peak{});
+        return true;
+    }
+
+    if (samplesPerPixel < kBaseBucketSize)
+    {
+        // Zoomed in: at most a bucket's worth of samples per pixel, cheaper
+        // to read directly than through the pyramid
+        const float *samples = asset.channels[static_cast<size_t>(channel)].data();
+        for (int px = 0; px < numPixels; ++px)
+        {
+            auto start = static_cast<SampleCount>(std::floor(firstSample + px * samplesPerPixel));
+            auto end = static_cast<SampleCount>(std::floor(firstSample + (px + 1) * samplesPerPixel));
+            end = std::max(end, start + 1); // Several pixels per sample
+            start = std::max(start, SampleCount(0));
+            end = std::min(end, asset.lengthInSamples);
+
+            if (start >= end)
+            {
+                out[px] = Peak{};
+                continue;
+            }
+            out[px] = scanBucket(samples + start, static_cast<int>(end - start));
+        }
+        return true;
+    }
+
+    const auto *pyramid = asset.peaks.get();
+    if (pyramid == nullptr || !pyramid->isReady())
+        return false;
+
+    if (pyramid->levels_.empty())
+    {
+        std::fill(out, out + numPixels, Peak{});
+        return true;
+    }
+
+    // Coarsest level whose buckets are no wider than a pixel
+    const int level = std::min(
+        static_cast<int>(std::floor(std::log2(samplesPerPixel / kBaseBucketSize))),
+        pyramid->getNumLevels() - 1);
+    pyramid->readLevel(std::max(level, 0), channel, firstSample, samplesPerPixel, out, numPixels);
+    return true;
+}
+
+void PeakPyramid::readLevel(int level, int channel, double firstSample, double samplesPerPixel,
+                            Peak *out, int numPixels) const noexcept
+{
+    const Level &source = levels_[static_cast<size_t>(level)];
+    const Peak *peaks = source.peaks.data() + channel * source.numBuckets;
+    const auto bucketSize = static_cast<double>(source.bucketSize);
+    const auto length = static_cast<double>(length_);
+
+    for (int px = 0; px < numPixels; ++px)
+    {
+        const double start = std::max(firstSample + px * samplesPerPixel, 0.0);
+        const double end = std::min(firstSample + (px + 1) * samplesPerPixel, length);
+        if (start >= end)
+        {
+            out[px] = Peak{};
+            continue;
+        }
+
+        // Whole buckets overlapping the pixel
+        const auto first = static_cast<int64_t>(std::floor(start / bucketSize));
+        const auto last = std::min(static_cast<int64_t>(std::ceil(end / bucketSize)), source.numBuckets);
+        if (first >= last)
+        {
+            out[px] = Peak{};
+            continue;
+        }
+
+        Peak peak = peaks[first];
+        float squares = peak.rms * peak.rms;
+        for (int64_t b = first + 1; b < last; ++b)
+        {
+            peak.min = std::min(peak.min, peaks[b].min);
+            peak.max = std::max(peak.max, peaks[b].max);
+            squares += peaks[b].rms * peaks[b].rms;
+        }
+        peak.rms = std::sqrt(squares / static_cast<float>(last - first));
+        out[px] = peak;
+    }
+}
+
+} // namespace ampl
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "util/Types.hpp"
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace ampl
+{
+
+struct AudioAsset;
+
+// Multi-resolution min/max/RMS overview of an AudioAsset, for drawing
+// waveforms. Level 0 holds one Peak per kBaseBucketSize samples of each
+// channel; every level above merges pairs of buckets of the level below, up
+// to a single bucket. A view at any zoom reads the coarsest level whose
+// buckets still fit inside one pixel, so drawing costs O(pixels) rather than
+// O(samples on screen).
+//
+// Built once per asset: streamed from the decoder while the asset loads, or
+// on a background thread (see buildInBackground()). Finished pyramids are
+// kept in peak files keyed by the source audio's content, so reopening a
+// session reads them back instead of rescanning the samples. Readers check
+// isReady(); the levels are never modified once published.
+class PeakPyramid
+{
+  public:
+    struct Peak
+    {
+        float min{0.0f};
+        float max{0.0f};
+        float rms{0.0f};
+    };
+
+    static constexpr int kBaseBucketSize = 64;
+
+    // Computes the levels on the calling thread and publishes them
+    void build(const AudioAsset &asset);
+
+    // Incremental build, e.g. while decoding: begin(), then every sample in
+    // order through addSamples() (each call but the last a whole number of
+    // base buckets long), then finish(), which adds the upper levels and
+    // publishes them.
+    void begin(int numChannels, SampleCount length);
+    void addSamples(const float *const *channels, int numSamples) noexcept;
+    void finish();
+
+    // Returns an empty pyramid for asset and queues it to be built on the
+    // shared peak thread. The job keeps the asset alive until it has run.
+    static std::shared_ptr<PeakPyramid> buildInBackground(std::shared_ptr<const AudioAsset> asset);
+
+    bool isReady() const noexcept
+    {
+        return ready_.load(std::memory_order_acquire);
+    }
+
+    // Blocks until the background build has published the levels
+    void waitUntilReady() const noexcept;
+
+    // Valid once isReady()
+    int getNumLevels() const noexcept
+    {
+        return static_cast<int>(levels_.size());
+    }
+    int getNumChannels() const noexcept
+    {
+        return numChannels_;
+    }
+    SampleCount getLength() const noexcept
+    {
+        return length_;
+    }
+
+    // --- Peak files ---
+
+    // Identifies the audio in a source file: a hash of its size, its
+    // modification time and 4 KiB blocks spread evenly through it, so a
+    // moved file keeps its peaks without a long file being read end to end,
+    // and an edit that keeps the size still changes the key. Zero if
+    // unreadable.
+    static uint64_t contentKey(const juce::File &source);
+
+    // Hash of an in-memory copy of the source file (e.g. embedded audio)
+    static uint64_t contentKey(const void *data, size_t size);
+
+    // Name of the peak file for key within a cache directory
+    static juce::File getPeakFile(const juce::File &directory, uint64_t key);
+
+    // Writes the published levels, tagged with key, creating the directory
+    // if needed. Replaces the file atomically.
+    bool saveToFile(const juce::File &file, uint64_t key) const;
+
+    // Reads a file written by saveToFile() with one read and publishes its
+    // levels. Fails (leaving this unpublished) if the file is missing,
+    // truncated, of another format version or saved for a different key.
+    bool loadFromFile(const juce::File &file, uint64_t key);
+
+    // Queues saveToFile() on the shared peak thread
+    static void saveInBackground(std::shared_ptr<const PeakPyramid> pyramid, const juce::File &file,
+                                 uint64_t key);
+
+    // Fills numPixels peaks of one channel of asset; pixel i covers the
+    // samples [firstSample + i * samplesPerPixel, firstSample + (i + 1) *
+    // samplesPerPixel). Samples outside the asset read as silence.
+    // Zoomed in to less than a base bucket per pixel, the samples are read
+    // directly; further out, asset.peaks is used. Returns false (out
+    // untouched) while the asset is loading or if that pyramid is missing or
+    // still being built.
+    static bool getPeaks(const AudioAsset &asset, int channel, double firstSample,
+                         double samplesPerPixel, Peak *out, int numPixels);
+
+  private:
+    struct Level
+    {
+        int64_t bucketSize{0};
+        int64_t numBuckets{0};
+        std::vector<Peak> peaks; // [channel * numBuckets + bucket]
+    };
+
+    static constexpr uint32_t kFileMagic = 0x504b5041; // "APKP"
+    static constexpr uint32_t kFileVersion = 1;
+
+    void addUpperLevels();
+    void readLevel(int level, int channel, double firstSample, double samplesPerPixel,
+                   Peak *out, int numPixels) const noexcept;
+
+    int numChannels_{0};
+    SampleCount length_{0};
+    int64_t bucketsAdded_{0}; // Level 0 buckets filled by addSamples()
+    std::vector<Level> levels_;
+    std::atomic<bool> ready_{false};
+};
+
+} // namespace ampl
@@ -0,0 +1,272 @@
+#include "model/ProjectArchive.hpp"
+
+namespace ampl
+{
+
+namespace
+{
+
+// A chunk read through the archive's memory map, which the stream keeps alive
+class MappedChunkStream : public juce::InputStream
+{
+  public:
+    MappedChunkStream(std::shared_ptr<const juce::MemoryMappedFile> map, const void *data,
+                      size_t size)
+        : map_(std::move(map)), in_(data, size, false)
+    {
+    }
+
+    juce::int64 getTotalLength() override
+    {
+        return in_.getTotalLength();
+    }
+    bool isExhausted() override
+    {
+        return in_.isExhausted();
+    }
+    int read(void *destBuffer, int maxBytesToRead) override
+    {
+        return in_.read(destBuffer, maxBytesToRead);
+    }
+    juce::int64 getPosition() override
+    {
+        return in_.getPosition();
+    }
+    bool setPosition(juce::int64 newPosition) override
+    {
+        return in_.setPosition(newPosition);
+    }
+
+  private:
+    std::shared_ptr<const juce::MemoryMappedFile> map_;
+    juce::MemoryInputStream in_;
+};
+
+int64_t alignUp(int64_t offset, int64_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+bool ProjectArchive::isArchive(const juce::File &file)
+{
+    juce::FileInputStream in(file);
+    return in.openedOk() && in.getTotalLength() >= kHeaderSize &&
+           static_cast<uint32_t>(in.readInt()) == kMagic;
+}
+
+// --- Writer ---
+
+ProjectArchive::Writer::Writer(const juce::File &file) : temp_(file)
+{
+    out_ = std::make_unique<juce::FileOutputStream>(temp_.getFile());
+    if (!out_->openedOk())
+        return;
+
+    // Patched by finish() once the index is written
+    out_->writeRepeatedByte(0, static_cast<size_t>(kHeaderSize));
+}
+
+int ProjectArchive::Writer::addChunk(ChunkType type, const void *data, size_t size)
+{
+    const auto offset = beginChunk(type);
+    if (offset < 0 || !out_->write(data, size))
+        return -1;
+    return endChunk(type, offset);
+}
+
+int ProjectArchive::Writer::addChunk(ChunkType type, juce::InputStream &source)
+{
+    const auto offset = beginChunk(type);
+    if (offset < 0)
+        return -1;
+
+    const auto expected = source.getNumBytesRemaining();
+    const auto written = out_->writeFromInputStream(source, -1);
+    if (expected >= 0 && written != expected)
+        return -1;
+    return endChunk(type, offset);
+}
+
+int ProjectArchive::Writer::addChunk(ChunkType type,
+                                     const std::function<void(juce::OutputStream &)> &write)
+{
+    const auto offset = beginChunk(type);
+    if (offset < 0)
+        return -1;
+    write(*out_);
+    return endChunk(type, offset);
+}
+
+int64_t ProjectArchive::Writer::beginChunk(ChunkType type)
+{
+    if (!openedOk())
+        return -1;
+
+    const auto position = out_->getPosition();
+    const auto offset = alignUp(position, type == ChunkType::Audio ? kPageAlignment : kChunkAlignment);
+    out_->writeRepeatedByte(0, static_cast<size_t>(offset - position));
+    return offset;
+}
+
+int ProjectArchive::Writer::endChunk(ChunkType type, int64_t offset)
+{
+    if (out_->getStatus().failed())
+        return -1;
+
+    chunks_.push_back({type, offset, out_->getPosition() - offset});
+    return static_cast<int>(chunks_.size()) - 1;
+}
+
+bool ProjectArchive::Writer::finish(const juce::String &metadata)
+{
+    if (!openedOk())
+        return false;
+
+    const auto position = out_->getPosition();
+    const auto indexOffset = alignUp(position, kChunkAlignment);
+    out_->writeRepeatedByte(0, static_cast<size_t>(indexOffset - position));
+
+    out_->writeInt(static_cast<int>(chunks_.size()));
+    for (const auto &chunk : chunks_)
+    {
+        out_->writeInt(static_cast<int>(chunk.type));
+        out_->writeInt64(chunk.offset);
+        out_->writeInt64(chunk.size);
+    }
+    const auto utf8 = metadata.toUTF8();
+    const auto metadataBytes = utf8.sizeInBytes() - 1;
+    out_->writeInt(static_cast<int>(metadataBytes));
+    out_->write(utf8.getAddress(), metadataBytes);
+    const auto indexSize = out_->getPosition() - indexOffset;
+
+    if (!out_->setPosition(0))
+        return false;
+    out_->writeInt(static_cast<int>(kMagic));
+    out_->writeInt(static_cast<int>(kVersion));
+    out_->writeInt64(indexOffset);
+    out_->writeInt64(indexSize);
+
+    out_->flush();
+    const bool ok = !out_->getStatus().failed();
+    out_.reset();
+    return ok && temp_.overwriteTargetFileWithTemporary();
+}
+
+// --- Reader ---
+
+bool ProjectArchive::Reader::open(const juce::File &file)
+{
+    file_ = file;
+    metadata_ = {};
+    chunks_.clear();
+    map_.reset();
+
+    juce::FileInputStream in(file);
+    if (!in.openedOk())
+        return false;
+
+    const auto fileSize = in.getTotalLength();
+    if (fileSize < kHeaderSize || static_cast<uint32_t>(in.readInt()) != kMagic)
+        return false;
+
+    const auto version = static_cast<uint32_t>(in.readInt());
+    const auto indexOffset = in.readInt64();
+    const auto indexSize = in.readInt64();
+    if (version < 1 || version > kVersion || indexOffset < kHeaderSize || indexSize < 8 ||
+        indexOffset > fileSize || indexSize > fileSize - indexOffset)
+        return false;
+
+    juce::MemoryBlock indexData;
+    if (!in.setPosition(indexOffset) ||
+        in.readIntoMemoryBlock(indexData, indexSize) != static_cast<size_t>(indexSize))
+        return false;
+
+    juce::MemoryInputStream index(indexData, false);
+    constexpr int64_t kEntryBytes = 4 + 8 + 8;
+    const auto numChunks = index.readInt();
+    if (numChunks < 0 || numChunks > (indexSize - 8) / kEntryBytes)
+        return false;
+
+    std::vector<Chunk> chunks(static_cast<size_t>(numChunks));
+    for (auto &chunk : chunks)
+    {
+        chunk.type = static_cast<ChunkType>(index.readInt());
+        chunk.offset = index.readInt64();
+        chunk.size = index.readInt64();
+
+        // Chunks lie between the header and the index
+        if (chunk.offset < kHeaderSize || chunk.offset > indexOffset || chunk.size < 0 ||
+            chunk.size > indexOffset - chunk.offset)
+            return false;
+    }
+
+    const auto metadataBytes = index.readInt();
+    if (metadataBytes < 0 || metadataBytes != index.getNumBytesRemaining())
+        return false;
+
+    chunks_ = std::move(chunks);
+    metadata_ = juce::String::fromUTF8(static_cast<const char *>(indexData.getData()) +
+                                           index.getPosition(),
+                                       metadataBytes);
+
+    auto map = std::make_shared<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    if (map->getData() != nullptr && static_cast<juce::int64>(map->getSize()) == fileSize)
+        map_ = std::move(map);
+    return true;
+}
+
+std::unique_ptr<juce::InputStream> ProjectArchive::Reader::openChunk(int chunk, ChunkType type) const
+{
+    if (!isChunk(chunk, type))
+        return nullptr;
+    const auto &entry = chunks_[static_cast<size_t>(chunk)];
+
+    if (map_ != nullptr)
+        return std::make_unique<MappedChunkStream>(
+            map_, static_cast<const char *>(map_->getData()) + entry.offset,
+            static_cast<size_t>(entry.size));
+
+    juce::MemoryBlock data;
+    if (!readChunk(chunk, type, data))
+        return nullptr;
+    return std::make_unique<juce::MemoryInputStream>(std::move(data));
+}
+
+bool ProjectArchive::Reader::readChunk(int chunk, ChunkType type, juce::MemoryBlock &data) const
+{
+    if (!isChunk(chunk, type))
+        return false;
+    const auto &entry = chunks_[static_cast<size_t>(chunk)];
+
+    if (map_ != nullptr)
+    {
+        data.replaceAll(static_cast<const char *>(map_->getData()) + entry.offset,
+                        static_cast<size_t>(entry.size));
+        return true;
+    }
+
+    data.reset();
+    juce::FileInputStream in(file_);
+    return in.openedOk() && in.setPosition(entry.offset) &&
+           in.readIntoMemoryBlock(data, entry.size) == static_cast<size_t>(entry.size);
+}
+
+bool ProjectArchive::Reader::copyChunkTo(int chunk, ChunkType type, const juce::File &target) const
+{
+    auto source = openChunk(chunk, type);
+    if (source == nullptr || !target.deleteFile())
+        return false;
+
+    juce::FileOutputStream out(target);
+    if (!out.openedOk())
+        return false;
+
+    const auto expected = source->getTotalLength();
+    const auto written = out.writeFromInputStream(*source, -1);
+    out.flush();
+    return written == expected && !out.getStatus().failed();
+}
+
+} // namespace ampl
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace ampl
+{
+
+// Chunked binary container used for .ampl projects. A small index (a chunk
+// table plus the project metadata as compact JSON) points at chunks holding
+// the bulky data: audio files, MIDI note columns and plugin state. Opening a
+// project reads the header and index only; chunks are read when needed.
+//
+// Layout: a fixed header, then the chunks, then the index.
+//   header  magic, container version, index offset and size (int64)
+//   chunk   payload only; audio payloads start on a kPageAlignment boundary,
+//           so each maps onto whole pages of its own
+//   index   chunk count, then type, offset and size of each chunk, then the
+//           metadata's length and UTF-8 bytes
+// All integers are little-endian.
+class ProjectArchive
+{
+  public:
+    enum class ChunkType : uint32_t
+    {
+        Audio = 1,       // A source audio file, byte for byte
+        MidiNotes = 2,   // MidiNoteList::writeTo()
+        PluginState = 3, // PluginSlot::stateData
+    };
+
+    struct Chunk
+    {
+        ChunkType type;
+        int64_t offset;
+        int64_t size;
+    };
+
+    // Largest page size we run on (16 KiB on Apple silicon)
+    static constexpr int64_t kPageAlignment = 16384;
+
+    static constexpr uint32_t kMagic = 0x42504d41; // "AMPB"
+    static constexpr uint32_t kVersion = 1;
+
+    // True if file starts with an archive header (older projects are JSON)
+    static bool isArchive(const juce::File &file);
+
+    // Writes an archive to a temporary file next to the target, which
+    // finish() moves into place
+    class Writer
+    {
+      public:
+        explicit Writer(const juce::File &file);
+
+        bool openedOk() const
+        {
+            return out_ != nullptr && out_->openedOk();
+        }
+
+        // Each returns the chunk's number, or -1 if writing failed
+        int addChunk(ChunkType type, const void *data, size_t size);
+        int addChunk(ChunkType type, juce::InputStream &source);
+        int addChunk(ChunkType type, const std::function<void(juce::OutputStream &)> &write);
+
+        // Writes the index and header and replaces the target file
+        bool finish(const juce::String &metadata);
+
+      private:
+        juce::TemporaryFile temp_;
+        std::unique_ptr<juce::FileOutputStream> out_;
+        std::vector<Chunk> chunks_;
+
+        // Pads to the alignment type needs and returns the offset reached
+        int64_t beginChunk(ChunkType type);
+        int endChunk(ChunkType type, int64_t offset);
+    };
+
+    // Reads an archive through a memory map of the whole file, so chunks are
+    // paged in as they are read. On POSIX systems they stay readable if the
+    // file is replaced while mapped; Windows cannot replace a mapped file at
+    // all, so nothing should keep a reader open longer than it needs (see
+    // ProjectSerializer, which copies audio chunks out). Once open() has
+    // succeeded the reader is immutable, so background threads can share it.
+    class Reader
+    {
+      public:
+        // Reads and checks the header and index. False if the file is not an
+        // archive, is of a newer version, or is truncated or inconsistent.
+        bool open(const juce::File &file);
+
+        const juce::File &getFile() const
+        {
+            return file_;
+        }
+        const juce::String &getMetadata() const
+        {
+            return metadata_;
+        }
+
+        int getNumChunks() const
+        {
+            return static_cast<int>(chunks_.size());
+        }
+        bool isChunk(int chunk, ChunkType type) const
+        {
+            return chunk >= 0 && chunk < getNumChunks() &&
+                   chunks_[static_cast<size_t>(chunk)].type == type;
+        }
+
+        // A stream over the chunk's bytes; nullptr if chunk is not of type
+        // or cannot be read
+        std::unique_ptr<juce::InputStream> openChunk(int chunk, ChunkType type) const;
+
+        // Reads the whole chunk into data
+        bool readChunk(int chunk, ChunkType type, juce::MemoryBlock &data) const;
+
+        // Writes the chunk's bytes to target, replacing it
+        bool copyChunkTo(int chunk, ChunkType type, const juce::File &target) const;
+
+      private:
+        juce::File file_;
+        juce::String metadata_;
+        std::vector<Chunk> chunks_;
+
+        // Null if the file could not be mapped; chunks are then read from
+        // the file by name
+        std::shared_ptr<const juce::MemoryMappedFile> map_;
+    };
+
+  private:
+    static constexpr int64_t kHeaderSize = 24;
+    static constexpr int64_t kChunkAlignment = 8;
+};
+
+} // namespace ampl
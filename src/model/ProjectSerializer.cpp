@@ -1,34 +1,118 @@
 #include "model/ProjectSerializer.hpp"
 
+#include <algorithm>
+#include <mutex>
+
 namespace ampl
 {
 
+namespace
+{
+
+// The encoded audio of an archived asset. The loader copies the chunk out to
+// a temporary file, after which the archive is no longer referenced and its
+// mapping is released: Windows cannot replace a mapped file, so keeping it
+// would make saving over the open project fail. Until then, and if the copy
+// fails, the chunk is read from the archive.
+class ArchivedAudioSource
+{
+  public:
+    ArchivedAudioSource(std::shared_ptr<const ProjectArchive::Reader> reader, int chunk)
+        : reader_(std::move(reader)), chunk_(chunk)
+    {
+    }
+
+    // Any thread
+    std::unique_ptr<juce::InputStream> open()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (copy_ != nullptr)
+            return copy_->getFile().createInputStream();
+        return reader_->openChunk(chunk_, ProjectArchive::ChunkType::Audio);
+    }
+
+    // Loader thread
+    void copyOut()
+    {
+        std::shared_ptr<const ProjectArchive::Reader> reader;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reader = reader_;
+        }
+        if (reader == nullptr)
+            return;
+
+        auto copy = std::make_unique<juce::TemporaryFile>(".audio");
+        if (!reader->copyChunkTo(chunk_, ProjectArchive::ChunkType::Audio, copy->getFile()))
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        copy_ = std::move(copy);
+        reader_.reset();
+    }
+
+  private:
+    std::mutex mutex_;
+    std::shared_ptr<const ProjectArchive::Reader> reader_; // Null once copied out
+    const int chunk_;
+    std::unique_ptr<juce::TemporaryFile> copy_; // Deleted with the asset
+};
+
+} // namespace
+
 bool ProjectSerializer::save(const Session &session, const juce::File &projectFile)
 {
-    auto projectDir = projectFile.getParentDirectory();
-    auto json = sessionToJson(session, projectDir);
+    ProjectArchive::Writer writer(projectFile);
+    if (!writer.openedOk())
+        return false;
 
-    auto jsonString = juce::JSON::toString(json, true);
-    return projectFile.replaceWithText(jsonString);
+    ArchiveOutput archive{writer, {}, true};
+    auto json = sessionToJson(session, projectFile.getParentDirectory(), &archive);
+    return archive.ok && writer.finish(juce::JSON::toString(json, true));
 }
 
 bool ProjectSerializer::load(Session &session, const juce::File &projectFile,
-                             juce::AudioFormatManager &formatManager)
+                             juce::AudioFormatManager &formatManager, AssetLoader *loader)
 {
     if (!projectFile.existsAsFile())
         return false;
 
+    auto projectDir = projectFile.getParentDirectory();
+
+    if (ProjectArchive::isArchive(projectFile))
+    {
+        auto reader = std::make_shared<ProjectArchive::Reader>();
+        if (!reader->open(projectFile))
+            return false;
+
+        auto json = juce::JSON::parse(reader->getMetadata());
+        if (!json.isObject())
+            return false;
+
+        ArchiveInput archive{std::move(reader), loader, {}};
+        return jsonToSession(json, session, projectDir, formatManager, &archive);
+    }
+
+    // JSON, from earlier versions or exportJson()
     auto jsonString = projectFile.loadFileAsString();
     auto json = juce::JSON::parse(jsonString);
 
     if (!json.isObject())
         return false;
 
-    auto projectDir = projectFile.getParentDirectory();
-    return jsonToSession(json, session, projectDir, formatManager);
+    return jsonToSession(json, session, projectDir, formatManager, nullptr);
+}
+
+bool ProjectSerializer::exportJson(const Session &session, const juce::File &file)
+{
+    auto json = sessionToJson(session, file.getParentDirectory(), nullptr);
+
+    auto jsonString = juce::JSON::toString(json, true);
+    return file.replaceWithText(jsonString);
 }
 
-juce::var ProjectSerializer::sessionToJson(const Session &session, const juce::File &projectDir)
+juce::var ProjectSerializer::sessionToJson(const Session &session, const juce::File &projectDir,
+                                           ArchiveOutput *archive)
 {
     auto *obj = new juce::DynamicObject();
 
@@ -54,7 +138,7 @@ juce::var ProjectSerializer::sessionToJson(const Session &session, const juce::F
     // Tracks
     juce::Array<juce::var> tracksArray;
     for (const auto &track : session.getTracks())
-        tracksArray.add(trackToJson(track, projectDir));
+        tracksArray.add(trackToJson(track, projectDir, archive));
     obj->setProperty("tracks", tracksArray);
 
     return juce::var(obj);
@@ -62,14 +146,18 @@ juce::var ProjectSerializer::sessionToJson(const Session &session, const juce::F
 
 bool ProjectSerializer::jsonToSession(const juce::var &json, Session &session,
                                       const juce::File &projectDir,
-                                      juce::AudioFormatManager &formatManager)
+                                      juce::AudioFormatManager &formatManager,
+                                      ArchiveInput *archive)
 {
     int version = json.getProperty("formatVersion", 0);
     if (version < 1 || version > kFormatVersion)
         return false;
     // Version 1 files have no track type — all tracks are Audio (backward compat)
 
-    session = Session(); // Reset
+    // Reset, but keep the peak cache the caller chose
+    const juce::File peakCacheDirectory = session.getPeakCacheDirectory();
+    session = Session();
+    session.setPeakCacheDirectory(peakCacheDirectory);
 
     session.setBpm(json.getProperty("bpm", 120.0));
     session.setTimeSignature(json.getProperty("timeSigNumerator", 4),
@@ -131,8 +219,14 @@ bool ProjectSerializer::jsonToSession(const juce::var &json, Session &session,
 
                     AudioAssetPtr asset;
 
+                    // Archived audio is read lazily
+                    auto chunkVar = clipVar.getProperty("assetChunk", juce::var());
+                    if (archive != nullptr && !chunkVar.isVoid())
+                        asset = archivedAsset(clipVar, static_cast<int>(chunkVar), session,
+                                              formatManager, *archive);
+
                     // Prefer embedded audio data when present
-                    if (assetData.isNotEmpty())
+                    if (!asset && assetData.isNotEmpty())
                     {
                         juce::MemoryBlock data;
                         if (data.fromBase64Encoding(assetData))
@@ -190,9 +284,18 @@ bool ProjectSerializer::jsonToSession(const juce::var &json, Session &session,
                     mc.lengthSamples = static_cast<SampleCount>(
                         (int64_t)mcVar.getProperty("lengthSamples", 0));
 
+                    auto notesChunkVar = mcVar.getProperty("notesChunk", juce::var());
                     auto notesVar = mcVar.getProperty("notes", juce::var());
-                    if (notesVar.isArray())
+                    if (archive != nullptr && !notesChunkVar.isVoid())
+                    {
+                        // A damaged chunk leaves the clip empty
+                        if (auto in = archive->reader->openChunk(
+                                static_cast<int>(notesChunkVar), ProjectArchive::ChunkType::MidiNotes))
+                            mc.notes.readFrom(*in);
+                    }
+                    else if (notesVar.isArray())
                     {
+                        mc.notes.reserve(static_cast<size_t>(notesVar.size()));
                         for (int k = 0; k < notesVar.size(); ++k)
                         {
                             auto nVar = notesVar[k];
@@ -200,14 +303,17 @@ bool ProjectSerializer::jsonToSession(const juce::var &json, Session &session,
                                 continue;
 
                             MidiNote note;
-                            note.id = nVar.getProperty("id", juce::Uuid().toString()).toString();
+                            // Older projects used UUID strings; those notes get fresh ids
+                            auto idVar = nVar.getProperty("id", juce::var());
+                            if (idVar.isInt() || idVar.isInt64())
+                                note.id = static_cast<MidiNoteId>((int64_t)idVar);
                             note.noteNumber = nVar.getProperty("noteNumber", 60);
                             note.velocity = static_cast<float>((double)nVar.getProperty("velocity", 0.8));
                             note.startSample = static_cast<SampleCount>(
                                 (int64_t)nVar.getProperty("startSample", 0));
                             note.lengthSamples = static_cast<SampleCount>(
                                 (int64_t)nVar.getProperty("lengthSamples", 0));
-                            mc.notes.push_back(note);
+                            mc.addNote(note);
                         }
                     }
 
@@ -223,21 +329,22 @@ bool ProjectSerializer::jsonToSession(const juce::var &json, Session &session,
                 {
                     auto slotVar = pluginChainVar[j];
                     if (slotVar.isObject())
-                        track->pluginChain.push_back(pluginSlotFromJson(slotVar));
+                        track->pluginChain.push_back(pluginSlotFromJson(slotVar, archive));
                 }
             }
 
             // Instrument plugin (for MIDI tracks)
             auto instrumentVar = trackVar.getProperty("instrumentPlugin", juce::var());
             if (instrumentVar.isObject())
-                track->instrumentPlugin = pluginSlotFromJson(instrumentVar);
+                track->instrumentPlugin = pluginSlotFromJson(instrumentVar, archive);
         }
     }
 
     return true;
 }
 
-juce::var ProjectSerializer::trackToJson(const TrackState &track, const juce::File &projectDir)
+juce::var ProjectSerializer::trackToJson(const TrackState &track, const juce::File &projectDir,
+                                         ArchiveOutput *archive)
 {
     auto *obj = new juce::DynamicObject();
 
@@ -251,28 +358,30 @@ juce::var ProjectSerializer::trackToJson(const TrackState &track, const juce::Fi
 
     juce::Array<juce::var> clipsArray;
     for (const auto &clip : track.clips)
-        clipsArray.add(clipToJson(clip, projectDir));
+        clipsArray.add(clipToJson(clip, projectDir, archive));
     obj->setProperty("clips", clipsArray);
 
     juce::Array<juce::var> midiClipsArray;
     for (const auto &mc : track.midiClips)
-        midiClipsArray.add(midiClipToJson(mc));
+        midiClipsArray.add(midiClipToJson(mc, archive));
     obj->setProperty("midiClips", midiClipsArray);
 
     // Plugin chain serialization
     juce::Array<juce::var> pluginChainArray;
     for (const auto &slot : track.pluginChain)
-        pluginChainArray.add(pluginSlotToJson(slot));
+        pluginChainArray.add(pluginSlotToJson(slot, archive));
     obj->setProperty("pluginChain", pluginChainArray);
 
     // Instrument plugin (for MIDI tracks)
     if (track.instrumentPlugin.has_value())
-        obj->setProperty("instrumentPlugin", pluginSlotToJson(track.instrumentPlugin.value()));
+        obj->setProperty("instrumentPlugin",
+                         pluginSlotToJson(track.instrumentPlugin.value(), archive));
 
     return juce::var(obj);
 }
 
-juce::var ProjectSerializer::clipToJson(const Clip &clip, const juce::File &projectDir)
+juce::var ProjectSerializer::clipToJson(const Clip &clip, const juce::File &projectDir,
+                                        ArchiveOutput *archive)
 {
     auto *obj = new juce::DynamicObject();
 
@@ -286,29 +395,41 @@ juce::var ProjectSerializer::clipToJson(const Clip &clip, const juce::File &proj
 
     if (clip.asset)
     {
-        const juce::File sourceFile(clip.asset->filePath);
+        const auto &asset = *clip.asset;
+        const auto sourceFile = getSourceFile(asset);
 
         obj->setProperty("assetFileName",
                          sourceFile.getFileName().isNotEmpty() ? sourceFile.getFileName()
-                                                               : clip.asset->fileName);
+                                                               : asset.fileName);
 
         if (sourceFile.existsAsFile())
-        {
             obj->setProperty("assetPath", makeRelativePath(sourceFile, projectDir));
 
-            if (auto stream = sourceFile.createInputStream())
+        if (archive != nullptr)
+        {
+            // What the clip needs before its audio is read
+            const int chunk = writeAssetChunk(asset, *archive);
+            if (chunk >= 0)
             {
-                juce::MemoryBlock data;
-                if (stream->readIntoMemoryBlock(data))
-                    obj->setProperty("assetData", data.toBase64Encoding());
+                obj->setProperty("assetChunk", chunk);
+                obj->setProperty("assetLength", static_cast<int64_t>(asset.lengthInSamples));
+                obj->setProperty("assetSampleRate", asset.sampleRate);
+                obj->setProperty("assetNumChannels", asset.numChannels);
+                obj->setProperty("assetPeakKey", static_cast<int64_t>(asset.peakKey));
             }
         }
+        else if (auto stream = openAssetSource(asset))
+        {
+            juce::MemoryBlock data;
+            if (stream->readIntoMemoryBlock(data))
+                obj->setProperty("assetData", data.toBase64Encoding());
+        }
     }
 
     return juce::var(obj);
 }
 
-juce::var ProjectSerializer::midiClipToJson(const MidiClip &clip)
+juce::var ProjectSerializer::midiClipToJson(const MidiClip &clip, ArchiveOutput *archive)
 {
     auto *obj = new juce::DynamicObject();
     obj->setProperty("id", clip.id);
@@ -316,6 +437,16 @@ juce::var ProjectSerializer::midiClipToJson(const MidiClip &clip)
     obj->setProperty("timelineStartSample", static_cast<int64_t>(clip.timelineStartSample));
     obj->setProperty("lengthSamples", static_cast<int64_t>(clip.lengthSamples));
 
+    if (archive != nullptr)
+    {
+        const int chunk = archive->writer.addChunk(ProjectArchive::ChunkType::MidiNotes,
+                                                   [&clip](juce::OutputStream &out)
+                                                   { clip.notes.writeTo(out); });
+        archive->ok = archive->ok && chunk >= 0;
+        obj->setProperty("notesChunk", chunk);
+        return juce::var(obj);
+    }
+
     juce::Array<juce::var> notesArray;
     for (const auto &note : clip.notes)
         notesArray.add(midiNoteToJson(note));
@@ -327,7 +458,7 @@ juce::var ProjectSerializer::midiClipToJson(const MidiClip &clip)
 juce::var ProjectSerializer::midiNoteToJson(const MidiNote &note)
 {
     auto *obj = new juce::DynamicObject();
-    obj->setProperty("id", note.id);
+    obj->setProperty("id", static_cast<int64_t>(note.id));
     obj->setProperty("noteNumber", note.noteNumber);
     obj->setProperty("velocity", static_cast<double>(note.velocity));
     obj->setProperty("startSample", static_cast<int64_t>(note.startSample));
@@ -335,7 +466,7 @@ juce::var ProjectSerializer::midiNoteToJson(const MidiNote &note)
     return juce::var(obj);
 }
 
-juce::var ProjectSerializer::pluginSlotToJson(const PluginSlot &slot)
+juce::var ProjectSerializer::pluginSlotToJson(const PluginSlot &slot, ArchiveOutput *archive)
 {
     auto *obj = new juce::DynamicObject();
     obj->setProperty("pluginId", slot.pluginId);
@@ -346,10 +477,17 @@ juce::var ProjectSerializer::pluginSlotToJson(const PluginSlot &slot)
     obj->setProperty("isResolved", slot.isResolved);
     obj->setProperty("originalIdentifier", slot.originalIdentifier);
 
-    // Encode state data as base64
-    if (!slot.stateData.empty())
+    // State data goes in a chunk of its own, or as base64
+    if (slot.hasState() && archive != nullptr)
+    {
+        const int chunk = archive->writer.addChunk(ProjectArchive::ChunkType::PluginState,
+                                                   slot.stateData->data(), slot.stateData->size());
+        archive->ok = archive->ok && chunk >= 0;
+        obj->setProperty("stateChunk", chunk);
+    }
+    else if (slot.hasState())
     {
-        juce::MemoryBlock mb(slot.stateData.data(), slot.stateData.size());
+        juce::MemoryBlock mb(slot.stateData->data(), slot.stateData->size());
         obj->setProperty("stateData", mb.toBase64Encoding());
     }
 
@@ -365,7 +503,8 @@ juce::var ProjectSerializer::pluginSlotToJson(const PluginSlot &slot)
     return juce::var(obj);
 }
 
-PluginSlot ProjectSerializer::pluginSlotFromJson(const juce::var &json)
+PluginSlot ProjectSerializer::pluginSlotFromJson(const juce::var &json,
+                                                 const ArchiveInput *archive)
 {
     PluginSlot slot;
 
@@ -380,15 +519,26 @@ PluginSlot ProjectSerializer::pluginSlotFromJson(const juce::var &json)
     slot.isResolved = json.getProperty("isResolved", false);
     slot.originalIdentifier = json.getProperty("originalIdentifier", "").toString();
 
-    // Decode state data from base64
+    // Read state data from its chunk, or decode it from base64
+    auto stateChunkVar = json.getProperty("stateChunk", juce::var());
     juce::String stateDataStr = json.getProperty("stateData", "").toString();
-    if (stateDataStr.isNotEmpty())
+    if (archive != nullptr && !stateChunkVar.isVoid())
+    {
+        juce::MemoryBlock mb;
+        if (archive->reader->readChunk(static_cast<int>(stateChunkVar),
+                                       ProjectArchive::ChunkType::PluginState, mb))
+        {
+            const uint8_t *data = static_cast<const uint8_t *>(mb.getData());
+            slot.stateData = std::make_shared<const std::vector<uint8_t>>(data, data + mb.getSize());
+        }
+    }
+    else if (stateDataStr.isNotEmpty())
     {
         juce::MemoryBlock mb;
         if (mb.fromBase64Encoding(stateDataStr))
         {
             const uint8_t *data = static_cast<const uint8_t *>(mb.getData());
-            slot.stateData.assign(data, data + mb.getSize());
+            slot.stateData = std::make_shared<const std::vector<uint8_t>>(data, data + mb.getSize());
         }
     }
 
@@ -406,6 +556,135 @@ PluginSlot ProjectSerializer::pluginSlotFromJson(const juce::var &json)
     return slot;
 }
 
+AudioAssetPtr ProjectSerializer::archivedAsset(const juce::var &clipVar, int chunk,
+                                               const Session &session,
+                                               juce::AudioFormatManager &formatManager,
+                                               ArchiveInput &archive)
+{
+    auto it = archive.assets.find(chunk);
+    if (it != archive.assets.end())
+        return it->second;
+
+    if (!archive.reader->isChunk(chunk, ProjectArchive::ChunkType::Audio))
+        return nullptr;
+
+    // Everything but the samples comes from the index
+    auto asset = std::make_shared<AudioAsset>();
+    asset->filePath = "archive:" + juce::String(chunk);
+    asset->fileName = clipVar.getProperty("assetFileName", "").toString();
+    asset->lengthInSamples =
+        static_cast<SampleCount>((int64_t)clipVar.getProperty("assetLength", 0));
+    asset->sampleRate = clipVar.getProperty("assetSampleRate", 0.0);
+    asset->numChannels = clipVar.getProperty("assetNumChannels", 0);
+    asset->peakKey = static_cast<uint64_t>((int64_t)clipVar.getProperty("assetPeakKey", 0));
+    auto source = std::make_shared<ArchivedAudioSource>(archive.reader, chunk);
+    asset->openSource = [source] { return source->open(); };
+    asset->loaded.store(false, std::memory_order_relaxed);
+
+    AssetLoader::OpenReader openReader =
+        [source, &formatManager]() -> std::unique_ptr<juce::AudioFormatReader>
+    {
+        source->copyOut();
+        auto stream = source->open();
+        if (stream == nullptr)
+            return nullptr;
+        return std::unique_ptr<juce::AudioFormatReader>(
+            formatManager.createReaderFor(std::move(stream)));
+    };
+
+    if (archive.loader != nullptr)
+        archive.loader->enqueue(asset, std::move(openReader), asset->peakKey,
+                                session.getPeakCacheDirectory());
+    else
+        AssetLoader::load(*asset, openReader().get(), asset->peakKey,
+                          session.getPeakCacheDirectory());
+
+    archive.assets[chunk] = asset;
+    return asset;
+}
+
+int ProjectSerializer::writeAssetChunk(const AudioAsset &asset, ArchiveOutput &archive)
+{
+    auto it = archive.audioChunks.find(&asset);
+    if (it != archive.audioChunks.end())
+        return it->second;
+
+    // Archived audio is copied out of the old archive while it loads; waiting
+    // for that keeps the save from reading (and so mapping) the file it replaces
+    asset.waitUntilLoaded();
+
+    // An asset with no audio left to save is dropped, as in JSON projects
+    auto source = openAssetSource(asset);
+    if (source == nullptr)
+        return -1;
+
+    const int chunk = archive.writer.addChunk(ProjectArchive::ChunkType::Audio, *source);
+    archive.ok = archive.ok && chunk >= 0;
+    archive.audioChunks[&asset] = chunk;
+    return chunk;
+}
+
+juce::File ProjectSerializer::getSourceFile(const AudioAsset &asset)
+{
+    if (!juce::File::isAbsolutePath(asset.filePath))
+        return {};
+    return juce::File(asset.filePath);
+}
+
+std::unique_ptr<juce::InputStream> ProjectSerializer::openAssetSource(const AudioAsset &asset)
+{
+    if (asset.openSource)
+        return asset.openSource();
+
+    const auto sourceFile = getSourceFile(asset);
+    if (sourceFile.existsAsFile())
+        return sourceFile.createInputStream();
+
+    // No source left (e.g. audio embedded in a JSON project): write out the
+    // samples, losslessly
+    asset.waitUntilLoaded();
+    if (!asset.hasSamples())
+        return nullptr;
+
+    juce::MemoryBlock wav;
+    auto stream = std::make_unique<juce::MemoryOutputStream>(wav, false);
+    juce::WavAudioFormat wavFormat;
+
+    JUCE_BEGIN_IGNORE_WARNINGS_MSVC(4996)
+    #if __clang__
+    _Pragma("clang diagnostic push")
+    _Pragma("clang diagnostic ignored \"-Wdeprecated-declarations\"")
+    #endif
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(
+        wavFormat.createWriterFor(stream.get(), asset.sampleRate,
+                                  static_cast<unsigned int>(asset.numChannels), 32, {}, 0));
+
+    #if __clang__
+    _Pragma("clang diagnostic pop")
+    #endif
+    JUCE_END_IGNORE_WARNINGS_MSVC
+
+    if (writer == nullptr)
+        return nullptr;
+    stream.release(); // Owned by the writer
+
+    constexpr SampleCount kBlockSize = 1 << 16;
+    std::vector<const float *> channels(asset.channels.size());
+    for (SampleCount start = 0; start < asset.lengthInSamples; start += kBlockSize)
+    {
+        const auto numSamples = std::min(kBlockSize, asset.lengthInSamples - start);
+        for (size_t ch = 0; ch < channels.size(); ++ch)
+            channels[ch] = asset.channels[ch].data() + start;
+        if (!writer->writeFromFloatArrays(channels.data(), static_cast<int>(channels.size()),
+                                          static_cast<int>(numSamples)))
+            return nullptr;
+    }
+    writer.reset(); // Completes the header
+
+    return std::make_unique<juce::MemoryInputStream>(std::move(wav));
+}
+
 juce::String ProjectSerializer::makeRelativePath(const juce::File &file, const juce::File &projectDir)
 {
     return file.getRelativePathFrom(projectDir);
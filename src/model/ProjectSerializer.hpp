@@ -1,43 +1,89 @@
 #pragma once
 
+#include "model/AssetLoader.hpp"
+#include "model/ProjectArchive.hpp"
 #include "model/Session.hpp"
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_core/juce_core.h>
+#include <map>
+#include <memory>
 
 namespace ampl
 {
 
-// Serializes/deserializes a Session to/from a JSON project file.
-// Project format: .ampl (JSON metadata) + embedded audio assets (base64) with
-// a relative path fallback for backward compatibility.
+// Serializes/deserializes a Session to/from a project file.
+// Project format: .ampl, a chunked binary archive (see ProjectArchive) whose
+// index holds the session as JSON and whose chunks hold each audio file, MIDI
+// note list and plugin state. The JSON format of earlier versions, with the
+// audio embedded as base64, can still be loaded and exported.
 class ProjectSerializer
 {
   public:
-    // Save session to a .ampl project file.
-    // Audio assets are referenced by relative path from the project directory.
+    // Save session to a binary .ampl project file.
+    // Each audio asset is stored once, copied from its source file, or as a
+    // float WAV of its samples if that file is gone.
     // Returns true on success.
     static bool save(const Session &session, const juce::File &projectFile);
 
-    // Load session from a .ampl project file.
-    // Audio assets are resolved relative to the project file location.
+    // Load session from a binary or JSON .ampl project file.
+    // Given a loader, a binary project's audio is read in the background:
+    // this returns once the index, notes and plugin state are read, and
+    // clips play and draw as their assets load. Otherwise (and for JSON
+    // projects) the audio is read before returning.
     // Returns true on success.
     static bool load(Session &session, const juce::File &projectFile,
-                     juce::AudioFormatManager &formatManager);
+                     juce::AudioFormatManager &formatManager, AssetLoader *loader = nullptr);
+
+    // Write session as a JSON project, audio embedded as base64, for tools
+    // that read the old format. Returns true on success.
+    static bool exportJson(const Session &session, const juce::File &file);
 
     // Project file extension
     static constexpr const char *kFileExtension = ".ampl";
 
   private:
-    static juce::var sessionToJson(const Session &session, const juce::File &projectDir);
+    // Chunks written so far: an asset shared by several clips is stored once
+    struct ArchiveOutput
+    {
+        ProjectArchive::Writer &writer;
+        std::map<const AudioAsset *, int> audioChunks;
+        bool ok{true};
+    };
+
+    struct ArchiveInput
+    {
+        std::shared_ptr<const ProjectArchive::Reader> reader;
+        AssetLoader *loader;
+        std::map<int, AudioAssetPtr> assets; // By chunk
+    };
+
+    // With archive, bulky data goes into chunks; without, into the JSON
+    static juce::var sessionToJson(const Session &session, const juce::File &projectDir,
+                                   ArchiveOutput *archive);
     static bool jsonToSession(const juce::var &json, Session &session, const juce::File &projectDir,
-                              juce::AudioFormatManager &formatManager);
+                              juce::AudioFormatManager &formatManager, ArchiveInput *archive);
 
-    static juce::var trackToJson(const TrackState &track, const juce::File &projectDir);
-    static juce::var clipToJson(const Clip &clip, const juce::File &projectDir);
-    static juce::var midiClipToJson(const MidiClip &clip);
+    static juce::var trackToJson(const TrackState &track, const juce::File &projectDir,
+                                 ArchiveOutput *archive);
+    static juce::var clipToJson(const Clip &clip, const juce::File &projectDir,
+                                ArchiveOutput *archive);
+    static juce::var midiClipToJson(const MidiClip &clip, ArchiveOutput *archive);
     static juce::var midiNoteToJson(const MidiNote &note);
-    static juce::var pluginSlotToJson(const PluginSlot &slot);
-    static PluginSlot pluginSlotFromJson(const juce::var &json);
+    static juce::var pluginSlotToJson(const PluginSlot &slot, ArchiveOutput *archive);
+    static PluginSlot pluginSlotFromJson(const juce::var &json, const ArchiveInput *archive);
+
+    // The asset behind an archived clip, unloaded and queued on the loader
+    // if there is one. Null if chunk is not an audio chunk.
+    static AudioAssetPtr archivedAsset(const juce::var &clipVar, int chunk, const Session &session,
+                                       juce::AudioFormatManager &formatManager,
+                                       ArchiveInput &archive);
+    static int writeAssetChunk(const AudioAsset &asset, ArchiveOutput &archive);
+
+    // The asset's source file, or File() if it has none (e.g. embedded)
+    static juce::File getSourceFile(const AudioAsset &asset);
+    // The encoded audio of asset: its source, or else its samples as a float
+    // WAV. Null if it has neither.
+    static std::unique_ptr<juce::InputStream> openAssetSource(const AudioAsset &asset);
 
     static juce::String makeRelativePath(const juce::File &file, const juce::File &projectDir);
     static juce::File resolveRelativePath(const juce::String &relativePath,
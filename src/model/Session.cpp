@@ -28,6 +28,8 @@ int Session::addTrack(const juce::String &name, TrackType type)
     {
         track.name = name;
     }
+    ++revision_;
+    trackIndex_.set(track.id, tracks_.size());
     tracks_.push_back(std::move(track));
     return static_cast<int>(tracks_.size()) - 1;
 }
@@ -40,7 +42,10 @@ int Session::addMidiTrack(const juce::String &name)
 void Session::removeTrack(int index)
 {
     if (index >= 0 && index < static_cast<int>(tracks_.size()))
+    {
+        ++revision_;
         tracks_.erase(tracks_.begin() + index);
+    }
 }
 
 void Session::insertTrack(int index, const TrackState &track)
@@ -49,7 +54,9 @@ void Session::insertTrack(int index, const TrackState &track)
         index = 0;
     if (index > static_cast<int>(tracks_.size()))
         index = static_cast<int>(tracks_.size());
+    ++revision_;
     tracks_.insert(tracks_.begin() + index, track);
+    trackIndex_.set(track.id, static_cast<size_t>(index));
 }
 
 void Session::moveTrack(int fromIndex, int toIndex)
@@ -60,6 +67,7 @@ void Session::moveTrack(int fromIndex, int toIndex)
     if (fromIndex == toIndex)
         return;
 
+    ++revision_;
     auto track = std::move(tracks_[static_cast<size_t>(fromIndex)]);
     tracks_.erase(tracks_.begin() + fromIndex);
     tracks_.insert(tracks_.begin() + toIndex, std::move(track));
@@ -68,7 +76,10 @@ void Session::moveTrack(int fromIndex, int toIndex)
 TrackState *Session::getTrack(int index)
 {
     if (index >= 0 && index < static_cast<int>(tracks_.size()))
+    {
+        ++revision_;
         return &tracks_[static_cast<size_t>(index)];
+    }
     return nullptr;
 }
 
@@ -81,10 +92,21 @@ const TrackState *Session::getTrack(int index) const
 
 TrackState *Session::findTrackById(const juce::String &id)
 {
-    for (auto &t : tracks_)
-        if (t.id == id)
-            return &t;
-    return nullptr;
+    return getTrack(findTrackIndexById(id));
+}
+
+int Session::findTrackIndexById(const juce::String &id) const
+{
+    auto position = trackIndex_.find(
+        id, revision_,
+        [this, &id](size_t position)
+        { return position < tracks_.size() && tracks_[position].id == id; },
+        [this](auto &&add)
+        {
+            for (size_t position = 0; position < tracks_.size(); ++position)
+                add(tracks_[position].id, position);
+        });
+    return position ? static_cast<int>(*position) : -1;
 }
 
 AudioAssetPtr Session::loadAudioAsset(const juce::File &file,
@@ -109,22 +131,9 @@ AudioAssetPtr Session::loadAudioAsset(const juce::File &file,
     mutableAsset->lengthInSamples = static_cast<SampleCount>(reader->lengthInSamples);
     mutableAsset->sampleRate = reader->sampleRate;
     mutableAsset->numChannels = static_cast<int>(reader->numChannels);
+    mutableAsset->peakKey = PeakPyramid::contentKey(file);
 
-    // Read entire file into memory
-    mutableAsset->channels.resize(static_cast<size_t>(mutableAsset->numChannels));
-    for (auto &ch : mutableAsset->channels)
-        ch.resize(static_cast<size_t>(mutableAsset->lengthInSamples), 0.0f);
-
-    juce::AudioBuffer<float> tempBuffer(mutableAsset->numChannels,
-                                        static_cast<int>(mutableAsset->lengthInSamples));
-    reader->read(&tempBuffer, 0, static_cast<int>(mutableAsset->lengthInSamples), 0, true, true);
-
-    for (int ch = 0; ch < mutableAsset->numChannels; ++ch)
-    {
-        const float *src = tempBuffer.getReadPointer(ch);
-        std::copy(src, src + mutableAsset->lengthInSamples,
-                  mutableAsset->channels[static_cast<size_t>(ch)].data());
-    }
+    readAsset(*reader, *mutableAsset, mutableAsset->peakKey, peakCacheDirectory_);
 
     assetCache_[key] = asset;
     return asset;
@@ -160,21 +169,9 @@ AudioAssetPtr Session::loadAudioAssetFromMemory(const void *data, size_t size,
     mutableAsset->lengthInSamples = static_cast<SampleCount>(reader->lengthInSamples);
     mutableAsset->sampleRate = reader->sampleRate;
     mutableAsset->numChannels = static_cast<int>(reader->numChannels);
+    mutableAsset->peakKey = PeakPyramid::contentKey(data, size);
 
-    mutableAsset->channels.resize(static_cast<size_t>(mutableAsset->numChannels));
-    for (auto &ch : mutableAsset->channels)
-        ch.resize(static_cast<size_t>(mutableAsset->lengthInSamples), 0.0f);
-
-    juce::AudioBuffer<float> tempBuffer(mutableAsset->numChannels,
-                                        static_cast<int>(mutableAsset->lengthInSamples));
-    reader->read(&tempBuffer, 0, static_cast<int>(mutableAsset->lengthInSamples), 0, true, true);
-
-    for (int ch = 0; ch < mutableAsset->numChannels; ++ch)
-    {
-        const float *src = tempBuffer.getReadPointer(ch);
-        std::copy(src, src + mutableAsset->lengthInSamples,
-                  mutableAsset->channels[static_cast<size_t>(ch)].data());
-    }
+    readAsset(*reader, *mutableAsset, mutableAsset->peakKey, peakCacheDirectory_);
 
     assetCache_[key] = asset;
     return asset;
@@ -188,11 +185,64 @@ AudioAssetPtr Session::getAudioAsset(const juce::String &filePath) const
     return nullptr;
 }
 
+void Session::readAsset(juce::AudioFormatReader &reader, AudioAsset &asset, uint64_t peakKey,
+                        const juce::File &peakCacheDirectory)
+{
+    asset.channels.resize(static_cast<size_t>(asset.numChannels));
+    for (auto &ch : asset.channels)
+        ch.resize(static_cast<size_t>(asset.lengthInSamples), 0.0f);
+
+    // A peak file saved for the same audio saves rescanning it
+    auto peaks = std::make_shared<PeakPyramid>();
+    const bool cacheEnabled = peakCacheDirectory != juce::File() && peakKey != 0;
+    const auto peakFile = cacheEnabled ? PeakPyramid::getPeakFile(peakCacheDirectory, peakKey)
+                                       : juce::File();
+    const bool peaksCached = cacheEnabled && peaks->loadFromFile(peakFile, peakKey) &&
+                             peaks->getNumChannels() == asset.numChannels &&
+                             peaks->getLength() == asset.lengthInSamples;
+    if (!peaksCached)
+    {
+        peaks = std::make_shared<PeakPyramid>();
+        peaks->begin(asset.numChannels, asset.lengthInSamples);
+    }
+
+    // Decode a block at a time (a whole number of peak buckets), feeding the
+    // peaks while the block is still in cache
+    constexpr int kBlockSize = PeakPyramid::kBaseBucketSize * 1024;
+    juce::AudioBuffer<float> block(asset.numChannels, kBlockSize);
+    std::vector<const float *> blockChannels(static_cast<size_t>(asset.numChannels));
+    for (SampleCount start = 0; start < asset.lengthInSamples; start += kBlockSize)
+    {
+        const auto numSamples =
+            static_cast<int>(std::min<SampleCount>(kBlockSize, asset.lengthInSamples - start));
+        reader.read(&block, 0, numSamples, start, true, true);
+
+        for (int ch = 0; ch < asset.numChannels; ++ch)
+        {
+            const float *src = block.getReadPointer(ch);
+            std::copy(src, src + numSamples,
+                      asset.channels[static_cast<size_t>(ch)].data() + start);
+            blockChannels[static_cast<size_t>(ch)] = src;
+        }
+        if (!peaksCached)
+            peaks->addSamples(blockChannels.data(), numSamples);
+    }
+
+    if (!peaksCached)
+    {
+        peaks->finish();
+        if (cacheEnabled)
+            PeakPyramid::saveInBackground(peaks, peakFile, peakKey);
+    }
+    asset.peaks = std::move(peaks);
+}
+
 bool Session::addClipToTrack(int trackIndex, const Clip &clip)
 {
     auto *track = getTrack(trackIndex);
     if (track == nullptr)
         return false;
+    clipIndex_.set(clip.id, {static_cast<size_t>(trackIndex), track->clips.size()});
     track->clips.push_back(clip);
     return true;
 }
@@ -215,19 +265,41 @@ bool Session::removeClipFromTrack(int trackIndex, const juce::String &clipId)
 
 Clip *Session::findClip(const juce::String &clipId)
 {
-    for (auto &track : tracks_)
-        for (auto &clip : track.clips)
-            if (clip.id == clipId)
-                return &clip;
-    return nullptr;
+    auto location = findClipLocation(clipId);
+    if (!location)
+        return nullptr;
+    ++revision_;
+    return &tracks_[location->track].clips[location->clip];
+}
+
+const Clip *Session::findClip(const juce::String &clipId) const
+{
+    auto location = findClipLocation(clipId);
+    return location ? &tracks_[location->track].clips[location->clip] : nullptr;
+}
+
+std::optional<Session::ClipLocation> Session::findClipLocation(const juce::String &clipId) const
+{
+    return clipIndex_.find(
+        clipId, revision_,
+        [this, &clipId](const ClipLocation &location)
+        {
+            return location.track < tracks_.size()
+                   && location.clip < tracks_[location.track].clips.size()
+                   && tracks_[location.track].clips[location.clip].id == clipId;
+        },
+        [this](auto &&add)
+        {
+            for (size_t t = 0; t < tracks_.size(); ++t)
+                for (size_t c = 0; c < tracks_[t].clips.size(); ++c)
+                    add(tracks_[t].clips[c].id, ClipLocation{t, c});
+        });
 }
 
 Session::Snapshot Session::takeSnapshot() const
 {
     Snapshot snap;
-    snap.tracks.reserve(tracks_.size());
-    for (const auto &t : tracks_)
-        snap.tracks.push_back(t.clone());
+    snap.tracks = tracks_; // Shares note data and plugin state
     snap.bpm = bpm_;
     snap.timeSigNumerator = timeSigNumerator_;
     snap.timeSigDenominator = timeSigDenominator_;
@@ -239,6 +311,7 @@ Session::Snapshot Session::takeSnapshot() const
 
 void Session::restoreSnapshot(const Snapshot &snapshot)
 {
+    ++revision_;
     tracks_ = snapshot.tracks;
     bpm_ = snapshot.bpm;
     timeSigNumerator_ = snapshot.timeSigNumerator;
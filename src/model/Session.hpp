@@ -2,9 +2,11 @@
 
 #include "model/Clip.hpp"
 #include "model/Track.hpp"
+#include "util/IdIndex.hpp"
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_core/juce_core.h>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -77,6 +79,7 @@ class Session
     }
     std::vector<TrackState> &getTracks()
     {
+        ++revision_;
         return tracks_;
     }
 
@@ -87,7 +90,15 @@ class Session
     void moveTrack(int fromIndex, int toIndex);
     TrackState *getTrack(int index);
     const TrackState *getTrack(int index) const;
+
+    // Lookups by ID are O(1) while the session is edited through its own
+    // methods; editing the track or clip vectors directly costs one O(n)
+    // rebuild on the next lookup (see IdIndex). A missing ID is remembered
+    // until the next call that hands out write access, so write through a
+    // track or clip reference before looking anything else up. Const
+    // lookups are safe to run concurrently.
     TrackState *findTrackById(const juce::String &id);
+    int findTrackIndexById(const juce::String &id) const; // -1 if not found
 
     // --- Master Bus ---
     float getMasterGainDb() const
@@ -114,12 +125,32 @@ class Session
                                            juce::AudioFormatManager &formatManager);
     AudioAssetPtr getAudioAsset(const juce::String &filePath) const;
 
+    // Where waveform peak files are kept between runs (see PeakPyramid).
+    // Off (an empty File) unless the owner picks a folder.
+    void setPeakCacheDirectory(const juce::File &directory)
+    {
+        peakCacheDirectory_ = directory;
+    }
+    const juce::File &getPeakCacheDirectory() const
+    {
+        return peakCacheDirectory_;
+    }
+
+    // Decodes reader into asset (numChannels and lengthInSamples already
+    // set) block by block, with its peaks from the peak cache or else
+    // computed from the blocks as they are decoded
+    static void readAsset(juce::AudioFormatReader &reader, AudioAsset &asset, uint64_t peakKey,
+                          const juce::File &peakCacheDirectory);
+
     // --- Clip Operations ---
     bool addClipToTrack(int trackIndex, const Clip &clip);
     bool removeClipFromTrack(int trackIndex, const juce::String &clipId);
     Clip *findClip(const juce::String &clipId);
+    const Clip *findClip(const juce::String &clipId) const;
 
     // --- Snapshot for undo ---
+    // Costs O(tracks + clips): note data and plugin state are shared with
+    // the session until either side changes them (see TrackState)
     struct Snapshot
     {
         std::vector<TrackState> tracks;
@@ -145,8 +176,21 @@ class Session
 
     std::vector<TrackState> tracks_;
     std::unordered_map<std::string, AudioAssetPtr> assetCache_;
+    juce::File peakCacheDirectory_;
 
     int nextTrackNumber_{1};
+
+    struct ClipLocation
+    {
+        size_t track;
+        size_t clip;
+    };
+
+    IdIndex<size_t> trackIndex_;
+    IdIndex<ClipLocation> clipIndex_;
+    uint64_t revision_{1}; // Bumped whenever write access to tracks_ is handed out
+
+    std::optional<ClipLocation> findClipLocation(const juce::String &clipId) const;
 };
 
 } // namespace ampl
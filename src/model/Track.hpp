@@ -3,8 +3,10 @@
 #include <juce_core/juce_core.h>
 #include "model/Clip.hpp"
 #include "model/MidiClip.hpp"
+#include "util/IdIndex.hpp"
 #include <vector>
 #include <atomic>
+#include <memory>
 #include <map>
 #include <optional>
 
@@ -22,8 +24,9 @@ struct PluginSlot
     bool bypassed{false};
     bool isResolved{false};          // True if plugin was found on this system
 
-    // Plugin state (chunk data for save/restore)
-    std::vector<uint8_t> stateData;
+    // Plugin state (chunk data for save/restore). Immutable and shared by
+    // copies of the slot; replace the pointer to change it.
+    std::shared_ptr<const std::vector<uint8_t>> stateData;
 
     // Parameter values (fallback if chunk not available)
     std::map<juce::String, float> parameterValues;
@@ -31,25 +34,27 @@ struct PluginSlot
     // Original identifier from import (for matching)
     juce::String originalIdentifier; // e.g., Logic AU identifier
 
-    PluginSlot clone() const
+    bool hasState() const { return stateData != nullptr && !stateData->empty(); }
+
+    // Bytes held by this slot, shared state included (see
+    // MidiNoteList::getMemoryUsage())
+    size_t getMemoryUsage() const
     {
-        PluginSlot s;
-        s.pluginId = pluginId;
-        s.pluginName = pluginName;
-        s.pluginFormat = pluginFormat;
-        s.pluginPath = pluginPath;
-        s.bypassed = bypassed;
-        s.isResolved = isResolved;
-        s.stateData = stateData;
-        s.parameterValues = parameterValues;
-        s.originalIdentifier = originalIdentifier;
-        return s;
+        size_t bytes = sizeof(PluginSlot);
+        if (stateData != nullptr)
+            bytes += stateData->capacity();
+        return bytes;
     }
 };
 
 // A track holds an ordered list of non-overlapping clips on the timeline.
 // Track state is modified on the UI thread; the audio thread reads a
 // snapshot via atomic pointer swap.
+//
+// Copies are cheap and are what undo keeps: audio clips share their assets,
+// MIDI clips share their notes until edited (see MidiNoteList) and plugin
+// slots share their state blobs, so a copy costs O(clips + slots) however
+// much note and plugin data the track holds.
 struct TrackState
 {
     juce::String id;
@@ -76,40 +81,50 @@ struct TrackState
     bool isAudio() const { return type == TrackType::Audio; }
     bool isMidi()  const { return type == TrackType::Midi; }
 
-    // Deep copy for undo snapshots
-    TrackState clone() const
+    // Bytes held by this track, including note and plugin data it shares
+    // with other copies
+    size_t getMemoryUsage() const
     {
-        TrackState t;
-        t.id = id;
-        t.name = name;
-        t.type = type;
-        t.clips = clips; // Clips share AudioAssetPtr (cheap copy)
+        size_t bytes = sizeof(TrackState) + clips.size() * sizeof(Clip);
         for (const auto& mc : midiClips)
-            t.midiClips.push_back(mc.clone());
-        for (const auto& ps : pluginChain)
-            t.pluginChain.push_back(ps.clone());
-        if (instrumentPlugin.has_value())
-            t.instrumentPlugin = instrumentPlugin->clone();
-        t.gainDb = gainDb;
-        t.pan = pan;
-        t.muted = muted;
-        t.solo = solo;
-        return t;
+            bytes += mc.getMemoryUsage();
+        for (const auto& slot : pluginChain)
+            bytes += slot.getMemoryUsage();
+        if (instrumentPlugin)
+            bytes += instrumentPlugin->getMemoryUsage();
+        return bytes;
     }
 
-    // Find a MIDI clip by ID
+
+    // Find a MIDI clip by ID, in O(1) unless midiClips changed since the
+    // last lookup (see IdIndex). midiClips is edited in place, so a missing
+    // ID rescans it every time; that scan covers one track's clips.
     MidiClip* findMidiClip(const juce::String& clipId)
     {
-        for (auto& mc : midiClips)
-            if (mc.id == clipId) return &mc;
-        return nullptr;
+        auto position = findMidiClipPosition(clipId);
+        return position ? &midiClips[*position] : nullptr;
     }
 
     const MidiClip* findMidiClip(const juce::String& clipId) const
     {
-        for (const auto& mc : midiClips)
-            if (mc.id == clipId) return &mc;
-        return nullptr;
+        auto position = findMidiClipPosition(clipId);
+        return position ? &midiClips[*position] : nullptr;
+    }
+
+private:
+    IdIndex<size_t> midiClipIndex_;
+
+    std::optional<size_t> findMidiClipPosition(const juce::String& clipId) const
+    {
+        return midiClipIndex_.find(
+            clipId, IdIndex<size_t>::kUntracked,
+            [this, &clipId](size_t position)
+            { return position < midiClips.size() && midiClips[position].id == clipId; },
+            [this](auto&& add)
+            {
+                for (size_t position = 0; position < midiClips.size(); ++position)
+                    add(midiClips[position].id, position);
+            });
     }
 };
 
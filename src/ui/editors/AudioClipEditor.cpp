@@ -16,8 +16,6 @@ void AudioClipEditor::setClip(int trackIndex, const juce::String& clipId)
 {
     trackIndex_ = trackIndex;
     clipId_ = clipId;
-    waveformPeaks_.clear();
-    cachedPPS_ = 0.0;
 
     // Auto-zoom to fit clip
     if (auto* clip = getClip())
@@ -36,7 +34,6 @@ void AudioClipEditor::clearClip()
 {
     trackIndex_ = -1;
     clipId_ = {};
-    waveformPeaks_.clear();
     repaint();
 }
 
@@ -49,8 +46,7 @@ Clip* AudioClipEditor::getClip()
 const Clip* AudioClipEditor::getClip() const
 {
     if (trackIndex_ < 0) return nullptr;
-    // const_cast needed since Session::findClip is non-const
-    return const_cast<Session&>(session_).findClip(clipId_);
+    return session_.findClip(clipId_);
 }
 
 void AudioClipEditor::paint(juce::Graphics& g)
@@ -102,41 +98,21 @@ void AudioClipEditor::paint(juce::Graphics& g)
 void AudioClipEditor::paintWaveform(juce::Graphics& g, juce::Rectangle<int> area)
 {
     auto* clip = getClip();
-    if (!clip || !clip->asset || clip->asset->numChannels == 0) return;
+    if (!clip || !clip->asset || !clip->asset->hasSamples()) return;
 
     int w = area.getWidth();
     if (w <= 0) return;
 
-    // Regenerate peaks if needed
-    if (waveformPeaks_.size() != static_cast<size_t>(w * 2) ||
-        std::abs(cachedPPS_ - pixelsPerSample_) > 1e-12)
+    // Peaks for the current zoom, O(w) through the asset's peak pyramid
+    waveformPeaks_.resize(static_cast<size_t>(w));
+    if (!PeakPyramid::getPeaks(*clip->asset, 0, static_cast<double>(clip->sourceStartSample),
+                               1.0 / pixelsPerSample_, waveformPeaks_.data(), w))
     {
-        waveformPeaks_.resize(static_cast<size_t>(w * 2), 0.0f);
-        cachedPPS_ = pixelsPerSample_;
-
-        const auto& ch = clip->asset->channels[0];
-        double samplesPerPixel = 1.0 / pixelsPerSample_;
-
-        for (int px = 0; px < w; ++px)
-        {
-            SampleCount s0 = clip->sourceStartSample +
-                static_cast<SampleCount>(static_cast<double>(px) * samplesPerPixel);
-            SampleCount s1 = clip->sourceStartSample +
-                static_cast<SampleCount>(static_cast<double>(px + 1) * samplesPerPixel);
-
-            s0 = std::max(s0, SampleCount(0));
-            s1 = std::min(s1, clip->asset->lengthInSamples);
-
-            float mn = 0.0f, mx = 0.0f;
-            for (SampleCount s = s0; s < s1; ++s)
-            {
-                float v = ch[static_cast<size_t>(s)];
-                mn = std::min(mn, v);
-                mx = std::max(mx, v);
-            }
-            waveformPeaks_[static_cast<size_t>(px * 2)] = mn;
-            waveformPeaks_[static_cast<size_t>(px * 2 + 1)] = mx;
-        }
+        // Overview still being built: look again shortly
+        juce::Timer::callAfterDelay(50, [safeThis = juce::Component::SafePointer<AudioClipEditor>(this)] {
+            if (safeThis != nullptr) safeThis->repaint();
+        });
+        waveformPeaks_.assign(static_cast<size_t>(w), PeakPyramid::Peak{});
     }
 
     // Draw waveform
@@ -156,13 +132,23 @@ void AudioClipEditor::paintWaveform(juce::Graphics& g, juce::Rectangle<int> area
     g.setColour(juce::Colour(ampl::Theme::clipAudioWave));
     for (int px = 0; px < w; ++px)
     {
-        float mn = waveformPeaks_[static_cast<size_t>(px * 2)];
-        float mx = waveformPeaks_[static_cast<size_t>(px * 2 + 1)];
-        float y1 = midY - mx * halfH;
-        float y2 = midY - mn * halfH;
+        const auto& peak = waveformPeaks_[static_cast<size_t>(px)];
+        float y1 = midY - peak.max * halfH;
+        float y2 = midY - peak.min * halfH;
         g.drawVerticalLine(area.getX() + px, y1, y2);
     }
 
+    // RMS band
+    g.setColour(juce::Colour(ampl::Theme::clipAudioWave).brighter(0.4f));
+    for (int px = 0; px < w; ++px)
+    {
+        const auto& peak = waveformPeaks_[static_cast<size_t>(px)];
+        float top = std::min(peak.rms, peak.max);
+        float bottom = std::max(-peak.rms, peak.min);
+        if (top > bottom)
+            g.drawVerticalLine(area.getX() + px, midY - top * halfH, midY - bottom * halfH);
+    }
+
     // Gain line
     float gainDb = clip->gainDb;
     float gainLin = juce::Decibels::decibelsToGain(gainDb);
@@ -244,9 +230,6 @@ void AudioClipEditor::resized()
 {
     auto toolbar = getLocalBounds().removeFromTop(kToolbarHeight).reduced(4, 2);
     closeBtn_.setBounds(toolbar.removeFromRight(26));
-
-    waveformPeaks_.clear();
-    cachedPPS_ = 0.0;
 }
 
 void AudioClipEditor::mouseDown(const juce::MouseEvent& e)
@@ -339,8 +322,6 @@ void AudioClipEditor::mouseWheelMove(const juce::MouseEvent& e,
             pixelsPerSample_ = std::min(pixelsPerSample_ * 1.3, 1.0);
         else
             pixelsPerSample_ = std::max(pixelsPerSample_ / 1.3, 0.0001);
-        waveformPeaks_.clear();
-        cachedPPS_ = 0.0;
     }
     else
     {
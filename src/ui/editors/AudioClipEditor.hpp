@@ -54,9 +54,8 @@ private:
 
     juce::TextButton closeBtn_{"X"};
 
-    // Waveform cache
-    std::vector<float> waveformPeaks_;
-    double cachedPPS_{0.0};
+    // Scratch for paintWaveform: one peak per pixel column
+    std::vector<PeakPyramid::Peak> waveformPeaks_;
 
     static constexpr int kToolbarHeight = 28;
     static constexpr int kInfoHeight = 24;
@@ -258,15 +258,7 @@ void PianoRollEditor::paintNotes(juce::Graphics &g, juce::Rectangle<int> area)
     if (!track)
         return;
 
-    const MidiClip *clip = nullptr;
-    for (const auto &mc : track->midiClips)
-    {
-        if (mc.id == clipId_)
-        {
-            clip = &mc;
-            break;
-        }
-    }
+    const auto *clip = track->findMidiClip(clipId_);
     if (!clip)
         return;
 
@@ -275,8 +267,14 @@ void PianoRollEditor::paintNotes(juce::Graphics &g, juce::Rectangle<int> area)
         return;
     float noteH = static_cast<float>(area.getHeight()) / static_cast<float>(range);
 
-    for (const auto &note : clip->notes)
+    // Only the notes under the grid, padded by a pixel for rounding
+    clip->findNotesInRange(xToSample(area.getX() - 1, area.getX(), area.getWidth()) - clip->timelineStartSample,
+                           xToSample(area.getRight() + 1, area.getX(), area.getWidth()) - clip->timelineStartSample,
+                           lowestVisibleNote_ - 1, highestVisibleNote_, visibleNotes_);
+
+    for (auto position : visibleNotes_)
     {
+        const auto &note = clip->notes[position];
         SampleCount absStart = clip->timelineStartSample + note.startSample;
         SampleCount absEnd = absStart + note.lengthSamples;
 
@@ -311,23 +309,20 @@ void PianoRollEditor::paintVelocityLane(juce::Graphics &g, juce::Rectangle<int>
     if (!track)
         return;
 
-    const MidiClip *clip = nullptr;
-    for (const auto &mc : track->midiClips)
-    {
-        if (mc.id == clipId_)
-        {
-            clip = &mc;
-            break;
-        }
-    }
+    const auto *clip = track->findMidiClip(clipId_);
     if (!clip)
         return;
 
     int gridLeft = area.getX() + 56;
     int gridWidth = area.getWidth() - 56;
 
-    for (const auto &note : clip->notes)
+    clip->findNotesInRange(xToSample(area.getX() - 1, gridLeft, gridWidth) - clip->timelineStartSample,
+                           xToSample(area.getRight() + 1, gridLeft, gridWidth) - clip->timelineStartSample,
+                           0, 127, visibleNotes_);
+
+    for (auto position : visibleNotes_)
     {
+        const auto &note = clip->notes[position];
         SampleCount absStart = clip->timelineStartSample + note.startSample;
         int x = sampleToX(absStart, gridLeft, gridWidth);
         if (x < area.getX() || x > area.getRight())
@@ -488,25 +483,22 @@ void PianoRollEditor::autoFitToClip()
     if (!track)
         return;
 
-    for (const auto &mc : track->midiClips)
+    const auto *mc = track->findMidiClip(clipId_);
+    if (mc == nullptr || mc->notes.empty())
+        return;
+
+    int lo = mc->getLowestNote();
+    int hi = mc->getHighestNote();
+    lowestVisibleNote_ = std::max(0, lo - 4);
+    highestVisibleNote_ = std::min(127, hi + 4);
+
+    scrollSamples_ = mc->timelineStartSample;
+    int gridWidth = getWidth() - 56;
+    if (gridWidth > 0)
     {
-        if (mc.id == clipId_ && !mc.notes.empty())
-        {
-            int lo = mc.getLowestNote();
-            int hi = mc.getHighestNote();
-            lowestVisibleNote_ = std::max(0, lo - 4);
-            highestVisibleNote_ = std::min(127, hi + 4);
-
-            scrollSamples_ = mc.timelineStartSample;
-            int gridWidth = getWidth() - 56;
-            if (gridWidth > 0)
-            {
-                auto totalSamples = mc.getTimelineEndSample() - mc.timelineStartSample;
-                if (totalSamples > 0)
-                    pixelsPerSample_ = static_cast<double>(gridWidth) / static_cast<double>(totalSamples);
-            }
-            return;
-        }
+        auto totalSamples = mc->getTimelineEndSample() - mc->timelineStartSample;
+        if (totalSamples > 0)
+            pixelsPerSample_ = static_cast<double>(gridWidth) / static_cast<double>(totalSamples);
     }
 }
 
@@ -539,38 +531,25 @@ void PianoRollEditor::mouseDown(const juce::MouseEvent &e)
             auto *track = session_.getTrack(trackIndex_);
             if (track)
             {
-                for (auto &mc : track->midiClips)
+                if (auto *mc = track->findMidiClip(clipId_))
                 {
-                    if (mc.id == clipId_)
+                    // Check if there's already a note here — if so, erase it
+                    bool erased = false;
+                    if (auto hit = mc->findNoteAt(clickNote, clickSample - mc->timelineStartSample))
+                        erased = mc->removeNote(hit->id);
+                    if (!erased)
                     {
-                        // Check if there's already a note here — if so, erase it
-                        bool erased = false;
-                        for (auto it = mc.notes.begin(); it != mc.notes.end(); ++it)
-                        {
-                            SampleCount absStart = mc.timelineStartSample + it->startSample;
-                            SampleCount absEnd = absStart + it->lengthSamples;
-                            if (clickNote == it->noteNumber && clickSample >= absStart && clickSample < absEnd)
-                            {
-                                mc.notes.erase(it);
-                                erased = true;
-                                break;
-                            }
-                        }
-                        if (!erased)
-                        {
-                            MidiNote newNote;
-                            newNote.id = juce::Uuid().toString();
-                            newNote.noteNumber = clickNote;
-                            newNote.startSample = snapped - mc.timelineStartSample;
-                            newNote.lengthSamples = noteLen;
-                            newNote.velocity = 100;
-                            mc.notes.push_back(newNote);
-                        }
-                        if (onSessionChanged)
-                            onSessionChanged();
-                        repaint();
-                        return;
+                        MidiNote newNote;
+                        newNote.noteNumber = clickNote;
+                        newNote.startSample = snapped - mc->timelineStartSample;
+                        newNote.lengthSamples = noteLen;
+                        newNote.velocity = 100;
+                        mc->addNote(newNote);
                     }
+                    if (onSessionChanged)
+                        onSessionChanged();
+                    repaint();
+                    return;
                 }
             }
         }
@@ -583,27 +562,18 @@ void PianoRollEditor::mouseDown(const juce::MouseEvent &e)
             auto *track = session_.getTrack(trackIndex_);
             if (track)
             {
-                for (auto &mc : track->midiClips)
+                if (auto *mc = track->findMidiClip(clipId_))
                 {
-                    if (mc.id == clipId_)
+                    if (auto note = mc->findNoteAt(clickNote, clickSample - mc->timelineStartSample))
                     {
-                        for (const auto &note : mc.notes)
-                        {
-                            SampleCount absStart = mc.timelineStartSample + note.startSample;
-                            SampleCount absEnd = absStart + note.lengthSamples;
-                            if (clickNote == note.noteNumber && clickSample >= absStart && clickSample < absEnd)
-                            {
-                                selectedNoteIds_.insert(note.id);
-                                dragMode_ = DragMode::MovingNote;
-                                dragNoteId_ = note.id;
-                                dragStartSample_ = clickSample;
-                                dragStartNote_ = clickNote;
-                                dragNoteOrigStart_ = note.startSample;
-                                dragNoteOrigNote_ = note.noteNumber;
-                                break;
-                            }
-                        }
-                        break;
+                        selectedNoteIds_.insert(note->id);
+                        dragMode_ = DragMode::MovingNote;
+                        dragNoteId_ = note->id;
+                        dragStartSample_ = clickSample;
+                        dragStartNote_ = clickNote;
+                        dragNoteOrigStart_ = note->startSample;
+                        dragNoteOrigNote_ = note->noteNumber;
+                        commandManager_.beginGesture();
                     }
                 }
             }
@@ -623,26 +593,13 @@ void PianoRollEditor::mouseDrag(const juce::MouseEvent &e)
         SampleCount sampleDelta = currentSample - dragStartSample_;
         int noteDelta = currentNote - dragStartNote_;
 
-        auto *track = session_.getTrack(trackIndex_);
-        if (track)
-        {
-            for (auto &mc : track->midiClips)
-            {
-                if (mc.id == clipId_)
-                {
-                    for (auto &note : mc.notes)
-                    {
-                        if (note.id == dragNoteId_)
-                        {
-                            note.startSample = std::max(SampleCount(0), dragNoteOrigStart_ + sampleDelta);
-                            note.noteNumber = juce::jlimit(0, 127, dragNoteOrigNote_ + noteDelta);
-                            break;
-                        }
-                    }
-                    break;
-                }
-            }
-        }
+        // One command per step; the gesture opened in mouseDown() folds
+        // them into a single undo step
+        auto newStart = std::max(SampleCount(0), dragNoteOrigStart_ + sampleDelta);
+        auto newNote = juce::jlimit(0, 127, dragNoteOrigNote_ + noteDelta);
+        commandManager_.execute(std::make_unique<MoveMidiNoteCommand>(trackIndex_, clipId_, dragNoteId_,
+                                                                      newStart, newNote),
+                                session_);
         if (onSessionChanged)
             onSessionChanged();
         repaint();
@@ -651,8 +608,10 @@ void PianoRollEditor::mouseDrag(const juce::MouseEvent &e)
 
 void PianoRollEditor::mouseUp(const juce::MouseEvent &)
 {
+    if (dragMode_ == DragMode::MovingNote)
+        commandManager_.endGesture();
     dragMode_ = DragMode::None;
-    dragNoteId_.clear();
+    dragNoteId_ = 0;
 }
 
 void PianoRollEditor::mouseDoubleClick(const juce::MouseEvent &)
@@ -7,6 +7,7 @@
 #include "ui/Theme.hpp"
 #include <functional>
 #include <set>
+#include <vector>
 
 namespace ampl {
 
@@ -98,14 +99,15 @@ private:
 
     enum class DragMode { None, MovingNote, ResizingNote, DrawingNote, SelectBox, VelocityDrag };
     DragMode dragMode_{DragMode::None};
-    juce::String dragNoteId_;
+    MidiNoteId dragNoteId_{0};
     SampleCount dragStartSample_{0};
     int dragStartNote_{0};
     SampleCount dragNoteOrigStart_{0};
     int dragNoteOrigNote_{0};
     juce::Point<int> dragStartPoint_;
 
-    std::set<juce::String> selectedNoteIds_;
+    std::set<MidiNoteId> selectedNoteIds_;
+    std::vector<uint32_t> visibleNotes_; // Scratch for the note index queries in paint
 
     // Toolbar buttons — two-tool system like Logic
     juce::TextButton pointerToolBtn_;
@@ -1,6 +1,7 @@
 #include "ui/panels/mixer/MixerPanel.hpp"
 #include "commands/ClipCommands.hpp"
 #include "ui/Theme.hpp"
+#include <algorithm>
 
 namespace ampl
 {
@@ -27,6 +28,16 @@ ChannelStrip::ChannelStrip()
         if (onGainChanged)
             onGainChanged(trackIndex_, static_cast<float>(gainSlider_.getValue()));
     };
+    gainSlider_.onDragStart = [this]
+    {
+        if (onGestureStarted)
+            onGestureStarted();
+    };
+    gainSlider_.onDragEnd = [this]
+    {
+        if (onGestureEnded)
+            onGestureEnded();
+    };
     addAndMakeVisible(gainSlider_);
 
     panSlider_.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
@@ -40,6 +51,16 @@ ChannelStrip::ChannelStrip()
         if (onPanChanged)
             onPanChanged(trackIndex_, static_cast<float>(panSlider_.getValue()));
     };
+    panSlider_.onDragStart = [this]
+    {
+        if (onGestureStarted)
+            onGestureStarted();
+    };
+    panSlider_.onDragEnd = [this]
+    {
+        if (onGestureEnded)
+            onGestureEnded();
+    };
     addAndMakeVisible(panSlider_);
 
     muteButton_.setClickingTogglesState(true);
@@ -168,6 +189,8 @@ void ChannelStrip::setSoloed(bool soloed)
 
 void ChannelStrip::setPeakLevel(float pL, float pR)
 {
+    if (pL == peakL_ && pR == peakR_)
+        return;
     peakL_ = pL;
     peakR_ = pR;
     repaint();
@@ -182,6 +205,7 @@ MixerPanel::MixerPanel(Session &session, CommandManager &commandManager)
 {
     viewport_.setViewedComponent(&stripContainer_, false);
     viewport_.setScrollBarsShown(false, true);
+    viewport_.onVisibleAreaChanged = [this] { layoutVisibleStrips(); };
     addAndMakeVisible(viewport_);
 
     setupMasterStrip();
@@ -214,90 +238,118 @@ void MixerPanel::resized()
     // Separator between master and tracks
     area.removeFromRight(2);
 
-    // Track strips in viewport
-    int totalWidth = static_cast<int>(strips_.size()) * ChannelStrip::kStripWidth;
+    // Track strips in viewport: the container spans every track, the
+    // strips only the ones in view
+    int totalWidth = static_cast<int>(session_.getTracks().size()) * ChannelStrip::kStripWidth;
     stripContainer_.setSize(std::max(totalWidth, area.getWidth()), area.getHeight());
 
-    int x = 0;
-    for (auto &strip : strips_)
-    {
-        strip->setBounds(x, 0, ChannelStrip::kStripWidth, area.getHeight());
-        x += ChannelStrip::kStripWidth;
-    }
-
     viewport_.setBounds(area);
+    layoutVisibleStrips();
 }
 
 void MixerPanel::rebuildStrips()
 {
-    strips_.clear();
-    stripContainer_.removeAllChildren();
+    // Update master
+    masterGainSlider_.setValue(static_cast<double>(session_.getMasterGainDb()),
+                               juce::dontSendNotification);
+    masterPanSlider_.setValue(static_cast<double>(session_.getMasterPan()),
+                              juce::dontSendNotification);
 
-    const auto &tracks = session_.getTracks();
-    for (int i = 0; i < static_cast<int>(tracks.size()); ++i)
+    resized();
+}
+
+std::unique_ptr<ChannelStrip> MixerPanel::createStrip()
+{
+    // Callbacks take the track index the strip is bound to when they fire
+    auto strip = std::make_unique<ChannelStrip>();
+
+    strip->onGainChanged = [this](int idx, float db)
     {
-        auto strip = std::make_unique<ChannelStrip>();
-        strip->setTrackIndex(i);
-        strip->setTrackName(tracks[static_cast<size_t>(i)].name);
-        strip->setGainDb(tracks[static_cast<size_t>(i)].gainDb);
-        strip->setPan(tracks[static_cast<size_t>(i)].pan);
-        strip->setMuted(tracks[static_cast<size_t>(i)].muted);
-        strip->setSoloed(tracks[static_cast<size_t>(i)].solo);
-
-        strip->onGainChanged = [this](int idx, float db)
-        {
-            auto cmd = std::make_unique<SetTrackGainCommand>(idx, db);
-            commandManager_.execute(std::move(cmd), session_);
-            if (onSessionChanged)
-                onSessionChanged();
-        };
+        auto cmd = std::make_unique<SetTrackGainCommand>(idx, db);
+        commandManager_.execute(std::move(cmd), session_);
+        if (onSessionChanged)
+            onSessionChanged();
+    };
 
-        strip->onPanChanged = [this](int idx, float pan)
-        {
-            auto cmd = std::make_unique<SetTrackPanCommand>(idx, pan);
-            commandManager_.execute(std::move(cmd), session_);
-            if (onSessionChanged)
-                onSessionChanged();
-        };
+    strip->onPanChanged = [this](int idx, float pan)
+    {
+        auto cmd = std::make_unique<SetTrackPanCommand>(idx, pan);
+        commandManager_.execute(std::move(cmd), session_);
+        if (onSessionChanged)
+            onSessionChanged();
+    };
 
-        strip->onMuteToggled = [this](int idx, bool muted)
-        {
-            auto cmd = std::make_unique<SetTrackMuteCommand>(idx, muted);
-            commandManager_.execute(std::move(cmd), session_);
-            if (onSessionChanged)
-                onSessionChanged();
-        };
+    strip->onGestureStarted = [this] { commandManager_.beginGesture(); };
+    strip->onGestureEnded = [this] { commandManager_.endGesture(); };
 
-        strip->onSoloToggled = [this](int idx, bool solo)
-        {
-            auto cmd = std::make_unique<SetTrackSoloCommand>(idx, solo);
-            commandManager_.execute(std::move(cmd), session_);
-            if (onSessionChanged)
-                onSessionChanged();
-        };
+    strip->onMuteToggled = [this](int idx, bool muted)
+    {
+        auto cmd = std::make_unique<SetTrackMuteCommand>(idx, muted);
+        commandManager_.execute(std::move(cmd), session_);
+        if (onSessionChanged)
+            onSessionChanged();
+    };
 
-        strip->onRemoveTrack = [this](int idx)
-        {
-            if (session_.getTracks().size() <= 1)
-                return; // Don't remove the last track
-            auto cmd = std::make_unique<RemoveTrackCommand>(idx);
-            commandManager_.execute(std::move(cmd), session_);
-            rebuildStrips();
-            if (onSessionChanged)
-                onSessionChanged();
-        };
-
-        stripContainer_.addAndMakeVisible(strip.get());
-        strips_.push_back(std::move(strip));
-    }
+    strip->onSoloToggled = [this](int idx, bool solo)
+    {
+        auto cmd = std::make_unique<SetTrackSoloCommand>(idx, solo);
+        commandManager_.execute(std::move(cmd), session_);
+        if (onSessionChanged)
+            onSessionChanged();
+    };
 
-    // Update master
-    masterGainSlider_.setValue(static_cast<double>(session_.getMasterGainDb()),
-                               juce::dontSendNotification);
-    masterPanSlider_.setValue(static_cast<double>(session_.getMasterPan()),
-                              juce::dontSendNotification);
+    strip->onRemoveTrack = [this](int idx)
+    {
+        if (session_.getTracks().size() <= 1)
+            return; // Don't remove the last track
+        auto cmd = std::make_unique<RemoveTrackCommand>(idx);
+        commandManager_.execute(std::move(cmd), session_);
+        rebuildStrips();
+        if (onSessionChanged)
+            onSessionChanged();
+    };
 
-    resized();
+    return strip;
+}
+
+void MixerPanel::layoutVisibleStrips()
+{
+    const auto &tracks = session_.getTracks();
+    const int numTracks = static_cast<int>(tracks.size());
+    const int viewX = viewport_.getViewPositionX();
+    const int first = std::clamp(viewX / ChannelStrip::kStripWidth, 0, numTracks);
+    const int last = std::clamp((viewX + viewport_.getMaximumVisibleWidth()) / ChannelStrip::kStripWidth + 1,
+                                first, numTracks);
+
+    // Grow the pool to cover the view
+    while (static_cast<int>(strips_.size()) < last - first)
+    {
+        strips_.push_back(createStrip());
+        stripContainer_.addChildComponent(strips_.back().get());
+    }
+
+    // Bind strip n to track first + n; the rest of the pool hides
+    for (size_t slot = 0; slot < strips_.size(); ++slot)
+    {
+        auto &strip = *strips_[slot];
+        const int index = first + static_cast<int>(slot);
+        if (index >= last)
+        {
+            strip.setVisible(false);
+            continue;
+        }
+
+        const auto &track = tracks[static_cast<size_t>(index)];
+        strip.setTrackIndex(index);
+        strip.setTrackName(track.name);
+        strip.setGainDb(track.gainDb);
+        strip.setPan(track.pan);
+        strip.setMuted(track.muted);
+        strip.setSoloed(track.solo);
+        strip.setBounds(index * ChannelStrip::kStripWidth, 0, ChannelStrip::kStripWidth,
+                        stripContainer_.getHeight());
+        strip.setVisible(true);
+    }
 }
 
 void MixerPanel::updateMeters()
@@ -306,6 +358,8 @@ void MixerPanel::updateMeters()
     // per-track peak messages from the audio thread in a future milestone.
     for (auto &strip : strips_)
     {
+        if (!strip->isVisible())
+            continue;
         float pL = 0.0f, pR = 0.0f;
         // Decay existing peaks
         strip->setPeakLevel(pL, pR);
@@ -337,6 +391,8 @@ void MixerPanel::setupMasterStrip()
         if (onSessionChanged)
             onSessionChanged();
     };
+    masterGainSlider_.onDragStart = [this] { commandManager_.beginGesture(); };
+    masterGainSlider_.onDragEnd = [this] { commandManager_.endGesture(); };
     addAndMakeVisible(masterGainSlider_);
 
     masterPanSlider_.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
@@ -353,6 +409,8 @@ void MixerPanel::setupMasterStrip()
         if (onSessionChanged)
             onSessionChanged();
     };
+    masterPanSlider_.onDragStart = [this] { commandManager_.beginGesture(); };
+    masterPanSlider_.onDragEnd = [this] { commandManager_.endGesture(); };
     addAndMakeVisible(masterPanSlider_);
 }
 
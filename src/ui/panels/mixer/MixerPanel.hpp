@@ -34,6 +34,8 @@ public:
     std::function<void(int, bool)>  onMuteToggled;      // (trackIndex, muted)
     std::function<void(int, bool)>  onSoloToggled;      // (trackIndex, soloed)
     std::function<void(int)>        onRemoveTrack;      // (trackIndex)
+    std::function<void()>           onGestureStarted;   // Gain or pan drag began
+    std::function<void()>           onGestureEnded;
 
     static constexpr int kStripWidth = 80;
 
@@ -53,8 +55,10 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelStrip)
 };
 
-// The mixer panel: a row of ChannelStrips (one per track) + a master strip.
-// Shown at the bottom of the main window.
+// The mixer panel: a scrolling row of ChannelStrips + a master strip.
+// Shown at the bottom of the main window. Strips exist only for the tracks
+// in view: a pool sized to the viewport is rebound to other tracks as the
+// row scrolls, so layout, painting and metering cost O(visible strips).
 class MixerPanel : public juce::Component
 {
 public:
@@ -63,7 +67,7 @@ public:
     void paint(juce::Graphics& g) override;
     void resized() override;
 
-    // Rebuild channel strips from session state
+    // Resync the strips in view with session state (track list or values)
     void rebuildStrips();
 
     // Update peak meters (called from timer)
@@ -73,19 +77,34 @@ public:
     std::function<void()> onSessionChanged;
 
 private:
+    // Viewport that reports scrolling, so the strip pool can be rebound
+    class StripViewport : public juce::Viewport
+    {
+    public:
+        std::function<void()> onVisibleAreaChanged;
+
+        void visibleAreaChanged(const juce::Rectangle<int>&) override
+        {
+            if (onVisibleAreaChanged)
+                onVisibleAreaChanged();
+        }
+    };
+
     void setupMasterStrip();
+    std::unique_ptr<ChannelStrip> createStrip();
+    void layoutVisibleStrips();
 
     Session& session_;
     CommandManager& commandManager_;
 
-    std::vector<std::unique_ptr<ChannelStrip>> strips_;
+    std::vector<std::unique_ptr<ChannelStrip>> strips_; // Pool; hidden when not bound
 
     // Master strip controls
     juce::Label masterLabel_;
     juce::Slider masterGainSlider_;
     juce::Slider masterPanSlider_;
 
-    juce::Viewport viewport_;
+    StripViewport viewport_;
     juce::Component stripContainer_;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MixerPanel)
@@ -49,6 +49,8 @@ TrackInfoPanel::TrackInfoPanel(Session &session, CommandManager &commandManager)
     gainSlider_.setTextBoxStyle(juce::Slider::TextBoxRight, false, 56, 18);
     gainSlider_.onValueChange = [this]
     { commitTrackGain(static_cast<float>(gainSlider_.getValue())); };
+    gainSlider_.onDragStart = [this] { commandManager_.beginGesture(); };
+    gainSlider_.onDragEnd = [this] { commandManager_.endGesture(); };
     Theme::styleSlider(gainSlider_);
     addAndMakeVisible(gainSlider_);
 
@@ -63,6 +65,8 @@ TrackInfoPanel::TrackInfoPanel(Session &session, CommandManager &commandManager)
     panSlider_.setTextBoxStyle(juce::Slider::TextBoxRight, false, 56, 18);
     panSlider_.onValueChange = [this]
     { commitTrackPan(static_cast<float>(panSlider_.getValue())); };
+    panSlider_.onDragStart = [this] { commandManager_.beginGesture(); };
+    panSlider_.onDragEnd = [this] { commandManager_.endGesture(); };
     Theme::styleSlider(panSlider_);
     addAndMakeVisible(panSlider_);
 
@@ -1,6 +1,8 @@
 #include "ui/timeline/TimelineView.hpp"
+#include "commands/ClipCommands.hpp"
 #include <algorithm>
 #include <cmath>
+#include <type_traits>
 
 namespace
 {
@@ -20,13 +22,42 @@ HeaderActionRects getHeaderActionRects(juce::Rectangle<int> headerContentArea)
     rects.mute = actionRow.removeFromRight(buttonW);
     return rects;
 }
+
+// Running 64-bit FNV-1a over everything a cached lane image depends on
+class LaneSignature
+{
+  public:
+    template <typename T> void add(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        addBytes(&value, sizeof(T));
+    }
+
+    void add(const juce::String &text)
+    {
+        addBytes(text.toRawUTF8(), text.getNumBytesAsUTF8());
+        add(0);
+    }
+
+    uint64_t get() const { return hash_ != 0 ? hash_ : 1; } // 0 means "no image"
+
+  private:
+    void addBytes(const void *data, size_t size)
+    {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i)
+            hash_ = (hash_ ^ bytes[i]) * 1099511628211ull;
+    }
+
+    uint64_t hash_{14695981039346656037ull};
+};
 } // namespace
 
 namespace ampl
 {
 
-TimelineView::TimelineView(AudioEngine &engine, Session &session)
-    : engine_(engine), session_(session)
+TimelineView::TimelineView(AudioEngine &engine, Session &session, CommandManager &commandManager)
+    : engine_(engine), session_(session), commandManager_(commandManager)
 {
 }
 
@@ -39,8 +70,10 @@ void TimelineView::handleAudioMessage(const AudioToUIMessage &msg)
     case AudioToUIMessage::Type::PlayheadPosition:
         if (playheadPositionSamples_ != msg.intValue)
         {
+            // Only the playhead layer moves: repaint the columns it leaves and enters
+            playheadDirty_ = playheadDirty_.getUnion(getPlayheadBounds(playheadPositionSamples_));
             playheadPositionSamples_ = msg.intValue;
-            repaintPending_ = true;
+            playheadDirty_ = playheadDirty_.getUnion(getPlayheadBounds(playheadPositionSamples_));
         }
         break;
     case AudioToUIMessage::Type::PeakLevel:
@@ -56,6 +89,11 @@ void TimelineView::updateDisplay()
         repaint();
         repaintPending_ = false;
     }
+    else if (!playheadDirty_.isEmpty())
+    {
+        repaint(playheadDirty_);
+    }
+    playheadDirty_ = {};
 }
 
 // --- Coordinate conversion ---
@@ -86,6 +124,14 @@ int TimelineView::trackIndexAtY(int y) const
 
 // --- Vertical scroll ---
 
+juce::Range<int> TimelineView::getVisibleTrackRange() const
+{
+    const int numTracks = static_cast<int>(session_.getTracks().size());
+    const int first = std::clamp(verticalScrollOffset_ / kTrackHeight, 0, numTracks);
+    const int last = (verticalScrollOffset_ + getHeight() - kRulerHeight) / kTrackHeight;
+    return {first, std::clamp(last + 1, first, numTracks)};
+}
+
 int TimelineView::getTotalContentHeight() const
 {
     int numTracks = static_cast<int>(session_.getTracks().size());
@@ -227,25 +273,26 @@ void TimelineView::paint(juce::Graphics &g)
 
     // Ruler at top (always fixed, not affected by vertical scroll)
     auto rulerArea = bounds.removeFromTop(kRulerHeight);
-    paintRuler(g, rulerArea);
+    if (g.clipRegionIntersects(rulerArea))
+        paintRuler(g, rulerArea);
 
     // Clip to the track area so tracks don't draw over the ruler
     g.saveState();
     g.reduceClipRegion(bounds);
 
-    // Track lanes — offset by vertical scroll
+    // Track lanes — offset by vertical scroll, blitted from their cached
+    // images. Only the rows in view are visited, so the cost follows the
+    // view height rather than the track count.
     const auto &tracks = session_.getTracks();
-    for (int i = 0; i < static_cast<int>(tracks.size()); ++i)
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    const auto visibleTracks = getVisibleTrackRange();
+    for (int i = visibleTracks.getStart(); i < visibleTracks.getEnd(); ++i)
     {
         int laneTop = kRulerHeight + i * kTrackHeight - verticalScrollOffset_;
-        int laneBottom = laneTop + kTrackHeight;
-
-        // Skip tracks that are entirely off-screen
-        if (laneBottom < kRulerHeight || laneTop > getHeight())
-            continue;
-
         auto laneArea = juce::Rectangle<int>(0, laneTop, getWidth(), kTrackHeight);
-        paintTrackLane(g, laneArea, tracks[static_cast<size_t>(i)], i);
+        if (g.clipRegionIntersects(laneArea))
+            g.drawImage(getLaneImage(tracks[static_cast<size_t>(i)], i, laneArea, scale),
+                        laneArea.toFloat());
     }
 
     // Empty area below all tracks
@@ -288,6 +335,111 @@ void TimelineView::paint(juce::Graphics &g)
     paintScrollbars(g);
 }
 
+const juce::Image &TimelineView::getLaneImage(const TrackState &track, int trackIndex,
+                                              juce::Rectangle<int> area, float scale)
+{
+    // One slot per row that fits in the view: consecutive tracks never share
+    // a slot, and a row scrolled into view recycles the one that just left
+    const auto numSlots = static_cast<size_t>(getHeight() / kTrackHeight + 2);
+    if (laneCaches_.size() != numSlots)
+        laneCaches_.assign(numSlots, {});
+
+    auto &cache = laneCaches_[static_cast<size_t>(trackIndex) % numSlots];
+    const auto signature = getLaneSignature(track, trackIndex, area.getWidth(), scale);
+    if (cache.signature == signature && cache.image.isValid())
+        return cache.image;
+
+    const int imageWidth = juce::roundToInt(static_cast<float>(area.getWidth()) * scale);
+    const int imageHeight = juce::roundToInt(static_cast<float>(area.getHeight()) * scale);
+    if (cache.image.getWidth() != imageWidth || cache.image.getHeight() != imageHeight)
+        cache.image = juce::Image(juce::Image::ARGB, std::max(imageWidth, 1),
+                                  std::max(imageHeight, 1), true);
+    else
+        cache.image.clear(cache.image.getBounds());
+
+    // Drawn at the physical pixel scale, in the same coordinates as the view
+    laneIncomplete_ = false;
+    {
+        juce::Graphics imageGraphics(cache.image);
+        imageGraphics.addTransform(juce::AffineTransform::scale(scale));
+        imageGraphics.setOrigin({-area.getX(), -area.getY()});
+        paintTrackLane(imageGraphics, area, track, trackIndex);
+    }
+
+    // A lane drawn before its waveforms were ready is redrawn next time
+    cache.signature = laneIncomplete_ ? 0 : signature;
+    return cache.image;
+}
+
+uint64_t TimelineView::getLaneSignature(const TrackState &track, int trackIndex, int width,
+                                        float scale) const
+{
+    LaneSignature signature;
+
+    // View state the lane is drawn with
+    signature.add(width);
+    signature.add(scale);
+    signature.add(pixelsPerSample_);
+    signature.add(scrollPositionSamples_);
+    signature.add(trackIndex);
+    signature.add(selectedTrackIndex_ == trackIndex);
+    signature.add(session_.getBpm());
+    signature.add(session_.getSampleRate());
+    signature.add(session_.getTimeSigNumerator());
+
+    // Clip state flags, as paintClip() and paintMidiClip() read them
+    auto addClipFlags = [&](const juce::String &clipId)
+    {
+        const auto clipKey = clipId.toStdString();
+        signature.add(clipId == selectedClipId_);
+        signature.add(clipId == hoveredClipId_);
+        signature.add(mutedClipIds_.count(clipKey) > 0);
+        signature.add(lockedClipIds_.count(clipKey) > 0);
+    };
+
+    // The track itself
+    signature.add(track.name);
+    signature.add(track.type);
+    signature.add(track.muted);
+    signature.add(track.solo);
+
+    signature.add(track.clips.size());
+    for (const auto &clip : track.clips)
+    {
+        signature.add(clip.id);
+        signature.add(clip.asset.get());
+        signature.add(clip.timelineStartSample);
+        signature.add(clip.sourceStartSample);
+        signature.add(clip.sourceLengthSamples);
+        signature.add(clip.gainDb);
+        signature.add(clip.fadeInSamples);
+        signature.add(clip.fadeOutSamples);
+        addClipFlags(clip.id);
+    }
+
+    signature.add(track.midiClips.size());
+    for (const auto &clip : track.midiClips)
+    {
+        signature.add(clip.id);
+        signature.add(clip.name);
+        signature.add(clip.timelineStartSample);
+        signature.add(clip.lengthSamples);
+        signature.add(clip.notes.getRevision()); // O(1), however many notes
+        addClipFlags(clip.id);
+    }
+
+    return signature.get();
+}
+
+juce::Rectangle<int> TimelineView::getPlayheadBounds(SampleCount position) const
+{
+    // The line and its glow, the ruler triangle and the time bubble either side
+    const int x = sampleToPixelX(position);
+    auto line = juce::Rectangle<int>(x - 6, 0, 12, getHeight());
+    auto bubble = juce::Rectangle<int>(x - 90, 0, 180, kRulerHeight);
+    return line.getUnion(bubble).getIntersection(getLocalBounds());
+}
+
 void TimelineView::paintRuler(juce::Graphics &g, juce::Rectangle<int> area)
 {
     g.setColour(juce::Colour(ampl::Theme::toolbarBg));
@@ -756,76 +908,51 @@ void TimelineView::paintMidiClip(juce::Graphics &g, juce::Rectangle<int> area, c
 
 void TimelineView::paintWaveform(juce::Graphics &g, juce::Rectangle<int> area, const Clip &clip)
 {
-    if (!clip.asset || clip.asset->numChannels == 0)
+    if (!clip.asset || !clip.asset->hasSamples())
         return;
 
-    auto cacheKey = clip.id.toStdString();
-    auto &cache = waveformCaches_[cacheKey];
+    // Only the columns being repainted; pixel 0 of area is the clip's source start
+    auto visible = area.getIntersection(g.getClipBounds());
+    if (visible.isEmpty())
+        return;
 
-    // Regenerate if zoom changed or clip changed
-    if (cache.clipId != clip.id || std::abs(cache.pixelsPerSample - pixelsPerSample_) > 1e-10 ||
-        static_cast<int>(cache.peaks.size()) != area.getWidth() * 2)
-    {
-        generateWaveformPeaks(clip, cache, area.getWidth());
-    }
+    const int width = visible.getWidth();
+    const double samplesPerPixel = 1.0 / pixelsPerSample_;
+    const double firstSample = static_cast<double>(clip.sourceStartSample) +
+                               static_cast<double>(visible.getX() - area.getX()) * samplesPerPixel;
 
-    if (cache.peaks.empty())
+    waveformPeaks_.resize(static_cast<size_t>(width));
+    if (!PeakPyramid::getPeaks(*clip.asset, 0, firstSample, samplesPerPixel, waveformPeaks_.data(),
+                               width))
+    {
+        // Overview still being built: try again on the next display tick
+        laneIncomplete_ = true;
+        repaintPending_ = true;
         return;
+    }
 
     float midY = static_cast<float>(area.getCentreY());
     float halfHeight = static_cast<float>(area.getHeight()) * 0.45f;
 
-    g.setColour(juce::Colour(ampl::Theme::clipAudioWave));
+    const juce::Colour waveColour(ampl::Theme::clipAudioWave);
+    const juce::Colour rmsColour = waveColour.brighter(0.4f);
 
-    int numPeaks = static_cast<int>(cache.peaks.size()) / 2;
-    for (int i = 0; i < numPeaks && i < area.getWidth(); ++i)
+    for (int i = 0; i < width; ++i)
     {
-        float minVal = cache.peaks[static_cast<size_t>(i * 2)];
-        float maxVal = cache.peaks[static_cast<size_t>(i * 2 + 1)];
-
-        float y1 = midY - maxVal * halfHeight;
-        float y2 = midY - minVal * halfHeight;
-
-        g.drawVerticalLine(area.getX() + i, y1, y2);
-    }
-}
-
-void TimelineView::generateWaveformPeaks(const Clip &clip, WaveformCache &cache, int widthPixels)
-{
-    cache.clipId = clip.id;
-    cache.pixelsPerSample = pixelsPerSample_;
-    cache.peaks.clear();
-
-    if (!clip.asset || clip.asset->numChannels == 0 || widthPixels <= 0)
-        return;
-
-    cache.peaks.resize(static_cast<size_t>(widthPixels * 2), 0.0f);
+        const auto &peak = waveformPeaks_[static_cast<size_t>(i)];
+        const int x = visible.getX() + i;
 
-    const auto &channelData = clip.asset->channels[0]; // Use first channel
-    double samplesPerPixel = 1.0 / pixelsPerSample_;
+        g.setColour(waveColour);
+        g.drawVerticalLine(x, midY - peak.max * halfHeight, midY - peak.min * halfHeight);
 
-    for (int px = 0; px < widthPixels; ++px)
-    {
-        SampleCount startSample =
-            clip.sourceStartSample +
-            static_cast<SampleCount>(static_cast<double>(px) * samplesPerPixel);
-        SampleCount endSample =
-            clip.sourceStartSample +
-            static_cast<SampleCount>(static_cast<double>(px + 1) * samplesPerPixel);
-
-        startSample = std::max(startSample, SampleCount(0));
-        endSample = std::min(endSample, clip.asset->lengthInSamples);
-
-        float minVal = 0.0f, maxVal = 0.0f;
-        for (SampleCount s = startSample; s < endSample; ++s)
+        // RMS band, inside the min/max envelope
+        const float rmsTop = std::min(peak.rms, peak.max);
+        const float rmsBottom = std::max(-peak.rms, peak.min);
+        if (rmsTop > rmsBottom)
         {
-            float val = channelData[static_cast<size_t>(s)];
-            minVal = std::min(minVal, val);
-            maxVal = std::max(maxVal, val);
+            g.setColour(rmsColour);
+            g.drawVerticalLine(x, midY - rmsTop * halfHeight, midY - rmsBottom * halfHeight);
         }
-
-        cache.peaks[static_cast<size_t>(px * 2)] = minVal;
-        cache.peaks[static_cast<size_t>(px * 2 + 1)] = maxVal;
     }
 }
 
@@ -1139,7 +1266,10 @@ void TimelineView::mouseDown(const juce::MouseEvent &e)
                     else if (e.x > clipEndX - 8)
                         dragMode_ = DragMode::TrimRight;
                     else
+                    {
                         dragMode_ = DragMode::MovingClip;
+                        commandManager_.beginGesture();
+                    }
 
                     dragClipId_ = clip.id;
                     dragStartSample_ = clickSample;
@@ -1247,9 +1377,11 @@ void TimelineView::mouseDrag(const juce::MouseEvent &e)
         SampleCount delta = currentSample - dragStartSample_;
         SampleCount newStart = std::max(SampleCount(0), dragClipOriginalStart_ + delta);
 
-        if (auto *clip = session_.findClip(dragClipId_))
+        // One command per step; the gesture opened in mouseDown() folds
+        // them into a single undo step
+        if (session_.findClip(dragClipId_) != nullptr)
         {
-            clip->timelineStartSample = newStart;
+            commandManager_.execute(std::make_unique<MoveClipCommand>(dragClipId_, newStart), session_);
             if (onSessionChanged)
                 onSessionChanged();
             repaintPending_ = true;
@@ -1260,6 +1392,8 @@ void TimelineView::mouseDrag(const juce::MouseEvent &e)
 void TimelineView::mouseUp(const juce::MouseEvent & /*e*/)
 {
     scrollbarDrag_ = ScrollbarDrag::None;
+    if (dragMode_ == DragMode::MovingClip)
+        commandManager_.endGesture();
     dragMode_ = DragMode::None;
     dragClipId_ = {};
     repaintPending_ = true;
@@ -1410,8 +1544,6 @@ void TimelineView::mouseWheelMove(const juce::MouseEvent &e, const juce::MouseWh
 
 void TimelineView::resized()
 {
-    // Invalidate waveform caches on resize
-    waveformCaches_.clear();
     clampVerticalScroll();
     repaintPending_ = true;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "commands/CommandManager.hpp"
 #include "engine/core/AudioEngine.hpp"
 #include "model/MidiClip.hpp"
 #include "model/Session.hpp"
@@ -15,7 +16,7 @@ namespace ampl
 class TimelineView : public juce::Component
 {
   public:
-    TimelineView(AudioEngine &engine, Session &session);
+    TimelineView(AudioEngine &engine, Session &session, CommandManager &commandManager);
     ~TimelineView() override;
 
     void paint(juce::Graphics &g) override;
@@ -88,10 +89,12 @@ class TimelineView : public juce::Component
     void paintScrollbars(juce::Graphics &g);
 
     void clampVerticalScroll();
+    juce::Range<int> getVisibleTrackRange() const; // Tracks at least partly in view
     void ensureTrackVisible(int trackIndex);
 
     AudioEngine &engine_;
     Session &session_;
+    CommandManager &commandManager_;
 
     // View state
     double pixelsPerSample_{0.01}; // Zoom level
@@ -129,16 +132,27 @@ class TimelineView : public juce::Component
     SampleCount dragClipOriginalStart_{0};
     int dragTrackIndex_{-1};
 
-    // Waveform cache: per-clip peak data at current zoom level
-    struct WaveformCache
+    // Scratch for paintWaveform: one peak per visible pixel column
+    std::vector<PeakPyramid::Peak> waveformPeaks_;
+
+    // Layers: each lane (header, grid, clips) is cached as an image and
+    // redrawn only when the model or view state it depends on changes, as
+    // caught by its signature. The ruler, loop region and playhead are
+    // drawn live on top; playhead moves repaint only the area it covers.
+    struct LaneCache
     {
-        juce::String clipId;
-        double pixelsPerSample{0.0};
-        std::vector<float> peaks; // min/max interleaved
+        juce::Image image;
+        uint64_t signature{0}; // 0: redraw
     };
-    std::unordered_map<std::string, WaveformCache> waveformCaches_;
-
-    void generateWaveformPeaks(const Clip &clip, WaveformCache &cache, int widthPixels);
+    std::vector<LaneCache> laneCaches_;     // Slot: track index % number of slots
+    bool laneIncomplete_{false};            // Set while drawing a lane whose peaks aren't ready
+    juce::Rectangle<int> playheadDirty_;    // Playhead area to repaint on the next tick
+
+    const juce::Image &getLaneImage(const TrackState &track, int trackIndex,
+                                    juce::Rectangle<int> area, float scale);
+    uint64_t getLaneSignature(const TrackState &track, int trackIndex, int width,
+                              float scale) const;
+    juce::Rectangle<int> getPlayheadBounds(SampleCount position) const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimelineView)
 };
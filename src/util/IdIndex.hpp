@@ -0,0 +1,112 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace ampl {
+
+// Hash map from a string ID to where the object with that ID lives (an
+// index into a vector, say). The containers it indexes are edited directly
+// all over the code base, so the index never assumes it is up to date:
+// find() checks every hit against the container and rebuilds the whole map
+// once when the entry is stale. Owners call set() when they add or move
+// something to keep later lookups from rebuilding at all.
+//
+// A missing ID rebuilds only if the container may have changed since the
+// last rebuild: owners pass a generation they bump whenever they hand out
+// write access to the container, and a miss in a map built at the current
+// generation is final. Owners that cannot tell pass kUntracked, and every
+// miss rebuilds.
+//
+// Lookups are O(1) while the index is current, and a run of edits costs at
+// most one O(n) rebuild before lookups are O(1) again. Lookups lock, so
+// const lookups may run on several threads at once.
+//
+// Copies start out empty; most copies are undo snapshots that are never
+// searched, so copying the map would be wasted work.
+template <typename Location>
+class IdIndex
+{
+public:
+    static constexpr uint64_t kUntracked = 0;
+
+    IdIndex() = default;
+    IdIndex(const IdIndex&) {}
+    IdIndex& operator=(const IdIndex&)
+    {
+        clear();
+        return *this;
+    }
+    IdIndex(IdIndex&& other) noexcept
+    {
+        std::lock_guard<std::mutex> lock(other.mutex_);
+        locations_ = std::move(other.locations_);
+        builtAt_ = std::exchange(other.builtAt_, kUntracked);
+    }
+    IdIndex& operator=(IdIndex&& other) noexcept
+    {
+        if (this != &other)
+        {
+            std::scoped_lock lock(mutex_, other.mutex_);
+            locations_ = std::move(other.locations_);
+            builtAt_ = std::exchange(other.builtAt_, kUntracked);
+        }
+        return *this;
+    }
+
+    // isAt(location) is true if the object at location has the ID;
+    // forEach(add) calls add(id, location) for every object
+    template <typename IsAt, typename ForEach>
+    std::optional<Location> find(const juce::String& id, uint64_t generation, IsAt&& isAt,
+                                 ForEach&& forEach) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = locations_.find(id);
+        if (it != locations_.end() && isAt(it->second))
+            return it->second;
+
+        // Nothing changed since the map was complete: the ID does not exist
+        if (it == locations_.end() && generation != kUntracked && generation == builtAt_)
+            return std::nullopt;
+
+        locations_.clear();
+        forEach([this](const juce::String& key, Location location)
+                { locations_.insert_or_assign(key, location); });
+        builtAt_ = generation;
+
+        it = locations_.find(id);
+        if (it != locations_.end() && isAt(it->second))
+            return it->second;
+        return std::nullopt;
+    }
+
+    void set(const juce::String& id, Location location) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        locations_.insert_or_assign(id, location);
+    }
+
+    void clear() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        locations_.clear();
+        builtAt_ = kUntracked;
+    }
+
+private:
+    struct Hash
+    {
+        size_t operator()(const juce::String& s) const { return static_cast<size_t>(s.hashCode64()); }
+    };
+
+    mutable std::mutex mutex_;
+    mutable std::unordered_map<juce::String, Location, Hash> locations_;
+    mutable uint64_t builtAt_{kUntracked}; // Generation of the last rebuild
+};
+
+} // namespace ampl
@@ -300,6 +300,116 @@ TEST(E2EWorkflow, ProjectSaveEmbedsAudioData)
     tempDir.deleteRecursively();
 }
 
+TEST(E2EWorkflow, ProjectArchiveLoadsAudioInBackground)
+{
+    auto tempDir = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                       .getChildFile("ampl_archive_" + juce::Uuid().toString());
+    ASSERT_TRUE(tempDir.createDirectory());
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto sourceFile = createSineWaveTestFile(tempDir, "archive.wav", 44100.0, 22050);
+    ASSERT_TRUE(sourceFile.existsAsFile());
+
+    Session session;
+    const int audioTrackIndex = session.addTrack("Audio", TrackType::Audio);
+    const int midiTrackIndex = session.addTrack("Synth", TrackType::Midi);
+
+    auto asset = session.loadAudioAsset(sourceFile, formatManager);
+    ASSERT_TRUE(asset != nullptr);
+    ASSERT_TRUE(session.addClipToTrack(audioTrackIndex, Clip::fromAsset(asset, 0)));
+    ASSERT_TRUE(session.addClipToTrack(audioTrackIndex, Clip::fromAsset(asset, 44100)));
+
+    auto *midiTrack = session.getTrack(midiTrackIndex);
+    ASSERT_NE(midiTrack, nullptr);
+    midiTrack->midiClips.push_back(MidiClip::createEmpty(0, 88200));
+    for (int i = 0; i < 4; ++i)
+    {
+        MidiNote note;
+        note.noteNumber = 60 + i;
+        note.startSample = i * 11025;
+        note.lengthSamples = 5000;
+        midiTrack->midiClips[0].addNote(note);
+    }
+
+    PluginSlot fx;
+    fx.pluginName = "Delay";
+    fx.stateData = std::make_shared<const std::vector<uint8_t>>(std::vector<uint8_t>{1, 2, 3, 4});
+    midiTrack->pluginChain.push_back(fx);
+
+    auto projectFile = tempDir.getChildFile("archive.ampl");
+    ASSERT_TRUE(ProjectSerializer::save(session, projectFile));
+    EXPECT_TRUE(ProjectArchive::isArchive(projectFile));
+    ASSERT_TRUE(sourceFile.deleteFile());
+
+    Session loaded;
+    AssetLoader loader;
+    ASSERT_TRUE(ProjectSerializer::load(loaded, projectFile, formatManager, &loader));
+    ASSERT_EQ(loaded.getTracks().size(), 2u);
+
+    // Both clips share one asset, described before its samples are read
+    const auto &clips = loaded.getTrack(0)->clips;
+    ASSERT_EQ(clips.size(), 2u);
+    ASSERT_TRUE(clips[0].asset != nullptr);
+    EXPECT_EQ(clips[0].asset, clips[1].asset);
+    EXPECT_EQ(clips[0].asset->lengthInSamples, asset->lengthInSamples);
+    EXPECT_EQ(clips[0].asset->numChannels, 1);
+
+    clips[0].asset->waitUntilLoaded();
+    ASSERT_TRUE(clips[0].asset->hasSamples());
+    for (SampleCount i = 0; i < asset->lengthInSamples; i += 997)
+        EXPECT_FLOAT_EQ(clips[0].asset->channels[0][static_cast<size_t>(i)],
+                        asset->channels[0][static_cast<size_t>(i)]);
+
+    const auto *loadedMidi = loaded.getTrack(1);
+    ASSERT_EQ(loadedMidi->midiClips.size(), 1u);
+    ASSERT_EQ(loadedMidi->midiClips[0].notes.size(), 4u);
+    EXPECT_EQ(loadedMidi->midiClips[0].findNoteAt(62, 23000)->noteNumber, 62);
+    ASSERT_EQ(loadedMidi->pluginChain.size(), 1u);
+    ASSERT_TRUE(loadedMidi->pluginChain[0].hasState());
+    EXPECT_EQ(*loadedMidi->pluginChain[0].stateData, (std::vector<uint8_t>{1, 2, 3, 4}));
+
+    // Saving over the open archive, then exporting to JSON, keeps the audio
+    ASSERT_TRUE(ProjectSerializer::save(loaded, projectFile));
+    auto jsonFile = tempDir.getChildFile("exported.ampl");
+    ASSERT_TRUE(ProjectSerializer::exportJson(loaded, jsonFile));
+    EXPECT_FALSE(ProjectArchive::isArchive(jsonFile));
+
+    Session imported;
+    ASSERT_TRUE(ProjectSerializer::load(imported, jsonFile, formatManager));
+    ASSERT_EQ(imported.getTrack(0)->clips.size(), 2u);
+    EXPECT_TRUE(imported.getTrack(0)->clips[0].asset->hasSamples());
+    EXPECT_EQ(imported.getTrack(1)->midiClips[0].notes.size(), 4u);
+    EXPECT_TRUE(imported.getTrack(1)->pluginChain[0].hasState());
+
+    tempDir.deleteRecursively();
+}
+
+TEST(E2EWorkflow, ProjectArchiveRejectsTruncatedFile)
+{
+    auto tempDir = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                       .getChildFile("ampl_truncated_" + juce::Uuid().toString());
+    ASSERT_TRUE(tempDir.createDirectory());
+
+    Session session;
+    session.addTrack("Audio", TrackType::Audio);
+
+    auto projectFile = tempDir.getChildFile("truncated.ampl");
+    ASSERT_TRUE(ProjectSerializer::save(session, projectFile));
+
+    juce::MemoryBlock data;
+    ASSERT_TRUE(projectFile.loadFileAsData(data));
+    ASSERT_TRUE(projectFile.replaceWithData(data.getData(), data.getSize() - 1));
+
+    Session loaded;
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    EXPECT_FALSE(ProjectSerializer::load(loaded, projectFile, formatManager));
+
+    tempDir.deleteRecursively();
+}
+
 TEST(E2EWorkflow, Phase1Workflow_CreateImportAddMidiAndBounce)
 {
     auto workspaceDir = juce::File::getSpecialLocation(juce::File::tempDirectory)
@@ -145,19 +145,19 @@ TEST_F(AudioProcessorTest, CompressorNodeCanProcess) {
     AudioBuffer input(inputChannels, 1, kTestBufferSize);
     AudioBuffer output(outputChannels, 1, kTestBufferSize);
 
-    // Process
+    // Process once to settle the detector, then measure
     compressorNode_->process(input, output, kTestBufferSize, 0);
+    compressorNode_->process(input, output, kTestBufferSize, kTestBufferSize);
 
-    // Verify compression occurred (output should have lower peak/RMS ratio)
+    // The signal sits above the threshold, so peaks and level both come down
     float inputPeak = TestUtilities::calculatePeak(inputBuffer.data(), kTestBufferSize);
     float outputPeak = TestUtilities::calculatePeak(outputBuffer.data(), kTestBufferSize);
     float inputRMS = TestUtilities::calculateRMS(inputBuffer.data(), kTestBufferSize);
     float outputRMS = TestUtilities::calculateRMS(outputBuffer.data(), kTestBufferSize);
 
-    float inputRatio = inputPeak / (inputRMS + 1e-6f);
-    float outputRatio = outputPeak / (outputRMS + 1e-6f);
-
-    EXPECT_LT(outputRatio, inputRatio); // Compression should reduce ratio
+    EXPECT_LT(outputPeak, inputPeak);
+    EXPECT_LT(outputRMS, inputRMS);
+    EXPECT_LT(compressorNode_->getGainReductionDb(), 0.0f);
 }
 
 // Plugin Host Tests
@@ -543,7 +543,7 @@ TEST_F(RealIOFixture, SessionRendererPluginChain)
     note.velocity = 0.8f;
     note.startSample = 0;
     note.lengthSamples = 22050; // half second
-    midiClip.notes.push_back(note);
+    midiClip.addNote(note);
     track->midiClips.push_back(midiClip);
 
     std::cout << "[FullPath] Session configured. Publishing...\n";
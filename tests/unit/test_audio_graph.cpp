@@ -0,0 +1,404 @@
+#include <gtest/gtest.h>
+#include "engine/graph/AudioGraph.hpp"
+#include "engine/graph/AudioProcessors.hpp"
+#include "engine/graph/Automation.hpp"
+#include "engine/graph/GraphCompiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using namespace ampl;
+
+namespace {
+
+float calculatePeak(const float* audio, int numSamples) {
+    float peak = 0.0f;
+    for (int i = 0; i < numSamples; ++i)
+        peak = std::max(peak, std::abs(audio[i]));
+    return peak;
+}
+
+} // namespace
+
+TEST(AudioGraph, CompiledPlanSumsParallelBranches) {
+    AudioGraph graph;
+    graph.beginUpdate();
+    graph.addNode(std::make_shared<GainNode>("input"));
+    graph.addNode(std::make_shared<GainNode>("left_branch"));
+    graph.addNode(std::make_shared<GainNode>("right_branch"));
+    graph.addNode(std::make_shared<MixerNode>("mix"));
+    graph.addConnection(AudioConnection{"input", "left_branch"});
+    graph.addConnection(AudioConnection{"input", "right_branch"});
+    graph.addConnection(AudioConnection{"left_branch", "mix"});
+    graph.addConnection(AudioConnection{"right_branch", "mix"});
+    graph.endUpdate();
+    graph.prepareToPlay(44100.0, 64);
+
+    // Larger than the prepared block size: processed in sub-blocks
+    std::vector<float> inL(200, 0.5f), inR(200, 0.5f), outL(200, 0.0f), outR(200, 0.0f);
+    float* inputChannels[] = {inL.data(), inR.data()};
+    float* outputChannels[] = {outL.data(), outR.data()};
+    AudioBuffer input(inputChannels, 2, 200);
+    AudioBuffer output(outputChannels, 2, 200);
+
+    graph.process(input, output, 200, 0);
+
+    // Each centre-panned stage scales by cos(pi/4); two branches are summed
+    const float stage = std::cos(juce::MathConstants<float>::pi / 4.0f);
+    const float expected = 0.5f * stage * stage * 2.0f * stage;
+    EXPECT_NEAR(outL.front(), expected, 1e-4f);
+    EXPECT_NEAR(outL.back(), expected, 1e-4f);
+    EXPECT_NEAR(outR[150], expected, 1e-4f);
+}
+
+TEST(AudioGraph, WideMixerReusesBufferSlots) {
+    constexpr int kTracks = 64;
+    AudioGraph graph;
+    graph.beginUpdate();
+    graph.addNode(std::make_shared<GainNode>("input"));
+    graph.addNode(std::make_shared<MixerNode>("mix"));
+    for (int t = 0; t < kTracks; ++t) {
+        const auto id = std::to_string(t);
+        graph.addNode(std::make_shared<EQNode>("eq" + id));
+        graph.addNode(std::make_shared<TrackOutputNode>("out" + id));
+        graph.addConnection(AudioConnection{"input", "eq" + id});
+        graph.addConnection(AudioConnection{"eq" + id, "out" + id});
+        graph.addConnection(AudioConnection{"out" + id, "mix"});
+    }
+    graph.endUpdate();
+    graph.prepareToPlay(44100.0, 128);
+
+    // One slot per node would be 2 * kTracks + 2
+    const auto info = graph.getPlanInfo();
+    EXPECT_EQ(info.numSteps, 2 * kTracks + 2);
+    EXPECT_LE(info.numBufferSlots, 4);
+
+    std::vector<float> inL(128, 0.5f), inR(128, 0.5f), outL(128, 0.0f), outR(128, 0.0f);
+    float* inputChannels[] = {inL.data(), inR.data()};
+    float* outputChannels[] = {outL.data(), outR.data()};
+    AudioBuffer input(inputChannels, 2, 128);
+    AudioBuffer output(outputChannels, 2, 128);
+    graph.process(input, output, 128, 0);
+
+    const float stage = std::cos(juce::MathConstants<float>::pi / 4.0f);
+    EXPECT_NEAR(outL[64], 0.5f * stage * stage * kTracks * stage, 1e-2f);
+}
+
+TEST(AudioGraph, ParallelSchedulerMatchesSerialOutput) {
+    constexpr int kTracks = 16;
+    std::vector<float> results;
+
+    for (int threads : {1, 4}) {
+        AudioGraph graph;
+        graph.setNumProcessingThreads(threads);
+        graph.beginUpdate();
+        graph.addNode(std::make_shared<GainNode>("input"));
+        graph.addNode(std::make_shared<MixerNode>("mix"));
+        for (int t = 0; t < kTracks; ++t) {
+            const auto id = std::to_string(t);
+            graph.addNode(std::make_shared<EQNode>("eq" + id));
+            graph.addNode(std::make_shared<TrackOutputNode>("out" + id));
+            graph.addConnection(AudioConnection{"input", "eq" + id});
+            graph.addConnection(AudioConnection{"eq" + id, "out" + id});
+            graph.addConnection(AudioConnection{"out" + id, "mix"});
+        }
+        graph.endUpdate();
+        graph.prepareToPlay(44100.0, 128);
+
+        // Independent track chains: parallelism is bounded by the track count
+        EXPECT_GT(graph.getPlanInfo().maxParallelism, 4.0f);
+
+        std::vector<float> inL(128, 0.5f), inR(128, 0.5f), outL(128, 0.0f), outR(128, 0.0f);
+        float* inputChannels[] = {inL.data(), inR.data()};
+        float* outputChannels[] = {outL.data(), outR.data()};
+        AudioBuffer input(inputChannels, 2, 128);
+        AudioBuffer output(outputChannels, 2, 128);
+        for (int block = 0; block < 8; ++block)
+            graph.process(input, output, 128, block * 128);
+
+        EXPECT_EQ(graph.getParallelStats().numThreads, threads);
+        results.push_back(outL[100]);
+    }
+
+    EXPECT_NEAR(results[0], results[1], 1e-5f);
+}
+
+TEST(AudioGraph, LatencyCompensationAlignsParallelPaths) {
+    auto lookahead = std::make_shared<LatencyCompensatorNode>("lookahead");
+    lookahead->setDelaySamples(10);
+
+    AudioGraph graph;
+    graph.beginUpdate();
+    graph.addNode(std::make_shared<GainNode>("input"));
+    graph.addNode(lookahead);
+    graph.addNode(std::make_shared<MixerNode>("mix"));
+    graph.addConnection(AudioConnection{"input", "lookahead"});
+    graph.addConnection(AudioConnection{"input", "mix"});
+    graph.addConnection(AudioConnection{"lookahead", "mix"});
+    graph.endUpdate();
+    graph.prepareToPlay(44100.0, 64);
+
+    // The direct path gets a delay node matching the 10-sample path
+    EXPECT_EQ(graph.getTotalLatency(), 10);
+    EXPECT_EQ(graph.getPlanInfo().numSteps, 4);
+    EXPECT_EQ(graph.getAllNodes().size(), 3u);
+
+    std::vector<float> inL(64, 0.0f), inR(64, 0.0f), outL(64, 0.0f), outR(64, 0.0f);
+    inL[0] = inR[0] = 1.0f;
+    float* inputChannels[] = {inL.data(), inR.data()};
+    float* outputChannels[] = {outL.data(), outR.data()};
+    AudioBuffer input(inputChannels, 2, 64);
+    AudioBuffer output(outputChannels, 2, 64);
+    graph.process(input, output, 64, 0);
+
+    // Both copies of the impulse arrive together
+    for (int i = 0; i < 64; ++i) {
+        if (i != 10) {
+            EXPECT_EQ(outL[i], 0.0f) << "sample " << i;
+        }
+    }
+    EXPECT_GT(outL[10], 0.0f);
+
+    // A latency change is picked up on the next update
+    lookahead->setDelaySamples(200);
+    graph.updateLatencyCompensation();
+    EXPECT_EQ(graph.getTotalLatency(), 200);
+}
+
+TEST(AudioGraph, OutputNodeIsTheGraphOutputWhateverSortsLast) {
+    std::vector<float> results;
+    for (bool extraSinks : {false, true}) {
+        for (int threads : {1, 2}) {
+            AudioGraph graph;
+            graph.beginUpdate();
+            graph.addNode(std::make_shared<GainNode>("input"));
+            graph.addNode(std::make_shared<MixerNode>("mix"));
+            graph.addConnection(AudioConnection{"input", "mix"});
+            if (extraSinks) {
+                // A louder meter tap and an unconnected node, both leaves
+                auto meter = std::make_shared<GainNode>("meter");
+                meter->setParameterValue("gain", 2.0f);
+                graph.addNode(meter);
+                graph.addNode(std::make_shared<GainNode>("orphan"));
+                graph.addConnection(AudioConnection{"input", "meter"});
+                graph.setOutputNode("mix");
+            }
+            graph.endUpdate();
+            graph.setNumProcessingThreads(threads);
+            graph.prepareToPlay(44100.0, 64);
+
+            std::vector<float> inL(64, 0.5f), inR(64, 0.5f), outL(64, 0.0f), outR(64, 0.0f);
+            float* inputChannels[] = {inL.data(), inR.data()};
+            float* outputChannels[] = {outL.data(), outR.data()};
+            AudioBuffer input(inputChannels, 2, 64);
+            AudioBuffer output(outputChannels, 2, 64);
+            graph.process(input, output, 64, 0);
+            results.push_back(outL[32]);
+        }
+    }
+
+    ASSERT_GT(results[0], 0.0f);
+    for (float result : results) {
+        EXPECT_NEAR(result, results[0], 1e-6f);
+    }
+}
+
+TEST(AudioGraph, FusesLinearGainChainsAndSplicesBypassedNodes) {
+    AudioGraph graph;
+    graph.beginUpdate();
+    graph.addNode(std::make_shared<GainNode>("input"));
+    graph.addNode(std::make_shared<GainNode>("gain"));
+    graph.addNode(std::make_shared<EQNode>("eq"));
+    graph.addNode(std::make_shared<TrackOutputNode>("out"));
+    graph.addNode(std::make_shared<MixerNode>("mix"));
+    graph.addConnection(AudioConnection{"input", "gain"});
+    graph.addConnection(AudioConnection{"gain", "eq"});
+    graph.addConnection(AudioConnection{"eq", "out"});
+    graph.addConnection(AudioConnection{"out", "mix"});
+    graph.endUpdate();
+    graph.prepareToPlay(44100.0, 64);
+
+    // [input, gain] -> eq -> [out, mix]
+    EXPECT_EQ(graph.getPlanInfo().numSteps, 3);
+
+    // Without the EQ the whole channel is one gain kernel
+    graph.setNodeBypassed("eq", true);
+    EXPECT_EQ(graph.getPlanInfo().numSteps, 1);
+
+    std::vector<float> inL(100, 0.5f), inR(100, 0.5f), outL(100, 0.0f), outR(100, 0.0f);
+    float* inputChannels[] = {inL.data(), inR.data()};
+    float* outputChannels[] = {outL.data(), outR.data()};
+    AudioBuffer input(inputChannels, 2, 100);
+    AudioBuffer output(outputChannels, 2, 100);
+    graph.process(input, output, 100, 0);
+
+    // Four centre-panned stages
+    const float stage = std::cos(juce::MathConstants<float>::pi / 4.0f);
+    const float expected = 0.5f * stage * stage * stage * stage;
+    EXPECT_NEAR(outL.front(), expected, 1e-5f);
+    EXPECT_NEAR(outR.back(), expected, 1e-5f);
+}
+
+TEST(AudioGraph, SidechainKeysCompressorAndLookaheadIsCompensated) {
+    auto key = std::make_shared<GainNode>("key");
+    key->setParameterValue("gain", 2.0f);
+    auto quiet = std::make_shared<GainNode>("quiet");
+    quiet->setParameterValue("gain", 0.03f);
+    auto compressor = std::make_shared<CompressorNode>("compressor");
+    compressor->setParameterValue("lookahead", 1.0f);
+
+    AudioGraph graph;
+    graph.beginUpdate();
+    graph.addNode(std::make_shared<GainNode>("input"));
+    graph.addNode(key);
+    graph.addNode(quiet);
+    graph.addNode(compressor);
+    graph.addNode(std::make_shared<MixerNode>("mix"));
+    graph.addConnection(AudioConnection{"input", "key"});
+    graph.addConnection(AudioConnection{"input", "quiet"});
+    graph.addConnection(AudioConnection{"quiet", "compressor"});
+    graph.addConnection(AudioConnection{"key", "compressor", -1, -1, true});
+    graph.addConnection(AudioConnection{"compressor", "mix"});
+    graph.endUpdate();
+    graph.prepareToPlay(44100.0, 256);
+
+    // The look-ahead is reported as latency
+    EXPECT_EQ(graph.getTotalLatency(), 44);
+
+    const int numSamples = 4410;
+    std::vector<float> inL(numSamples), inR(numSamples), outL(numSamples, 0.0f), outR(numSamples, 0.0f);
+    for (int i = 0; i < numSamples; ++i) {
+        inL[static_cast<size_t>(i)] = inR[static_cast<size_t>(i)] =
+            0.9f * std::sin(2.0f * juce::MathConstants<float>::pi * 1000.0f * i / 44100.0f);
+    }
+    float* inputChannels[] = {inL.data(), inR.data()};
+    float* outputChannels[] = {outL.data(), outR.data()};
+    AudioBuffer input(inputChannels, 2, numSamples);
+    AudioBuffer output(outputChannels, 2, numSamples);
+    graph.process(input, output, numSamples, 0);
+
+    // The quiet path is far below the threshold; only the loud key can duck it
+    EXPECT_LT(compressor->getGainReductionDb(), -6.0f);
+    const float stage = std::cos(juce::MathConstants<float>::pi / 4.0f);  // Centre pan
+    const float uncompressed = 0.9f * 0.03f * stage * stage * stage;
+    EXPECT_LT(calculatePeak(outL.data() + numSamples / 2, numSamples / 2),
+              uncompressed * 0.5f);
+
+    // A longer look-ahead set through the graph re-aligns the paths
+    graph.setNodeParameter("compressor", "lookahead", 2.0f);
+    EXPECT_EQ(graph.getTotalLatency(), 88);
+}
+
+TEST(AudioGraph, RoutingEditsSwapPlansWithFade) {
+    AudioGraph graph;
+    graph.setPlanSwapFade(100);
+    graph.beginUpdate();
+    graph.addNode(std::make_shared<GainNode>("input"));
+    graph.addNode(std::make_shared<GainNode>("a"));
+    graph.addNode(std::make_shared<MixerNode>("mix"));
+    graph.addConnection(AudioConnection{"input", "a"});
+    graph.addConnection(AudioConnection{"a", "mix"});
+    graph.endUpdate();
+    graph.prepareToPlay(44100.0, 64);
+
+    std::vector<float> inL(64, 0.5f), inR(64, 0.5f), outL(64, 0.0f), outR(64, 0.0f);
+    float* inputChannels[] = {inL.data(), inR.data()};
+    float* outputChannels[] = {outL.data(), outR.data()};
+    AudioBuffer input(inputChannels, 2, 64);
+    AudioBuffer output(outputChannels, 2, 64);
+
+    std::vector<float> rendered;
+    for (int block = 0; block < 12; ++block) {
+        if (block == 4) {
+            // A second parallel path doubles the level once the new plan is in
+            graph.beginUpdate();
+            graph.addNode(std::make_shared<GainNode>("b"));
+            graph.addConnection(AudioConnection{"input", "b"});
+            graph.addConnection(AudioConnection{"b", "mix"});
+            graph.endUpdate();
+            graph.waitForPlan();
+        }
+        graph.process(input, output, 64, block * 64);
+        rendered.insert(rendered.end(), outL.begin(), outL.end());
+    }
+
+    // The old plan fades out over 100 samples and the new one fades in
+    const float before = rendered[255];
+    EXPECT_GT(before, 0.0f);
+    EXPECT_NEAR(rendered[256 + 100], 0.0f, 1e-6f);
+    EXPECT_NEAR(rendered.back(), 2.0f * before, 1e-5f);
+
+    float maxStep = 0.0f;
+    for (size_t i = 1; i < rendered.size(); ++i) {
+        maxStep = std::max(maxStep, std::abs(rendered[i] - rendered[i - 1]));
+    }
+    EXPECT_LT(maxStep, 1.01f * 2.0f * before / 100.0f);
+}
+
+TEST(AudioGraph, PlansReplacedDuringFadeAreNotFreedOnAudioThread) {
+    // Counts nodes whose last reference went inside process()
+    static bool processing = false;
+    static int destroyedWhileProcessing = 0;
+    struct TrackedNode : GainNode {
+        using GainNode::GainNode;
+        ~TrackedNode() override { destroyedWhileProcessing += processing ? 1 : 0; }
+    };
+
+    AudioGraph graph;
+    graph.setPlanSwapFade(256);
+    graph.beginUpdate();
+    graph.addNode(std::make_shared<GainNode>("input"));
+    graph.addNode(std::make_shared<MixerNode>("mix"));
+    graph.addConnection(AudioConnection{"input", "mix"});
+    graph.endUpdate();
+    graph.prepareToPlay(44100.0, 64);
+
+    std::vector<float> inL(64, 0.5f), inR(64, 0.5f), outL(64, 0.0f), outR(64, 0.0f);
+    float* inputChannels[] = {inL.data(), inR.data()};
+    float* outputChannels[] = {outL.data(), outR.data()};
+    AudioBuffer input(inputChannels, 2, 64);
+    AudioBuffer output(outputChannels, 2, 64);
+
+    // Removing the node while the plan adding it is still fading in retires
+    // that plan; the fade then finishes with no compile in between, retiring
+    // the old active plan too. The node's last owner is a retired plan.
+    for (int edit = 0; edit < 8; ++edit) {
+        const auto id = "tracked" + std::to_string(edit);
+        graph.addNode(std::make_shared<TrackedNode>(id));
+        graph.waitForPlan();
+        processing = true;
+        graph.process(input, output, 64, edit * 768);
+        processing = false;
+
+        graph.removeNode(id);
+        graph.waitForPlan();
+        processing = true;
+        for (int block = 1; block < 12; ++block) {
+            graph.process(input, output, 64, edit * 768 + block * 64);
+        }
+        processing = false;
+    }
+    EXPECT_EQ(destroyedWhileProcessing, 0);
+}
+
+TEST(AudioGraph, AutomationIsBoundByParameterIndex) {
+    auto gain = std::make_shared<GainNode>("gain");
+    AudioGraph graph;
+    graph.addNode(gain);
+    EXPECT_EQ(gain->getAutomationSnapshot(GainNode::kGainParameter), nullptr);
+
+    auto lane = std::make_shared<AutomationLane>();
+    lane->addPoint(AutomationPoint{0, 0.25f, 0.0f});
+    graph.setAutomationLane("gain", "gain", lane);
+
+    const auto* snapshot = gain->getAutomationSnapshot(GainNode::kGainParameter);
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_FLOAT_EQ(snapshot->getValueAt(1000), 0.25f);
+    EXPECT_EQ(gain->getAutomationSnapshot(GainNode::kPanParameter), nullptr);
+
+    // Later edits are published without recompiling
+    lane->addPoint(AutomationPoint{1000, 0.75f, 0.0f});
+    snapshot = gain->getAutomationSnapshot(GainNode::kGainParameter);
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_FLOAT_EQ(snapshot->getValueAt(1000), 0.75f);
+}
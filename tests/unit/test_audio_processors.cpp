@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include "engine/graph/AudioProcessors.hpp"
+#include "engine/graph/Automation.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace ampl;
+
+namespace {
+
+float calculateRMS(const float* audio, int numSamples) {
+    float sum = 0.0f;
+    for (int i = 0; i < numSamples; ++i)
+        sum += audio[i] * audio[i];
+    return std::sqrt(sum / static_cast<float>(numSamples));
+}
+
+float calculatePeak(const float* audio, int numSamples) {
+    float peak = 0.0f;
+    for (int i = 0; i < numSamples; ++i)
+        peak = std::max(peak, std::abs(audio[i]));
+    return peak;
+}
+
+} // namespace
+
+class AudioProcessorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        gainNode_ = std::make_unique<GainNode>("test_gain");
+        eqNode_ = std::make_unique<EQNode>("test_eq");
+        compressorNode_ = std::make_unique<CompressorNode>("test_compressor");
+
+        gainNode_->prepareToPlay(kTestSampleRate, kTestBufferSize);
+        eqNode_->prepareToPlay(kTestSampleRate, kTestBufferSize);
+        compressorNode_->prepareToPlay(kTestSampleRate, kTestBufferSize);
+    }
+
+    std::unique_ptr<GainNode> gainNode_;
+    std::unique_ptr<EQNode> eqNode_;
+    std::unique_ptr<CompressorNode> compressorNode_;
+
+    const int kTestSampleRate = 44100;
+    const int kTestBufferSize = 512;
+};
+
+TEST_F(AudioProcessorTest, ParametersAreAddressedByInternedId) {
+    const ParameterId bandGain = ParameterId::intern("band2_gain");
+    EXPECT_EQ(ParameterId::intern("band2_gain"), bandGain);
+    EXPECT_EQ(ParameterId::find("band2_gain"), bandGain);
+    EXPECT_EQ(bandGain.name(), "band2_gain");
+    EXPECT_FALSE(ParameterId::find("no_such_parameter").isValid());
+
+    eqNode_->setParameter(bandGain, 6.0f);
+    EXPECT_FLOAT_EQ(eqNode_->getParameterValue("band2_gain"), 6.0f);
+    EXPECT_FLOAT_EQ(eqNode_->getBand(2).gain, 6.0f);
+    EXPECT_FLOAT_EQ(eqNode_->getBand(1).gain, 0.0f);
+
+    // Unknown names resolve to an invalid handle and are ignored
+    eqNode_->setParameterValue("no_such_parameter", 1.0f);
+    EXPECT_EQ(eqNode_->getParameterIndex(bandGain), 9);
+    EXPECT_EQ(eqNode_->getParameterIndex("no_such_parameter"), -1);
+}
+
+TEST_F(AudioProcessorTest, EQNodeFiltersChannelsIndependently) {
+    constexpr int kSamples = 4800;
+    eqNode_->prepareToPlay(48000.0, 512);
+    eqNode_->setParameterValue("band2_gain", 12.0f);  // 1 kHz peak
+
+    // Tone on the left only: the right channel must stay silent
+    std::vector<float> left(kSamples), right(kSamples, 0.0f);
+    for (int i = 0; i < kSamples; ++i) {
+        left[static_cast<size_t>(i)] = 0.1f * std::sin(2.0f * juce::MathConstants<float>::pi * 1000.0f * i / 48000.0f);
+    }
+    float* channels[] = {left.data(), right.data()};
+    AudioBuffer buffer(channels, 2, kSamples);
+    eqNode_->process(buffer, buffer, kSamples, 0);
+
+    float leftPeak = 0.0f;
+    for (int i = kSamples / 2; i < kSamples; ++i) {
+        leftPeak = std::max(leftPeak, std::abs(left[static_cast<size_t>(i)]));
+    }
+    EXPECT_NEAR(juce::Decibels::gainToDecibels(leftPeak / 0.1f), 12.0f, 0.1f);
+    EXPECT_EQ(calculateRMS(right.data(), kSamples), 0.0f);
+}
+
+TEST_F(AudioProcessorTest, EQBandsFollowAutomation) {
+    constexpr int kSamples = 4800;
+    constexpr int kBlock = 480;
+    eqNode_->prepareToPlay(48000.0, kBlock);
+
+    // Automation, not the static value, drives the band
+    auto lane = std::make_shared<AutomationLane>();
+    lane->addPoint(AutomationPoint{0, 12.0f, 0.0f});
+    const int bandGain = eqNode_->getParameterIndex("band2_gain");
+    eqNode_->bindAutomation(bandGain, lane.get());
+
+    std::vector<float> left(kSamples), right(kSamples);
+    for (int i = 0; i < kSamples; ++i) {
+        left[static_cast<size_t>(i)] = 0.1f * std::sin(2.0f * juce::MathConstants<float>::pi * 1000.0f * i / 48000.0f);
+    }
+    right = left;
+    for (int start = 0; start < kSamples; start += kBlock) {
+        float* channels[] = {left.data() + start, right.data() + start};
+        AudioBuffer buffer(channels, 2, kBlock);
+        eqNode_->process(buffer, buffer, kBlock, start);
+    }
+
+    float peak = 0.0f;
+    for (int i = kSamples / 2; i < kSamples; ++i) {
+        peak = std::max(peak, std::abs(left[static_cast<size_t>(i)]));
+    }
+    EXPECT_NEAR(juce::Decibels::gainToDecibels(peak / 0.1f), 12.0f, 0.1f);
+    EXPECT_FLOAT_EQ(eqNode_->getBand(2).gain, 0.0f);
+
+    eqNode_->bindAutomation(bandGain, nullptr);
+}
+
+TEST_F(AudioProcessorTest, LimiterHoldsCeilingWithLookahead) {
+    LimiterNode limiter("limiter");
+    limiter.setParameterValue("ceiling", -6.0f);
+    limiter.setParameterValue("lookahead", 2.0f);
+    limiter.prepareToPlay(kTestSampleRate, kTestBufferSize);
+    EXPECT_EQ(limiter.getLatencySamples(), 88);
+
+    std::vector<float> left(kTestBufferSize), right(kTestBufferSize);
+    float* channels[] = {left.data(), right.data()};
+    AudioBuffer buffer(channels, 2, kTestBufferSize);
+
+    // A loud tone with single-sample spikes, which a look-ahead limiter must catch
+    float outputPeak = 0.0f;
+    for (int block = 0; block < 8; ++block) {
+        for (int i = 0; i < kTestBufferSize; ++i) {
+            const int n = block * kTestBufferSize + i;
+            left[static_cast<size_t>(i)] = 0.9f * std::sin(2.0f * juce::MathConstants<float>::pi * 440.0f * n / kTestSampleRate);
+            right[static_cast<size_t>(i)] = (n % 300 == 0) ? 2.0f : 0.1f;
+        }
+        limiter.process(buffer, buffer, kTestBufferSize, block * kTestBufferSize);
+        outputPeak = std::max({outputPeak,
+                               calculatePeak(left.data(), kTestBufferSize),
+                               calculatePeak(right.data(), kTestBufferSize)});
+    }
+
+    EXPECT_LE(outputPeak, juce::Decibels::decibelsToGain(-6.0f));
+    EXPECT_GT(outputPeak, juce::Decibels::decibelsToGain(-7.0f));
+}
+
+TEST_F(AudioProcessorTest, OversampledNodeReportsLatencyAndPassesBand) {
+    auto limiter = std::make_shared<LimiterNode>("limiter");
+    OversampledNode node(limiter, 4);
+    EXPECT_EQ(node.getId(), "limiter");
+    EXPECT_EQ(node.getType(), AudioNode::Type::Limiter);
+
+    // Forwarded to the limiter, which runs at 4x the session rate
+    node.setParameterValue("ceiling", -6.0f);
+    node.setParameterValue("lookahead", 1.0f);
+    EXPECT_FLOAT_EQ(limiter->getParameterValue("ceiling"), -6.0f);
+    node.prepareToPlay(kTestSampleRate, kTestBufferSize);
+    EXPECT_EQ(node.getFactor(), 4);
+
+    // The filters' round trip plus the look-ahead (176 samples at 4x)
+    const int latency = node.getLatencySamples();
+    EXPECT_EQ(latency, 61 + 44);
+
+    // A tone under the ceiling comes out unchanged, delayed by the latency
+    const int numBlocks = 8;
+    std::vector<float> reference(static_cast<size_t>(numBlocks * kTestBufferSize));
+    std::vector<float> left(kTestBufferSize), right(kTestBufferSize);
+    float* channels[] = {left.data(), right.data()};
+    AudioBuffer buffer(channels, 2, kTestBufferSize);
+
+    float maxError = 0.0f;
+    for (int block = 0; block < numBlocks; ++block) {
+        for (int i = 0; i < kTestBufferSize; ++i) {
+            const int n = block * kTestBufferSize + i;
+            reference[static_cast<size_t>(n)] = 0.1f * std::sin(2.0f * juce::MathConstants<float>::pi * 1000.0f * n / kTestSampleRate);
+            left[static_cast<size_t>(i)] = right[static_cast<size_t>(i)] = reference[static_cast<size_t>(n)];
+        }
+        node.process(buffer, buffer, kTestBufferSize, block * kTestBufferSize);
+        for (int i = 0; i < kTestBufferSize; ++i) {
+            const int n = block * kTestBufferSize + i;
+            if (n >= 2 * latency) {
+                maxError = std::max(maxError, std::abs(left[static_cast<size_t>(i)] - reference[static_cast<size_t>(n - latency)]));
+            }
+        }
+    }
+
+    EXPECT_LT(maxError, 1.0e-3f);
+}
+
+TEST_F(AudioProcessorTest, LatencyCompensatorCrossfadesAndGrowsWithoutRestart) {
+    LatencyCompensatorNode delay("delay");
+    delay.setDelaySamples(100);
+    delay.prepareToPlay(kTestSampleRate, kTestBufferSize);
+    const int capacity = delay.getMaxDelaySamples();
+
+    std::vector<float> left(kTestBufferSize), right(kTestBufferSize);
+    float* channels[] = {left.data(), right.data()};
+    AudioBuffer buffer(channels, 2, kTestBufferSize);
+
+    // A slow tone on the left, a ramp on the right
+    const float step = 2.0f * juce::MathConstants<float>::pi * 100.0f / kTestSampleRate;
+    float previous = 0.0f;
+    float maxJump = 0.0f;
+    float maxRampError = 0.0f;
+    const int newDelay = capacity + 1000;
+    for (int block = 0; block < 32; ++block) {
+        if (block == 4) {
+            delay.setDelaySamples(150);
+        }
+        if (block == 12) {
+            // Past the ring's capacity: a larger ring is swapped in during playback
+            delay.setDelaySamples(newDelay);
+        }
+        for (int i = 0; i < kTestBufferSize; ++i) {
+            const int n = block * kTestBufferSize + i;
+            left[static_cast<size_t>(i)] = std::sin(step * n);
+            right[static_cast<size_t>(i)] = static_cast<float>(n);
+        }
+        delay.process(buffer, buffer, kTestBufferSize, block * kTestBufferSize);
+
+        for (int i = 0; i < kTestBufferSize; ++i) {
+            const int n = block * kTestBufferSize + i;
+            if (n > 100 && block < 12) {
+                maxJump = std::max(maxJump, std::abs(left[static_cast<size_t>(i)] - previous));
+            }
+            previous = left[static_cast<size_t>(i)];
+            if (n >= 12 * kTestBufferSize + newDelay) {
+                maxRampError = std::max(maxRampError, std::abs(right[static_cast<size_t>(i)] - static_cast<float>(n - newDelay)));
+            }
+        }
+    }
+
+    // The 50-sample change crossfades instead of jumping
+    EXPECT_LT(maxJump, 2.0f * step);
+    EXPECT_GE(delay.getMaxDelaySamples(), newDelay);
+    EXPECT_EQ(delay.getLatencySamples(), newDelay);
+    EXPECT_EQ(maxRampError, 0.0f);
+}
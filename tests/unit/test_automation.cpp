@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "engine/graph/Automation.hpp"
+#include <thread>
+
+using namespace ampl;
+
+class AutomationTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        lane_ = std::make_unique<AutomationLane>();
+    }
+
+    std::unique_ptr<AutomationLane> lane_;
+};
+
+TEST_F(AutomationTest, EditsPublishNewSnapshots) {
+    const AutomationSnapshot* empty = lane_->getSnapshot();
+    ASSERT_NE(empty, nullptr);
+    EXPECT_TRUE(empty->points.empty());
+
+    lane_->addPoint(AutomationPoint{0, 0.0f, 0.0f});
+    lane_->addPoint(AutomationPoint{44100, 1.0f, 0.0f});
+
+    const AutomationSnapshot* snapshot = lane_->getSnapshot();
+    EXPECT_NE(snapshot, empty);
+    EXPECT_EQ(snapshot->points.size(), 2u);
+    EXPECT_NEAR(snapshot->getValueAt(22050), 0.5f, 0.01f);
+    EXPECT_FLOAT_EQ(snapshot->getValueAt(-100), 0.0f);
+    EXPECT_FLOAT_EQ(snapshot->getValueAt(90000), 1.0f);
+}
+
+TEST_F(AutomationTest, ReplacedSnapshotsOutliveEveryReadersBlock) {
+    lane_->addPoint(AutomationPoint{0, 0.5f, 0.0f});
+
+    // Two graphs: the first is mid-block while the second runs several
+    AutomationReader first;
+    AutomationReader second;
+    first.beginBlock();
+    const AutomationSnapshot* seen = lane_->getSnapshot();
+
+    lane_->addPoint(AutomationPoint{1000, 1.0f, 0.0f});
+    for (int block = 0; block < 4; ++block) {
+        second.beginBlock();
+        EXPECT_FLOAT_EQ(lane_->getSnapshot()->getValueAt(1000), 1.0f);
+        second.endBlock();
+        lane_->addPoint(AutomationPoint{2000 + block, 0.0f, 0.0f});
+    }
+    lane_->reclaimRetired();
+
+    // Still readable (ASan would flag a use after free here)
+    ASSERT_EQ(seen->points.size(), 1u);
+    EXPECT_FLOAT_EQ(seen->getValueAt(5000), 0.5f);
+    first.endBlock();
+    lane_->reclaimRetired();
+}
+
+TEST_F(AutomationTest, RenderBlockMatchesPointEvaluation) {
+    lane_->addPoint(AutomationPoint{1000, 0.0f, 0.0f});
+    lane_->addPoint(AutomationPoint{3000, 1.0f, 2.0f});
+    lane_->addPoint(AutomationPoint{9000, 0.25f, 0.0f});
+
+    // Consecutive blocks crossing hold, curved and linear segments
+    std::vector<float> block(512);
+    AutomationCursor cursor;
+    const auto* snapshot = lane_->getSnapshot();
+    for (SampleCount start = 0; start < 12000; start += 512) {
+        const bool constant = lane_->renderBlock(cursor, start, 512, block.data());
+        bool allEqual = true;
+        for (int i = 0; i < 512; ++i) {
+            EXPECT_NEAR(block[static_cast<size_t>(i)], snapshot->getValueAt(start + i), 1e-4f)
+                << "sample " << start + i;
+            allEqual = allEqual && block[static_cast<size_t>(i)] == block[0];
+        }
+        if (constant) {
+            EXPECT_TRUE(allEqual);
+        }
+    }
+
+    // Blocks entirely before the first or after the last point are constant
+    EXPECT_TRUE(lane_->renderBlock(cursor, 0, 512, block.data()));
+    EXPECT_FLOAT_EQ(block[0], 0.0f);
+    EXPECT_TRUE(lane_->renderBlock(cursor, 20000, 512, block.data()));
+    EXPECT_FLOAT_EQ(block[511], 0.25f);
+    EXPECT_FALSE(lane_->renderBlock(cursor, 5000, 512, block.data()));
+
+    // Cursor lookups agree with searching, forward and after a jump back
+    AutomationCursor lookup;
+    for (SampleCount position : {0, 999, 1000, 2000, 3000, 3001, 8999, 9000, 12000, 2500, 2600}) {
+        EXPECT_FLOAT_EQ(snapshot->getValueAt(lookup, position), snapshot->getValueAt(position))
+            << "position " << position;
+    }
+}
+
+TEST_F(AutomationTest, TouchWritingMergesThinnedPass) {
+    lane_->addPoint(AutomationPoint{0, 1.0f, 0.0f});
+    lane_->addPoint(AutomationPoint{100000, 1.0f, 0.0f});
+
+    auto& recorder = lane_->getRecorder();
+    recorder.setMode(AutomationWriteMode::Touch);
+    recorder.setTolerance(0.01f);
+
+    float value = 0.0f;
+    EXPECT_FALSE(recorder.capture(0, value));
+
+    // A linear fader move captured once per 256-sample block
+    recorder.beginTouch(0.5f);
+    for (int block = 0; block < 100; ++block) {
+        recorder.setValue(0.5f + 0.002f * static_cast<float>(block));
+        EXPECT_TRUE(recorder.capture(10240 + block * 256, value));
+    }
+    recorder.endTouch();
+    EXPECT_FALSE(recorder.capture(40000, value));
+
+    EXPECT_TRUE(recorder.merge());
+
+    // The ramp thins to its end points, pinned to the old curve on both sides
+    const auto& points = lane_->getPoints();
+    EXPECT_EQ(points.size(), 6u);
+    EXPECT_FLOAT_EQ(lane_->getValueAt(5000), 1.0f);
+    EXPECT_NEAR(lane_->getValueAt(10240 + 50 * 256), 0.6f, 0.01f);
+    EXPECT_FLOAT_EQ(lane_->getValueAt(60000), 1.0f);
+    EXPECT_EQ(lane_->getSnapshot()->points.size(), points.size());
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include "commands/ClipCommands.hpp"
+#include "commands/CommandManager.hpp"
+#include "commands/MidiCommands.hpp"
+#include "model/Session.hpp"
+
+using namespace ampl;
+
+TEST(CommandManager, GesturesMergeAndHistoryStaysInBudget) {
+    Session session;
+    const int index = session.addTrack("Bass");
+    CommandManager commandManager;
+
+    // A fader drag undoes in one step, back to where it started
+    commandManager.beginGesture();
+    for (int step = 1; step <= 20; ++step)
+        commandManager.execute(std::make_unique<SetTrackGainCommand>(index, -0.5f * step), session);
+    commandManager.endGesture();
+    EXPECT_EQ(commandManager.getUndoStackSize(), 1);
+    EXPECT_FLOAT_EQ(session.getTrack(index)->gainDb, -10.0f);
+
+    // The next edit is a step of its own, though it targets the same fader
+    commandManager.execute(std::make_unique<SetTrackGainCommand>(index, -3.0f), session);
+    EXPECT_EQ(commandManager.getUndoStackSize(), 2);
+    commandManager.undo(session);
+    commandManager.undo(session);
+    EXPECT_FLOAT_EQ(session.getTrack(index)->gainDb, 0.0f);
+    commandManager.redo(session);
+    EXPECT_FLOAT_EQ(session.getTrack(index)->gainDb, -10.0f);
+
+    // The oldest steps go once the history is over budget
+    commandManager.clear();
+    commandManager.setMemoryBudget(10 * Command::kSmallCommandBytes);
+    for (int i = 0; i < 50; ++i)
+        commandManager.execute(std::make_unique<SetTrackMuteCommand>(index, i % 2 == 0), session);
+    EXPECT_EQ(commandManager.getUndoStackSize(), 10);
+    EXPECT_LE(commandManager.getMemoryUsage(), 10 * Command::kSmallCommandBytes);
+}
+
+TEST(CommandManager, LargeUndoPayloadsSpillToDisk) {
+    Session session;
+    const int index = session.addMidiTrack("Keys");
+    auto clip = MidiClip::createEmpty(0, 48000 * 600);
+    for (int i = 0; i < 50000; ++i) {
+        MidiNote note;
+        note.noteNumber = 36 + (i % 48);
+        note.startSample = i * 500;
+        note.lengthSamples = 400;
+        clip.addNote(note);
+    }
+    const auto clipId = clip.id;
+    session.getTrack(index)->midiClips.push_back(std::move(clip));
+
+    const auto spillDir = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                              .getChildFile("ampl_undo_spill_test");
+    spillDir.deleteRecursively();
+
+    {
+        CommandManager commandManager;
+        commandManager.setSpillDirectory(spillDir);
+        commandManager.execute(std::make_unique<RemoveMidiClipCommand>(index, clipId), session);
+        const auto heldBytes = commandManager.getMemoryUsage();
+        EXPECT_GE(heldBytes, CommandManager::kSpillThresholdBytes);
+
+        // Once the removal is far enough back, its notes move to disk
+        for (size_t i = 0; i < CommandManager::kSpillDepth; ++i)
+            commandManager.execute(std::make_unique<SetTrackGainCommand>(index, -1.0f * i), session);
+        EXPECT_LT(commandManager.getMemoryUsage(), heldBytes / 10);
+        EXPECT_EQ(spillDir.getNumberOfChildFiles(juce::File::findFiles), 1);
+
+        // and come back on undo
+        while (commandManager.canUndo())
+            commandManager.undo(session);
+        const auto* restored = session.getTrack(index)->findMidiClip(clipId);
+        ASSERT_NE(restored, nullptr);
+        EXPECT_EQ(restored->notes.size(), 50000u);
+        EXPECT_EQ(restored->findNoteAt(36 + 7, 7 * 500 + 100)->startSample, 7 * 500);
+        EXPECT_EQ(spillDir.getNumberOfChildFiles(juce::File::findFiles), 0);
+    }
+
+    spillDir.deleteRecursively();
+}
+
+TEST(CommandManager, UnreadableSpillRefusesUndo) {
+    Session session;
+    const int index = session.addMidiTrack("Keys");
+    auto clip = MidiClip::createEmpty(0, 48000 * 600);
+    for (int i = 0; i < 50000; ++i) {
+        MidiNote note;
+        note.startSample = i * 500;
+        note.lengthSamples = 400;
+        clip.addNote(note);
+    }
+    const auto clipId = clip.id;
+    session.getTrack(index)->midiClips.push_back(std::move(clip));
+
+    const auto spillDir = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                              .getChildFile("ampl_undo_unreadable_spill_test");
+    spillDir.deleteRecursively();
+
+    {
+        CommandManager commandManager;
+        commandManager.setSpillDirectory(spillDir);
+        commandManager.execute(std::make_unique<RemoveMidiClipCommand>(index, clipId), session);
+        for (size_t i = 0; i < CommandManager::kSpillDepth; ++i)
+            commandManager.execute(std::make_unique<SetTrackGainCommand>(index, -1.0f * i), session);
+        const auto spillFiles = spillDir.findChildFiles(juce::File::findFiles, false);
+        ASSERT_EQ(spillFiles.size(), 1);
+
+        juce::MemoryBlock payload;
+        ASSERT_TRUE(spillFiles[0].loadFileAsData(payload));
+        ASSERT_TRUE(spillFiles[0].replaceWithData(payload.getData(), payload.getSize() / 2));
+
+        // A truncated spill must not undo into an empty clip
+        for (size_t i = 0; i < CommandManager::kSpillDepth; ++i)
+            EXPECT_TRUE(commandManager.undo(session));
+        EXPECT_FALSE(commandManager.undo(session));
+        EXPECT_TRUE(commandManager.canUndo());
+        EXPECT_EQ(session.getTrack(index)->findMidiClip(clipId), nullptr);
+
+        // and the entry is still there once the file reads again
+        ASSERT_TRUE(spillFiles[0].replaceWithData(payload.getData(), payload.getSize()));
+        EXPECT_TRUE(commandManager.undo(session));
+        const auto* restored = session.getTrack(index)->findMidiClip(clipId);
+        ASSERT_NE(restored, nullptr);
+        EXPECT_EQ(restored->notes.size(), 50000u);
+    }
+
+    spillDir.deleteRecursively();
+}
+
+TEST(CommandManager, SharedUndoPayloadsCountInFull) {
+    Session session;
+    const int index = session.addMidiTrack("Keys");
+    auto clip = MidiClip::createEmpty(0, 48000 * 60);
+    for (int i = 0; i < 10000; ++i) {
+        MidiNote note;
+        note.startSample = i * 100;
+        note.lengthSamples = 50;
+        clip.addNote(note);
+    }
+    const auto clipId = clip.id;
+    const auto noteBytes = clip.notes.getMemoryUsage();
+    session.getTrack(index)->midiClips.push_back(std::move(clip));
+
+    // A copy still shares the notes when the removal is pushed (as a
+    // pending publish would); the entry is charged for them anyway, since
+    // it becomes their only owner once the copy goes
+    auto copy = std::make_unique<Session::Snapshot>(session.takeSnapshot());
+    CommandManager commandManager;
+    commandManager.execute(std::make_unique<RemoveMidiClipCommand>(index, clipId), session);
+    EXPECT_GE(commandManager.getMemoryUsage(), noteBytes);
+    copy.reset();
+
+    commandManager.setMemoryBudget(noteBytes / 2);
+    commandManager.execute(std::make_unique<SetTrackGainCommand>(index, -1.0f), session);
+    EXPECT_EQ(commandManager.getUndoStackSize(), 1);
+}
+
+TEST(CommandManager, TransactionsUndoAsOneStep) {
+    Session session;
+    const int first = session.addTrack("A");
+    const int second = session.addTrack("B");
+    CommandManager commandManager;
+    int notifications = 0;
+    commandManager.onStateChanged = [&notifications] { ++notifications; };
+
+    {
+        CommandManager::ScopedTransaction transaction(commandManager, "Paste Track Settings");
+        commandManager.execute(std::make_unique<SetTrackGainCommand>(first, -6.0f), session);
+        commandManager.execute(std::make_unique<SetTrackPanCommand>(first, 0.5f), session);
+        commandManager.execute(std::make_unique<SetTrackMuteCommand>(second, true), session);
+        EXPECT_EQ(notifications, 0);
+    }
+    EXPECT_EQ(notifications, 1); // Listeners hear once per transaction
+    EXPECT_EQ(commandManager.getUndoStackSize(), 1);
+    EXPECT_EQ(commandManager.getUndoDescription(), "Paste Track Settings");
+
+    ASSERT_TRUE(commandManager.undo(session));
+    EXPECT_FLOAT_EQ(session.getTrack(first)->gainDb, 0.0f);
+    EXPECT_FLOAT_EQ(session.getTrack(first)->pan, 0.0f);
+    EXPECT_FALSE(session.getTrack(second)->muted);
+    ASSERT_TRUE(commandManager.redo(session));
+    EXPECT_FLOAT_EQ(session.getTrack(first)->pan, 0.5f);
+    EXPECT_TRUE(session.getTrack(second)->muted);
+
+    // A transaction of one command records that command
+    {
+        CommandManager::ScopedTransaction transaction(commandManager, "Unused");
+        commandManager.execute(std::make_unique<SetTrackSoloCommand>(second, true), session);
+    }
+    EXPECT_EQ(commandManager.getUndoStackSize(), 2);
+    EXPECT_EQ(commandManager.getUndoDescription(), "Solo Track");
+}
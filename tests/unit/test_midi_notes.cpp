@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include "model/MidiClip.hpp"
+#include "model/MidiNoteIndex.hpp"
+#include "model/MidiNoteList.hpp"
+#include <algorithm>
+
+using namespace ampl;
+
+TEST(MidiNoteIndex, QueriesFollowNoteEdits) {
+    MidiClip clip;
+    MidiNote longNote;
+    longNote.noteNumber = 60;
+    longNote.startSample = 0;
+    longNote.lengthSamples = 100000;
+    const auto longId = clip.addNote(longNote);
+
+    for (int i = 0; i < 100; ++i) {
+        MidiNote note;
+        note.noteNumber = 60 + (i % 12);
+        note.startSample = i * 1000;
+        note.lengthSamples = 500;
+        clip.addNote(note);
+    }
+
+    std::vector<uint32_t> visible;
+    clip.findNotesInRange(10200, 12100, 60, 61, visible);
+    ASSERT_EQ(visible.size(), 2u); // The long note and the one at 12000
+    EXPECT_EQ(clip.notes.getId(visible[0]), longId);
+    EXPECT_EQ(clip.notes.getStart(visible[1]), 12000);
+
+    // The later of two overlapping notes wins the hit test
+    ASSERT_TRUE(clip.findNoteAt(60, 12100).has_value());
+    EXPECT_EQ(clip.findNoteAt(60, 12100)->startSample, 12000);
+    EXPECT_EQ(clip.findNoteAt(60, 12700)->id, longId);
+    EXPECT_FALSE(clip.findNoteAt(61, 12100).has_value());
+
+    // Removing and moving notes keeps the index in step
+    ASSERT_TRUE(clip.removeNote(longId));
+    EXPECT_FALSE(clip.findNoteAt(60, 12700).has_value());
+    const auto movedId = clip.findNoteAt(60, 12100)->id;
+    ASSERT_TRUE(clip.updateNote(movedId, [](MidiNote& note) { note.noteNumber = 100; }));
+    EXPECT_FALSE(clip.findNoteAt(60, 12100).has_value());
+    EXPECT_EQ(clip.findNoteAt(100, 12100)->id, movedId);
+    EXPECT_EQ(clip.getHighestNote(), 100);
+}
+
+TEST(MidiNoteIndex, LongNotesDoNotWidenQueries) {
+    // One note spans the whole clip, under thousands of short ones
+    MidiClip clip;
+    MidiNote longNote;
+    longNote.noteNumber = 60;
+    longNote.startSample = 0;
+    longNote.lengthSamples = 10000000;
+    const auto longId = clip.addNote(longNote);
+
+    juce::Random random(7);
+    for (int i = 0; i < 5000; ++i) {
+        MidiNote note;
+        note.noteNumber = 60;
+        note.startSample = random.nextInt(10000000);
+        note.lengthSamples = 1 + random.nextInt(i % 100 == 0 ? 200000 : 2000);
+        clip.addNote(note);
+    }
+
+    // Every query matches a scan of the notes
+    auto check = [&clip](SampleCount start, SampleCount end) {
+        std::vector<uint32_t> found;
+        clip.findNotesInRange(start, end, 60, 60, found);
+        std::vector<uint32_t> expected;
+        int64_t latest = -1;
+        for (uint32_t p = 0; p < clip.notes.size(); ++p) {
+            if (clip.notes.getStart(p) < end && clip.notes.getEnd(p) > start)
+                expected.push_back(p);
+            if (clip.notes.getStart(p) <= start && clip.notes.getEnd(p) > start &&
+                (latest < 0 || clip.notes.getStart(p) >= clip.notes.getStart(static_cast<uint32_t>(latest))))
+                latest = p;
+        }
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected);
+
+        auto hit = clip.findNoteAt(60, start);
+        ASSERT_EQ(hit.has_value(), latest >= 0);
+        if (hit)
+            EXPECT_EQ(hit->startSample, clip.notes.getStart(static_cast<uint32_t>(latest)));
+    };
+
+    for (int i = 0; i < 200; ++i) {
+        const SampleCount start = random.nextInt(10000000);
+        check(start, start + random.nextInt(50000));
+    }
+
+    ASSERT_TRUE(clip.removeNote(longId));
+    for (int i = 0; i < 200; ++i) {
+        const SampleCount start = random.nextInt(10000000);
+        check(start, start + random.nextInt(50000));
+    }
+}
+
+TEST(MidiNoteList, IdsStayValidAcrossRemovalAndClone) {
+    MidiClip clip;
+    std::vector<MidiNoteId> ids;
+    for (int i = 0; i < 10; ++i) {
+        MidiNote note;
+        note.noteNumber = 40 + i;
+        note.startSample = i * 100;
+        note.lengthSamples = 50;
+        ids.push_back(clip.addNote(note));
+    }
+
+    // Removal moves the last note into the hole; lookups by id still work
+    MidiNote removed;
+    ASSERT_TRUE(clip.removeNote(ids[2], &removed));
+    EXPECT_EQ(removed.noteNumber, 42);
+    EXPECT_FALSE(clip.findNote(ids[2]).has_value());
+    EXPECT_EQ(clip.findNote(ids[9])->noteNumber, 49);
+
+    // Ids are not reused, but a removed note can be put back under its id
+    MidiNote fresh;
+    EXPECT_NE(clip.addNote(fresh), ids[2]);
+    EXPECT_EQ(clip.addNote(removed), ids[2]);
+    EXPECT_NE(clip.addNote(removed), ids[2]); // Taken now
+
+    auto copy = clip.clone();
+    EXPECT_NE(copy.id, clip.id);
+    ASSERT_EQ(copy.notes.size(), clip.notes.size());
+    EXPECT_EQ(copy.findNote(ids[5])->startSample, 500);
+    EXPECT_EQ(copy.findNoteAt(45, 520)->id, ids[5]);
+}
+
+TEST(MidiNoteList, RevisionChangesWithEveryEdit) {
+    MidiNoteList notes;
+    MidiNote note;
+    note.lengthSamples = 50;
+    const auto id = notes.add(note);
+    const auto added = notes.getRevision();
+
+    // Copies report the same revision until one of them is edited
+    auto copy = notes;
+    EXPECT_EQ(copy.getRevision(), added);
+    copy.update(id, [](MidiNote& n) { n.startSample = 100; });
+    EXPECT_NE(copy.getRevision(), added);
+    EXPECT_EQ(notes.getRevision(), added);
+
+    // Same edit on the original: same notes, but never a repeated revision
+    notes.update(id, [](MidiNote& n) { n.startSample = 100; });
+    EXPECT_NE(notes.getRevision(), added);
+    EXPECT_NE(notes.getRevision(), copy.getRevision());
+
+    // An edit that changes nothing keeps the revision
+    const auto moved = notes.getRevision();
+    notes.update(id, [](MidiNote& n) { n.startSample = 100; });
+    EXPECT_EQ(notes.getRevision(), moved);
+    notes.remove(id);
+    EXPECT_NE(notes.getRevision(), moved);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "model/Clip.hpp"
+#include "model/PeakPyramid.hpp"
+
+using namespace ampl;
+
+TEST(PeakPyramid, LevelsBoundTheSamplesOfEachPixel) {
+    auto asset = std::make_shared<AudioAsset>();
+    asset->numChannels = 1;
+    asset->lengthInSamples = 100000;
+    asset->channels.assign(1, std::vector<float>(100000));
+    for (size_t i = 0; i < asset->channels[0].size(); ++i) {
+        asset->channels[0][i] = 0.8f * std::sin(0.001f * static_cast<float>(i)) * std::sin(0.37f * static_cast<float>(i));
+    }
+    asset->peaks = PeakPyramid::buildInBackground(asset);
+    asset->peaks->waitUntilReady();
+    EXPECT_GT(asset->peaks->getNumLevels(), 10);
+
+    for (double samplesPerPixel : {4.0, 100.0, 2500.0}) {
+        std::vector<PeakPyramid::Peak> peaks(40);
+        ASSERT_TRUE(PeakPyramid::getPeaks(*asset, 0, 1000.0, samplesPerPixel, peaks.data(), 40));
+
+        for (int px = 0; px < 40; ++px) {
+            const auto start = static_cast<size_t>(1000.0 + px * samplesPerPixel);
+            const auto end = std::min(static_cast<size_t>(1000.0 + (px + 1) * samplesPerPixel), asset->channels[0].size());
+            float minValue = 1.0f, maxValue = -1.0f;
+            for (size_t i = start; i < end; ++i) {
+                minValue = std::min(minValue, asset->channels[0][i]);
+                maxValue = std::max(maxValue, asset->channels[0][i]);
+            }
+            const auto& peak = peaks[static_cast<size_t>(px)];
+            if (start >= end) {
+                EXPECT_EQ(peak.max, 0.0f);
+                continue;
+            }
+            EXPECT_LE(peak.min, minValue);
+            EXPECT_GE(peak.max, maxValue);
+            EXPECT_LE(peak.rms, std::max(std::abs(peak.min), std::abs(peak.max)));
+        }
+    }
+}
+
+TEST(PeakPyramid, PeakFilesRoundTripAndRejectOtherAudio) {
+    AudioAsset asset;
+    asset.numChannels = 2;
+    asset.lengthInSamples = 10000;
+    asset.channels.assign(2, std::vector<float>(10000));
+    for (size_t i = 0; i < 10000; ++i) {
+        asset.channels[0][i] = std::sin(0.01f * static_cast<float>(i));
+        asset.channels[1][i] = 0.5f * std::sin(0.03f * static_cast<float>(i));
+    }
+
+    // Streamed in decoder-sized blocks
+    PeakPyramid streamed;
+    streamed.begin(2, asset.lengthInSamples);
+    for (SampleCount start = 0; start < asset.lengthInSamples; start += 4096) {
+        const float* block[] = {asset.channels[0].data() + start, asset.channels[1].data() + start};
+        streamed.addSamples(block, static_cast<int>(std::min<SampleCount>(4096, asset.lengthInSamples - start)));
+    }
+    streamed.finish();
+    ASSERT_TRUE(streamed.isReady());
+
+    const uint64_t key = PeakPyramid::contentKey(asset.channels[0].data(), 10000 * sizeof(float));
+    auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("ampl_peak_test");
+    auto file = PeakPyramid::getPeakFile(directory, key);
+    ASSERT_TRUE(streamed.saveToFile(file, key));
+
+    PeakPyramid loaded;
+    ASSERT_TRUE(loaded.loadFromFile(file, key));
+    EXPECT_EQ(loaded.getNumLevels(), streamed.getNumLevels());
+    EXPECT_EQ(loaded.getNumChannels(), 2);
+    EXPECT_EQ(loaded.getLength(), asset.lengthInSamples);
+
+    PeakPyramid other;
+    EXPECT_FALSE(other.loadFromFile(file, key + 1));
+    EXPECT_FALSE(other.isReady());
+
+    directory.deleteRecursively();
+}
+
+TEST(PeakPyramid, ContentKeyChangesWithSameSizeEdits) {
+    auto file = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("ampl_content_key_test.raw");
+    juce::MemoryBlock data(1 << 20, true);
+    ASSERT_TRUE(file.replaceWithData(data.getData(), data.getSize()));
+    ASSERT_TRUE(file.setLastModificationTime(juce::Time(2024, 0, 1, 12, 0)));
+    const uint64_t key = PeakPyramid::contentKey(file);
+    EXPECT_NE(key, 0u);
+    EXPECT_EQ(PeakPyramid::contentKey(file), key);
+
+    // One byte between the sampled blocks, as an editor saving in place would
+    static_cast<char*>(data.getData())[12345] = 1;
+    ASSERT_TRUE(file.replaceWithData(data.getData(), data.getSize()));
+    ASSERT_TRUE(file.setLastModificationTime(juce::Time(2024, 0, 1, 12, 5)));
+    EXPECT_NE(PeakPyramid::contentKey(file), key);
+
+    file.deleteFile();
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "model/Session.hpp"
+#include <atomic>
+#include <thread>
+
+using namespace ampl;
+
+TEST(Session, SnapshotsShareNotesUntilEdited) {
+    Session session;
+    const int index = session.addMidiTrack("Keys");
+    auto* track = session.getTrack(index);
+    track->midiClips.push_back(MidiClip::createEmpty(0, 48000));
+    MidiNote note;
+    note.startSample = 1000;
+    note.lengthSamples = 500;
+    const auto noteId = track->midiClips[0].addNote(note);
+
+    const auto snapshot = session.takeSnapshot();
+    EXPECT_TRUE(snapshot.tracks[0].midiClips[0].notes.sharesStorageWith(track->midiClips[0].notes));
+
+    // Editing the live clip leaves the snapshot's notes as they were
+    track->midiClips[0].updateNote(noteId, [](MidiNote& n) { n.startSample = 2000; });
+    EXPECT_FALSE(snapshot.tracks[0].midiClips[0].notes.sharesStorageWith(track->midiClips[0].notes));
+    EXPECT_EQ(snapshot.tracks[0].midiClips[0].findNote(noteId)->startSample, 1000);
+
+    session.restoreSnapshot(snapshot);
+    EXPECT_EQ(session.getTrack(index)->midiClips[0].findNote(noteId)->startSample, 1000);
+    EXPECT_EQ(session.getTrack(index)->midiClips[0].findNoteAt(60, 1200)->id, noteId);
+}
+
+TEST(Session, LookupsByIdFollowDirectEdits) {
+    Session session;
+    std::vector<juce::String> trackIds;
+    for (int i = 0; i < 20; ++i)
+        trackIds.push_back(session.getTrack(session.addTrack())->id);
+
+    Clip clip;
+    clip.id = "clip";
+    ASSERT_TRUE(session.addClipToTrack(3, clip));
+    EXPECT_EQ(session.findTrackIndexById(trackIds[7]), 7);
+    EXPECT_EQ(session.findClip("clip"), &session.getTrack(3)->clips[0]);
+
+    // Edits that bypass Session are picked up on the next lookup
+    session.moveTrack(3, 0);
+    session.getTracks().erase(session.getTracks().begin() + 5);
+    EXPECT_EQ(session.findTrackIndexById(trackIds[3]), 0);
+    EXPECT_EQ(session.findTrackIndexById(trackIds[7]), 6);
+    EXPECT_EQ(session.findTrackIndexById(trackIds[5]), -1);
+    EXPECT_EQ(session.findClip("clip"), &session.getTrack(0)->clips[0]);
+    EXPECT_EQ(session.findTrackById(trackIds[19])->id, trackIds[19]);
+
+    auto* track = session.getTrack(1);
+    for (int i = 0; i < 4; ++i)
+        track->midiClips.push_back(MidiClip::createEmpty(i * 1000, 1000));
+    const auto thirdId = track->midiClips[2].id;
+    EXPECT_EQ(track->findMidiClip(thirdId), &track->midiClips[2]);
+    track->midiClips.erase(track->midiClips.begin());
+    EXPECT_EQ(track->findMidiClip(thirdId), &track->midiClips[1]);
+
+    // Copies find their own clips, not the original's
+    const TrackState copy = *track;
+    EXPECT_EQ(copy.findMidiClip(thirdId), &copy.midiClips[1]);
+    EXPECT_EQ(copy.findMidiClip("missing"), nullptr);
+}
+
+TEST(Session, ConstLookupsRunConcurrently) {
+    Session session;
+    std::vector<juce::String> trackIds;
+    for (int i = 0; i < 50; ++i)
+        trackIds.push_back(session.getTrack(session.addTrack())->id);
+    session.getTracks().erase(session.getTracks().begin()); // Leaves the index stale
+
+    // Readers race to rebuild the index and look up IDs that do not exist
+    const Session& reader = session;
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                const int k = i % 50;
+                if (reader.findTrackIndexById(trackIds[static_cast<size_t>(k)]) != k - 1)
+                    ++wrong;
+                if (reader.findClip("missing") != nullptr)
+                    ++wrong;
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(wrong.load(), 0);
+}